@@ -4,6 +4,11 @@
 #include <CLI11/CLI11.hpp>
 #include <stan3/algorithm_type.hpp>
 #include <stan3/metric_type.hpp>
+#include <stan3/optimizer_type.hpp>
+#include <stan3/output_format_type.hpp>
+#include <stan3/variational_type.hpp>
+#include <stan3/zstd_stream.hpp>
+#include <algorithm>
 #include <string>
 #include <map>
 #include <memory>
@@ -38,6 +43,7 @@ struct init_args {
 struct inference_args {
   model_args model;
   size_t num_chains = 1;
+  unsigned int num_threads = 1;
   init_args init;
   std::string output_dir;
 };
@@ -57,10 +63,21 @@ struct hmc_nuts_args {
   int max_depth = 10;
 
   // HMC output options
+  output_format_t output_format = output_format_t::CSV;
+  bool async_output = false;
+  int compression_level = 0;
+  unsigned int compression_threads = 1;
   bool save_start_params = false;
   bool save_warmup = false;
   bool save_diagnostics = false;
   bool save_metric = false;
+  // Write all chains to shared files with a chain__ column
+  bool single_file = false;
+  std::string profile_file;
+  std::string summary_file;
+  // Variables of the sample and diagnostic files; empty lists keep all
+  std::vector<std::string> output_vars;
+  std::vector<std::string> exclude_vars;
   
   // NUTS adaptation options
   double delta = 0.8;
@@ -70,6 +87,113 @@ struct hmc_nuts_args {
   unsigned int init_buffer = 75;
   unsigned int term_buffer = 50;
   unsigned int window = 25;
+
+  // Initialize chains and the diagonal metric from a Pathfinder run
+  bool pathfinder_init = false;
+
+  // Pool metric and step size adaptation across concurrently running chains
+  bool cross_chain_warmup = false;
+
+  // Threads of each chain's log density and gradient evaluations
+  // (reduce_sum, map_rect), taken from --num-threads; 0 splits
+  // --num-threads evenly between the concurrently running chains
+  unsigned int threads_per_chain = 1;
+
+  // Pin each concurrently running chain and its threads to a block of
+  // cores on one NUMA node (Linux only)
+  bool affinity = false;
+
+  // Keep no copy of the chains' initial values and, for a dense metric
+  // from a single --metric file that is not adapted, share one inverse
+  // metric between all chains instead of one per chain
+  bool memory_lean = false;
+
+  // Keep the --metric files' inverse metric and step size, adapting only
+  // the step size during warmup (none with --warmup 0)
+  bool warm_start = false;
+
+  // Stop sampling once every column reaches these targets; 0 disables
+  double target_ess = 0;
+  double target_rhat = 0;
+};
+
+/* Pathfinder specific arguments */
+struct pathfinder_args {
+  inference_args base;
+
+  int num_paths = 4;
+  int num_draws = 1000;
+  int num_multi_draws = 1000;
+  int num_elbo_draws = 25;
+  bool psis_resample = true;
+  bool calculate_lp = true;
+  int refresh = 100;
+
+  // L-BFGS options
+  int history_size = 5;
+  double init_alpha = 0.001;
+  double tol_obj = 1e-12;
+  double tol_rel_obj = 1e4;
+  double tol_grad = 1e-8;
+  double tol_rel_grad = 1e7;
+  double tol_param = 1e-8;
+  int num_iterations = 1000;
+};
+
+/* Optimization (MLE / MAP) specific arguments */
+struct optimize_args {
+  inference_args base;
+
+  optimizer_t algorithm = optimizer_t::LBFGS;
+  bool jacobian = false;
+  int num_iterations = 2000;
+  bool save_iterations = false;
+  int refresh = 100;
+
+  // Independent optimizations, one per initialization, run in parallel
+  // on up to --num-threads threads
+  size_t num_runs = 1;
+
+  // (L-)BFGS options
+  int history_size = 5;
+  double init_alpha = 0.001;
+  double tol_obj = 1e-12;
+  double tol_rel_obj = 1e4;
+  double tol_grad = 1e-8;
+  double tol_rel_grad = 1e7;
+  double tol_param = 1e-8;
+};
+
+/* ADVI specific arguments */
+struct advi_args {
+  inference_args base;
+
+  variational_t algorithm = variational_t::MEANFIELD;
+  int num_iterations = 10000;
+  int grad_samples = 1;
+  int elbo_samples = 100;
+  double eta = 1.0;
+  bool adapt_engaged = true;
+  int adapt_iterations = 50;
+  double tol_rel_obj = 0.01;
+  int eval_elbo = 100;
+  int output_draws = 1000;
+};
+
+/* Standalone generated quantities specific arguments */
+struct gq_args {
+  inference_args base;
+
+  std::string fitted_params_file;
+  size_t chunk_size = 1024;
+  output_format_t output_format = output_format_t::CSV;
+};
+
+/* Batch of HMC-NUTS jobs read from a manifest */
+struct batch_args {
+  std::string manifest_file;
+  unsigned int num_threads = 1;
+  std::string output_dir;
 };
 
 /* Custom validator for JSON input files */
@@ -97,6 +221,33 @@ struct JSONFileValidator : public CLI::Validator {
   }
 };
 
+/* Custom validator for data files: JSON, or the binary data format for
+ * files with a ".bin" extension */
+struct DataFileValidator : public CLI::Validator {
+  DataFileValidator() {
+    name_ = "DataFile";
+    func_ = [](const std::string& str) -> std::string {
+      if (std::filesystem::path(str).extension() != ".bin") {
+        JSONFileValidator json_validator;
+        return json_validator(str);
+      }
+      if (!std::filesystem::exists(str)) {
+        return "Data file does not exist: " + str;
+      }
+      std::ifstream test_stream(str, std::ios::binary);
+      if (!test_stream.good()) {
+        return "Data file is not readable (permission denied?): " + str;
+      }
+      char magic[8] = {0};
+      test_stream.read(magic, sizeof(magic));
+      if (std::string(magic, sizeof(magic)) != "STAN3DAT") {
+        return "File is not in the binary data format: " + str;
+      }
+      return std::string{};
+    };
+  }
+};
+
 /* Custom validator for vector of JSON files */
 struct JSONFileVectorValidator : public CLI::Validator {
   JSONFileVectorValidator() {
@@ -121,6 +272,31 @@ inline std::map<std::string, metric_t> create_metric_map() {
   };
 }
 
+/* Function to create string-to-enum mapping for draws output format */
+inline std::map<std::string, output_format_t> create_output_format_map() {
+  return {
+    {"csv", output_format_t::CSV},
+    {"binary", output_format_t::BINARY}
+  };
+}
+
+/* Function to create string-to-enum mapping for optimization algorithm */
+inline std::map<std::string, optimizer_t> create_optimizer_map() {
+  return {
+    {"lbfgs", optimizer_t::LBFGS},
+    {"bfgs", optimizer_t::BFGS},
+    {"newton", optimizer_t::NEWTON}
+  };
+}
+
+/* Function to create string-to-enum mapping for the ADVI variational family */
+inline std::map<std::string, variational_t> create_variational_map() {
+  return {
+    {"meanfield", variational_t::MEANFIELD},
+    {"fullrank", variational_t::FULLRANK}
+  };
+}
+
 /* Function to create a unique temporary directory */
 inline std::string create_temp_output_dir() {
   auto temp_base = std::filesystem::temp_directory_path();
@@ -157,7 +333,7 @@ inline void setup_model_options(CLI::App& app, model_args& args) {
   
   app.add_option("--data", args.data_file, 
                  "Data inputs file")
-    ->check(JSONFileValidator{});
+    ->check(DataFileValidator{});
 }
 
 /* Function to setup initialization options */
@@ -180,10 +356,16 @@ inline void setup_inference_options(CLI::App& app, inference_args& args) {
     ->check(CLI::PositiveNumber)
     ->capture_default_str();
 
+  app.add_option("--num-threads", args.num_threads,
+                 "Maximum number of threads, shared by concurrently running chains")
+    ->check(CLI::PositiveNumber)
+    ->capture_default_str();
+
   app.add_option("-o,--output-dir", args.output_dir, 
                  "Directory for all output files")
-    ->default_function([]() { return create_temp_output_dir(); })
-    ->capture_default_str();
+    // Only finalizing creates the temporary directory, so that parsing,
+    // e.g. of every job of a batch manifest, leaves nothing behind
+    ->default_str("new temporary directory");
 }
 
 
@@ -226,6 +408,35 @@ inline bool validate_hmc_arguments(const hmc_nuts_args& args, std::string& error
     return false;
   }
   
+  if (args.compression_level > 0 && !compression_enabled()) {
+    error_message = "Error: --compression-level requires building with STAN3_ZSTD=true";
+    return false;
+  }
+
+  if (args.target_rhat != 0 && args.target_rhat <= 1) {
+    error_message = "Error: --target-rhat must be greater than 1 (or 0 for no target)";
+    return false;
+  }
+
+  for (const auto& name : args.exclude_vars) {
+    if (std::find(args.output_vars.begin(), args.output_vars.end(), name)
+        != args.output_vars.end()) {
+      error_message = "Error: " + name + " is both in --output-vars and --exclude-vars";
+      return false;
+    }
+  }
+
+  if (args.threads_per_chain > args.base.num_threads) {
+    error_message = "Error: --threads-per-chain (" + std::to_string(args.threads_per_chain)
+      + ") cannot exceed --num-threads (" + std::to_string(args.base.num_threads) + ")";
+    return false;
+  }
+
+  if (args.warm_start && args.metric_files.empty()) {
+    error_message = "Error: --warm-start requires --metric files from a previous run";
+    return false;
+  }
+
   // Validate init_files: must be empty, size 1, or size num_chains
   if (!args.base.init.init_files.empty() && 
       args.base.init.init_files.size() != 1 && 
@@ -288,6 +499,18 @@ inline bool parse_hmc_args(int argc, char** argv, hmc_nuts_args& args, std::stri
                        "Maximum tree depth")
     ->check(CLI::PositiveNumber)
     ->capture_default_str();
+
+  hmc_opts->add_option("--target-ess", args.target_ess,
+                       "Stop sampling once every variable has this effective sample size "
+                       "(0 = run all --samples)")
+    ->check(CLI::NonNegativeNumber)
+    ->capture_default_str();
+
+  hmc_opts->add_option("--target-rhat", args.target_rhat,
+                       "Stop sampling once every variable has at most this split R-hat "
+                       "(0 = run all --samples)")
+    ->check(CLI::NonNegativeNumber)
+    ->capture_default_str();
   
   hmc_opts->add_option("--warmup", args.num_warmup, 
                        "Number of warmup iterations")
@@ -343,8 +566,53 @@ inline bool parse_hmc_args(int argc, char** argv, hmc_nuts_args& args, std::stri
                         "Initial width of slow adaptation interval")
     ->check(CLI::PositiveNumber)
     ->capture_default_str();
+
+  nuts_opts->add_flag("--pathfinder-init", args.pathfinder_init,
+                      "Initialize chains and the diagonal metric from a Pathfinder run?")
+    ->capture_default_str();
+
+  nuts_opts->add_flag("--cross-chain-warmup", args.cross_chain_warmup,
+                      "Pool metric and step size adaptation across parallel chains?")
+    ->capture_default_str();
+
+  nuts_opts->add_option("--threads-per-chain", args.threads_per_chain,
+                        "Threads of each chain for reduce_sum and map_rect, out of --num-threads "
+                        "(0 = split --num-threads between the chains)")
+    ->capture_default_str();
+
+  nuts_opts->add_flag("--affinity", args.affinity,
+                      "Pin each parallel chain and its threads to its own cores?")
+    ->capture_default_str();
+
+  nuts_opts->add_flag("--memory-lean", args.memory_lean,
+                      "Reduce per-chain memory: no copy of the initial values, one dense "
+                      "--metric shared by all chains when it is not adapted?")
+    ->capture_default_str();
+
+  nuts_opts->add_flag("--warm-start", args.warm_start,
+                      "Start from the --metric files' metric and step size, adapting only the step size?")
+    ->capture_default_str();
   
   // Output options
+  auto output_format_map = create_output_format_map();
+  output_opts->add_option("--output-format", args.output_format,
+                          "Format of the sample and diagnostic files")
+    ->transform(CLI::CheckedTransformer(output_format_map, CLI::ignore_case))
+    ->capture_default_str();
+
+  output_opts->add_flag("--async-output", args.async_output,
+                        "Write sample and diagnostic files from a background thread?")
+    ->capture_default_str();
+
+  output_opts->add_option("--compression-level", args.compression_level,
+                          "zstd level (1-22) for the sample and diagnostic files (0 = uncompressed)")
+    ->check(CLI::Range(0, 22))
+    ->capture_default_str();
+
+  output_opts->add_option("--compression-threads", args.compression_threads,
+                          "Background threads compressing each file (0 = compress while writing)")
+    ->capture_default_str();
+
   output_opts->add_flag("--save-inits", args.save_start_params,
                         "Save initial parameter values?")
     ->capture_default_str();
@@ -360,6 +628,26 @@ inline bool parse_hmc_args(int argc, char** argv, hmc_nuts_args& args, std::stri
   output_opts->add_flag("--save-diag", args.save_diagnostics, 
                         "Save unconstrained parameter values and gradients?")
     ->capture_default_str();
+
+  output_opts->add_flag("--single-file", args.single_file,
+                        "Write all chains to one file per output, with a chain__ column?")
+    ->capture_default_str();
+
+  output_opts->add_option("--profile-output", args.profile_file,
+                          "JSON file for per-chain timing, leapfrog and tree depth statistics");
+
+  output_opts->add_option("--summary-output", args.summary_file,
+                          "JSON file for mean, sd, ESS and split R-hat computed while sampling");
+
+  output_opts->add_option("--output-vars", args.output_vars,
+                          "Variables or columns to write to the sample and diagnostic files "
+                          "(comma-separated; default all)")
+    ->delimiter(',');
+
+  output_opts->add_option("--exclude-vars", args.exclude_vars,
+                          "Variables or columns not to write to the sample and diagnostic files "
+                          "(comma-separated)")
+    ->delimiter(',');
   
   try {
     app.parse(argc, argv);
@@ -421,6 +709,18 @@ inline CLI::App* setup_backward_compatible_cli(CLI::App& app, hmc_nuts_args& hmc
                        "Maximum tree depth")
     ->check(CLI::PositiveNumber)
     ->capture_default_str();
+
+  hmc_opts->add_option("--target-ess", hmc_args.target_ess,
+                       "Stop sampling once every variable has this effective sample size "
+                       "(0 = run all --samples)")
+    ->check(CLI::NonNegativeNumber)
+    ->capture_default_str();
+
+  hmc_opts->add_option("--target-rhat", hmc_args.target_rhat,
+                       "Stop sampling once every variable has at most this split R-hat "
+                       "(0 = run all --samples)")
+    ->check(CLI::NonNegativeNumber)
+    ->capture_default_str();
   
   hmc_opts->add_option("--warmup", hmc_args.num_warmup, 
                        "Number of warmup iterations")
@@ -476,8 +776,53 @@ inline CLI::App* setup_backward_compatible_cli(CLI::App& app, hmc_nuts_args& hmc
                         "Initial width of slow adaptation interval")
     ->check(CLI::PositiveNumber)
     ->capture_default_str();
+
+  nuts_opts->add_flag("--pathfinder-init", hmc_args.pathfinder_init,
+                      "Initialize chains and the diagonal metric from a Pathfinder run?")
+    ->capture_default_str();
+
+  nuts_opts->add_flag("--cross-chain-warmup", hmc_args.cross_chain_warmup,
+                      "Pool metric and step size adaptation across parallel chains?")
+    ->capture_default_str();
+
+  nuts_opts->add_option("--threads-per-chain", hmc_args.threads_per_chain,
+                        "Threads of each chain for reduce_sum and map_rect, out of --num-threads "
+                        "(0 = split --num-threads between the chains)")
+    ->capture_default_str();
+
+  nuts_opts->add_flag("--affinity", hmc_args.affinity,
+                      "Pin each parallel chain and its threads to its own cores?")
+    ->capture_default_str();
+
+  nuts_opts->add_flag("--memory-lean", hmc_args.memory_lean,
+                      "Reduce per-chain memory: no copy of the initial values, one dense "
+                      "--metric shared by all chains when it is not adapted?")
+    ->capture_default_str();
+
+  nuts_opts->add_flag("--warm-start", hmc_args.warm_start,
+                      "Start from the --metric files' metric and step size, adapting only the step size?")
+    ->capture_default_str();
   
   // Output options
+  auto output_format_map = create_output_format_map();
+  output_opts->add_option("--output-format", hmc_args.output_format,
+                          "Format of the sample and diagnostic files")
+    ->transform(CLI::CheckedTransformer(output_format_map, CLI::ignore_case))
+    ->capture_default_str();
+
+  output_opts->add_flag("--async-output", hmc_args.async_output,
+                        "Write sample and diagnostic files from a background thread?")
+    ->capture_default_str();
+
+  output_opts->add_option("--compression-level", hmc_args.compression_level,
+                          "zstd level (1-22) for the sample and diagnostic files (0 = uncompressed)")
+    ->check(CLI::Range(0, 22))
+    ->capture_default_str();
+
+  output_opts->add_option("--compression-threads", hmc_args.compression_threads,
+                          "Background threads compressing each file (0 = compress while writing)")
+    ->capture_default_str();
+
   output_opts->add_flag("--save-inits", hmc_args.save_start_params,
                         "Save initial parameter values?")
     ->capture_default_str();
@@ -493,10 +838,420 @@ inline CLI::App* setup_backward_compatible_cli(CLI::App& app, hmc_nuts_args& hmc
   output_opts->add_flag("--save-diag", hmc_args.save_diagnostics, 
                         "Save unconstrained parameter values and gradients?")
     ->capture_default_str();
+
+  output_opts->add_flag("--single-file", hmc_args.single_file,
+                        "Write all chains to one file per output, with a chain__ column?")
+    ->capture_default_str();
+
+  output_opts->add_option("--profile-output", hmc_args.profile_file,
+                          "JSON file for per-chain timing, leapfrog and tree depth statistics");
+
+  output_opts->add_option("--summary-output", hmc_args.summary_file,
+                          "JSON file for mean, sd, ESS and split R-hat computed while sampling");
+
+  output_opts->add_option("--output-vars", hmc_args.output_vars,
+                          "Variables or columns to write to the sample and diagnostic files "
+                          "(comma-separated; default all)")
+    ->delimiter(',');
+
+  output_opts->add_option("--exclude-vars", hmc_args.exclude_vars,
+                          "Variables or columns not to write to the sample and diagnostic files "
+                          "(comma-separated)")
+    ->delimiter(',');
   
   return hmc_sub;
 }
 
+/* Function to setup Pathfinder options */
+inline void setup_pathfinder_options(CLI::App& app, pathfinder_args& args) {
+  auto pathfinder_opts = app.add_option_group("Pathfinder Options");
+  auto lbfgs_opts = app.add_option_group("L-BFGS Options");
+
+  pathfinder_opts->add_option("--paths", args.num_paths,
+                              "Number of single-path Pathfinder runs")
+    ->check(CLI::PositiveNumber)
+    ->capture_default_str();
+
+  pathfinder_opts->add_option("--draws", args.num_draws,
+                              "Number of approximate draws per path")
+    ->check(CLI::PositiveNumber)
+    ->capture_default_str();
+
+  pathfinder_opts->add_option("--multi-draws", args.num_multi_draws,
+                              "Number of draws returned after importance resampling")
+    ->check(CLI::PositiveNumber)
+    ->capture_default_str();
+
+  pathfinder_opts->add_option("--elbo-draws", args.num_elbo_draws,
+                              "Number of draws used to evaluate the ELBO")
+    ->check(CLI::PositiveNumber)
+    ->capture_default_str();
+
+  pathfinder_opts->add_option("--psis-resample", args.psis_resample,
+                              "Resample the draws of all paths with Pareto-smoothed importance weights?")
+    ->capture_default_str();
+
+  pathfinder_opts->add_option("--calculate-lp", args.calculate_lp,
+                              "Evaluate the log density of every draw?")
+    ->capture_default_str();
+
+  pathfinder_opts->add_option("--refresh", args.refresh,
+                              "Number of iterations between progress messages")
+    ->capture_default_str();
+
+  lbfgs_opts->add_option("--history-size", args.history_size,
+                         "Number of past gradients used for the Hessian approximation")
+    ->check(CLI::PositiveNumber)
+    ->capture_default_str();
+
+  lbfgs_opts->add_option("--init-alpha", args.init_alpha,
+                         "Line search step size for the first iteration")
+    ->check(CLI::PositiveNumber)
+    ->capture_default_str();
+
+  lbfgs_opts->add_option("--tol-obj", args.tol_obj,
+                         "Convergence tolerance on changes in the objective")
+    ->check(CLI::NonNegativeNumber)
+    ->capture_default_str();
+
+  lbfgs_opts->add_option("--tol-rel-obj", args.tol_rel_obj,
+                         "Convergence tolerance on relative changes in the objective")
+    ->check(CLI::NonNegativeNumber)
+    ->capture_default_str();
+
+  lbfgs_opts->add_option("--tol-grad", args.tol_grad,
+                         "Convergence tolerance on the norm of the gradient")
+    ->check(CLI::NonNegativeNumber)
+    ->capture_default_str();
+
+  lbfgs_opts->add_option("--tol-rel-grad", args.tol_rel_grad,
+                         "Convergence tolerance on the relative norm of the gradient")
+    ->check(CLI::NonNegativeNumber)
+    ->capture_default_str();
+
+  lbfgs_opts->add_option("--tol-param", args.tol_param,
+                         "Convergence tolerance on changes in parameter values")
+    ->check(CLI::NonNegativeNumber)
+    ->capture_default_str();
+
+  lbfgs_opts->add_option("--iterations", args.num_iterations,
+                         "Maximum number of L-BFGS iterations per path")
+    ->check(CLI::PositiveNumber)
+    ->capture_default_str();
+}
+
+/* Function for Pathfinder specific validation */
+inline bool validate_pathfinder_arguments(const pathfinder_args& args,
+                                          std::string& error_message) {
+  if (!args.base.init.init_files.empty() &&
+      args.base.init.init_files.size() != 1 &&
+      args.base.init.init_files.size() != static_cast<size_t>(args.num_paths)) {
+    error_message = "Error: --inits must specify either 1 file (for all paths) or " +
+                   std::to_string(args.num_paths) + " files (one per path). " +
+                   "Found " + std::to_string(args.base.init.init_files.size()) + " files.";
+    return false;
+  }
+  return true;
+}
+
+/* Standalone parser for Pathfinder arguments (includes inference args) */
+inline bool parse_pathfinder_args(int argc, char** argv, pathfinder_args& args,
+                                  std::string& error_msg) {
+  CLI::App app{"Stan3 Pathfinder"};
+  setup_model_options(app, args.base.model);
+  setup_init_options(app, args.base.init);
+  setup_inference_options(app, args.base);
+  setup_pathfinder_options(app, args);
+
+  try {
+    app.parse(argc, argv);
+    return validate_pathfinder_arguments(args, error_msg);
+  } catch (const CLI::ParseError& e) {
+    error_msg = "Pathfinder argument parsing failed: " + std::to_string(e.get_exit_code()) +
+      " (" + e.get_name() + "): " + e.what();
+    return false;
+  }
+}
+
+/* Add the Pathfinder subcommand to the main CLI */
+inline CLI::App* setup_pathfinder_subcommand(CLI::App& app, pathfinder_args& args) {
+  auto pathfinder_sub = app.add_subcommand("pathfinder",
+                                           "Pathfinder variational approximation");
+  setup_model_options(*pathfinder_sub, args.base.model);
+  setup_init_options(*pathfinder_sub, args.base.init);
+  setup_inference_options(*pathfinder_sub, args.base);
+  setup_pathfinder_options(*pathfinder_sub, args);
+  return pathfinder_sub;
+}
+
+/* Function to setup optimization options */
+inline void setup_optimize_options(CLI::App& app, optimize_args& args) {
+  auto optimize_opts = app.add_option_group("Optimization Options");
+  auto bfgs_opts = app.add_option_group("(L-)BFGS Options");
+
+  auto optimizer_map = create_optimizer_map();
+  optimize_opts->add_option("--algorithm", args.algorithm,
+                            "Optimization algorithm")
+    ->transform(CLI::CheckedTransformer(optimizer_map, CLI::ignore_case))
+    ->capture_default_str();
+
+  optimize_opts->add_flag("--jacobian", args.jacobian,
+                          "Apply the Jacobian adjustment of the constraining "
+                          "transforms (MAP estimate on the unconstrained scale)?")
+    ->capture_default_str();
+
+  optimize_opts->add_option("--iterations", args.num_iterations,
+                            "Maximum number of iterations per optimization")
+    ->check(CLI::PositiveNumber)
+    ->capture_default_str();
+
+  optimize_opts->add_option("--runs", args.num_runs,
+                            "Number of independent optimizations, each from its own "
+                            "initialization, run in parallel with --num-threads")
+    ->check(CLI::PositiveNumber)
+    ->capture_default_str();
+
+  optimize_opts->add_flag("--save-iterations", args.save_iterations,
+                          "Save the iterates of each optimization?")
+    ->capture_default_str();
+
+  optimize_opts->add_option("--refresh", args.refresh,
+                            "Number of iterations between progress messages")
+    ->capture_default_str();
+
+  bfgs_opts->add_option("--history-size", args.history_size,
+                        "Number of past gradients used by L-BFGS for the Hessian approximation")
+    ->check(CLI::PositiveNumber)
+    ->capture_default_str();
+
+  bfgs_opts->add_option("--init-alpha", args.init_alpha,
+                        "Line search step size for the first iteration")
+    ->check(CLI::PositiveNumber)
+    ->capture_default_str();
+
+  bfgs_opts->add_option("--tol-obj", args.tol_obj,
+                        "Convergence tolerance on changes in the objective")
+    ->check(CLI::NonNegativeNumber)
+    ->capture_default_str();
+
+  bfgs_opts->add_option("--tol-rel-obj", args.tol_rel_obj,
+                        "Convergence tolerance on relative changes in the objective")
+    ->check(CLI::NonNegativeNumber)
+    ->capture_default_str();
+
+  bfgs_opts->add_option("--tol-grad", args.tol_grad,
+                        "Convergence tolerance on the norm of the gradient")
+    ->check(CLI::NonNegativeNumber)
+    ->capture_default_str();
+
+  bfgs_opts->add_option("--tol-rel-grad", args.tol_rel_grad,
+                        "Convergence tolerance on the relative norm of the gradient")
+    ->check(CLI::NonNegativeNumber)
+    ->capture_default_str();
+
+  bfgs_opts->add_option("--tol-param", args.tol_param,
+                        "Convergence tolerance on changes in parameter values")
+    ->check(CLI::NonNegativeNumber)
+    ->capture_default_str();
+}
+
+/* Function for optimization specific validation */
+inline bool validate_optimize_arguments(const optimize_args& args,
+                                        std::string& error_message) {
+  if (!args.base.init.init_files.empty() &&
+      args.base.init.init_files.size() != 1 &&
+      args.base.init.init_files.size() != args.num_runs) {
+    error_message = "Error: --inits must specify either 1 file (for all runs) or " +
+                   std::to_string(args.num_runs) + " files (one per run). " +
+                   "Found " + std::to_string(args.base.init.init_files.size()) + " files.";
+    return false;
+  }
+  return true;
+}
+
+/* Standalone parser for optimization arguments (includes inference args) */
+inline bool parse_optimize_args(int argc, char** argv, optimize_args& args,
+                                std::string& error_msg) {
+  CLI::App app{"Stan3 Optimization"};
+  setup_model_options(app, args.base.model);
+  setup_init_options(app, args.base.init);
+  setup_inference_options(app, args.base);
+  setup_optimize_options(app, args);
+
+  try {
+    app.parse(argc, argv);
+    return validate_optimize_arguments(args, error_msg);
+  } catch (const CLI::ParseError& e) {
+    error_msg = "Optimize argument parsing failed: " + std::to_string(e.get_exit_code()) +
+      " (" + e.get_name() + "): " + e.what();
+    return false;
+  }
+}
+
+/* Add the optimize subcommand to the main CLI */
+inline CLI::App* setup_optimize_subcommand(CLI::App& app, optimize_args& args) {
+  auto optimize_sub = app.add_subcommand("optimize",
+                                         "Penalized maximum likelihood or MAP estimation");
+  setup_model_options(*optimize_sub, args.base.model);
+  setup_init_options(*optimize_sub, args.base.init);
+  setup_inference_options(*optimize_sub, args.base);
+  setup_optimize_options(*optimize_sub, args);
+  return optimize_sub;
+}
+
+/* Function to setup ADVI options */
+inline void setup_advi_options(CLI::App& app, advi_args& args) {
+  auto advi_opts = app.add_option_group("ADVI Options");
+  auto adapt_opts = app.add_option_group("ADVI Adaptation Options");
+
+  auto variational_map = create_variational_map();
+  advi_opts->add_option("--algorithm", args.algorithm,
+                        "Variational family")
+    ->transform(CLI::CheckedTransformer(variational_map, CLI::ignore_case))
+    ->capture_default_str();
+
+  advi_opts->add_option("--iterations", args.num_iterations,
+                        "Maximum number of iterations")
+    ->check(CLI::PositiveNumber)
+    ->capture_default_str();
+
+  advi_opts->add_option("--grad-samples", args.grad_samples,
+                        "Number of draws for the Monte Carlo ELBO gradient, "
+                        "evaluated in parallel with --num-threads")
+    ->check(CLI::PositiveNumber)
+    ->capture_default_str();
+
+  advi_opts->add_option("--elbo-samples", args.elbo_samples,
+                        "Number of draws for the Monte Carlo ELBO estimate")
+    ->check(CLI::PositiveNumber)
+    ->capture_default_str();
+
+  advi_opts->add_option("--eta", args.eta,
+                        "Step size scaling parameter")
+    ->check(CLI::PositiveNumber)
+    ->capture_default_str();
+
+  advi_opts->add_option("--tol-rel-obj", args.tol_rel_obj,
+                        "Convergence tolerance on the relative norm of the objective")
+    ->check(CLI::PositiveNumber)
+    ->capture_default_str();
+
+  advi_opts->add_option("--eval-elbo", args.eval_elbo,
+                        "Number of iterations between ELBO evaluations")
+    ->check(CLI::PositiveNumber)
+    ->capture_default_str();
+
+  advi_opts->add_option("--draws", args.output_draws,
+                        "Number of approximate posterior draws to save")
+    ->check(CLI::NonNegativeNumber)
+    ->capture_default_str();
+
+  adapt_opts->add_option("--adapt-engaged", args.adapt_engaged,
+                         "Adapt the step size scaling parameter eta?")
+    ->capture_default_str();
+
+  adapt_opts->add_option("--adapt-iterations", args.adapt_iterations,
+                         "Number of iterations for each candidate eta")
+    ->check(CLI::PositiveNumber)
+    ->capture_default_str();
+}
+
+/* Standalone parser for ADVI arguments (includes inference args) */
+inline bool parse_advi_args(int argc, char** argv, advi_args& args, std::string& error_msg) {
+  CLI::App app{"Stan3 ADVI"};
+  setup_model_options(app, args.base.model);
+  setup_init_options(app, args.base.init);
+  setup_inference_options(app, args.base);
+  setup_advi_options(app, args);
+
+  try {
+    app.parse(argc, argv);
+    return true;
+  } catch (const CLI::ParseError& e) {
+    error_msg = "ADVI argument parsing failed: " + std::to_string(e.get_exit_code()) +
+      " (" + e.get_name() + "): " + e.what();
+    return false;
+  }
+}
+
+/* Add the ADVI subcommand to the main CLI */
+inline CLI::App* setup_advi_subcommand(CLI::App& app, advi_args& args) {
+  auto advi_sub = app.add_subcommand("advi",
+                                     "Automatic differentiation variational inference");
+  setup_model_options(*advi_sub, args.base.model);
+  setup_init_options(*advi_sub, args.base.init);
+  setup_inference_options(*advi_sub, args.base);
+  setup_advi_options(*advi_sub, args);
+  return advi_sub;
+}
+
+/* Function to setup standalone generated quantities options */
+inline void setup_gq_options(CLI::App& app, gq_args& args) {
+  auto gq_opts = app.add_option_group("Generated Quantities Options");
+
+  gq_opts->add_option("--fitted-params", args.fitted_params_file,
+                      "Draws file (CSV or binary) of a previous fit of the model")
+    ->required()
+    ->check(CLI::ExistingFile);
+
+  gq_opts->add_option("--chunk-size", args.chunk_size,
+                      "Number of draws read and evaluated in parallel at a time")
+    ->check(CLI::PositiveNumber)
+    ->capture_default_str();
+
+  auto output_format_map = create_output_format_map();
+  gq_opts->add_option("--output-format", args.output_format,
+                      "Format of the generated quantities file")
+    ->transform(CLI::CheckedTransformer(output_format_map, CLI::ignore_case))
+    ->capture_default_str();
+}
+
+/* Standalone parser for generated quantities arguments (includes inference args) */
+inline bool parse_gq_args(int argc, char** argv, gq_args& args, std::string& error_msg) {
+  CLI::App app{"Stan3 Generated Quantities"};
+  setup_model_options(app, args.base.model);
+  setup_inference_options(app, args.base);
+  setup_gq_options(app, args);
+
+  try {
+    app.parse(argc, argv);
+    return true;
+  } catch (const CLI::ParseError& e) {
+    error_msg = "Generated quantities argument parsing failed: "
+      + std::to_string(e.get_exit_code()) + " (" + e.get_name() + "): " + e.what();
+    return false;
+  }
+}
+
+/* Add the standalone generated quantities subcommand to the main CLI */
+inline CLI::App* setup_gq_subcommand(CLI::App& app, gq_args& args) {
+  auto gq_sub = app.add_subcommand("gq",
+                                   "Generated quantities for the draws of a previous fit");
+  setup_model_options(*gq_sub, args.base.model);
+  setup_inference_options(*gq_sub, args.base);
+  setup_gq_options(*gq_sub, args);
+  return gq_sub;
+}
+
+/* Add the batch subcommand to the main CLI */
+inline CLI::App* setup_batch_subcommand(CLI::App& app, batch_args& args) {
+  auto batch_sub = app.add_subcommand("batch",
+                                      "Run a manifest of HMC-NUTS jobs on one thread pool");
+  batch_sub->add_option("--manifest", args.manifest_file,
+                        "File with the hmc options of one job per line")
+    ->required()
+    ->check(CLI::ExistingFile);
+
+  batch_sub->add_option("--num-threads", args.num_threads,
+                        "Number of threads shared by the chains of all jobs")
+    ->check(CLI::PositiveNumber)
+    ->capture_default_str();
+
+  batch_sub->add_option("-o,--output-dir", args.output_dir,
+                        "Directory holding the output directories of jobs without --output-dir");
+  return batch_sub;
+}
+
 /* Function to finalize arguments after CLI parsing */
 inline void finalize_hmc_arguments(hmc_nuts_args& args) {
   if (args.base.output_dir.empty()) {
@@ -504,6 +1259,36 @@ inline void finalize_hmc_arguments(hmc_nuts_args& args) {
   }
 }
 
+inline void finalize_pathfinder_arguments(pathfinder_args& args) {
+  if (args.base.output_dir.empty()) {
+    args.base.output_dir = create_temp_output_dir();
+  }
+}
+
+inline void finalize_optimize_arguments(optimize_args& args) {
+  if (args.base.output_dir.empty()) {
+    args.base.output_dir = create_temp_output_dir();
+  }
+}
+
+inline void finalize_advi_arguments(advi_args& args) {
+  if (args.base.output_dir.empty()) {
+    args.base.output_dir = create_temp_output_dir();
+  }
+}
+
+inline void finalize_gq_arguments(gq_args& args) {
+  if (args.base.output_dir.empty()) {
+    args.base.output_dir = create_temp_output_dir();
+  }
+}
+
+inline void finalize_batch_arguments(batch_args& args) {
+  if (args.output_dir.empty()) {
+    args.output_dir = create_temp_output_dir();
+  }
+}
+
 /* Helper function to get init file for a specific chain */
 inline std::string get_init_file_for_chain(const init_args& args, size_t chain_idx) {
   if (args.init_files.empty()) {
@@ -0,0 +1,198 @@
+#ifndef STAN3_ASYNC_WRITER_HPP
+#define STAN3_ASYNC_WRITER_HPP
+
+#include <stan/callbacks/writer.hpp>
+
+#include <condition_variable>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace stan3 {
+
+/**
+ * Writer that hands output to a background I/O thread.
+ *
+ * Each call copies its argument into the next slot of a fixed-size ring
+ * buffer and returns; a dedicated thread forwards the slots, in order, to
+ * the wrapped writer. Slot storage is reused, so once the buffer has
+ * cycled, writing a draw does not allocate. When the ring is full the
+ * caller blocks until the I/O thread has caught up.
+ *
+ * An exception thrown by the wrapped writer stops further output and is
+ * rethrown from the next call on the sampling thread, or from flush().
+ *
+ * Calls must come from a single thread, as with every per-chain writer.
+ *
+ * @tparam WriterType Type of the wrapped writer
+ */
+template <typename WriterType>
+class async_writer : public stan::callbacks::writer {
+public:
+  using writer_type = WriterType;
+
+  /**
+   * @param writer Writer that performs the actual output
+   * @param capacity Number of slots in the ring buffer
+   */
+  explicit async_writer(std::unique_ptr<WriterType>&& writer, size_t capacity = 64)
+    : writer_(std::move(writer)), ring_(capacity == 0 ? 1 : capacity) {
+    if (!writer_) {
+      throw std::invalid_argument("async_writer: wrapped writer is null");
+    }
+    thread_ = std::thread([this] { run(); });
+  }
+
+  async_writer(const async_writer&) = delete;
+  async_writer& operator=(const async_writer&) = delete;
+
+  /* Drain the ring buffer, then stop the I/O thread */
+  ~async_writer() override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_ = true;
+    }
+    not_empty_.notify_one();
+    thread_.join();
+    if (error_) {
+      try {
+        std::rethrow_exception(error_);
+      } catch (const std::exception& e) {
+        std::cerr << "Error writing output: " << e.what() << std::endl;
+      } catch (...) {
+        std::cerr << "Error writing output" << std::endl;
+      }
+    }
+  }
+
+  void operator()(const std::vector<std::string>& names) override {
+    slot& s = acquire();
+    s.type = kind::NAMES;
+    s.names = names;
+    publish();
+  }
+
+  void operator()(const std::vector<double>& state) override {
+    slot& s = acquire();
+    s.type = kind::VALUES;
+    s.values.assign(state.begin(), state.end());
+    publish();
+  }
+
+  void operator()() override {
+    acquire().type = kind::BLANK;
+    publish();
+  }
+
+  void operator()(const std::string& message) override {
+    slot& s = acquire();
+    s.type = kind::MESSAGE;
+    s.message = message;
+    publish();
+  }
+
+  /* Block until everything written so far has reached the wrapped writer */
+  void flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this] { return size_ == 0 || error_; });
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+  WriterType& get_writer() { return *writer_; }
+
+private:
+  enum class kind { NAMES, VALUES, BLANK, MESSAGE };
+
+  struct slot {
+    kind type = kind::BLANK;
+    std::vector<double> values;
+    std::vector<std::string> names;
+    std::string message;
+  };
+
+  /* Wait for a free slot; the slot at tail_ belongs to the producer until published */
+  slot& acquire() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this] { return size_ < ring_.size() || error_; });
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+    return ring_[tail_];
+  }
+
+  void publish() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tail_ = (tail_ + 1) % ring_.size();
+      ++size_;
+    }
+    not_empty_.notify_one();
+  }
+
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      not_empty_.wait(lock, [this] { return size_ > 0 || done_; });
+      if (size_ == 0) {
+        break;
+      }
+      slot& s = ring_[head_];
+      lock.unlock();
+      std::exception_ptr error;
+      if (!error_) {
+        try {
+          write_slot(s);
+        } catch (...) {
+          error = std::current_exception();
+        }
+      }
+      lock.lock();
+      if (error) {
+        error_ = error;
+      }
+      head_ = (head_ + 1) % ring_.size();
+      --size_;
+      not_full_.notify_one();
+    }
+  }
+
+  void write_slot(const slot& s) {
+    switch (s.type) {
+      case kind::NAMES:
+        (*writer_)(s.names);
+        break;
+      case kind::VALUES:
+        (*writer_)(s.values);
+        break;
+      case kind::BLANK:
+        (*writer_)();
+        break;
+      case kind::MESSAGE:
+        (*writer_)(s.message);
+        break;
+    }
+  }
+
+  std::unique_ptr<WriterType> writer_;
+  std::vector<slot> ring_;
+  size_t head_ = 0;
+  size_t tail_ = 0;
+  size_t size_ = 0;
+  bool done_ = false;
+  std::exception_ptr error_;
+  std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::thread thread_;
+};
+
+}  // namespace stan3
+
+#endif  // STAN3_ASYNC_WRITER_HPP
@@ -0,0 +1,338 @@
+#ifndef STAN3_BINARY_VAR_CONTEXT_HPP
+#define STAN3_BINARY_VAR_CONTEXT_HPP
+
+#include <stan/io/var_context.hpp>
+#include <stan/io/validate_dims.hpp>
+#include <stan3/mapped_file.hpp>
+
+#include <complex>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan3 {
+
+/**
+ * Layout of the binary data format.
+ *
+ * A header and an index of variables are followed by the values of each
+ * variable. Values are stored in the same column-major order as
+ * var_context::vals_r/vals_i, each array starting on an 8-byte boundary
+ * so it can be read in place from a memory-mapped file. Integers and
+ * doubles use the writer's native byte order, recorded by the
+ * byte-order mark.
+ *
+ *   header
+ *     char[8]   magic "STAN3DAT"
+ *     uint32    byte-order mark 0x01020304
+ *     uint32    format version
+ *     uint64    number of variables N
+ *
+ *   index, N entries
+ *     uint64    name length, then the name bytes
+ *     uint32    dtype (FLOAT64 or INT32)
+ *     uint32    number of dimensions K
+ *     K x uint64 dimensions
+ *     uint64    byte offset of the values from the start of the file
+ *
+ *   values, at the offsets given by the index; a variable with
+ *   dimensions d1..dK holds d1 * ... * dK values (1 for a scalar)
+ *
+ * Complex values are stored as FLOAT64 with a trailing dimension of 2,
+ * real and imaginary parts adjacent, as in the JSON format.
+ */
+namespace data_format {
+  constexpr char magic[8] = {'S', 'T', 'A', 'N', '3', 'D', 'A', 'T'};
+  constexpr uint32_t byte_order_mark = 0x01020304;
+  constexpr uint32_t version = 1;
+
+  enum dtype : uint32_t {
+    FLOAT64 = 1,
+    INT32 = 2
+  };
+
+  inline size_t dtype_size(uint32_t type) { return type == INT32 ? 4 : 8; }
+}
+
+/**
+ * var_context over a memory-mapped file in the binary data format.
+ *
+ * Opening the file reads only the index, so the cost of loading does not
+ * grow with the size of the data; values are copied out of the mapping
+ * when the model asks for them. The mapping stays open for the lifetime
+ * of the context.
+ */
+class binary_var_context : public stan::io::var_context {
+public:
+  /**
+   * @param filename Path to the binary data file
+   * @throws std::runtime_error if the file cannot be read or is malformed
+   */
+  explicit binary_var_context(const std::string& filename)
+    : file_(std::make_shared<mapped_file>(filename)) {
+    if (!file_->is_open()) {
+      throw std::runtime_error("Could not open binary data file: " + filename);
+    }
+    read_index(filename);
+  }
+
+  bool contains_r(const std::string& name) const override {
+    return vars_.count(name) > 0;
+  }
+
+  std::vector<double> vals_r(const std::string& name) const override {
+    auto it = vars_.find(name);
+    if (it == vars_.end()) {
+      return {};
+    }
+    const entry& var = it->second;
+    std::vector<double> vals(var.size);
+    if (var.type == data_format::FLOAT64) {
+      std::memcpy(vals.data(), file_->data() + var.offset, var.size * sizeof(double));
+    } else {
+      const int32_t* ints = reinterpret_cast<const int32_t*>(file_->data() + var.offset);
+      for (size_t i = 0; i < var.size; ++i) {
+        vals[i] = ints[i];
+      }
+    }
+    return vals;
+  }
+
+  std::vector<std::complex<double>> vals_c(const std::string& name) const override {
+    auto it = vars_.find(name);
+    if (it == vars_.end()) {
+      return {};
+    }
+    std::vector<double> reals = vals_r(name);
+    std::vector<std::complex<double>> vals;
+    if (it->second.type == data_format::INT32) {
+      vals.reserve(reals.size());
+      for (double x : reals) {
+        vals.emplace_back(x, 0.0);
+      }
+    } else {
+      vals.reserve(reals.size() / 2);
+      for (size_t i = 0; i + 1 < reals.size(); i += 2) {
+        vals.emplace_back(reals[i], reals[i + 1]);
+      }
+    }
+    return vals;
+  }
+
+  std::vector<size_t> dims_r(const std::string& name) const override {
+    auto it = vars_.find(name);
+    return it == vars_.end() ? std::vector<size_t>() : it->second.dims;
+  }
+
+  bool contains_i(const std::string& name) const override {
+    auto it = vars_.find(name);
+    return it != vars_.end() && it->second.type == data_format::INT32;
+  }
+
+  std::vector<int> vals_i(const std::string& name) const override {
+    if (!contains_i(name)) {
+      return {};
+    }
+    const entry& var = vars_.at(name);
+    std::vector<int> vals(var.size);
+    std::memcpy(vals.data(), file_->data() + var.offset, var.size * sizeof(int32_t));
+    return vals;
+  }
+
+  std::vector<size_t> dims_i(const std::string& name) const override {
+    return contains_i(name) ? vars_.at(name).dims : std::vector<size_t>();
+  }
+
+  void names_r(std::vector<std::string>& names) const override {
+    names.clear();
+    for (const auto& var : vars_) {
+      if (var.second.type == data_format::FLOAT64) {
+        names.push_back(var.first);
+      }
+    }
+  }
+
+  void names_i(std::vector<std::string>& names) const override {
+    names.clear();
+    for (const auto& var : vars_) {
+      if (var.second.type == data_format::INT32) {
+        names.push_back(var.first);
+      }
+    }
+  }
+
+  void validate_dims(const std::string& stage, const std::string& name,
+                     const std::string& base_type,
+                     const std::vector<size_t>& dims_declared) const override {
+    stan::io::validate_dims(*this, stage, name, base_type, dims_declared);
+  }
+
+private:
+  struct entry {
+    uint32_t type;
+    std::vector<size_t> dims;
+    size_t offset;
+    size_t size;
+  };
+
+  /* Bounds-checked reader over the mapped header and index */
+  template <typename T>
+  T read_pod(size_t& pos, const std::string& filename) const {
+    if (pos + sizeof(T) > file_->size()) {
+      throw std::runtime_error("Truncated binary data file: " + filename);
+    }
+    T value;
+    std::memcpy(&value, file_->data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return value;
+  }
+
+  void read_index(const std::string& filename) {
+    if (file_->size() < sizeof(data_format::magic)
+        || std::memcmp(file_->data(), data_format::magic, sizeof(data_format::magic)) != 0) {
+      throw std::runtime_error("Not a binary data file: " + filename);
+    }
+    size_t pos = sizeof(data_format::magic);
+    if (read_pod<uint32_t>(pos, filename) != data_format::byte_order_mark) {
+      throw std::runtime_error("Binary data file has a different byte order: " + filename);
+    }
+    uint32_t version = read_pod<uint32_t>(pos, filename);
+    if (version != data_format::version) {
+      throw std::runtime_error("Unsupported binary data format version "
+                               + std::to_string(version) + ": " + filename);
+    }
+    uint64_t num_vars = read_pod<uint64_t>(pos, filename);
+    for (uint64_t n = 0; n < num_vars; ++n) {
+      uint64_t name_len = read_pod<uint64_t>(pos, filename);
+      if (name_len > file_->size() - pos) {
+        throw std::runtime_error("Truncated binary data file: " + filename);
+      }
+      std::string name(file_->data() + pos, name_len);
+      pos += name_len;
+
+      entry var;
+      var.type = read_pod<uint32_t>(pos, filename);
+      if (var.type != data_format::FLOAT64 && var.type != data_format::INT32) {
+        throw std::runtime_error("Unknown dtype for variable " + name + " in " + filename);
+      }
+      uint32_t num_dims = read_pod<uint32_t>(pos, filename);
+      // A size that overflows cannot fit in the file; rejecting it here
+      // keeps a wrapped-around size from passing the bounds check below
+      var.size = 1;
+      for (uint32_t k = 0; k < num_dims; ++k) {
+        uint64_t dim = read_pod<uint64_t>(pos, filename);
+        if (dim > SIZE_MAX || (dim != 0 && var.size > SIZE_MAX / dim)) {
+          throw std::runtime_error("Dimensions of variable " + name + " overflow in "
+                                   + filename);
+        }
+        var.dims.push_back(static_cast<size_t>(dim));
+        var.size *= var.dims.back();
+      }
+      var.offset = read_pod<uint64_t>(pos, filename);
+      size_t dtype_size = data_format::dtype_size(var.type);
+      if (var.size > SIZE_MAX / dtype_size) {
+        throw std::runtime_error("Dimensions of variable " + name + " overflow in "
+                                 + filename);
+      }
+      size_t bytes = var.size * dtype_size;
+      if (var.offset % 8 != 0 || var.offset > file_->size()
+          || bytes > file_->size() - var.offset) {
+        throw std::runtime_error("Invalid offset for variable " + name + " in " + filename);
+      }
+      if (!vars_.emplace(name, std::move(var)).second) {
+        throw std::runtime_error("Duplicate variable " + name + " in " + filename);
+      }
+    }
+  }
+
+  std::shared_ptr<mapped_file> file_;
+  std::map<std::string, entry> vars_;
+};
+
+/* Write the contents of a var_context to a file in the binary data format
+ *
+ * @param context Data to write, e.g. parsed from a JSON file
+ * @param filename Path of the binary data file to create
+ * @throws std::runtime_error if the file cannot be written
+ */
+inline void write_binary_data(const stan::io::var_context& context,
+                              const std::string& filename) {
+  struct var_info {
+    std::string name;
+    uint32_t type;
+    std::vector<size_t> dims;
+    size_t size;
+  };
+  std::vector<var_info> vars;
+  std::vector<std::string> names;
+  context.names_i(names);
+  for (const auto& name : names) {
+    vars.push_back({name, data_format::INT32, context.dims_i(name), context.vals_i(name).size()});
+  }
+  context.names_r(names);
+  for (const auto& name : names) {
+    if (!context.contains_i(name)) {
+      vars.push_back({name, data_format::FLOAT64, context.dims_r(name), context.vals_r(name).size()});
+    }
+  }
+
+  // Index size determines where the values start
+  size_t pos = sizeof(data_format::magic) + 2 * sizeof(uint32_t) + sizeof(uint64_t);
+  for (const auto& var : vars) {
+    pos += sizeof(uint64_t) + var.name.size() + 2 * sizeof(uint32_t)
+           + (var.dims.size() + 1) * sizeof(uint64_t);
+  }
+  auto align = [](size_t n) { return (n + 7) / 8 * 8; };
+  std::vector<uint64_t> offsets;
+  for (const auto& var : vars) {
+    pos = align(pos);
+    offsets.push_back(pos);
+    pos += var.size * data_format::dtype_size(var.type);
+  }
+
+  std::ofstream out(filename, std::ios::binary);
+  if (!out) {
+    throw std::runtime_error("Cannot open output file: " + filename);
+  }
+  auto write_pod = [&](auto value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  };
+  out.write(data_format::magic, sizeof(data_format::magic));
+  write_pod(data_format::byte_order_mark);
+  write_pod(data_format::version);
+  write_pod(static_cast<uint64_t>(vars.size()));
+  for (size_t n = 0; n < vars.size(); ++n) {
+    write_pod(static_cast<uint64_t>(vars[n].name.size()));
+    out.write(vars[n].name.data(), vars[n].name.size());
+    write_pod(vars[n].type);
+    write_pod(static_cast<uint32_t>(vars[n].dims.size()));
+    for (size_t d : vars[n].dims) {
+      write_pod(static_cast<uint64_t>(d));
+    }
+    write_pod(offsets[n]);
+  }
+  for (size_t n = 0; n < vars.size(); ++n) {
+    static const char zeros[8] = {0};
+    out.write(zeros, offsets[n] - static_cast<uint64_t>(out.tellp()));
+    if (vars[n].type == data_format::INT32) {
+      std::vector<int> vals = context.vals_i(vars[n].name);
+      std::vector<int32_t> ints(vals.begin(), vals.end());
+      out.write(reinterpret_cast<const char*>(ints.data()), ints.size() * sizeof(int32_t));
+    } else {
+      std::vector<double> vals = context.vals_r(vars[n].name);
+      out.write(reinterpret_cast<const char*>(vals.data()), vals.size() * sizeof(double));
+    }
+  }
+  if (!out) {
+    throw std::runtime_error("Error writing binary data file: " + filename);
+  }
+}
+
+}  // namespace stan3
+
+#endif  // STAN3_BINARY_VAR_CONTEXT_HPP
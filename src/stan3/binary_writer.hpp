@@ -0,0 +1,190 @@
+#ifndef STAN3_BINARY_WRITER_HPP
+#define STAN3_BINARY_WRITER_HPP
+
+#include <stan/callbacks/writer.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan3 {
+
+/**
+ * Layout of the binary columnar draws format.
+ *
+ * The file is a header followed by a sequence of blocks. Every block
+ * starts on an 8-byte boundary, so the doubles of a draws block can be
+ * read in place from a memory-mapped file. Integers and doubles are
+ * stored in the writer's native byte order, recorded by the byte-order
+ * mark.
+ *
+ *   header
+ *     char[8]   magic "STAN3DRW"
+ *     uint32    byte-order mark 0x01020304
+ *     uint32    format version
+ *     uint64    number of columns C
+ *     C x { uint64 length, char[length] column name }
+ *     zero padding to a multiple of 8 bytes
+ *
+ *   block, repeated until end of file
+ *     uint32    block type (DRAWS or COMMENT)
+ *     uint32    reserved, 0
+ *     uint64    count: number of rows R for DRAWS, number of bytes for COMMENT
+ *     DRAWS:    R x C doubles, column-major (all R values of column 0,
+ *               then all R values of column 1, ...)
+ *     COMMENT:  message bytes, zero padded to a multiple of 8 bytes
+ */
+namespace binary_format {
+  constexpr char magic[8] = {'S', 'T', 'A', 'N', '3', 'D', 'R', 'W'};
+  constexpr uint32_t byte_order_mark = 0x01020304;
+  constexpr uint32_t version = 1;
+
+  enum block_type : uint32_t {
+    DRAWS = 1,
+    COMMENT = 2
+  };
+
+  /* Number of zero bytes needed to pad n bytes to a multiple of 8 */
+  inline size_t padding(size_t n) { return (8 - n % 8) % 8; }
+}
+
+/**
+ * Writer for the binary columnar draws format.
+ *
+ * Draws are buffered into row groups of about block_bytes bytes and
+ * written as one DRAWS block each. Comments flush the pending row group
+ * first so that blocks keep the order in which they were written.
+ *
+ * @tparam Stream Output stream type, opened in binary mode
+ * @tparam Deleter Deleter for the stream
+ */
+template <typename Stream, typename Deleter = std::default_delete<Stream>>
+class binary_stream_writer : public stan::callbacks::writer {
+public:
+  /**
+   * @param output Stream to write to
+   * @param block_bytes Approximate size of a row group in bytes
+   */
+  explicit binary_stream_writer(std::unique_ptr<Stream, Deleter>&& output,
+                                size_t block_bytes = 1 << 20)
+    : output_(std::move(output)), block_bytes_(block_bytes) {
+    if (!output_) {
+      throw std::invalid_argument("binary_stream_writer: output stream is null");
+    }
+  }
+
+  binary_stream_writer(binary_stream_writer&&) = default;
+
+  ~binary_stream_writer() override {
+    if (output_) {
+      flush_rows();
+      output_->flush();
+    }
+  }
+
+  /* Write the header; column names may be given only once */
+  void operator()(const std::vector<std::string>& names) override {
+    if (header_written_) {
+      throw std::logic_error("binary_stream_writer: column names already written");
+    }
+    num_cols_ = names.size();
+    output_->write(binary_format::magic, sizeof(binary_format::magic));
+    write_pod(binary_format::byte_order_mark);
+    write_pod(binary_format::version);
+    write_pod(static_cast<uint64_t>(num_cols_));
+    size_t bytes = sizeof(binary_format::magic) + 2 * sizeof(uint32_t) + sizeof(uint64_t);
+    for (const auto& name : names) {
+      write_pod(static_cast<uint64_t>(name.size()));
+      output_->write(name.data(), name.size());
+      bytes += sizeof(uint64_t) + name.size();
+    }
+    write_padding(binary_format::padding(bytes));
+
+    rows_per_block_ = std::max<size_t>(1, block_bytes_ / (sizeof(double) * std::max<size_t>(1, num_cols_)));
+    rows_.reserve(rows_per_block_ * num_cols_);
+    header_written_ = true;
+  }
+
+  /* Buffer one draw; a DRAWS block is written once the row group is full */
+  void operator()(const std::vector<double>& state) override {
+    if (state.empty()) {
+      return;
+    }
+    if (!header_written_) {
+      throw std::logic_error("binary_stream_writer: draws written before column names");
+    }
+    if (state.size() != num_cols_) {
+      throw std::invalid_argument("binary_stream_writer: expected "
+                                  + std::to_string(num_cols_) + " values, found "
+                                  + std::to_string(state.size()));
+    }
+    rows_.insert(rows_.end(), state.begin(), state.end());
+    if (rows_.size() >= rows_per_block_ * num_cols_) {
+      flush_rows();
+    }
+  }
+
+  /* Write an empty comment */
+  void operator()() override { write_comment(std::string()); }
+
+  /* Write a comment block */
+  void operator()(const std::string& message) override { write_comment(message); }
+
+private:
+  template <typename T>
+  void write_pod(const T& value) {
+    output_->write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  void write_padding(size_t n) {
+    static const char zeros[8] = {0};
+    output_->write(zeros, n);
+  }
+
+  void write_block_header(binary_format::block_type type, uint64_t count) {
+    write_pod(static_cast<uint32_t>(type));
+    write_pod(static_cast<uint32_t>(0));
+    write_pod(count);
+  }
+
+  void write_comment(const std::string& message) {
+    flush_rows();
+    write_block_header(binary_format::COMMENT, message.size());
+    output_->write(message.data(), message.size());
+    write_padding(binary_format::padding(message.size()));
+  }
+
+  /* Transpose the buffered rows and write them as one DRAWS block */
+  void flush_rows() {
+    if (rows_.empty()) {
+      return;
+    }
+    const size_t num_rows = rows_.size() / num_cols_;
+    columns_.resize(rows_.size());
+    for (size_t r = 0; r < num_rows; ++r) {
+      for (size_t c = 0; c < num_cols_; ++c) {
+        columns_[c * num_rows + r] = rows_[r * num_cols_ + c];
+      }
+    }
+    write_block_header(binary_format::DRAWS, num_rows);
+    output_->write(reinterpret_cast<const char*>(columns_.data()),
+                   columns_.size() * sizeof(double));
+    rows_.clear();
+  }
+
+  std::unique_ptr<Stream, Deleter> output_;
+  size_t block_bytes_;
+  size_t num_cols_ = 0;
+  size_t rows_per_block_ = 1;
+  bool header_written_ = false;
+  std::vector<double> rows_;
+  std::vector<double> columns_;
+};
+
+}  // namespace stan3
+
+#endif  // STAN3_BINARY_WRITER_HPP
@@ -0,0 +1,281 @@
+#ifndef STAN3_CHAIN_AFFINITY_HPP
+#define STAN3_CHAIN_AFFINITY_HPP
+
+#include <stan3/parallel_chains.hpp>
+
+#include <tbb/global_control.h>
+#include <tbb/task_arena.h>
+#include <tbb/task_scheduler_observer.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace stan3 {
+
+/* Whether threads can be pinned to CPUs on this platform */
+inline constexpr bool affinity_supported() {
+#ifdef __linux__
+  return true;
+#else
+  return false;
+#endif
+}
+
+/* CPUs listed in a Linux cpulist string such as "0-3,8-11" */
+inline std::vector<int> parse_cpu_list(const std::string& list) {
+  std::vector<int> cpus;
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    try {
+      size_t dash = range.find('-');
+      int first = std::stoi(range.substr(0, dash));
+      int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+      for (int cpu = first; cpu <= last; ++cpu) {
+        cpus.push_back(cpu);
+      }
+    } catch (const std::exception&) {
+      // Blank or malformed entries name no CPU
+    }
+  }
+  return cpus;
+}
+
+/* NUMA node of each CPU, from /sys/devices/system/node; CPUs that are
+ * not listed there (or all, without NUMA information) are on node 0 */
+inline std::map<int, int> cpu_numa_nodes(
+    const std::filesystem::path& node_dir = "/sys/devices/system/node") {
+  std::map<int, int> nodes;
+  std::error_code ec;
+  for (const auto& entry : std::filesystem::directory_iterator(node_dir, ec)) {
+    std::string name = entry.path().filename().string();
+    if (name.size() <= 4 || name.compare(0, 4, "node") != 0
+        || name.find_first_not_of("0123456789", 4) != std::string::npos) {
+      continue;
+    }
+    std::ifstream file(entry.path() / "cpulist");
+    std::string list;
+    std::getline(file, list);
+    for (int cpu : parse_cpu_list(list)) {
+      nodes[cpu] = std::stoi(name.substr(4));
+    }
+  }
+  return nodes;
+}
+
+/* CPUs the process may run on, grouped by NUMA node and in increasing
+ * order within a node; empty where affinity is not supported */
+inline std::vector<int> available_cpus() {
+  std::vector<int> cpus;
+#ifdef __linux__
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  if (sched_getaffinity(0, sizeof(mask), &mask) != 0) {
+    return cpus;
+  }
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &mask)) {
+      cpus.push_back(cpu);
+    }
+  }
+  auto nodes = cpu_numa_nodes();
+  auto node = [&](int cpu) {
+    auto it = nodes.find(cpu);
+    return it == nodes.end() ? 0 : it->second;
+  };
+  std::stable_sort(cpus.begin(), cpus.end(),
+                   [&](int a, int b) { return node(a) < node(b); });
+#endif
+  return cpus;
+}
+
+/* CPUs of each of num_slots concurrently running chains: consecutive
+ * blocks of threads_per_chain CPUs, so that a chain stays on one NUMA
+ * node whenever its threads fit on one. With fewer CPUs than threads,
+ * the blocks wrap around and share CPUs.
+ *
+ * @param num_slots Number of concurrently running chains
+ * @param threads_per_chain Threads of each chain
+ * @param cpus Available CPUs, as returned by available_cpus()
+ * @return One CPU set per slot; all empty if cpus is empty
+ */
+inline std::vector<std::vector<int>> chain_core_sets(size_t num_slots,
+                                                     unsigned int threads_per_chain,
+                                                     const std::vector<int>& cpus) {
+  std::vector<std::vector<int>> core_sets(num_slots);
+  if (cpus.empty()) {
+    return core_sets;
+  }
+  size_t block = std::max(1u, threads_per_chain);
+  for (size_t slot = 0; slot < num_slots; ++slot) {
+    for (size_t k = 0; k < std::min(block, cpus.size()); ++k) {
+      core_sets[slot].push_back(cpus[(slot * block + k) % cpus.size()]);
+    }
+  }
+  return core_sets;
+}
+
+/**
+ * Observer that pins every thread entering a task arena to a set of
+ * CPUs, the calling thread of execute() included, and restores the
+ * thread's previous affinity when it leaves.
+ *
+ * Without affinity support it does nothing.
+ */
+class cpu_pinning_observer : public tbb::task_scheduler_observer {
+public:
+  cpu_pinning_observer(tbb::task_arena& arena, std::vector<int> cpus)
+    : tbb::task_scheduler_observer(arena), cpus_(std::move(cpus)) {
+    observe(true);
+  }
+
+  ~cpu_pinning_observer() override { observe(false); }
+
+  void on_scheduler_entry(bool) override {
+#ifdef __linux__
+    cpu_set_t previous;
+    CPU_ZERO(&previous);
+    sched_getaffinity(0, sizeof(previous), &previous);
+    saved_masks().push_back(previous);
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (int cpu : cpus_) {
+      CPU_SET(cpu, &mask);
+    }
+    sched_setaffinity(0, sizeof(mask), &mask);
+#endif
+  }
+
+  void on_scheduler_exit(bool) override {
+#ifdef __linux__
+    auto& masks = saved_masks();
+    if (!masks.empty()) {
+      sched_setaffinity(0, sizeof(masks.back()), &masks.back());
+      masks.pop_back();
+    }
+#endif
+  }
+
+private:
+#ifdef __linux__
+  /* Affinity of the calling thread before each arena it is in */
+  static std::vector<cpu_set_t>& saved_masks() {
+    thread_local std::vector<cpu_set_t> masks;
+    return masks;
+  }
+#endif
+
+  std::vector<int> cpus_;
+};
+
+/**
+ * Placement of a run's chains on threads and cores.
+ *
+ * The thread budget is split as by allocate_threads(). With affinity,
+ * each chain runs in a task arena of its own pinned to the core set of
+ * its slot, chain index modulo the number of concurrently running
+ * chains; memory a chain first touches there, such as its sampler state
+ * and metric, is then placed on that core set's NUMA node by the
+ * operating system. run_chains() then runs the chains in waves of one
+ * chain per slot, so that no two chains run on the same core set at
+ * once. Without affinity, chains run as by run_in_chain_arena().
+ */
+class chain_placement {
+public:
+  /**
+   * @param num_chains Number of chains
+   * @param num_threads Maximum number of threads of all chains together
+   * @param threads_per_chain Threads of each chain, 0 for an even split
+   * @param affinity Pin each chain to a core set?
+   */
+  chain_placement(size_t num_chains, unsigned int num_threads,
+                  unsigned int threads_per_chain, bool affinity)
+    : threads_(allocate_threads(num_chains, num_threads, threads_per_chain)) {
+    if (affinity) {
+      core_sets_ = chain_core_sets(threads_.parallel_chains, threads_.threads_per_chain,
+                                   available_cpus());
+    }
+  }
+
+  const thread_allocation& threads() const { return threads_; }
+
+  /* Whether chains are pinned to core sets */
+  bool pinned() const { return !core_sets_.empty() && !core_sets_.front().empty(); }
+
+  /* Whether run_chains() runs all num_chains chains at the same time:
+   * they fit the concurrently running chains, TBB's thread limit and, if
+   * pinned, one wave, and no shared_pool_scope leaves their scheduling to
+   * a shared pool */
+  bool runs_all_at_once(size_t num_chains) const {
+    if (num_chains <= 1) {
+      return true;
+    }
+    return threads_.parallel_chains >= num_chains
+           && tbb::global_control::active_value(
+                tbb::global_control::max_allowed_parallelism) >= num_chains
+           && (!pinned() || core_sets_.size() >= num_chains)
+           && !shared_pool_scope::active();
+  }
+
+  /* CPUs of a chain (0-based index); empty if chains are not pinned */
+  std::vector<int> cores(size_t chain_idx) const {
+    return pinned() ? core_sets_[chain_idx % core_sets_.size()] : std::vector<int>();
+  }
+
+  /* Run f() as the work of a chain (0-based index), on its threads and cores */
+  template <typename F>
+  void run(size_t chain_idx, F&& f) const {
+    if (!pinned()) {
+      run_in_chain_arena(threads_.threads_per_chain, f);
+      return;
+    }
+    tbb::task_arena arena(static_cast<int>(threads_.threads_per_chain));
+    arena.initialize();
+    cpu_pinning_observer observer(arena, cores(chain_idx));
+    arena.execute(f);
+  }
+
+  /* Run task(i) for each chain index i in [0, num_chains), as by
+   * run_chains_parallel() with the concurrently running chains; pinned
+   * chains run in waves of one chain per core set, the next wave
+   * starting once the whole wave has finished
+   *
+   * @return One exception_ptr per chain, null for chains that succeeded
+   */
+  template <typename F>
+  std::vector<std::exception_ptr> run_chains(size_t num_chains, F&& task) const {
+    if (!pinned()) {
+      return run_chains_parallel(num_chains, threads_.parallel_chains, task);
+    }
+    std::vector<std::exception_ptr> errors(num_chains);
+    const size_t wave_size = core_sets_.size();
+    for (size_t first = 0; first < num_chains; first += wave_size) {
+      size_t n = std::min(wave_size, num_chains - first);
+      auto wave_errors = run_chains_parallel(n, static_cast<unsigned int>(n),
+                                             [&](size_t k) { task(first + k); });
+      std::move(wave_errors.begin(), wave_errors.end(), errors.begin() + first);
+    }
+    return errors;
+  }
+
+private:
+  thread_allocation threads_;
+  std::vector<std::vector<int>> core_sets_;
+};
+
+}  // namespace stan3
+
+#endif  // STAN3_CHAIN_AFFINITY_HPP
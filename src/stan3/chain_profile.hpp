@@ -0,0 +1,246 @@
+#ifndef STAN3_CHAIN_PROFILE_HPP
+#define STAN3_CHAIN_PROFILE_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/structured_writer.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/mcmc/sample.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace stan3 {
+
+/* Wall-clock seconds elapsed since a steady_clock time point */
+inline double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/* Peak resident set size of the process so far in bytes, 0 if unknown */
+inline size_t peak_rss_bytes() {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+    return counters.PeakWorkingSetSize;
+  }
+  return 0;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+#ifdef __APPLE__
+  return static_cast<size_t>(usage.ru_maxrss);
+#else
+  return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+/**
+ * Timing and sampler statistics for one chain.
+ *
+ * Warmup and sampling times cover the sampler transitions only; time spent
+ * in the sample and diagnostic writers is reported separately, and the
+ * total covers the whole run of the chain after initialization.
+ * 
+ * Memory is that of the chain's sampler state: its phase space point,
+ * inverse metric and adaptation estimator, but not a metric shared with
+ * other chains nor the model.
+ */
+struct chain_profile {
+  double init_seconds = 0;
+  double warmup_seconds = 0;
+  double sampling_seconds = 0;
+  double writer_seconds = 0;
+  double total_seconds = 0;
+  size_t warmup_iterations = 0;
+  size_t sampling_iterations = 0;
+  size_t warmup_leapfrogs = 0;
+  size_t sampling_leapfrogs = 0;
+  size_t divergences = 0;
+  size_t memory_bytes = 0;
+  // Number of transitions that reached each tree depth, indexed by depth
+  std::vector<size_t> tree_depth_counts;
+
+  /* Record one transition of the sampler */
+  void record_transition(bool warmup, int depth, int n_leapfrog, bool divergent,
+                         double seconds) {
+    if (warmup) {
+      ++warmup_iterations;
+      warmup_leapfrogs += n_leapfrog;
+      warmup_seconds += seconds;
+    } else {
+      ++sampling_iterations;
+      sampling_leapfrogs += n_leapfrog;
+      sampling_seconds += seconds;
+    }
+    divergences += divergent;
+    size_t d = depth < 0 ? 0 : depth;
+    if (tree_depth_counts.size() <= d) {
+      tree_depth_counts.resize(d + 1, 0);
+    }
+    ++tree_depth_counts[d];
+  }
+
+  /* Each NUTS leapfrog step evaluates the log density gradient once */
+  size_t gradient_evaluations() const {
+    return warmup_leapfrogs + sampling_leapfrogs;
+  }
+};
+
+/**
+ * NUTS sampler that records a chain_profile of its transitions.
+ *
+ * The overhead is two clock reads per transition, so every sampler built
+ * by load_samplers carries its profile; it is only written out when
+ * requested.
+ *
+ * @tparam Sampler Adaptive NUTS sampler type
+ */
+template <typename Sampler>
+class instrumented_sampler : public Sampler {
+public:
+  using Sampler::Sampler;
+
+  stan::mcmc::sample transition(stan::mcmc::sample& init_sample,
+                                stan::callbacks::logger& logger) override {
+    bool warmup = this->adapting();
+    auto start = std::chrono::steady_clock::now();
+    stan::mcmc::sample s = Sampler::transition(init_sample, logger);
+    profile_.record_transition(warmup, this->depth_, this->n_leapfrog_,
+                               this->divergent_, seconds_since(start));
+    return s;
+  }
+
+  chain_profile& profile() { return profile_; }
+  const chain_profile& profile() const { return profile_; }
+
+private:
+  chain_profile profile_;
+};
+
+/**
+ * Writer that forwards to another writer and adds the time spent in each
+ * call to a running total. Does not own the wrapped writer.
+ */
+class timed_writer : public stan::callbacks::writer {
+public:
+  /**
+   * @param writer Writer to forward to
+   * @param seconds Running total, incremented by every call
+   */
+  timed_writer(stan::callbacks::writer& writer, double& seconds)
+    : writer_(writer), seconds_(seconds) {}
+
+  void operator()(const std::vector<std::string>& names) override {
+    auto start = std::chrono::steady_clock::now();
+    writer_(names);
+    seconds_ += seconds_since(start);
+  }
+
+  void operator()(const std::vector<double>& state) override {
+    auto start = std::chrono::steady_clock::now();
+    writer_(state);
+    seconds_ += seconds_since(start);
+  }
+
+  void operator()() override {
+    auto start = std::chrono::steady_clock::now();
+    writer_();
+    seconds_ += seconds_since(start);
+  }
+
+  void operator()(const std::string& message) override {
+    auto start = std::chrono::steady_clock::now();
+    writer_(message);
+    seconds_ += seconds_since(start);
+  }
+
+private:
+  stan::callbacks::writer& writer_;
+  double& seconds_;
+};
+
+/* Write the fields of a profile into the current record */
+inline void write_profile_fields(stan::callbacks::structured_writer& writer,
+                                 const chain_profile& profile) {
+  writer.write("init_seconds", profile.init_seconds);
+  writer.write("warmup_seconds", profile.warmup_seconds);
+  writer.write("sampling_seconds", profile.sampling_seconds);
+  writer.write("writer_seconds", profile.writer_seconds);
+  writer.write("total_seconds", profile.total_seconds);
+  writer.write("warmup_iterations", profile.warmup_iterations);
+  writer.write("sampling_iterations", profile.sampling_iterations);
+  writer.write("warmup_leapfrogs", profile.warmup_leapfrogs);
+  writer.write("sampling_leapfrogs", profile.sampling_leapfrogs);
+  writer.write("gradient_evaluations", profile.gradient_evaluations());
+  writer.write("divergences", profile.divergences);
+  writer.write("memory_bytes", profile.memory_bytes);
+  writer.begin_record("tree_depth_counts");
+  for (size_t d = 0; d < profile.tree_depth_counts.size(); ++d) {
+    writer.write(std::to_string(d), profile.tree_depth_counts[d]);
+  }
+  writer.end_record();
+}
+
+/**
+ * Write per-chain profiles as one JSON object: a "chain_<n>" record per
+ * chain followed by an "all_chains" record with the sums across chains,
+ * and the peak resident memory of the process.
+ *
+ * @param writer Structured writer for the profile file
+ * @param model_name Name of the Stan model
+ * @param profiles Profiles, one per chain
+ */
+inline void write_profiles(stan::callbacks::structured_writer& writer,
+                           const std::string& model_name,
+                           const std::vector<chain_profile>& profiles) {
+  chain_profile all;
+  for (const auto& p : profiles) {
+    all.init_seconds += p.init_seconds;
+    all.warmup_seconds += p.warmup_seconds;
+    all.sampling_seconds += p.sampling_seconds;
+    all.writer_seconds += p.writer_seconds;
+    all.total_seconds += p.total_seconds;
+    all.warmup_iterations += p.warmup_iterations;
+    all.sampling_iterations += p.sampling_iterations;
+    all.warmup_leapfrogs += p.warmup_leapfrogs;
+    all.sampling_leapfrogs += p.sampling_leapfrogs;
+    all.divergences += p.divergences;
+    all.memory_bytes += p.memory_bytes;
+    if (all.tree_depth_counts.size() < p.tree_depth_counts.size()) {
+      all.tree_depth_counts.resize(p.tree_depth_counts.size(), 0);
+    }
+    for (size_t d = 0; d < p.tree_depth_counts.size(); ++d) {
+      all.tree_depth_counts[d] += p.tree_depth_counts[d];
+    }
+  }
+
+  writer.begin_record();
+  writer.write("model_name", model_name);
+  writer.write("num_chains", profiles.size());
+  writer.write("peak_rss_bytes", peak_rss_bytes());
+  for (size_t i = 0; i < profiles.size(); ++i) {
+    writer.begin_record("chain_" + std::to_string(i + 1));
+    write_profile_fields(writer, profiles[i]);
+    writer.end_record();
+  }
+  writer.begin_record("all_chains");
+  write_profile_fields(writer, all);
+  writer.end_record();
+  writer.end_record();
+}
+
+}  // namespace stan3
+
+#endif  // STAN3_CHAIN_PROFILE_HPP
@@ -0,0 +1,274 @@
+#ifndef STAN3_CROSS_CHAIN_WARMUP_HPP
+#define STAN3_CROSS_CHAIN_WARMUP_HPP
+
+#include <stan3/metric_type.hpp>
+#include <stan3/parallel_chains.hpp>
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/mcmc/sample.hpp>
+
+#include <Eigen/Dense>
+
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace stan3 {
+
+/**
+ * Running moments of the adaptation window draws of one chain (Welford),
+ * mergeable across chains.
+ *
+ * m2 holds the summed squared deviations from the mean: as a single
+ * column for a diagonal metric, as the full matrix for a dense one.
+ */
+struct window_moments {
+  bool dense = false;
+  double n = 0;
+  Eigen::VectorXd mean;
+  Eigen::MatrixXd m2;
+
+  void add(const Eigen::VectorXd& q) {
+    if (n == 0) {
+      mean = Eigen::VectorXd::Zero(q.size());
+      m2 = Eigen::MatrixXd::Zero(q.size(), dense ? q.size() : 1);
+    }
+    n += 1;
+    Eigen::VectorXd delta = q - mean;
+    mean += delta / n;
+    if (dense) {
+      m2 += (q - mean) * delta.transpose();
+    } else {
+      m2.col(0) += delta.cwiseProduct(q - mean);
+    }
+  }
+
+  /* Combine with the moments of another chain (Chan et al.) */
+  void merge(const window_moments& other) {
+    if (other.n == 0) {
+      return;
+    }
+    if (n == 0) {
+      *this = other;
+      return;
+    }
+    double total = n + other.n;
+    Eigen::VectorXd delta = other.mean - mean;
+    double weight = n * other.n / total;
+    if (dense) {
+      m2 += other.m2 + weight * delta * delta.transpose();
+    } else {
+      m2.col(0) += other.m2.col(0) + weight * delta.cwiseProduct(delta);
+    }
+    mean += delta * (other.n / total);
+    n = total;
+  }
+
+  /* Sample (co)variance shrunk towards 1e-3 times the identity, the
+   * regularization Stan's windowed adaptation applies to one chain */
+  Eigen::MatrixXd regularized_variance() const {
+    Eigen::MatrixXd var = m2 / (n - 1);
+    var *= n / (n + 5.0);
+    double shrinkage = 1e-3 * (5.0 / (n + 5.0));
+    if (dense) {
+      var.diagonal().array() += shrinkage;
+    } else {
+      var.array() += shrinkage;
+    }
+    return var;
+  }
+};
+
+/**
+ * Meeting point of the chains of a cross-chain warmup.
+ *
+ * Each pool_* call blocks until every chain has made the same call, then
+ * returns the same pooled value to all of them, so all chains must run
+ * concurrently. A chain that stops early must call cancel(); chains
+ * waiting for it, or arriving later, then unwind with chain_interrupted.
+ */
+class cross_chain_adapter {
+public:
+  explicit cross_chain_adapter(size_t num_chains)
+    : num_chains_(num_chains), moments_(num_chains), stepsizes_(num_chains) {}
+
+  cross_chain_adapter(const cross_chain_adapter&) = delete;
+  cross_chain_adapter& operator=(const cross_chain_adapter&) = delete;
+
+  size_t num_chains() const { return num_chains_; }
+
+  /* Pool the window moments of all chains
+   *
+   * @param chain Chain index (0-based)
+   * @param moments Moments of the calling chain's window
+   * @return Moments of the draws of all chains' windows
+   * @throws chain_interrupted if the warmup was cancelled
+   */
+  window_moments pool_moments(size_t chain, const window_moments& moments) {
+    moments_[chain] = moments;
+    wait_for_all();
+    window_moments pooled = moments_[0];
+    for (size_t i = 1; i < num_chains_; ++i) {
+      pooled.merge(moments_[i]);
+    }
+    wait_for_all();
+    return pooled;
+  }
+
+  /* Pool the step sizes of all chains
+   *
+   * @param chain Chain index (0-based)
+   * @param stepsize Step size of the calling chain
+   * @return Geometric mean of the step sizes of all chains
+   * @throws chain_interrupted if the warmup was cancelled
+   */
+  double pool_stepsize(size_t chain, double stepsize) {
+    stepsizes_[chain] = stepsize;
+    wait_for_all();
+    double log_sum = 0;
+    for (double e : stepsizes_) {
+      log_sum += std::log(e);
+    }
+    wait_for_all();
+    return std::exp(log_sum / num_chains_);
+  }
+
+  /* Release all waiting chains; every later pool_* call throws */
+  void cancel() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancelled_ = true;
+    all_arrived_.notify_all();
+  }
+
+private:
+  void wait_for_all() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (cancelled_) {
+      throw chain_interrupted();
+    }
+    size_t generation = generation_;
+    if (++arrived_ == num_chains_) {
+      arrived_ = 0;
+      ++generation_;
+      all_arrived_.notify_all();
+      return;
+    }
+    all_arrived_.wait(lock, [&] { return generation_ != generation || cancelled_; });
+    if (generation_ == generation) {
+      throw chain_interrupted();
+    }
+  }
+
+  const size_t num_chains_;
+  std::vector<window_moments> moments_;
+  std::vector<double> stepsizes_;
+  std::mutex mutex_;
+  std::condition_variable all_arrived_;
+  size_t arrived_ = 0;
+  size_t generation_ = 0;
+  bool cancelled_ = false;
+};
+
+/**
+ * Adaptive NUTS sampler that can adapt together with the other chains of
+ * a run.
+ *
+ * Without a cross_chain_adapter it is the wrapped sampler. With one, at
+ * every adaptation window boundary the chains pool the draws of their
+ * windows into a single inverse metric (DIAG_E and DENSE_E), restart
+ * step size adaptation from a shared step size, and at the end of warmup
+ * they share the geometric mean of their adapted step sizes, so all
+ * chains sample with the same metric and step size.
+ *
+ * @tparam Sampler Adaptive NUTS sampler type
+ * @tparam MetricType Metric of the sampler
+ */
+template <typename Sampler, metric_t MetricType>
+class cross_chain_sampler : public Sampler {
+public:
+  using Sampler::Sampler;
+
+  /* Adapt together with the other chains sharing the adapter
+   *
+   * @param adapter Adapter shared by all chains of the run
+   * @param chain Index of this chain (0-based)
+   */
+  void set_cross_chain_adapter(std::shared_ptr<cross_chain_adapter> adapter, size_t chain) {
+    adapter_ = std::move(adapter);
+    chain_ = chain;
+  }
+
+  /* Release the other chains from waiting for this one */
+  void cancel_cross_chain_warmup() {
+    if (adapter_) {
+      adapter_->cancel();
+    }
+  }
+
+  stan::mcmc::sample transition(stan::mcmc::sample& init_sample,
+                                stan::callbacks::logger& logger) override {
+    if constexpr (MetricType == metric_t::UNIT_E) {
+      return Sampler::transition(init_sample, logger);
+    } else {
+      if (!adapter_ || !this->adapting()) {
+        return Sampler::transition(init_sample, logger);
+      }
+      // The window schedule is the same for every chain; the wrapped
+      // sampler updates its own metric at a boundary, which is replaced
+      // here by the pooled one
+      auto& windows = window_adaptation();
+      bool in_window = windows.adaptation_window();
+      bool window_end = windows.end_adaptation_window();
+      stan::mcmc::sample s = Sampler::transition(init_sample, logger);
+      if (in_window) {
+        moments_.add(this->z().q);
+      }
+      if (window_end) {
+        window_moments pooled = adapter_->pool_moments(chain_, moments_);
+        moments_ = window_moments{MetricType == metric_t::DENSE_E};
+        Eigen::MatrixXd inv_metric = pooled.regularized_variance();
+        if constexpr (MetricType == metric_t::DENSE_E) {
+          this->set_metric(inv_metric);
+        } else {
+          this->set_metric(Eigen::VectorXd(inv_metric.col(0)));
+        }
+        this->init_stepsize(logger);
+        double stepsize = adapter_->pool_stepsize(chain_, this->get_nominal_stepsize());
+        this->set_nominal_stepsize(stepsize);
+        this->get_stepsize_adaptation().set_mu(std::log(10 * stepsize));
+        this->get_stepsize_adaptation().restart();
+      }
+      return s;
+    }
+  }
+
+  /* End adaptation; with an adapter, every chain then takes the pooled
+   * step size */
+  void disengage_adaptation() override {
+    Sampler::disengage_adaptation();
+    if (adapter_) {
+      this->set_nominal_stepsize(
+        adapter_->pool_stepsize(chain_, this->get_nominal_stepsize()));
+    }
+  }
+
+private:
+  auto& window_adaptation() {
+    if constexpr (MetricType == metric_t::DENSE_E) {
+      return this->covar_adaptation_;
+    } else {
+      return this->var_adaptation_;
+    }
+  }
+
+  std::shared_ptr<cross_chain_adapter> adapter_;
+  size_t chain_ = 0;
+  window_moments moments_{MetricType == metric_t::DENSE_E};
+};
+
+}  // namespace stan3
+
+#endif  // STAN3_CROSS_CHAIN_WARMUP_HPP
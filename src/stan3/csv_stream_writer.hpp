@@ -0,0 +1,140 @@
+#ifndef STAN3_CSV_STREAM_WRITER_HPP
+#define STAN3_CSV_STREAM_WRITER_HPP
+
+#include <stan/callbacks/writer.hpp>
+
+#include <charconv>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan3 {
+
+/**
+ * CSV writer for draws files that formats without iostreams.
+ *
+ * It writes the same rows, comments and header as
+ * stan::callbacks::unique_stream_writer, but each double is formatted
+ * with std::to_chars as its shortest representation that reads back to
+ * the same value, independent of the locale. Rows are appended to a
+ * reusable byte buffer that is handed to the stream in one write() call
+ * whenever it holds about buffer_bytes bytes, and when the writer is
+ * destroyed; lines are not flushed one by one. The buffer is allocated
+ * by the first write, on the thread of the chain writing the file.
+ *
+ * @tparam Stream Output stream type
+ * @tparam Deleter Deleter for the stream
+ */
+template <typename Stream, typename Deleter = std::default_delete<Stream>>
+class csv_stream_writer : public stan::callbacks::writer {
+public:
+  /**
+   * @param output Stream to write to
+   * @param comment_prefix Prefix of comment lines
+   * @param buffer_bytes Number of buffered bytes that triggers a write
+   */
+  explicit csv_stream_writer(std::unique_ptr<Stream, Deleter>&& output,
+                             const std::string& comment_prefix = "",
+                             size_t buffer_bytes = 1 << 16)
+    : output_(std::move(output)), comment_prefix_(comment_prefix),
+      buffer_bytes_(buffer_bytes == 0 ? 1 : buffer_bytes) {
+    if (!output_) {
+      throw std::invalid_argument("csv_stream_writer: output stream is null");
+    }
+  }
+
+  csv_stream_writer(csv_stream_writer&&) = default;
+
+  ~csv_stream_writer() override {
+    if (output_) {
+      write_buffer();
+      output_->flush();
+    }
+  }
+
+  void operator()(const std::vector<std::string>& names) override {
+    if (names.empty()) {
+      return;
+    }
+    for (size_t i = 0; i < names.size(); ++i) {
+      append(names[i].data(), names[i].size());
+      append(i + 1 < names.size() ? ',' : '\n');
+    }
+  }
+
+  void operator()(const std::vector<double>& state) override {
+    if (state.empty()) {
+      return;
+    }
+    for (size_t i = 0; i < state.size(); ++i) {
+      reserve(max_value_chars);
+      char* end = std::to_chars(buffer_.data() + size_,
+                                buffer_.data() + buffer_.size(), state[i]).ptr;
+      size_ = end - buffer_.data();
+      buffer_[size_++] = i + 1 < state.size() ? ',' : '\n';
+    }
+  }
+
+  void operator()() override {
+    append(comment_prefix_.data(), comment_prefix_.size());
+    append('\n');
+  }
+
+  void operator()(const std::string& message) override {
+    append(comment_prefix_.data(), comment_prefix_.size());
+    append(message.data(), message.size());
+    append('\n');
+  }
+
+  /* Hand the buffered bytes to the stream and flush it */
+  void flush() {
+    write_buffer();
+    output_->flush();
+  }
+
+private:
+  // Longest shortest-representation double, "-2.2250738585072014e-308",
+  // plus a separator, rounded up
+  static constexpr size_t max_value_chars = 32;
+
+  /* Make room for n more bytes, writing the buffer once it holds more
+   * than buffer_bytes_ bytes */
+  void reserve(size_t n) {
+    if (buffer_.empty()) {
+      buffer_.resize(buffer_bytes_ + max_value_chars);
+    }
+    if (size_ + n > buffer_.size()) {
+      write_buffer();
+      if (n > buffer_.size()) {
+        buffer_.resize(n);
+      }
+    }
+  }
+
+  void append(const char* data, size_t n) {
+    reserve(n);
+    std::memcpy(buffer_.data() + size_, data, n);
+    size_ += n;
+  }
+
+  void append(char c) { append(&c, 1); }
+
+  void write_buffer() {
+    if (size_ > 0) {
+      output_->write(buffer_.data(), static_cast<std::streamsize>(size_));
+      size_ = 0;
+    }
+  }
+
+  std::unique_ptr<Stream, Deleter> output_;
+  std::string comment_prefix_;
+  size_t buffer_bytes_;
+  std::vector<char> buffer_;
+  size_t size_ = 0;
+};
+
+}  // namespace stan3
+
+#endif  // STAN3_CSV_STREAM_WRITER_HPP
@@ -0,0 +1,115 @@
+#ifndef STAN3_DATA_CACHE_HPP
+#define STAN3_DATA_CACHE_HPP
+
+#include <stan3/read_data.hpp>
+#include <stan/io/empty_var_context.hpp>
+#include <stan/io/var_context.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace stan3 {
+
+/**
+ * Cache of parsed data files.
+ *
+ * Entries are keyed by absolute path and remember the file's modification
+ * time and size; a lookup whose file has changed since it was parsed
+ * reads the file again. Entries stay until evicted or the cache is
+ * cleared, so repeated loads of the same data skip parsing.
+ *
+ * All member functions are safe to call concurrently.
+ */
+class data_cache {
+public:
+  /* Get the parsed contents of a data file, reading it on a miss
+   *
+   * @param filename Path to the data file, empty for no data
+   * @return Shared data context
+   * @throws std::runtime_error if the file cannot be read
+   */
+  std::shared_ptr<const stan::io::var_context> get(const std::string& filename) {
+    if (filename.empty()) {
+      return std::make_shared<stan::io::empty_var_context>();
+    }
+    std::string key = make_key(filename);
+    file_stamp stamp = stamp_of(filename);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = entries_.find(key);
+      if (it != entries_.end() && it->second.stamp == stamp) {
+        return it->second.context;
+      }
+    }
+    // Parse outside the lock so that other files can be served meanwhile
+    std::shared_ptr<const stan::io::var_context> context = read_data(filename);
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[key] = entry{stamp, context};
+    return context;
+  }
+
+  /* Remove the entry for a data file
+   *
+   * @param filename Path to the data file
+   * @return true if an entry was removed
+   */
+  bool evict(const std::string& filename) {
+    std::string key = make_key(filename);
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.erase(key) > 0;
+  }
+
+  /* Remove all entries */
+  void clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+  }
+
+  /* Number of cached data files */
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+  }
+
+private:
+  struct file_stamp {
+    std::filesystem::file_time_type mtime;
+    std::uintmax_t size;
+
+    bool operator==(const file_stamp& other) const {
+      return mtime == other.mtime && size == other.size;
+    }
+  };
+
+  struct entry {
+    file_stamp stamp;
+    std::shared_ptr<const stan::io::var_context> context;
+  };
+
+  static std::string make_key(const std::string& filename) {
+    std::error_code ec;
+    auto path = std::filesystem::absolute(filename, ec);
+    return ec ? filename : path.lexically_normal().string();
+  }
+
+  /* Missing or unreadable files get an empty stamp; read_data reports the error */
+  static file_stamp stamp_of(const std::string& filename) {
+    std::error_code ec;
+    file_stamp stamp{std::filesystem::last_write_time(filename, ec), 0};
+    if (!ec) {
+      stamp.size = std::filesystem::file_size(filename, ec);
+    }
+    return stamp;
+  }
+
+  std::map<std::string, entry> entries_;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace stan3
+
+#endif  // STAN3_DATA_CACHE_HPP
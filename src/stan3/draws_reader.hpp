@@ -0,0 +1,248 @@
+#ifndef STAN3_DRAWS_READER_HPP
+#define STAN3_DRAWS_READER_HPP
+
+#include <stan3/binary_writer.hpp>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan3 {
+
+/**
+ * Streaming reader for a draws file: the column names, then one draw at
+ * a time, so the file is never held in memory as a whole.
+ */
+class draws_reader {
+public:
+  virtual ~draws_reader() = default;
+
+  /* Column names from the header */
+  const std::vector<std::string>& column_names() const { return names_; }
+
+  /* Read the next draw
+   *
+   * @param draw Values of the draw, one per column
+   * @return false once there are no more draws
+   * @throws std::runtime_error if the file is malformed
+   */
+  virtual bool next(std::vector<double>& draw) = 0;
+
+  /* Number of draws read so far */
+  size_t num_draws() const { return num_draws_; }
+
+protected:
+  std::vector<std::string> names_;
+  size_t num_draws_ = 0;
+};
+
+/**
+ * Streaming reader for a Stan CSV draws file.
+ *
+ * Comment lines (starting with '#') and blank lines are skipped; the first
+ * other line is the header of column names and every following line is
+ * one draw.
+ */
+class csv_draws_reader : public draws_reader {
+public:
+  /**
+   * @param filename Path to the CSV file
+   * @throws std::runtime_error if the file cannot be opened or has no header
+   */
+  explicit csv_draws_reader(const std::string& filename)
+    : filename_(filename), in_(filename) {
+    if (!in_) {
+      throw std::runtime_error("Cannot open draws file: " + filename);
+    }
+    std::string line;
+    if (!next_line(line)) {
+      throw std::runtime_error("Draws file has no header: " + filename);
+    }
+    size_t start = 0;
+    while (true) {
+      size_t end = line.find(',', start);
+      names_.push_back(line.substr(start, end - start));
+      if (end == std::string::npos) {
+        break;
+      }
+      start = end + 1;
+    }
+  }
+
+  bool next(std::vector<double>& draw) override {
+    std::string line;
+    if (!next_line(line)) {
+      return false;
+    }
+    draw.resize(names_.size());
+    const char* p = line.c_str();
+    for (size_t j = 0; j < names_.size(); ++j) {
+      char* end;
+      errno = 0;
+      draw[j] = std::strtod(p, &end);
+      bool last = j + 1 == names_.size();
+      if (end == p || (last ? *end != '\0' : *end != ',')) {
+        throw std::runtime_error("Malformed draw " + std::to_string(num_draws_ + 1)
+                                 + " in " + filename_);
+      }
+      p = end + 1;
+    }
+    ++num_draws_;
+    return true;
+  }
+
+private:
+  bool next_line(std::string& line) {
+    while (std::getline(in_, line)) {
+      if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+      }
+      if (!line.empty() && line[0] != '#') {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::string filename_;
+  std::ifstream in_;
+};
+
+/**
+ * Streaming reader for the binary columnar draws format written by
+ * binary_stream_writer (see binary_format).
+ *
+ * One DRAWS block is held at a time; COMMENT blocks are skipped.
+ */
+class binary_draws_reader : public draws_reader {
+public:
+  /**
+   * @param filename Path to the binary draws file
+   * @throws std::runtime_error if the file cannot be opened, is not in the
+   *   binary draws format, or was written with a different byte order
+   */
+  explicit binary_draws_reader(const std::string& filename)
+    : filename_(filename), in_(filename, std::ios::binary) {
+    if (!in_) {
+      throw std::runtime_error("Cannot open draws file: " + filename);
+    }
+    char magic[sizeof(binary_format::magic)];
+    in_.read(magic, sizeof(magic));
+    if (!in_ || std::memcmp(magic, binary_format::magic, sizeof(magic)) != 0) {
+      throw std::runtime_error("File is not in the binary draws format: " + filename);
+    }
+    if (read_pod<uint32_t>() != binary_format::byte_order_mark) {
+      throw std::runtime_error("Draws file was written with a different byte order: "
+                               + filename);
+    }
+    uint32_t version = read_pod<uint32_t>();
+    if (version != binary_format::version) {
+      throw std::runtime_error("Unsupported binary draws format version "
+                               + std::to_string(version) + ": " + filename);
+    }
+    uint64_t num_cols = read_pod<uint64_t>();
+    size_t bytes = sizeof(magic) + 2 * sizeof(uint32_t) + sizeof(uint64_t);
+    for (uint64_t c = 0; c < num_cols; ++c) {
+      uint64_t length = read_pod<uint64_t>();
+      std::string name(length, '\0');
+      in_.read(&name[0], length);
+      names_.push_back(std::move(name));
+      bytes += sizeof(uint64_t) + length;
+    }
+    in_.ignore(binary_format::padding(bytes));
+    if (!in_) {
+      throw std::runtime_error("Truncated header in draws file: " + filename);
+    }
+  }
+
+  bool next(std::vector<double>& draw) override {
+    while (row_ == block_rows_) {
+      if (!read_block()) {
+        return false;
+      }
+    }
+    const size_t num_cols = names_.size();
+    draw.resize(num_cols);
+    for (size_t c = 0; c < num_cols; ++c) {
+      draw[c] = block_[c * block_rows_ + row_];
+    }
+    ++row_;
+    ++num_draws_;
+    return true;
+  }
+
+private:
+  template <typename T>
+  T read_pod() {
+    T value{};
+    in_.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return value;
+  }
+
+  /* Read the next DRAWS block, skipping comments; false at end of file */
+  bool read_block() {
+    while (true) {
+      uint32_t type = read_pod<uint32_t>();
+      if (in_.eof()) {
+        return false;
+      }
+      read_pod<uint32_t>();
+      uint64_t count = read_pod<uint64_t>();
+      if (!in_) {
+        throw std::runtime_error("Truncated block in draws file: " + filename_);
+      }
+      if (type == binary_format::COMMENT) {
+        in_.ignore(count + binary_format::padding(count));
+        continue;
+      }
+      if (type != binary_format::DRAWS) {
+        throw std::runtime_error("Unknown block type " + std::to_string(type)
+                                 + " in draws file: " + filename_);
+      }
+      block_.resize(count * names_.size());
+      in_.read(reinterpret_cast<char*>(block_.data()), block_.size() * sizeof(double));
+      if (!in_) {
+        throw std::runtime_error("Truncated block in draws file: " + filename_);
+      }
+      block_rows_ = count;
+      row_ = 0;
+      return true;
+    }
+  }
+
+  std::string filename_;
+  std::ifstream in_;
+  std::vector<double> block_;
+  size_t block_rows_ = 0;
+  size_t row_ = 0;
+};
+
+/* Open a draws file with the reader for its format: binary draws files
+ * are recognized by their magic bytes, anything else is read as CSV
+ *
+ * @param filename Path to the draws file
+ * @return Reader positioned at the first draw
+ * @throws std::runtime_error if the file cannot be opened or read
+ */
+inline std::unique_ptr<draws_reader> open_draws_reader(const std::string& filename) {
+  std::ifstream in(filename, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("Cannot open draws file: " + filename);
+  }
+  char magic[sizeof(binary_format::magic)] = {0};
+  in.read(magic, sizeof(magic));
+  if (in && std::memcmp(magic, binary_format::magic, sizeof(magic)) == 0) {
+    return std::make_unique<binary_draws_reader>(filename);
+  }
+  return std::make_unique<csv_draws_reader>(filename);
+}
+
+}  // namespace stan3
+
+#endif  // STAN3_DRAWS_READER_HPP
@@ -0,0 +1,180 @@
+#ifndef STAN3_FILTERED_WRITER_HPP
+#define STAN3_FILTERED_WRITER_HPP
+
+#include <stan/callbacks/writer.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan3 {
+
+/* Variables written to a draws file; an empty include list keeps all */
+struct variable_filter {
+  std::vector<std::string> include;
+  std::vector<std::string> exclude;
+
+  bool empty() const { return include.empty() && exclude.empty(); }
+
+  /* Whether a column is written, given its name and its variable's name;
+   * a list entry may name either */
+  bool keeps(const std::string& column, const std::string& variable) const {
+    auto listed = [&](const std::vector<std::string>& names) {
+      return std::find(names.begin(), names.end(), variable) != names.end()
+             || std::find(names.begin(), names.end(), column) != names.end();
+    };
+    return (include.empty() || listed(include)) && !listed(exclude);
+  }
+};
+
+/* Name of the variable of a draws file column: the column name up to the
+ * first index ("theta.1.2") or tuple element ("x:1") separator */
+inline std::string column_variable(const std::string& column) {
+  return column.substr(0, column.find_first_of(".:"));
+}
+
+/* Whether a column holds a sampler quantity (lp__, stepsize__, ...) */
+inline bool is_sampler_column(const std::string& column) {
+  return column.size() > 2 && column.compare(column.size() - 2, 2, "__") == 0;
+}
+
+/* Check that every variable named by a filter is one of the columns —
+ * by column or variable name — or a sampler column
+ *
+ * @param filter Variables to keep
+ * @param columns Column names of the model's draws
+ * @throws std::invalid_argument listing the unknown names of each list
+ */
+inline void validate_variable_filter(const variable_filter& filter,
+                                     const std::vector<std::string>& columns) {
+  auto unknown = [&](const std::vector<std::string>& names) {
+    std::string list;
+    for (const auto& name : names) {
+      bool known = is_sampler_column(name)
+        || std::any_of(columns.begin(), columns.end(), [&](const std::string& column) {
+             return column == name || column_variable(column) == name;
+           });
+      if (!known) {
+        list += (list.empty() ? "" : ", ") + name;
+      }
+    }
+    return list;
+  };
+  std::string unknown_include = unknown(filter.include);
+  std::string unknown_exclude = unknown(filter.exclude);
+  if (!unknown_include.empty()) {
+    throw std::invalid_argument("Unknown variables in --output-vars: " + unknown_include);
+  }
+  if (!unknown_exclude.empty()) {
+    throw std::invalid_argument("Unknown variables in --exclude-vars: " + unknown_exclude);
+  }
+}
+
+/* Indices of the columns kept by a filter; sampler columns always are
+ *
+ * With diagnostics, the columns are those of a diagnostic file: the
+ * sampler columns, then the unconstrained parameters, their momenta and
+ * their gradients, so the momentum and gradient columns follow the
+ * filter's decision for the parameter at the same position.
+ *
+ * @param names Column names
+ * @param filter Variables to keep
+ * @param diagnostics Columns of a diagnostic file?
+ * @return Increasing indices of the kept columns
+ */
+inline std::vector<size_t> select_columns(const std::vector<std::string>& names,
+                                          const variable_filter& filter,
+                                          bool diagnostics) {
+  std::vector<size_t> model_columns;
+  for (size_t i = 0; i < names.size(); ++i) {
+    if (!is_sampler_column(names[i])) {
+      model_columns.push_back(i);
+    }
+  }
+  size_t block = model_columns.size();
+  if (diagnostics && block % 3 == 0) {
+    block /= 3;
+  }
+
+  std::vector<bool> keep(names.size(), true);
+  for (size_t j = 0; j < model_columns.size(); ++j) {
+    const std::string& name = names[model_columns[j % std::max<size_t>(block, 1)]];
+    keep[model_columns[j]] = filter.keeps(name, column_variable(name));
+  }
+  std::vector<size_t> columns;
+  for (size_t i = 0; i < names.size(); ++i) {
+    if (keep[i]) {
+      columns.push_back(i);
+    }
+  }
+  return columns;
+}
+
+/**
+ * Writer that forwards only the columns kept by a variable filter.
+ *
+ * The header selects the columns; each draw is then copied, column by
+ * column, into a reused buffer before it reaches the wrapped writer, so
+ * dropped columns are never formatted or written. Rows whose size differs
+ * from the header, and messages, are forwarded unchanged.
+ */
+class filtered_writer : public stan::callbacks::writer {
+public:
+  /**
+   * @param writer Writer receiving the kept columns
+   * @param filter Variables to keep
+   * @param diagnostics Is the writer that of a diagnostic file?
+   */
+  filtered_writer(std::unique_ptr<stan::callbacks::writer>&& writer,
+                  variable_filter filter, bool diagnostics = false)
+    : writer_(std::move(writer)), filter_(std::move(filter)),
+      diagnostics_(diagnostics) {
+    if (!writer_) {
+      throw std::invalid_argument("filtered_writer: wrapped writer is null");
+    }
+  }
+
+  void operator()(const std::vector<std::string>& names) override {
+    num_columns_ = names.size();
+    columns_ = select_columns(names, filter_, diagnostics_);
+    std::vector<std::string> kept;
+    kept.reserve(columns_.size());
+    for (size_t i : columns_) {
+      kept.push_back(names[i]);
+    }
+    (*writer_)(kept);
+    values_.resize(columns_.size());
+  }
+
+  void operator()(const std::vector<double>& state) override {
+    if (state.size() != num_columns_) {
+      (*writer_)(state);
+      return;
+    }
+    for (size_t j = 0; j < columns_.size(); ++j) {
+      values_[j] = state[columns_[j]];
+    }
+    (*writer_)(values_);
+  }
+
+  void operator()() override { (*writer_)(); }
+
+  void operator()(const std::string& message) override { (*writer_)(message); }
+
+  stan::callbacks::writer& get_writer() { return *writer_; }
+
+private:
+  std::unique_ptr<stan::callbacks::writer> writer_;
+  variable_filter filter_;
+  bool diagnostics_;
+  size_t num_columns_ = 0;
+  std::vector<size_t> columns_;
+  std::vector<double> values_;
+};
+
+}  // namespace stan3
+
+#endif  // STAN3_FILTERED_WRITER_HPP
@@ -1,9 +1,14 @@
 #ifndef STAN3_HMC_OUTPUT_WRITERS_HPP
 #define STAN3_HMC_OUTPUT_WRITERS_HPP
 
+#include <stan3/filtered_writer.hpp>
+#include <stan3/memory_writer.hpp>
 #include <stan3/output_writers.hpp>
+#include <stan3/output_format_type.hpp>
+#include <stan3/shared_output.hpp>
 #include <stan/callbacks/json_writer.hpp>
 #include <stan/callbacks/unique_stream_writer.hpp>
+#include <stan/callbacks/writer.hpp>
 
 #include <chrono>
 #include <filesystem>
@@ -19,36 +24,133 @@ namespace stan3 {
 
 /* Container for all output writers needed for a single HMC-NUTS chain */
 struct hmc_nuts_writers {
-  std::unique_ptr<csv_writer> sample_writer;
-  std::unique_ptr<csv_writer> start_params_writer;
-  std::unique_ptr<csv_writer> diagnostics_writer;
-  std::unique_ptr<json_writer> metric_writer;
+  std::unique_ptr<stan::callbacks::writer> sample_writer;
+  std::unique_ptr<stan::callbacks::writer> start_params_writer;
+  std::unique_ptr<stan::callbacks::writer> diagnostics_writer;
+  std::unique_ptr<stan::callbacks::structured_writer> metric_writer;
 };
 
-/* Create HMC-NUTS output writers for a single chain
+/* Variables of the sample and diagnostic files selected by the arguments */
+inline variable_filter output_variable_filter(const hmc_nuts_args& args) {
+  return {args.output_vars, args.exclude_vars};
+}
+
+/* Check the variables named by --output-vars and --exclude-vars against
+ * the model's parameters, transformed parameters and generated quantities
+ * 
+ * @throws std::invalid_argument listing the names the model does not have
+ */
+template <class Model>
+void validate_output_variables(const hmc_nuts_args& args, const Model& model) {
+  variable_filter filter = output_variable_filter(args);
+  if (filter.empty()) {
+    return;
+  }
+  std::vector<std::string> columns;
+  model.constrained_param_names(columns, true, true);
+  validate_variable_filter(filter, columns);
+}
+
+/* Wrap a draws writer so that it only receives the columns selected by
+ * --output-vars and --exclude-vars; without a selection it is returned
+ * as is
+ * 
+ * @param args HMC-NUTS arguments containing output configuration
+ * @param writer Writer of a sample or diagnostic file
+ * @param diagnostics Is it the writer of a diagnostic file?
+ * @return Writer of the selected columns
+ */
+inline std::unique_ptr<stan::callbacks::writer> filter_draws_writer(
+    const hmc_nuts_args& args, std::unique_ptr<stan::callbacks::writer>&& writer,
+    bool diagnostics) {
+  variable_filter filter = output_variable_filter(args);
+  if (filter.empty()) {
+    return std::move(writer);
+  }
+  return std::make_unique<filtered_writer>(std::move(writer), std::move(filter),
+                                           diagnostics);
+}
+
+/* Open a draws file in the requested output format, driven from a
+ * background thread when asynchronous output is requested and
+ * zstd-compressed when a compression level is set. Only the columns
+ * selected by --output-vars and --exclude-vars are formatted.
+ * 
+ * @param args HMC-NUTS arguments containing output configuration
+ * @param path Path of the file without its extension
+ * @param comment_prefix Comment prefix for CSV files
+ * @param diagnostics Is it a diagnostic file?
+ * @param async Write from a background thread if --async-output is set?
+ * @return Writer for the draws file
+ */
+inline std::unique_ptr<stan::callbacks::writer> open_draws_writer(
+    const hmc_nuts_args& args,
+    const std::string& path,
+    const std::string& comment_prefix,
+    bool diagnostics,
+    bool async = true) {
+  output_compression compression{args.compression_level, args.compression_threads};
+  std::string suffix = compression.enabled() ? ".zst" : "";
+  std::unique_ptr<stan::callbacks::writer> writer;
+  if (args.output_format == output_format_t::BINARY) {
+    if (async && args.async_output) {
+      writer = create_writer_impl<async_writer<binary_writer>>(
+          path + ".bin" + suffix, "", compression);
+    } else {
+      writer = create_writer_impl<binary_writer>(path + ".bin" + suffix, "", compression);
+    }
+  } else if (async && args.async_output) {
+    writer = create_writer_impl<async_writer<fast_csv_writer>>(
+        path + ".csv" + suffix, comment_prefix, compression);
+  } else {
+    writer = create_writer_impl<fast_csv_writer>(
+        path + ".csv" + suffix, comment_prefix, compression);
+  }
+  return filter_draws_writer(args, std::move(writer), diagnostics);
+}
+
+/* Create a writer for the per-iteration draws of one chain; see
+ * open_draws_writer
  * 
  * @param args HMC-NUTS arguments containing output configuration
  * @param model_name Name of the Stan model
  * @param timestamp Timestamp string
  * @param chain_id Chain number (1-indexed)
- * @param comment_prefix Optional comment prefix for CSV files
- * @return hmc_nuts_writers struct containing all writers for the chain
+ * @param data_type Type of data ("sample" or "param_grads")
+ * @param comment_prefix Comment prefix for CSV files
+ * @return Writer for the draws file
  */
-inline hmc_nuts_writers create_hmc_nuts_single_chain_writers(
+inline std::unique_ptr<stan::callbacks::writer> create_draws_writer(
     const hmc_nuts_args& args,
     const std::string& model_name,
     const std::string& timestamp,
     unsigned int chain_id,
-    const std::string& comment_prefix = "#") {
-    
-  hmc_nuts_writers writers;
-  
-  // Sample writer is always required
-  writers.sample_writer = create_writer<csv_writer>(
-      args.base.output_dir, model_name, timestamp, chain_id, 
-      "sample", ".csv", comment_prefix);
-  
-  // Optional writers
+    const std::string& data_type,
+    const std::string& comment_prefix) {
+  return open_draws_writer(
+      args,
+      create_file_path(args.base.output_dir,
+                       generate_filename(model_name, timestamp, chain_id, data_type, "")),
+      comment_prefix, data_type == "param_grads");
+}
+
+/* Create the optional file writers (initial values, diagnostics, metric)
+ * requested by the arguments; writers that are not requested stay null
+ * 
+ * @param args HMC-NUTS arguments containing output configuration
+ * @param model_name Name of the Stan model
+ * @param timestamp Timestamp string
+ * @param chain_id Chain number (1-indexed)
+ * @param comment_prefix Comment prefix for CSV files
+ * @param writers Writers for the chain, updated in place
+ */
+inline void create_hmc_nuts_optional_writers(
+    const hmc_nuts_args& args,
+    const std::string& model_name,
+    const std::string& timestamp,
+    unsigned int chain_id,
+    const std::string& comment_prefix,
+    hmc_nuts_writers& writers) {
   if (args.save_start_params) {
     writers.start_params_writer = create_writer<csv_writer>(
         args.base.output_dir, model_name, timestamp, chain_id,
@@ -58,9 +160,8 @@ inline hmc_nuts_writers create_hmc_nuts_single_chain_writers(
   }
   
   if (args.save_diagnostics) {
-    writers.diagnostics_writer = create_writer<csv_writer>(
-        args.base.output_dir, model_name, timestamp, chain_id,
-        "param_grads", ".csv", comment_prefix);
+    writers.diagnostics_writer = create_draws_writer(
+        args, model_name, timestamp, chain_id, "param_grads", comment_prefix);
   } else {
     writers.diagnostics_writer = nullptr;
   }
@@ -72,11 +173,96 @@ inline hmc_nuts_writers create_hmc_nuts_single_chain_writers(
   } else {
     writers.metric_writer = nullptr;
   }
+}
+
+/* Create HMC-NUTS output writers for a single chain
+ * 
+ * @param args HMC-NUTS arguments containing output configuration
+ * @param model_name Name of the Stan model
+ * @param timestamp Timestamp string
+ * @param chain_id Chain number (1-indexed)
+ * @param comment_prefix Optional comment prefix for CSV files
+ * @return hmc_nuts_writers struct containing all writers for the chain
+ */
+inline hmc_nuts_writers create_hmc_nuts_single_chain_writers(
+    const hmc_nuts_args& args,
+    const std::string& model_name,
+    const std::string& timestamp,
+    unsigned int chain_id,
+    const std::string& comment_prefix = "#") {
+    
+  hmc_nuts_writers writers;
+  
+  // Sample writer is always required
+  writers.sample_writer = create_draws_writer(
+      args, model_name, timestamp, chain_id, "sample", comment_prefix);
   
+  create_hmc_nuts_optional_writers(args, model_name, timestamp, chain_id,
+                                   comment_prefix, writers);
   return writers;
 }
 
-/* Create HMC-NUTS output writers for a multi-chain run.
+/* Create HMC-NUTS output writers for a multi-chain run whose chains
+ * share one file per output: the sample, diagnostic and initial value
+ * files get a leading chain__ column, the metric file holds an array of
+ * one record per chain. The files are complete once the writers of all
+ * chains have been destroyed.
+ * 
+ * @param args HMC-NUTS arguments containing output configuration
+ * @param model_name Name of the Stan model
+ * @param timestamp Timestamp string
+ * @param comment_prefix Optional comment prefix for CSV files
+ * @return Vector of hmc_nuts_writers, one for each chain
+ */
+inline std::vector<hmc_nuts_writers> create_hmc_nuts_shared_file_writers(
+    const hmc_nuts_args& args,
+    const std::string& model_name,
+    const std::string& timestamp,
+    const std::string& comment_prefix = "#") {
+  auto path = [&](const std::string& data_type, const std::string& extension) {
+    return create_file_path(args.base.output_dir,
+                            generate_shared_filename(model_name, timestamp, data_type,
+                                                     extension));
+  };
+  // The shared files have an I/O thread of their own
+  auto sample_file = std::make_shared<shared_draws_file>(
+      open_draws_writer(args, path("sample", ""), comment_prefix, false, false));
+  std::shared_ptr<shared_draws_file> diagnostics_file;
+  if (args.save_diagnostics) {
+    diagnostics_file = std::make_shared<shared_draws_file>(
+        open_draws_writer(args, path("param_grads", ""), comment_prefix, true, false));
+  }
+  std::shared_ptr<shared_draws_file> start_params_file;
+  if (args.save_start_params) {
+    start_params_file = std::make_shared<shared_draws_file>(
+        create_writer_impl<csv_writer>(path("start_params", ".csv"), ""));
+  }
+  std::shared_ptr<shared_json_file> metric_file;
+  if (args.save_metric) {
+    metric_file = std::make_shared<shared_json_file>(path("metric", ".json"),
+                                                     args.base.num_chains);
+  }
+
+  std::vector<hmc_nuts_writers> multi_writers(args.base.num_chains);
+  for (unsigned int i = 0; i < args.base.num_chains; ++i) {
+    multi_writers[i].sample_writer = std::make_unique<shared_chain_writer>(sample_file, i + 1);
+    if (diagnostics_file) {
+      multi_writers[i].diagnostics_writer
+        = std::make_unique<shared_chain_writer>(diagnostics_file, i + 1);
+    }
+    if (start_params_file) {
+      multi_writers[i].start_params_writer
+        = std::make_unique<shared_chain_writer>(start_params_file, i + 1);
+    }
+    if (metric_file) {
+      multi_writers[i].metric_writer = create_shared_json_writer(metric_file, i);
+    }
+  }
+  return multi_writers;
+}
+
+/* Create HMC-NUTS output writers for a multi-chain run, with files per
+ * chain or, with --single-file, files shared by all chains.
  * 
  * @param args HMC-NUTS arguments containing output configuration
  * @param model_name Name of the Stan model
@@ -90,6 +276,10 @@ inline std::vector<hmc_nuts_writers> create_hmc_nuts_multi_chain_writers(
     
   ensure_output_directory(args.base.output_dir);
   std::string timestamp = generate_timestamp();
+
+  if (args.single_file) {
+    return create_hmc_nuts_shared_file_writers(args, model_name, timestamp, comment_prefix);
+  }
   
   std::vector<hmc_nuts_writers> multi_writers;
   multi_writers.reserve(args.base.num_chains);
@@ -102,6 +292,54 @@ inline std::vector<hmc_nuts_writers> create_hmc_nuts_multi_chain_writers(
   return multi_writers;
 }
 
+/* Number of draws saved from iterations transitions thinned by thin */
+inline size_t num_saved_iterations(int iterations, int thin) {
+  return iterations <= 0 ? 0 : (iterations + thin - 1) / thin;
+}
+
+/* Number of draws per chain written to the sample writer
+ * 
+ * @param args HMC-NUTS arguments
+ * @return Saved sampling iterations, plus warmup iterations if saved
+ */
+inline size_t num_saved_draws(const hmc_nuts_args& args) {
+  return (args.save_warmup ? num_saved_iterations(args.num_warmup, args.thin) : 0)
+         + num_saved_iterations(args.num_samples, args.thin);
+}
+
+/* Create HMC-NUTS output writers that keep the draws of every chain in
+ * memory, restricted to the columns selected by --output-vars and
+ * --exclude-vars. The optional writers still write files when requested.
+ * 
+ * @param args HMC-NUTS arguments containing output configuration
+ * @param model_name Name of the Stan model
+ * @param buffer Buffer sized for args.base.num_chains chains of
+ *   num_saved_draws(args) draws
+ * @param comment_prefix Optional comment prefix for CSV files
+ * @return Vector of hmc_nuts_writers, one for each chain
+ */
+inline std::vector<hmc_nuts_writers> create_hmc_nuts_memory_writers(
+    const hmc_nuts_args& args,
+    const std::string& model_name,
+    const std::shared_ptr<draws_buffer>& buffer,
+    const std::string& comment_prefix = "#") {
+  
+  if (args.save_start_params || args.save_diagnostics || args.save_metric) {
+    ensure_output_directory(args.base.output_dir);
+  }
+  std::string timestamp = generate_timestamp();
+  
+  std::vector<hmc_nuts_writers> multi_writers(args.base.num_chains);
+  for (unsigned int i = 0; i < args.base.num_chains; ++i) {
+    multi_writers[i].sample_writer = filter_draws_writer(
+        args, std::make_unique<memory_writer>(buffer, i), false);
+    create_hmc_nuts_optional_writers(args, model_name, timestamp, i + 1,
+                                     comment_prefix, multi_writers[i]);
+  }
+  
+  return multi_writers;
+}
+
 }  // namespace stan3
 
 #endif  // STAN3_HMC_OUTPUT_WRITERS_HPP
@@ -2,8 +2,13 @@
 #define STAN3_LOAD_SAMPLERS_HPP
 
 #include <stan3/arguments.hpp>
+#include <stan3/chain_affinity.hpp>
+#include <stan3/chain_profile.hpp>
+#include <stan3/cross_chain_warmup.hpp>
 #include <stan3/hmc_output_writers.hpp>
 #include <stan3/metric_type.hpp>
+#include <stan3/parallel_chains.hpp>
+#include <stan3/shared_dense_metric.hpp>
 
 #include <stan/callbacks/logger.hpp>
 #include <stan/callbacks/stream_logger.hpp>
@@ -21,8 +26,12 @@
 
 #include <boost/random/mixmax.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <exception>
 #include <memory>
 #include <stdexcept>
+#include <string>
 #include <variant>
 #include <vector>
 
@@ -38,26 +47,51 @@ struct sampler_config {
   std::vector<std::vector<double>> init_params;
 };
 
-/* Template specialization for different metric types */
+/* Template specialization for different metric types; every sampler
+ * records a chain_profile of its transitions and can adapt across chains.
+ * 
+ * state_doubles(n) is the number of doubles a chain's sampler holds for
+ * n parameters: the phase space point (q, p, g), the inverse metric and
+ * the estimator adapting it. */
 template <metric_t MetricType>
 struct sampler_traits {};
 
 template <>
 struct sampler_traits<metric_t::DIAG_E> {
   template <typename Model>
-  using sampler_type = stan::mcmc::adapt_diag_e_nuts<Model, rng_t>;
+  using sampler_type = instrumented_sampler<
+    cross_chain_sampler<stan::mcmc::adapt_diag_e_nuts<Model, rng_t>, metric_t::DIAG_E>>;
+  static constexpr bool shares_metric = false;
+  static size_t state_doubles(size_t n) { return 6 * n; }
 };
 
 template <>
 struct sampler_traits<metric_t::DENSE_E> {
   template <typename Model>
-  using sampler_type = stan::mcmc::adapt_dense_e_nuts<Model, rng_t>;
+  using sampler_type = instrumented_sampler<
+    cross_chain_sampler<stan::mcmc::adapt_dense_e_nuts<Model, rng_t>, metric_t::DENSE_E>>;
+  static constexpr bool shares_metric = false;
+  static size_t state_doubles(size_t n) { return 4 * n + 2 * n * n; }
 };
 
 template <>
 struct sampler_traits<metric_t::UNIT_E> {
   template <typename Model>
-  using sampler_type = stan::mcmc::adapt_unit_e_nuts<Model, rng_t>;
+  using sampler_type = instrumented_sampler<
+    cross_chain_sampler<stan::mcmc::adapt_unit_e_nuts<Model, rng_t>, metric_t::UNIT_E>>;
+  static constexpr bool shares_metric = false;
+  static size_t state_doubles(size_t n) { return 3 * n; }
+};
+
+/* Dense-metric samplers of a --memory-lean run sharing one inverse metric
+ * that is not adapted; like the unit metric, only the step size adapts,
+ * also across chains */
+struct shared_dense_sampler_traits {
+  template <typename Model>
+  using sampler_type = instrumented_sampler<
+    cross_chain_sampler<adapt_shared_dense_e_nuts<Model, rng_t>, metric_t::UNIT_E>>;
+  static constexpr bool shares_metric = true;
+  static size_t state_doubles(size_t n) { return 3 * n; }
 };
 
 /* Convenience alias for the variant type */
@@ -65,9 +99,38 @@ template <typename Model>
 using sampler_variant = std::variant<
   sampler_config<typename sampler_traits<metric_t::UNIT_E>::template sampler_type<Model>>,
   sampler_config<typename sampler_traits<metric_t::DIAG_E>::template sampler_type<Model>>,
-  sampler_config<typename sampler_traits<metric_t::DENSE_E>::template sampler_type<Model>>
+  sampler_config<typename sampler_traits<metric_t::DENSE_E>::template sampler_type<Model>>,
+  sampler_config<typename shared_dense_sampler_traits::template sampler_type<Model>>
 >;
 
+/* Whether the chains of a run share one read-only dense inverse metric:
+ * with --memory-lean, a single --metric file and no metric adaptation
+ * (--warm-start or --warmup 0) */
+inline bool shares_dense_metric(const hmc_nuts_args& args) {
+  return args.memory_lean && args.metric_type == metric_t::DENSE_E
+         && args.metric_files.size() == 1 && (args.warm_start || args.num_warmup == 0);
+}
+
+/* Dense inverse metric of a metric context for all chains, the identity
+ * if there is none or it cannot be read */
+template <typename Model>
+std::shared_ptr<const dense_inv_metric> load_shared_dense_metric(
+    const Model& model, const stan::io::var_context* metric_context,
+    stan::callbacks::logger& logger) {
+  size_t n = model.num_params_r();
+  Eigen::MatrixXd inv_metric = Eigen::MatrixXd::Identity(n, n);
+  if (metric_context) {
+    try {
+      inv_metric = stan::services::util::read_dense_inv_metric(*metric_context, n, logger);
+    } catch (const std::exception& e) {
+      logger.warn("Using identity matrix metric (failed to read provided metric)");
+      inv_metric = Eigen::MatrixXd::Identity(n, n);
+    }
+  }
+  stan::services::util::validate_dense_inv_metric(inv_metric, logger);
+  return std::make_shared<const dense_inv_metric>(inv_metric);
+}
+
 /* Helper function to configure metric based on type */
 template <metric_t MetricType, typename SamplerType, typename Model>
 void configure_metric(SamplerType& sampler, const Model& model,
@@ -117,15 +180,29 @@ void configure_metric(SamplerType& sampler, const Model& model,
   }
 }
 
-/* Helper function to configure common sampler parameters */
+/* Step size saved next to the inverse metric by --save-metric, or the
+ * fallback if the metric context has none */
+inline double saved_stepsize(const stan::io::var_context* metric_context, double fallback) {
+  if (metric_context && metric_context->contains_r("stepsize")) {
+    std::vector<double> stepsize = metric_context->vals_r("stepsize");
+    if (stepsize.size() == 1 && stepsize[0] > 0) {
+      return stepsize[0];
+    }
+  }
+  return fallback;
+}
+
+/* Helper function to configure common sampler parameters; the step size
+ * adaptation starts from the given step size */
 template <typename SamplerType>
 void configure_sampler_basic(SamplerType& sampler, 
-                            const hmc_nuts_args& args) {
-  sampler.set_nominal_stepsize(args.stepsize);
+                            const hmc_nuts_args& args,
+                            double stepsize) {
+  sampler.set_nominal_stepsize(stepsize);
   sampler.set_stepsize_jitter(args.stepsize_jitter);
   sampler.set_max_depth(args.max_depth);
   
-  sampler.get_stepsize_adaptation().set_mu(std::log(10 * args.stepsize));
+  sampler.get_stepsize_adaptation().set_mu(std::log(10 * stepsize));
   sampler.get_stepsize_adaptation().set_delta(args.delta);
   sampler.get_stepsize_adaptation().set_gamma(args.gamma);
   sampler.get_stepsize_adaptation().set_kappa(args.kappa);
@@ -145,8 +222,16 @@ void configure_windowed_adaptation(SamplerType& sampler,
 }
 
 /* Load and configure samplers for a specific metric type
+ * 
+ * Chains are initialized concurrently when --num-threads > 1 and the
+ * model is compiled with STAN_THREADS. With --cross-chain-warmup and a
+ * thread per chain, the samplers share a cross_chain_adapter. With
+ * --warm-start the samplers keep the metric and step size of the metric
+ * contexts and adapt only the step size. Samplers whose traits share the
+ * metric all get the inverse metric of the first metric context.
  * 
  * @tparam MetricType The metric type enum value
+ * @tparam Traits Sampler traits, those of MetricType by default
  * @tparam Model The Stan model type
  * @param model Reference to the instantiated model
  * @param args HMC-NUTS arguments containing sampler configuration
@@ -156,8 +241,8 @@ void configure_windowed_adaptation(SamplerType& sampler,
  * @param init_writers Vector of writers for initialization output (can contain nullptrs)
  * @return sampler_config containing initialized samplers and related data
  */
-template <metric_t MetricType, typename Model>
-sampler_config<typename sampler_traits<MetricType>::template sampler_type<Model>>
+template <metric_t MetricType, typename Traits = sampler_traits<MetricType>, typename Model>
+sampler_config<typename Traits::template sampler_type<Model>>
 load_samplers(Model& model,
               const hmc_nuts_args& args,
               const std::vector<std::shared_ptr<const stan::io::var_context>>& init_contexts,
@@ -165,20 +250,60 @@ load_samplers(Model& model,
               stan::callbacks::logger& logger,
               const std::vector<stan::callbacks::writer*>& init_writers) {
   
-  using sampler_type = typename sampler_traits<MetricType>::template sampler_type<Model>;
+  using sampler_type = typename Traits::template sampler_type<Model>;
   using config_type = sampler_config<sampler_type>;
   
   config_type config;
-  config.samplers.reserve(args.base.num_chains);
-  config.rngs.reserve(args.base.num_chains);
-  config.init_params.reserve(args.base.num_chains);
+  const size_t num_chains = args.base.num_chains;
+  config.samplers.reserve(num_chains);
+  config.rngs.reserve(num_chains);
+  config.init_params.resize(num_chains);
   
   try {
-    for (size_t i = 0; i < args.base.num_chains; ++i) {
-      // RNGs passed in?
-      // Create RNG for this chain
+    chain_placement placement(num_chains, args.base.num_threads, args.threads_per_chain,
+                              args.affinity);
+    if (args.affinity && !placement.pinned()) {
+      logger.warn("Chain affinity is only supported on Linux; chains are not "
+                  "pinned to cores.");
+    }
+
+    // RNGs and samplers are created up front so that each chain's
+    // initialization only writes into its own preallocated slot. Each
+    // sampler is created on its chain's cores, so with --affinity its
+    // state and metric are allocated on the chain's NUMA node.
+    for (size_t i = 0; i < num_chains; ++i) {
       config.rngs.emplace_back(stan::services::util::create_rng(args.base.model.random_seed, i + 1));
-      
+      placement.run(i, [&] { config.samplers.emplace_back(model, config.rngs[i]); });
+    }
+    if constexpr (Traits::shares_metric) {
+      auto inv_metric = load_shared_dense_metric(
+        model, metric_contexts.empty() ? nullptr : metric_contexts.front().get(), logger);
+      for (auto& sampler : config.samplers) {
+        sampler.z().share_metric(inv_metric);
+      }
+    }
+
+    // Chains adapting together wait for each other at every window
+    // boundary, so each chain needs a thread of its own
+    const thread_allocation& threads = placement.threads();
+    if (args.cross_chain_warmup) {
+      if (num_chains > 1 && threading_enabled() && threads.parallel_chains >= num_chains
+          && num_chains <= static_cast<size_t>(tbb::this_task_arena::max_concurrency())) {
+        auto adapter = std::make_shared<cross_chain_adapter>(num_chains);
+        for (size_t i = 0; i < num_chains; ++i) {
+          config.samplers[i].set_cross_chain_adapter(adapter, i);
+        }
+      } else {
+        logger.warn("Cross-chain warmup requires several chains, a model compiled "
+                    "with STAN_THREADS and a thread per chain (--num-threads at "
+                    "least --chains times --threads-per-chain); adapting each "
+                    "chain separately.");
+      }
+    }
+
+    auto initialize_chain = [&](size_t i) {
+      auto start = std::chrono::steady_clock::now();
+
       // Initialize parameters
       stan::io::var_context* init_context =
         const_cast<stan::io::var_context*>(init_contexts[i].get());
@@ -189,23 +314,46 @@ load_samplers(Model& model,
         (init_writers[i] != nullptr) ? init_writers[i] : &dummy_writer;
 
       // initialize with timing message == false      
-      auto init_params = stan::services::util::initialize(
+      config.init_params[i] = stan::services::util::initialize(
         model, *init_context, config.rngs[i], args.base.init.init_radius, false, logger,  
         *writer_to_use);
-      config.init_params.push_back(std::move(init_params));
       
-      // Create and configure sampler
-      config.samplers.emplace_back(model, config.rngs[i]);
-      auto& sampler = config.samplers.back();
+      auto& sampler = config.samplers[i];
       
-      // Configure metric
-      configure_metric<MetricType>(sampler, model, metric_contexts[i].get(), logger);
+      // Configure metric, unless it is shared
+      if constexpr (!Traits::shares_metric) {
+        configure_metric<MetricType>(sampler, model, metric_contexts[i].get(), logger);
+      }
       
-      // Configure basic sampler parameters
-      configure_sampler_basic(sampler, args);
+      // Configure basic sampler parameters; a warm start also takes the
+      // step size of the previous run
+      double stepsize = args.warm_start
+        ? saved_stepsize(metric_contexts[i].get(), args.stepsize) : args.stepsize;
+      configure_sampler_basic(sampler, args, stepsize);
       
-      // Configure windowed adaptation (only for diag_e and dense_e)
-      configure_windowed_adaptation<MetricType>(sampler, args, logger);
+      // Configure windowed adaptation (only for diag_e and dense_e). A
+      // warm start keeps the metric: without window parameters the
+      // windowed adaptation never ends a window, so warmup only adapts
+      // the step size
+      if constexpr (!Traits::shares_metric) {
+        if (!args.warm_start) {
+          configure_windowed_adaptation<MetricType>(sampler, args, logger);
+        }
+      }
+
+      sampler.profile().memory_bytes = sizeof(double) * Traits::state_doubles(model.num_params_r());
+      sampler.profile().init_seconds = seconds_since(start);
+    };
+
+    if (num_chains > 1 && threads.parallel_chains > 1) {
+      auto errors = placement.run_chains(num_chains, [&](size_t i) {
+        placement.run(i, [&] { initialize_chain(i); });
+      });
+      rethrow_first_chain_error(errors);
+    } else {
+      for (size_t i = 0; i < num_chains; ++i) {
+        placement.run(i, [&] { initialize_chain(i); });
+      }
     }
   } catch (const std::exception& e) {
     throw std::runtime_error("Error configuring samplers: " + std::string(e.what()));
@@ -234,6 +382,17 @@ create_samplers(Model& model,
       return load_samplers<metric_t::DIAG_E>(model, args, init_contexts,
                                            metric_contexts, logger, init_writers);
     case metric_t::DENSE_E:
+      // A --single-file metric array gives each chain its own record
+      if (shares_dense_metric(args)
+          && std::all_of(metric_contexts.begin(), metric_contexts.end(),
+                         [&](const auto& context) { return context == metric_contexts.front(); })) {
+        return load_samplers<metric_t::DENSE_E, shared_dense_sampler_traits>(
+          model, args, init_contexts, metric_contexts, logger, init_writers);
+      }
+      if (args.memory_lean) {
+        logger.info("The chains share the dense metric only with a single --metric "
+                    "file holding one metric and no metric adaptation (--warm-start or --warmup 0).");
+      }
       return load_samplers<metric_t::DENSE_E>(model, args, init_contexts,
                                             metric_contexts, logger, init_writers);
     default:
@@ -0,0 +1,187 @@
+#ifndef STAN3_LOG_DENSITY_HPP
+#define STAN3_LOG_DENSITY_HPP
+
+#include <stan3/parallel_chains.hpp>
+
+#include <stan/model/gradient.hpp>
+#ifdef STAN_THREADS
+#include <stan/math/rev/core/chainablestack.hpp>
+#endif
+#include <stan/services/util/create_rng.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
+#include <Eigen/Dense>
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan3 {
+
+/* Buffers of one thread, reused by all of its evaluations so that
+ * evaluating a model of fixed size does not allocate */
+struct log_density_workspace {
+  Eigen::VectorXd theta;
+  Eigen::VectorXd grad;
+  Eigen::VectorXd constrained;
+};
+
+/* Workspace of the calling thread */
+inline log_density_workspace& thread_workspace() {
+#ifdef STAN_THREADS
+  // Threads of the caller that never joined a tbb arena have no autodiff
+  // stack yet; on all others this does nothing
+  [[maybe_unused]] thread_local stan::math::ChainableStack autodiff_stack;
+#endif
+  thread_local log_density_workspace workspace;
+  return workspace;
+}
+
+/* Log density and gradient at an unconstrained parameter vector
+ *
+ * The density is the one the samplers target: up to a constant, with the
+ * Jacobian of the constraining transform. The gradient is computed on the
+ * autodiff stack of the calling thread, which is thread-local when the
+ * model is compiled with STAN_THREADS, so concurrent calls do not share
+ * any state. Model print statements are discarded.
+ *
+ * @param model Stan model
+ * @param theta_unc num_params_r() unconstrained values
+ * @param grad Output for the num_params_r() partial derivatives
+ * @return Log density
+ * @throws std::exception if the model cannot be evaluated
+ */
+template <class Model>
+double log_density_gradient(const Model& model, const double* theta_unc, double* grad) {
+  auto& workspace = thread_workspace();
+  const Eigen::Index n = model.num_params_r();
+  workspace.theta = Eigen::Map<const Eigen::VectorXd>(theta_unc, n);
+  double lp = 0;
+  stan::model::gradient(model, workspace.theta, lp, workspace.grad, nullptr);
+  Eigen::Map<Eigen::VectorXd>(grad, n) = workspace.grad;
+  return lp;
+}
+
+/* Log density and gradient at many unconstrained parameter vectors,
+ * evaluated in parallel on a dedicated tbb arena
+ *
+ * Every vector is evaluated even if some fail; a failed vector gets a NaN
+ * log density. Without STAN_THREADS the vectors are evaluated serially.
+ *
+ * @param model Stan model
+ * @param num_evals Number of parameter vectors
+ * @param theta_unc Row-major num_evals x num_params_r() unconstrained values
+ * @param lp Output for the num_evals log densities
+ * @param grad Output for the row-major num_evals x num_params_r() gradients
+ * @param num_threads Maximum number of threads
+ * @throws std::domain_error naming the first failed vector if any failed
+ */
+template <class Model>
+void log_density_gradient_batch(const Model& model, size_t num_evals,
+                                const double* theta_unc, double* lp, double* grad,
+                                unsigned int num_threads) {
+  if (num_evals == 0) {
+    return;
+  }
+  const size_t n = model.num_params_r();
+  std::mutex error_mutex;
+  size_t first_failed = num_evals;
+  std::string first_error;
+  auto evaluate = [&](size_t begin, size_t end) {
+    for (size_t i = begin; i != end; ++i) {
+      try {
+        lp[i] = log_density_gradient(model, theta_unc + i * n, grad + i * n);
+      } catch (const std::exception& e) {
+        lp[i] = std::numeric_limits<double>::quiet_NaN();
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (i < first_failed) {
+          first_failed = i;
+          first_error = e.what();
+        }
+      }
+    }
+  };
+
+  unsigned int concurrency = threading_enabled()
+    ? static_cast<unsigned int>(std::min<size_t>(std::max(1u, num_threads), num_evals))
+    : 1;
+  if (concurrency == 1) {
+    evaluate(0, num_evals);
+  } else {
+    tbb::task_arena arena(static_cast<int>(concurrency));
+    arena.execute([&] {
+      tbb::parallel_for(tbb::blocked_range<size_t>(0, num_evals),
+                        [&](const tbb::blocked_range<size_t>& r) {
+                          evaluate(r.begin(), r.end());
+                        });
+    });
+  }
+  if (first_failed < num_evals) {
+    throw std::domain_error("Evaluation " + std::to_string(first_failed)
+                            + " failed: " + first_error);
+  }
+}
+
+/* Number of constrained parameter values, without transformed
+ * parameters and generated quantities; this allocates the names, so
+ * callers evaluating a model repeatedly compute it once */
+template <class Model>
+size_t num_constrained_params(const Model& model) {
+  std::vector<std::string> names;
+  model.constrained_param_names(names, false, false);
+  return names.size();
+}
+
+/* Unconstrained values of the parameters
+ *
+ * @param model Stan model
+ * @param num_constrained num_constrained_params(model)
+ * @param theta num_constrained constrained parameter values, in the
+ *   order of constrained_param_names() without transformed parameters
+ *   and generated quantities
+ * @param theta_unc Output for the num_params_r() unconstrained values
+ * @throws std::exception if a value violates its constraint
+ */
+template <class Model>
+void param_unconstrain(const Model& model, size_t num_constrained, const double* theta,
+                       double* theta_unc) {
+  auto& workspace = thread_workspace();
+  workspace.constrained = Eigen::Map<const Eigen::VectorXd>(theta, num_constrained);
+  model.unconstrain_array(workspace.constrained, workspace.theta, nullptr);
+  Eigen::Map<Eigen::VectorXd>(theta_unc, model.num_params_r()) = workspace.theta;
+}
+
+/* Constrained values of the parameters, and optionally of the
+ * transformed parameters and generated quantities
+ *
+ * @param model Stan model
+ * @param theta_unc num_params_r() unconstrained values
+ * @param include_tp Include transformed parameters?
+ * @param include_gq Include generated quantities?
+ * @param seed Seed of the random number generator of generated quantities
+ * @param theta Output for the values, in the order of
+ *   constrained_param_names(include_tp, include_gq)
+ * @throws std::exception if the model cannot be evaluated
+ */
+template <class Model>
+void param_constrain(const Model& model, const double* theta_unc, bool include_tp,
+                     bool include_gq, unsigned int seed, double* theta) {
+  auto& workspace = thread_workspace();
+  auto rng = stan::services::util::create_rng(seed, 1);
+  workspace.theta = Eigen::Map<const Eigen::VectorXd>(theta_unc, model.num_params_r());
+  model.write_array(rng, workspace.theta, workspace.constrained, include_tp, include_gq,
+                    nullptr);
+  std::copy(workspace.constrained.data(),
+            workspace.constrained.data() + workspace.constrained.size(), theta);
+}
+
+}  // namespace stan3
+
+#endif  // STAN3_LOG_DENSITY_HPP
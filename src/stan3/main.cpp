@@ -5,14 +5,28 @@
 #include <stan3/arguments.hpp>
 #include <stan3/load_model.hpp>
 #include <stan3/metric_type.hpp>
+#include <stan3/run_advi.hpp>
+#include <stan3/run_batch.hpp>
+#include <stan3/run_gq.hpp>
 #include <stan3/run_hmc_nuts.hpp>
-#include <stan3/run_others.hpp>
+#include <stan3/run_optimize.hpp>
+#include <stan3/run_pathfinder.hpp>
 
 int main(int argc, char** argv) {
     CLI::App app{"Stan3 - Command line interface for Stan"};
 
     stan3::hmc_nuts_args hmc_args;
     CLI::App* selected_subcommand = stan3::setup_backward_compatible_cli(app, hmc_args);
+    stan3::pathfinder_args pathfinder_args;
+    stan3::setup_pathfinder_subcommand(app, pathfinder_args);
+    stan3::optimize_args optimize_args;
+    stan3::setup_optimize_subcommand(app, optimize_args);
+    stan3::advi_args advi_args;
+    stan3::setup_advi_subcommand(app, advi_args);
+    stan3::gq_args gq_args;
+    stan3::setup_gq_subcommand(app, gq_args);
+    stan3::batch_args batch_args;
+    stan3::setup_batch_subcommand(app, batch_args);
     CLI11_PARSE(app, argc, argv);
 
     std::string error_message;
@@ -23,6 +37,22 @@ int main(int argc, char** argv) {
         if (validation_passed) {
             stan3::finalize_hmc_arguments(hmc_args);
         }
+    } else if (app.got_subcommand("pathfinder")) {
+        validation_passed = stan3::validate_pathfinder_arguments(pathfinder_args, error_message);
+        if (validation_passed) {
+            stan3::finalize_pathfinder_arguments(pathfinder_args);
+        }
+    } else if (app.got_subcommand("optimize")) {
+        validation_passed = stan3::validate_optimize_arguments(optimize_args, error_message);
+        if (validation_passed) {
+            stan3::finalize_optimize_arguments(optimize_args);
+        }
+    } else if (app.got_subcommand("advi")) {
+        stan3::finalize_advi_arguments(advi_args);
+    } else if (app.got_subcommand("gq")) {
+        stan3::finalize_gq_arguments(gq_args);
+    } else if (app.got_subcommand("batch")) {
+        stan3::finalize_batch_arguments(batch_args);
     }
     // Add validation for other algorithms here as they're implemented
     if (!validation_passed) {
@@ -31,11 +61,25 @@ int main(int argc, char** argv) {
     }
     std::cout << "config" << std::endl << app.config_to_str() << std::endl;
 
-    stan::model::model_base& model = stan3::load_model(hmc_args.base.model);
-
     // Dispatch to the appropriate algorithm
     if (app.got_subcommand("hmc")) {
+        stan::model::model_base& model = stan3::load_model(hmc_args.base.model);
         return stan3::run_hmc(hmc_args, model);
+    } else if (app.got_subcommand("pathfinder")) {
+        stan::model::model_base& model = stan3::load_model(pathfinder_args.base.model);
+        return stan3::run_pathfinder(pathfinder_args, model);
+    } else if (app.got_subcommand("optimize")) {
+        stan::model::model_base& model = stan3::load_model(optimize_args.base.model);
+        return stan3::run_optimize(optimize_args, model);
+    } else if (app.got_subcommand("advi")) {
+        stan::model::model_base& model = stan3::load_model(advi_args.base.model);
+        return stan3::run_advi(advi_args, model);
+    } else if (app.got_subcommand("gq")) {
+        stan::model::model_base& model = stan3::load_model(gq_args.base.model);
+        return stan3::run_gq(gq_args, model);
+    } else if (app.got_subcommand("batch")) {
+        // Every job loads a model instance of its own
+        return stan3::run_batch(batch_args);
     } else {
         // Handle other algorithms when they're implemented
         std::cerr << "Error: No algorithm subcommand selected" << std::endl;
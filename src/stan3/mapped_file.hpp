@@ -0,0 +1,163 @@
+#ifndef STAN3_MAPPED_FILE_HPP
+#define STAN3_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <istream>
+#include <streambuf>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace stan3 {
+
+/**
+ * Read-only memory mapping of a whole file.
+ *
+ * The mapping is released when the object is destroyed. A file that
+ * cannot be mapped (missing, unreadable, or a special file) leaves the
+ * object invalid; an empty file is valid with size() == 0.
+ */
+class mapped_file {
+public:
+  explicit mapped_file(const std::string& filename) { open(filename); }
+
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  ~mapped_file() { close(); }
+
+  bool is_open() const { return valid_; }
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+#ifdef _WIN32
+  void open(const std::string& filename) {
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              NULL, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+      return;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+      CloseHandle(file);
+      return;
+    }
+    size_ = static_cast<size_t>(size.QuadPart);
+    if (size_ == 0) {
+      CloseHandle(file);
+      data_ = "";
+      valid_ = true;
+      return;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL) {
+      return;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (view == NULL) {
+      return;
+    }
+    data_ = static_cast<const char*>(view);
+    mapped_ = true;
+    valid_ = true;
+  }
+
+  void close() {
+    if (mapped_) {
+      UnmapViewOfFile(data_);
+    }
+  }
+#else
+  void open(const std::string& filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+      ::close(fd);
+      return;
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ == 0) {
+      ::close(fd);
+      data_ = "";
+      valid_ = true;
+      return;
+    }
+    void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+      return;
+    }
+#ifdef MADV_SEQUENTIAL
+    ::madvise(addr, size_, MADV_SEQUENTIAL);
+#endif
+    data_ = static_cast<const char*>(addr);
+    mapped_ = true;
+    valid_ = true;
+  }
+
+  void close() {
+    if (mapped_) {
+      ::munmap(const_cast<char*>(data_), size_);
+    }
+  }
+#endif
+
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  bool mapped_ = false;
+  bool valid_ = false;
+};
+
+/**
+ * Stream buffer reading directly from a block of memory, so that a
+ * std::istream over a mapped file is served without copying.
+ */
+class memory_streambuf : public std::streambuf {
+public:
+  memory_streambuf(const char* data, size_t size) {
+    char* begin = const_cast<char*>(data);
+    setg(begin, begin, begin + size);
+  }
+
+protected:
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                   std::ios_base::openmode which = std::ios_base::in) override {
+    if (!(which & std::ios_base::in)) {
+      return pos_type(off_type(-1));
+    }
+    char* base = dir == std::ios_base::beg ? eback()
+               : dir == std::ios_base::cur ? gptr() : egptr();
+    char* target = base + off;
+    if (target < eback() || target > egptr()) {
+      return pos_type(off_type(-1));
+    }
+    setg(eback(), target, egptr());
+    return pos_type(target - eback());
+  }
+
+  pos_type seekpos(pos_type pos,
+                   std::ios_base::openmode which = std::ios_base::in) override {
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+  }
+};
+
+}  // namespace stan3
+
+#endif  // STAN3_MAPPED_FILE_HPP
@@ -0,0 +1,144 @@
+#ifndef STAN3_MEMORY_WRITER_HPP
+#define STAN3_MEMORY_WRITER_HPP
+
+#include <stan/callbacks/writer.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan3 {
+
+/**
+ * In-memory store for the draws of a multi-chain run.
+ *
+ * Values are held in one contiguous row-major array of
+ * num_chains x draws_per_chain rows by num_cols columns: the rows of
+ * chain c are rows [c * draws_per_chain, (c + 1) * draws_per_chain).
+ * The array is allocated once, when the first chain writes its column
+ * names, and rows that are never written (for example after an early
+ * stop) stay NaN.
+ *
+ * Each chain writes only its own rows, so chains can write concurrently
+ * without locking; only the column names are guarded.
+ */
+class draws_buffer {
+public:
+  /**
+   * @param num_chains Number of chains
+   * @param draws_per_chain Number of draws each chain will save
+   */
+  draws_buffer(size_t num_chains, size_t draws_per_chain)
+    : num_chains_(num_chains), draws_per_chain_(draws_per_chain),
+      draws_written_(num_chains, 0) {}
+
+  draws_buffer(const draws_buffer&) = delete;
+  draws_buffer& operator=(const draws_buffer&) = delete;
+
+  /* Set the column names, allocating storage on the first call; later
+   * calls must give the same names */
+  void set_column_names(const std::vector<std::string>& names) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (allocated_) {
+      if (names != names_) {
+        throw std::invalid_argument("draws_buffer: chains wrote different column names");
+      }
+      return;
+    }
+    names_ = names;
+    values_.assign(num_chains_ * draws_per_chain_ * names_.size(),
+                   std::numeric_limits<double>::quiet_NaN());
+    allocated_ = true;
+  }
+
+  /* Pointer to the first value of a draw of a chain */
+  double* row(size_t chain, size_t draw) {
+    return values_.data() + (chain * draws_per_chain_ + draw) * names_.size();
+  }
+
+  void set_draws_written(size_t chain, size_t n) { draws_written_[chain] = n; }
+
+  size_t num_chains() const { return num_chains_; }
+  size_t draws_per_chain() const { return draws_per_chain_; }
+  size_t num_rows() const { return allocated_ ? num_chains_ * draws_per_chain_ : 0; }
+  size_t num_cols() const { return names_.size(); }
+  size_t draws_written(size_t chain) const { return draws_written_[chain]; }
+  const std::vector<std::string>& column_names() const { return names_; }
+  double* data() { return values_.data(); }
+  const std::vector<double>& values() const { return values_; }
+
+private:
+  size_t num_chains_;
+  size_t draws_per_chain_;
+  bool allocated_ = false;
+  std::vector<std::string> names_;
+  std::vector<double> values_;
+  std::vector<size_t> draws_written_;
+  std::mutex mutex_;
+};
+
+/**
+ * Writer that stores the draws of one chain in a shared draws_buffer.
+ *
+ * Column names size the buffer, each draw is copied into the chain's
+ * next row, and comments are discarded.
+ */
+class memory_writer : public stan::callbacks::writer {
+public:
+  /**
+   * @param buffer Buffer shared by all chains of the run
+   * @param chain_idx Chain index (0-indexed)
+   */
+  memory_writer(std::shared_ptr<draws_buffer> buffer, size_t chain_idx)
+    : buffer_(std::move(buffer)), chain_idx_(chain_idx) {
+    if (!buffer_) {
+      throw std::invalid_argument("memory_writer: draws buffer is null");
+    }
+    if (chain_idx_ >= buffer_->num_chains()) {
+      throw std::out_of_range("memory_writer: chain index out of range");
+    }
+  }
+
+  void operator()(const std::vector<std::string>& names) override {
+    buffer_->set_column_names(names);
+    has_names_ = true;
+  }
+
+  void operator()(const std::vector<double>& state) override {
+    if (state.empty()) {
+      return;
+    }
+    if (!has_names_) {
+      throw std::logic_error("memory_writer: draws written before column names");
+    }
+    if (state.size() != buffer_->num_cols()) {
+      throw std::invalid_argument("memory_writer: expected "
+                                  + std::to_string(buffer_->num_cols())
+                                  + " values, found " + std::to_string(state.size()));
+    }
+    if (draw_ >= buffer_->draws_per_chain()) {
+      throw std::out_of_range("memory_writer: more draws than the buffer holds ("
+                              + std::to_string(buffer_->draws_per_chain()) + ")");
+    }
+    std::copy(state.begin(), state.end(), buffer_->row(chain_idx_, draw_));
+    buffer_->set_draws_written(chain_idx_, ++draw_);
+  }
+
+  void operator()() override {}
+
+  void operator()(const std::string&) override {}
+
+private:
+  std::shared_ptr<draws_buffer> buffer_;
+  size_t chain_idx_;
+  size_t draw_ = 0;
+  bool has_names_ = false;
+};
+
+}  // namespace stan3
+
+#endif  // STAN3_MEMORY_WRITER_HPP
@@ -0,0 +1,486 @@
+#ifndef STAN3_ONLINE_SUMMARY_HPP
+#define STAN3_ONLINE_SUMMARY_HPP
+
+#include <stan/callbacks/structured_writer.hpp>
+#include <stan/callbacks/writer.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace stan3 {
+
+/* Running count, mean and sum of squared deviations of a stream of
+ * values (Welford's algorithm) */
+struct welford_accumulator {
+  size_t n = 0;
+  double mean = 0;
+  double m2 = 0;
+
+  void add(double x) {
+    ++n;
+    double delta = x - mean;
+    mean += delta / n;
+    m2 += delta * (x - mean);
+  }
+
+  /* Add the values of another accumulator (Chan et al.) */
+  void add(const welford_accumulator& other) {
+    if (other.n == 0) {
+      return;
+    }
+    size_t total = n + other.n;
+    double delta = other.mean - mean;
+    mean += delta * other.n / total;
+    m2 += other.m2 + delta * delta * n * other.n / total;
+    n = total;
+  }
+
+  /* Sample variance, NaN with fewer than two values */
+  double variance() const {
+    return n < 2 ? std::numeric_limits<double>::quiet_NaN() : m2 / (n - 1);
+  }
+};
+
+/**
+ * Batch moments of a stream of values: batch means for the asymptotic
+ * variance of its mean under autocorrelation, and the moments of each
+ * half of the stream so far for split R-hat.
+ *
+ * Values are accumulated over batches of batch_size() consecutive values.
+ * When 2 * min_batches batches are full, adjacent batches are merged and
+ * the batch size doubles, so memory stays bounded while the batch size
+ * grows with the length of the stream; between min_batches and
+ * 2 * min_batches batches are kept.
+ */
+class batch_means {
+public:
+  static constexpr size_t min_batches = 32;
+
+  void add(double x) {
+    current_.add(x);
+    if (current_.n < batch_size_) {
+      return;
+    }
+    batches_.push_back(current_);
+    current_ = welford_accumulator();
+    if (batches_.size() == 2 * min_batches) {
+      for (size_t b = 0; b < min_batches; ++b) {
+        batches_[b] = batches_[2 * b];
+        batches_[b].add(batches_[2 * b + 1]);
+      }
+      batches_.resize(min_batches);
+      batch_size_ *= 2;
+    }
+  }
+
+  size_t batch_size() const { return batch_size_; }
+
+  /* Number of values added */
+  size_t size() const { return batches_.size() * batch_size_ + current_.n; }
+
+  /* Moments of half h (0 or 1) of the values added so far. The halves
+   * are split at the batch boundary nearest the middle, which is exact
+   * until the batch size first doubles and within batch_size() / 2 values
+   * of it afterwards. */
+  welford_accumulator half(size_t h) const {
+    size_t split = std::min(batches_.size(), (size() / 2 + batch_size_ / 2) / batch_size_);
+    welford_accumulator moments;
+    for (size_t b = h == 0 ? 0 : split; b < (h == 0 ? split : batches_.size()); ++b) {
+      moments.add(batches_[b]);
+    }
+    if (h == 1) {
+      moments.add(current_);
+    }
+    return moments;
+  }
+
+  /* Estimate of the variance of the stream times its length divided by
+   * its effective sample size: batch size times the variance of the full
+   * batch means; NaN with fewer than two full batches */
+  double asymptotic_variance() const {
+    welford_accumulator means;
+    for (const auto& batch : batches_) {
+      means.add(batch.mean);
+    }
+    return batch_size_ * means.variance();
+  }
+
+private:
+  std::vector<welford_accumulator> batches_;
+  welford_accumulator current_;
+  size_t batch_size_ = 1;
+};
+
+/**
+ * Running summaries of every column of one chain's draws: batch moments,
+ * which give the moments of each half of the chain for split R-hat and
+ * the batch means for the effective sample size. The chain is split at
+ * its current number of draws, so a run stopped early by a convergence
+ * target still checks split R-hat.
+ */
+class chain_summary {
+public:
+  /* Set the column names; resets the summaries */
+  void set_names(const std::vector<std::string>& names) {
+    names_ = names;
+    batches_.assign(names.size(), batch_means());
+    num_draws_ = 0;
+  }
+
+  /* Add one draw, one value per column; extra values are ignored */
+  void add(const std::vector<double>& draw) {
+    const size_t num_cols = std::min(draw.size(), names_.size());
+    for (size_t j = 0; j < num_cols; ++j) {
+      batches_[j].add(draw[j]);
+    }
+    ++num_draws_;
+  }
+
+  const std::vector<std::string>& names() const { return names_; }
+  size_t num_draws() const { return num_draws_; }
+
+  /* Moments of column j over half h (0 or 1) of the chain so far */
+  welford_accumulator half(size_t h, size_t j) const { return batches_[j].half(h); }
+
+  /* Batch moments of column j over the whole chain */
+  const batch_means& batches(size_t j) const { return batches_[j]; }
+
+private:
+  std::vector<std::string> names_;
+  std::vector<batch_means> batches_;
+  size_t num_draws_ = 0;
+};
+
+/* Posterior summary of one column across chains */
+struct column_summary {
+  double mean = std::numeric_limits<double>::quiet_NaN();
+  double sd = std::numeric_limits<double>::quiet_NaN();
+  double mcse_mean = std::numeric_limits<double>::quiet_NaN();
+  double ess = std::numeric_limits<double>::quiet_NaN();
+  double rhat = std::numeric_limits<double>::quiet_NaN();
+};
+
+/* Summary of column j across the chains that wrote it
+ *
+ * @param chains Summaries of the chains
+ * @param j Column index
+ * @return Mean, sd, MCSE of the mean, ESS and split R-hat of the column;
+ *   statistics that cannot be computed yet are NaN
+ */
+inline column_summary summarize_column(const std::vector<chain_summary>& chains, size_t j) {
+  // Only half-chains with at least two draws enter R-hat and ESS; the
+  // mean and sd use every draw
+  size_t total = 0;
+  double sum_x = 0;
+  welford_accumulator within;
+  welford_accumulator half_means;
+  welford_accumulator asymptotic;
+  size_t split_draws = 0;
+  for (const auto& c : chains) {
+    if (c.names().size() <= j) {
+      continue;
+    }
+    for (size_t h = 0; h < 2; ++h) {
+      welford_accumulator half = c.half(h, j);
+      total += half.n;
+      sum_x += half.n * half.mean;
+      if (half.n >= 2) {
+        within.add(half.variance());
+        half_means.add(half.mean);
+        split_draws += half.n;
+      }
+    }
+    double sigma2 = c.batches(j).asymptotic_variance();
+    if (std::isfinite(sigma2)) {
+      asymptotic.add(sigma2);
+    }
+  }
+
+  column_summary s;
+  if (total == 0) {
+    return s;
+  }
+  s.mean = sum_x / total;
+  // Pooled variance from the moments of the half-chains
+  double m2 = 0;
+  for (const auto& c : chains) {
+    if (c.names().size() <= j) {
+      continue;
+    }
+    for (size_t h = 0; h < 2; ++h) {
+      welford_accumulator half = c.half(h, j);
+      m2 += half.m2 + half.n * (half.mean - s.mean) * (half.mean - s.mean);
+    }
+  }
+  double variance = total > 1 ? m2 / (total - 1) : 0.0;
+  s.sd = std::sqrt(variance);
+
+  if (half_means.n < 2 || !(within.mean > 0)) {
+    return s;
+  }
+  double n = static_cast<double>(split_draws) / half_means.n;
+  double var_plus = (n - 1) / n * within.mean + half_means.variance();
+  s.rhat = std::sqrt(var_plus / within.mean);
+
+  if (asymptotic.n > 0 && asymptotic.mean > 0) {
+    double draws = static_cast<double>(total);
+    s.ess = std::min(draws * var_plus / asymptotic.mean, draws * std::log10(draws));
+    s.mcse_mean = std::sqrt(variance / s.ess);
+  }
+  return s;
+}
+
+/**
+ * Summary statistics of a multi-chain run, accumulated draw by draw
+ * while the chains sample instead of from the draws files afterwards.
+ *
+ * Each chain updates only its own chain_summary, under a lock of its
+ * own, so chains sampling concurrently do not contend; snapshot() copies
+ * all chains while they sample and summaries are combined across chains
+ * by summarize_column. R-hat is the split R-hat of Gelman et al. over the
+ * half-chains; the effective sample size divides the total number of
+ * draws by the ratio of the batch-means asymptotic variance, averaged
+ * over chains, to the pooled variance of the split R-hat.
+ */
+class online_summary {
+public:
+  /* @param num_chains Number of chains */
+  explicit online_summary(size_t num_chains)
+    : chains_(num_chains), mutexes_(new std::mutex[num_chains]) {}
+
+  /* Set the column names of a chain; resets its summary */
+  void set_names(size_t chain, const std::vector<std::string>& names) {
+    std::lock_guard<std::mutex> lock(mutexes_[chain]);
+    chains_[chain].set_names(names);
+  }
+
+  /* Add one sampling draw of a chain */
+  void add(size_t chain, const std::vector<double>& draw) {
+    std::lock_guard<std::mutex> lock(mutexes_[chain]);
+    chains_[chain].add(draw);
+  }
+
+  /* Copy of the summaries of all chains, safe while chains sample */
+  std::vector<chain_summary> snapshot() const {
+    std::vector<chain_summary> chains;
+    chains.reserve(chains_.size());
+    for (size_t i = 0; i < chains_.size(); ++i) {
+      std::lock_guard<std::mutex> lock(mutexes_[i]);
+      chains.push_back(chains_[i]);
+    }
+    return chains;
+  }
+
+  size_t num_chains() const { return chains_.size(); }
+
+  // The accessors below read the summaries without locking; use them
+  // once sampling has finished, or snapshot() while chains still sample.
+
+  const chain_summary& chain(size_t i) const { return chains_[i]; }
+
+  /* Column names, taken from the first chain that wrote any */
+  const std::vector<std::string>& names() const {
+    for (const auto& c : chains_) {
+      if (!c.names().empty()) {
+        return c.names();
+      }
+    }
+    return chains_.front().names();
+  }
+
+  /* Total number of sampling draws across chains */
+  size_t num_draws() const {
+    size_t n = 0;
+    for (const auto& c : chains_) {
+      n += c.num_draws();
+    }
+    return n;
+  }
+
+  /* Summary of column j across the chains that wrote it */
+  column_summary summarize(size_t j) const { return summarize_column(chains_, j); }
+
+  /**
+   * Write the summary as one JSON object with a record per column,
+   * holding its mean, sd, mcse_mean, ess and rhat.
+   *
+   * @param writer Structured writer for the summary file
+   * @param model_name Name of the Stan model
+   */
+  void write(stan::callbacks::structured_writer& writer,
+             const std::string& model_name) const {
+    writer.begin_record();
+    writer.write("model_name", model_name);
+    writer.write("num_chains", chains_.size());
+    writer.write("num_draws", num_draws());
+    writer.begin_record("variables");
+    const auto& cols = names();
+    for (size_t j = 0; j < cols.size(); ++j) {
+      column_summary s = summarize(j);
+      writer.begin_record(cols[j]);
+      writer.write("mean", s.mean);
+      writer.write("sd", s.sd);
+      writer.write("mcse_mean", s.mcse_mean);
+      writer.write("ess", s.ess);
+      writer.write("rhat", s.rhat);
+      writer.end_record();
+    }
+    writer.end_record();
+    writer.end_record();
+  }
+
+private:
+  std::vector<chain_summary> chains_;
+  std::unique_ptr<std::mutex[]> mutexes_;
+};
+
+/**
+ * Decides when a run has converged: when every monitored column of the
+ * sampling draws has reached the target effective sample size and split
+ * R-hat.
+ *
+ * Sampler diagnostics (columns ending in "__" other than lp__) and
+ * constant columns are not monitored. A check combines a snapshot of all
+ * chains; chains request one every check_interval of their sampling
+ * draws, and nothing is checked until every chain has check_interval
+ * draws. The first check that meets the targets calls on_converged.
+ */
+class convergence_monitor {
+public:
+  /**
+   * @param summary Online summary of the run
+   * @param target_ess Minimum ESS of every column, or 0 for no ESS target
+   * @param target_rhat Maximum split R-hat of every column, or 0 for no
+   *   R-hat target
+   * @param on_converged Called once, by the chain whose check met the targets
+   * @param check_interval Number of draws of a chain between its checks
+   */
+  convergence_monitor(const online_summary& summary, double target_ess,
+                      double target_rhat, std::function<void()> on_converged,
+                      size_t check_interval = 100)
+    : summary_(summary), target_ess_(target_ess), target_rhat_(target_rhat),
+      on_converged_(std::move(on_converged)),
+      check_interval_(std::max<size_t>(1, check_interval)) {}
+
+  /* Called by a chain once it has added its num_draws-th sampling draw;
+   * a chain arriving while another one checks skips its check */
+  void draw_added(size_t num_draws) {
+    if (num_draws % check_interval_ != 0 || converged()) {
+      return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+    if (!lock.owns_lock() || converged()) {
+      return;
+    }
+    if (targets_met()) {
+      converged_.store(true);
+      on_converged_();
+    }
+  }
+
+  /* True once a check has met the targets */
+  bool converged() const { return converged_.load(); }
+
+  /* Check the targets against a snapshot of the summary */
+  bool targets_met() const {
+    auto chains = summary_.snapshot();
+    for (const auto& c : chains) {
+      if (c.num_draws() < check_interval_) {
+        return false;
+      }
+    }
+    const auto& names = chains.front().names();
+    for (size_t j = 0; j < names.size(); ++j) {
+      const std::string& name = names[j];
+      if (name != "lp__" && name.size() > 2
+          && name.compare(name.size() - 2, 2, "__") == 0) {
+        continue;
+      }
+      column_summary s = summarize_column(chains, j);
+      if (s.sd == 0) {
+        continue;
+      }
+      if (target_ess_ > 0 && !(s.ess >= target_ess_)) {
+        return false;
+      }
+      if (target_rhat_ > 0 && !(s.rhat <= target_rhat_)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  const online_summary& summary_;
+  double target_ess_;
+  double target_rhat_;
+  std::function<void()> on_converged_;
+  size_t check_interval_;
+  std::mutex mutex_;
+  std::atomic<bool> converged_{false};
+};
+
+/**
+ * Writer that forwards to another writer and adds every sampling draw to
+ * the chain's online summary. Rows before the sampling draws, the saved
+ * warmup, are forwarded but not summarized. Does not own the wrapped
+ * writer.
+ */
+class summary_writer : public stan::callbacks::writer {
+public:
+  /**
+   * @param writer Writer to forward to
+   * @param summary Online summary of the run
+   * @param chain Chain index (0-based)
+   * @param num_warmup_draws Number of leading rows that are warmup draws
+   * @param monitor Convergence monitor told about every sampling draw,
+   *   or null
+   */
+  summary_writer(stan::callbacks::writer& writer, online_summary& summary,
+                 size_t chain, size_t num_warmup_draws = 0,
+                 convergence_monitor* monitor = nullptr)
+    : writer_(writer), summary_(summary), chain_(chain),
+      skip_(num_warmup_draws), monitor_(monitor) {}
+
+  void operator()(const std::vector<std::string>& names) override {
+    writer_(names);
+    summary_.set_names(chain_, names);
+  }
+
+  void operator()(const std::vector<double>& state) override {
+    writer_(state);
+    if (skip_ > 0) {
+      --skip_;
+      return;
+    }
+    summary_.add(chain_, state);
+    ++num_draws_;
+    if (monitor_) {
+      monitor_->draw_added(num_draws_);
+    }
+  }
+
+  void operator()() override { writer_(); }
+
+  void operator()(const std::string& message) override { writer_(message); }
+
+private:
+  stan::callbacks::writer& writer_;
+  online_summary& summary_;
+  size_t chain_;
+  size_t skip_;
+  convergence_monitor* monitor_;
+  size_t num_draws_ = 0;
+};
+
+}  // namespace stan3
+
+#endif  // STAN3_ONLINE_SUMMARY_HPP
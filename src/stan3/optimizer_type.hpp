@@ -0,0 +1,13 @@
+#ifndef STAN3_OPTIMIZER_TYPE_HPP
+#define STAN3_OPTIMIZER_TYPE_HPP
+
+namespace stan3 {
+
+enum class optimizer_t {
+    LBFGS = 0,
+    BFGS = 1,
+    NEWTON = 2
+};
+
+}  // namespace stan3
+#endif
@@ -0,0 +1,12 @@
+#ifndef STAN3_OUTPUT_FORMAT_TYPE_HPP
+#define STAN3_OUTPUT_FORMAT_TYPE_HPP
+
+namespace stan3 {
+
+enum class output_format_t {
+    CSV = 0,
+    BINARY = 1
+};
+
+}  // namespace stan3
+#endif
@@ -4,6 +4,10 @@
 #include <stan/callbacks/json_writer.hpp>
 #include <stan/callbacks/unique_stream_writer.hpp>
 #include <stan3/arguments.hpp>
+#include <stan3/async_writer.hpp>
+#include <stan3/binary_writer.hpp>
+#include <stan3/csv_stream_writer.hpp>
+#include <stan3/zstd_stream.hpp>
 
 #include <chrono>
 #include <filesystem>
@@ -20,6 +24,9 @@ namespace stan3 {
 // Convenience aliases for commonly used writer types
 using csv_writer = stan::callbacks::unique_stream_writer<std::ofstream>;
 using json_writer = stan::callbacks::json_writer<std::ofstream>;
+using binary_writer = binary_stream_writer<std::ofstream>;
+// CSV writer for draws files, formatting without iostreams
+using fast_csv_writer = csv_stream_writer<std::ofstream>;
 
 /**
  * Generate a timestamp string in format YYYYMMDD_HHMMSS
@@ -53,6 +60,22 @@ inline std::string generate_filename(const std::string& model_name,
          + "_" + data_type + extension;
 }
 
+/**
+ * Generate filename for output files shared by all chains of a run
+ * 
+ * @param model_name Name of the Stan model
+ * @param timestamp Timestamp string
+ * @param data_type Type of data ("sample", "start_params", "param_grads", "metric")
+ * @param extension File extension (".csv" or ".json")
+ * @return Complete filename
+ */
+inline std::string generate_shared_filename(const std::string& model_name,
+                                            const std::string& timestamp,
+                                            const std::string& data_type,
+                                            const std::string& extension) {
+  return model_name + "_" + timestamp + "_" + data_type + extension;
+}
+
 /**
  * Create output directory if it doesn't exist
  * 
@@ -89,40 +112,78 @@ namespace traits {
   
   template <typename Stream, typename Deleter>
   struct is_stream_writer<stan::callbacks::unique_stream_writer<Stream, Deleter>> : std::true_type {};
+
+  template <typename Stream, typename Deleter>
+  struct is_stream_writer<csv_stream_writer<Stream, Deleter>> : std::true_type {};
   
   template <typename T>
   struct is_json_writer : std::false_type {};
   
   template <typename Stream, typename Deleter>
   struct is_json_writer<stan::callbacks::json_writer<Stream, Deleter>> : std::true_type {};
+
+  template <typename T>
+  struct is_binary_writer : std::false_type {};
+
+  template <typename Stream, typename Deleter>
+  struct is_binary_writer<binary_stream_writer<Stream, Deleter>> : std::true_type {};
+
+  template <typename T>
+  struct is_async_writer : std::false_type {};
+
+  template <typename WriterType>
+  struct is_async_writer<async_writer<WriterType>> : std::true_type {};
 }
 
 /**
- * Create writer helper function for stream writers
+ * Create writer helper function for stream writers; the file is
+ * zstd-compressed when compression is enabled
  */
 template <typename WriterType>
 typename std::enable_if<traits::is_stream_writer<WriterType>::value, 
                        std::unique_ptr<WriterType>>::type
-inline create_writer_impl(const std::string& filepath, const std::string& comment_prefix) {
-  auto stream = std::make_unique<std::ofstream>(filepath);
-  if (!stream->is_open()) {
-    throw std::runtime_error("Cannot open output file: " + filepath);
-  }
-  return std::make_unique<WriterType>(std::move(stream), comment_prefix);
+inline create_writer_impl(const std::string& filepath, const std::string& comment_prefix,
+                          const output_compression& compression = {}) {
+  return std::make_unique<WriterType>(open_output_stream(filepath, false, compression),
+                                      comment_prefix);
 }
 
 /**
- * Create writer helper function for JSON writers
+ * Create writer helper function for JSON writers; these small files are
+ * never compressed
  */
 template <typename WriterType>
 typename std::enable_if<traits::is_json_writer<WriterType>::value, 
                        std::unique_ptr<WriterType>>::type
-inline create_writer_impl(const std::string& filepath, const std::string&) {
-  auto stream = std::make_unique<std::ofstream>(filepath);
-  if (!stream->is_open()) {
-    throw std::runtime_error("Cannot open output file: " + filepath);
-  }
-  return std::make_unique<WriterType>(std::move(stream));
+inline create_writer_impl(const std::string& filepath, const std::string&,
+                          const output_compression& = {}) {
+  return std::make_unique<WriterType>(open_output_stream(filepath, false));
+}
+
+/**
+ * Create writer helper function for binary draws writers; the file is
+ * zstd-compressed when compression is enabled
+ */
+template <typename WriterType>
+typename std::enable_if<traits::is_binary_writer<WriterType>::value, 
+                       std::unique_ptr<WriterType>>::type
+inline create_writer_impl(const std::string& filepath, const std::string&,
+                          const output_compression& compression = {}) {
+  return std::make_unique<WriterType>(open_output_stream(filepath, true, compression));
+}
+
+/**
+ * Create writer helper function for asynchronous writers: the wrapped
+ * writer is created for the same file and driven by a background thread
+ */
+template <typename WriterType>
+typename std::enable_if<traits::is_async_writer<WriterType>::value, 
+                       std::unique_ptr<WriterType>>::type
+inline create_writer_impl(const std::string& filepath, const std::string& comment_prefix,
+                          const output_compression& compression = {}) {
+  return std::make_unique<WriterType>(
+      create_writer_impl<typename WriterType::writer_type>(filepath, comment_prefix,
+                                                           compression));
 }
 
 /**
@@ -133,8 +194,10 @@ inline create_writer_impl(const std::string& filepath, const std::string&) {
  * @param timestamp Timestamp string
  * @param chain_id Chain number (1-indexed)
  * @param data_type Type of data (e.g., "sample", "metric")
- * @param extension File extension (e.g., ".csv", ".json")
+ * @param extension File extension (e.g., ".csv", ".json", ".bin")
  * @param comment_prefix Optional comment prefix (only used for stream writers)
+ * @param compression Compression of the file; when enabled, ".zst" is
+ *   appended to the extension
  * @return Unique pointer to the requested writer type
  */
 template <typename WriterType>
@@ -145,11 +208,14 @@ inline create_writer(const std::string& output_dir,
              unsigned int chain_id,
              const std::string& data_type,
              const std::string& extension,
-             const std::string& comment_prefix = "") {
+             const std::string& comment_prefix = "",
+             const output_compression& compression = {}) {
   std::string filename = generate_filename(model_name, timestamp, chain_id, 
-                                          data_type, extension);
+                                          data_type,
+                                          compression.enabled() ? extension + ".zst"
+                                                                : extension);
   std::string filepath = create_file_path(output_dir, filename);
-  return create_writer_impl<WriterType>(filepath, comment_prefix);
+  return create_writer_impl<WriterType>(filepath, comment_prefix, compression);
 }
 
 
@@ -0,0 +1,230 @@
+#ifndef STAN3_PARALLEL_CHAINS_HPP
+#define STAN3_PARALLEL_CHAINS_HPP
+
+#include <stan/callbacks/interrupt.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/partitioner.h>
+#include <tbb/task_arena.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace stan3 {
+
+/* Whether chains may evaluate gradients concurrently.
+ *
+ * The Stan Math autodiff stack is only thread-local when the model is
+ * compiled with STAN_THREADS; without it, chains must run sequentially.
+ */
+inline constexpr bool threading_enabled() {
+#ifdef STAN_THREADS
+  return true;
+#else
+  return false;
+#endif
+}
+
+/* Thrown by shared_interrupt to unwind a chain after a stop request */
+struct chain_interrupted : public std::runtime_error {
+  chain_interrupted() : std::runtime_error("Chain interrupted") {}
+};
+
+/* Interrupt shared by all concurrently running chains.
+ *
+ * Forwards each check to the caller's interrupt, serialized because the
+ * caller's interrupt need not be thread-safe, and unwinds the calling
+ * chain with chain_interrupted once request_stop() has been called.
+ */
+class shared_interrupt : public stan::callbacks::interrupt {
+public:
+  explicit shared_interrupt(stan::callbacks::interrupt& base) : base_(base) {}
+
+  void operator()() override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      base_();
+    }
+    if (stop_requested()) {
+      throw chain_interrupted();
+    }
+  }
+
+  void request_stop() { stop_.store(true, std::memory_order_relaxed); }
+
+  bool stop_requested() const { return stop_.load(std::memory_order_relaxed); }
+
+private:
+  stan::callbacks::interrupt& base_;
+  std::mutex mutex_;
+  std::atomic<bool> stop_{false};
+};
+
+/* Split of a thread budget between concurrently running chains and the
+ * threads each chain's log density evaluations use for reduce_sum and
+ * map_rect */
+struct thread_allocation {
+  unsigned int parallel_chains = 1;
+  unsigned int threads_per_chain = 1;
+};
+
+/* Split num_threads threads between num_chains chains
+ *
+ * With threads_per_chain 0, as many chains as possible run concurrently
+ * and share the budget evenly; otherwise each chain gets
+ * threads_per_chain threads and num_threads / threads_per_chain chains
+ * run at a time. Without STAN_THREADS everything runs on one thread.
+ *
+ * @param num_chains Number of chains
+ * @param num_threads Maximum number of threads of all chains together
+ * @param threads_per_chain Threads of each chain, 0 for an even split
+ * @return Concurrent chains and threads per chain, both at least 1
+ */
+inline thread_allocation allocate_threads(size_t num_chains, unsigned int num_threads,
+                                          unsigned int threads_per_chain) {
+  thread_allocation allocation;
+  if (!threading_enabled() || num_chains == 0) {
+    return allocation;
+  }
+  num_threads = std::max(1u, num_threads);
+  if (threads_per_chain == 0) {
+    allocation.parallel_chains = static_cast<unsigned int>(
+      std::min<size_t>(num_chains, num_threads));
+    allocation.threads_per_chain = num_threads / allocation.parallel_chains;
+  } else {
+    allocation.threads_per_chain = std::min(threads_per_chain, num_threads);
+    allocation.parallel_chains = static_cast<unsigned int>(
+      std::min<size_t>(num_chains, num_threads / allocation.threads_per_chain));
+  }
+  return allocation;
+}
+
+/* Run f() on a task arena of num_threads threads of its own, nested in
+ * the calling one, so that the parallel algorithms it calls, such as a
+ * model's reduce_sum, use those threads and chains running side by side
+ * do not take each other's. With one thread f runs in the calling arena.
+ */
+template <typename F>
+void run_in_chain_arena(unsigned int num_threads, F&& f) {
+  if (num_threads <= 1) {
+    f();
+    return;
+  }
+  tbb::task_arena arena(static_cast<int>(num_threads));
+  arena.execute(f);
+}
+
+/**
+ * Scope in which run_chains_parallel() on the calling thread runs its
+ * chains as tasks of the calling arena rather than of an arena of their
+ * own, so that they share its threads with the other work there. The
+ * jobs of a batch run in such scopes: threads that finish a chain or a
+ * job take over pending chains of any other job. Scopes nest.
+ */
+class shared_pool_scope {
+public:
+  shared_pool_scope() { ++depth(); }
+  ~shared_pool_scope() { --depth(); }
+
+  shared_pool_scope(const shared_pool_scope&) = delete;
+  shared_pool_scope& operator=(const shared_pool_scope&) = delete;
+
+  /* Whether the calling thread is in a scope */
+  static bool active() { return depth() > 0; }
+
+private:
+  static int& depth() {
+    thread_local int scopes = 0;
+    return scopes;
+  }
+};
+
+/* Run task(i) for each chain index i in [0, num_chains) on a dedicated
+ * TBB task arena with at most num_threads threads, or, in a
+ * shared_pool_scope, as tasks of the calling arena.
+ *
+ * Exceptions are captured per chain so that one failing chain does not
+ * leave the others running unobserved; callers decide how to report them.
+ *
+ * @param num_chains Number of chains
+ * @param num_threads Maximum number of concurrently running chains
+ * @param task Callable taking the 0-based chain index
+ * @return One exception_ptr per chain, null for chains that succeeded
+ */
+template <typename F>
+std::vector<std::exception_ptr> run_chains_parallel(size_t num_chains,
+                                                    unsigned int num_threads,
+                                                    F&& task) {
+  std::vector<std::exception_ptr> errors(num_chains);
+  if (num_chains == 0) {
+    return errors;
+  }
+  auto run_all = [&] {
+    tbb::parallel_for(
+      tbb::blocked_range<size_t>(0, num_chains, 1),
+      [&](const tbb::blocked_range<size_t>& r) {
+        for (size_t i = r.begin(); i != r.end(); ++i) {
+          try {
+            task(i);
+          } catch (...) {
+            errors[i] = std::current_exception();
+          }
+        }
+      },
+      tbb::simple_partitioner());
+  };
+  if (shared_pool_scope::active()) {
+    run_all();
+    return errors;
+  }
+  int concurrency = static_cast<int>(
+    std::max<size_t>(1, std::min<size_t>(num_threads, num_chains)));
+  tbb::task_arena arena(concurrency);
+  arena.execute(run_all);
+  return errors;
+}
+
+/* Report the chains of a run_chains_parallel() result that failed or
+ * stopped early on std::cerr, and rethrow the error of the first chain
+ * that failed; chains stopped through a shared_interrupt are not failures
+ *
+ * @param errors One exception_ptr per chain, null for chains that succeeded
+ * @throws The exception of the first failed chain, if any
+ */
+inline void rethrow_first_chain_error(const std::vector<std::exception_ptr>& errors) {
+  std::exception_ptr first_error;
+  for (size_t i = 0; i < errors.size(); ++i) {
+    if (!errors[i]) {
+      continue;
+    }
+    try {
+      std::rethrow_exception(errors[i]);
+    } catch (const chain_interrupted&) {
+      std::cerr << "Chain " << (i + 1) << " stopped early" << std::endl;
+    } catch (const std::exception& e) {
+      std::cerr << "Chain " << (i + 1) << " failed: " << e.what() << std::endl;
+      if (!first_error) {
+        first_error = errors[i];
+      }
+    } catch (...) {
+      std::cerr << "Chain " << (i + 1) << " failed" << std::endl;
+      if (!first_error) {
+        first_error = errors[i];
+      }
+    }
+  }
+  if (first_error) {
+    std::rethrow_exception(first_error);
+  }
+}
+
+}  // namespace stan3
+
+#endif  // STAN3_PARALLEL_CHAINS_HPP
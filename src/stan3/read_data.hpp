@@ -0,0 +1,53 @@
+#ifndef STAN3_READ_DATA_HPP
+#define STAN3_READ_DATA_HPP
+
+#include <stan3/binary_var_context.hpp>
+#include <stan3/read_json_data.hpp>
+#include <stan/io/var_context.hpp>
+
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace stan3 {
+
+/* Check whether a data file uses the binary data format
+ *
+ * @param filename Path to the data file
+ * @return true if the file has a ".bin" extension
+ */
+inline bool is_binary_data_file(const std::string& filename) {
+  return std::filesystem::path(filename).extension() == ".bin";
+}
+
+/* Read a binary data file and return it as a var_context.
+ *
+ * @param filename Path to the binary data file
+ * @return std::shared_ptr to a var_context over the mapped file
+ * @throws std::runtime_error if the file cannot be opened or is malformed
+ */
+inline std::shared_ptr<stan::io::var_context> read_binary_data(const std::string& filename) {
+  if (!std::filesystem::exists(filename)) {
+    throw std::runtime_error("Data file does not exist: " + filename);
+  }
+  return std::make_shared<binary_var_context>(filename);
+}
+
+/* Read a data file in the format given by its extension: ".bin" files
+ * use the binary data format, all others are read as JSON.
+ *
+ * @param filename Path to the data file, empty for no data
+ * @return std::shared_ptr to a var_context containing the data
+ * @throws std::runtime_error if the file cannot be read
+ */
+inline std::shared_ptr<stan::io::var_context> read_data(const std::string& filename) {
+  if (!filename.empty() && is_binary_data_file(filename)) {
+    return read_binary_data(filename);
+  }
+  return read_json_data(filename);
+}
+
+}  // namespace stan3
+
+#endif  // STAN3_READ_DATA_HPP
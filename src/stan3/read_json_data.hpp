@@ -4,16 +4,25 @@
 #include <stan/io/var_context.hpp>
 #include <stan/io/json/json_data.hpp>
 #include <stan/io/empty_var_context.hpp>
+#include <stan3/mapped_file.hpp>
 
 #include <memory>
 #include <string>
 #include <fstream>
+#include <istream>
+#include <sstream>
 #include <stdexcept>
 #include <filesystem>
+#include <vector>
+#include <cctype>
 
 namespace stan3 {
 
 /* Read JSON data from a file and return it as a var_context.
+ *
+ * The file is memory-mapped and parsed straight from the mapping, which
+ * avoids the buffered copies of an ifstream for large data files. Files
+ * that cannot be mapped are read through an ifstream instead.
  *
  * @param filename Path to the JSON file
  * @return std::shared_ptr to a var_context containing the parsed JSON data
@@ -24,6 +33,13 @@ inline std::shared_ptr<stan::io::var_context> read_json_data(const std::string&
     return std::make_shared<stan::io::empty_var_context>();
   }
     
+  mapped_file mapping(filename);
+  if (mapping.is_open()) {
+    memory_streambuf buf(mapping.data(), mapping.size());
+    std::istream in(&buf);
+    return std::make_shared<stan::json::json_data>(in);
+  }
+
   std::ifstream in(filename);
   if (!in) {
     if (!std::filesystem::exists(filename)) {
@@ -35,6 +51,104 @@ inline std::shared_ptr<stan::io::var_context> read_json_data(const std::string&
   return std::make_shared<stan::json::json_data>(in);
 }
 
+/* Top-level elements of a JSON array, as text
+ *
+ * @param text JSON text holding one array
+ * @return The elements in order, without surrounding whitespace
+ * @throws std::runtime_error if the text is not a complete JSON array
+ */
+inline std::vector<std::string> split_json_array(const std::string& text) {
+  size_t pos = text.find_first_not_of(" \t\r\n");
+  if (pos == std::string::npos || text[pos] != '[') {
+    throw std::runtime_error("Expected a JSON array");
+  }
+  std::vector<std::string> elements;
+  std::string element;
+  int depth = 0;
+  bool in_string = false;
+  for (++pos; pos < text.size(); ++pos) {
+    char c = text[pos];
+    if (in_string) {
+      element += c;
+      if (c == '\\' && pos + 1 < text.size()) {
+        element += text[++pos];
+      } else if (c == '"') {
+        in_string = false;
+      }
+      continue;
+    }
+    if (depth == 0 && (c == ',' || c == ']')) {
+      size_t begin = element.find_first_not_of(" \t\r\n");
+      if (begin != std::string::npos) {
+        elements.push_back(element.substr(begin, element.find_last_not_of(" \t\r\n") + 1 - begin));
+      } else if (c == ',' || !elements.empty()) {
+        throw std::runtime_error("Empty element in JSON array");
+      }
+      element.clear();
+      if (c == ']') {
+        return elements;
+      }
+      continue;
+    }
+    if (c == '"') {
+      in_string = true;
+    } else if (c == '{' || c == '[') {
+      ++depth;
+    } else if (c == '}' || c == ']') {
+      --depth;
+    }
+    element += c;
+  }
+  throw std::runtime_error("Unterminated JSON array");
+}
+
+/* Records of a JSON file holding one object, or an array of per-chain
+ * objects such as the metric file written with --single-file */
+struct json_records {
+  // True if the file held an array, whose i-th record belongs to chain i
+  bool per_chain = false;
+  // Parsed records; null for array elements that are null
+  std::vector<std::shared_ptr<stan::io::var_context>> records;
+};
+
+/* Read a JSON file holding either one object or an array of objects
+ *
+ * @param filename Path to the JSON file, empty for no data
+ * @return The records of the file
+ * @throws std::runtime_error if the file cannot be opened or parsed
+ */
+inline json_records read_json_records(const std::string& filename) {
+  json_records result;
+  std::string text;
+  {
+    mapped_file mapping(filename);
+    if (mapping.is_open()) {
+      const char* end = mapping.data() + mapping.size();
+      const char* first = mapping.data();
+      while (first != end && std::isspace(static_cast<unsigned char>(*first))) {
+        ++first;
+      }
+      if (first != end && *first == '[') {
+        text.assign(first, end);
+      }
+    }
+  }
+  if (text.empty()) {
+    result.records.push_back(read_json_data(filename));
+    return result;
+  }
+  result.per_chain = true;
+  for (const std::string& element : split_json_array(text)) {
+    if (element == "null") {
+      result.records.push_back(nullptr);
+      continue;
+    }
+    std::istringstream in(element);
+    result.records.push_back(std::make_shared<stan::json::json_data>(in));
+  }
+  return result;
+}
+
 }  // namespace stan3
 
 #endif  // STAN3_READ_JSON_DATA_HPP
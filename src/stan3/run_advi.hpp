@@ -0,0 +1,290 @@
+#ifndef STAN3_RUN_ADVI_HPP
+#define STAN3_RUN_ADVI_HPP
+
+#include <stan3/arguments.hpp>
+#include <stan3/output_writers.hpp>
+#include <stan3/parallel_chains.hpp>
+#include <stan3/read_json_data.hpp>
+#include <stan3/variational_type.hpp>
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/math/prim.hpp>
+#include <stan/model/gradient.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <stan/services/util/initialize.hpp>
+#include <stan/variational/advi.hpp>
+#include <stan/variational/families/normal_fullrank.hpp>
+#include <stan/variational/families/normal_meanfield.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan3 {
+
+/* Monte Carlo estimate of the ELBO gradient with the model gradients of
+ * the draws evaluated in parallel on the current tbb arena
+ *
+ * The standard normal draws eta are generated serially from rng, so the
+ * estimate is the same for any number of threads; the gradients at
+ * zeta = q.transform(eta) are then evaluated concurrently. As in Stan's
+ * serial estimator, a draw whose gradient cannot be evaluated or is not
+ * finite fails the whole estimate; print statements and accumulate are
+ * handled in draw order up to that draw.
+ *
+ * @param q Variational approximation
+ * @param model Stan model
+ * @param n_monte_carlo_grad Number of draws
+ * @param rng Random number generator of the ADVI run
+ * @param logger Logger for print statements of the model
+ * @param function Name of the caller for error messages
+ * @param accumulate Called serially, in draw order, with the gradient
+ *   and eta of each draw
+ * @throws std::domain_error if the gradient of a draw fails
+ */
+template <class Q, class Model, class BaseRNG, class F>
+void parallel_monte_carlo_grad(const Q& q, Model& model, int n_monte_carlo_grad,
+                               BaseRNG& rng, stan::callbacks::logger& logger,
+                               const char* function, F&& accumulate) {
+  const int dimension = q.dimension();
+  std::vector<Eigen::VectorXd> etas(n_monte_carlo_grad);
+  std::vector<Eigen::VectorXd> grads(n_monte_carlo_grad);
+  std::vector<char> succeeded(n_monte_carlo_grad, 0);
+  std::vector<std::string> messages(n_monte_carlo_grad);
+  for (int m = 0; m < n_monte_carlo_grad; ++m) {
+    etas[m].resize(dimension);
+    for (int d = 0; d < dimension; ++d) {
+      etas[m](d) = stan::math::normal_rng(0, 1, rng);
+    }
+  }
+
+  tbb::parallel_for(tbb::blocked_range<int>(0, n_monte_carlo_grad),
+                    [&](const tbb::blocked_range<int>& r) {
+    for (int m = r.begin(); m != r.end(); ++m) {
+      std::stringstream ss;
+      try {
+        Eigen::VectorXd zeta = q.transform(etas[m]);
+        double lp = 0;
+        stan::model::gradient(model, zeta, lp, grads[m], &ss);
+        stan::math::check_finite(function, "Gradient of mu", grads[m]);
+        succeeded[m] = 1;
+      } catch (const std::exception&) {
+        succeeded[m] = 0;
+      }
+      messages[m] = ss.str();
+    }
+  });
+
+  for (int m = 0; m < n_monte_carlo_grad; ++m) {
+    if (!messages[m].empty()) {
+      logger.info(messages[m]);
+    }
+    if (!succeeded[m]) {
+      stan::math::throw_domain_error(
+          function, "The number of dropped evaluations", n_monte_carlo_grad,
+          "has reached its maximum amount (",
+          "). Your model may be either severely ill-conditioned or misspecified.");
+    }
+    accumulate(grads[m], etas[m]);
+  }
+}
+
+/**
+ * Mean-field Gaussian family whose ELBO gradient evaluates its Monte
+ * Carlo draws in parallel (see parallel_monte_carlo_grad). All other
+ * operations are those of stan::variational::normal_meanfield.
+ */
+class parallel_normal_meanfield : public stan::variational::normal_meanfield {
+public:
+  using stan::variational::normal_meanfield::normal_meanfield;
+
+  // Results of the base class arithmetic convert back to this family
+  parallel_normal_meanfield(const stan::variational::normal_meanfield& q)  // NOLINT
+    : stan::variational::normal_meanfield(q) {}
+
+  template <class Model, class BaseRNG>
+  void calc_grad(parallel_normal_meanfield& elbo_grad, Model& model,
+                 Eigen::VectorXd& cont_params, int n_monte_carlo_grad,
+                 BaseRNG& rng, stan::callbacks::logger& logger) const {
+    static const char* function = "stan3::parallel_normal_meanfield::calc_grad";
+    stan::math::check_size_match(function, "Dimension of elbo_grad", elbo_grad.dimension(),
+                                 "Dimension of variational q", dimension());
+    stan::math::check_size_match(function, "Dimension of variational q", dimension(),
+                                 "Dimension of variables in model", cont_params.size());
+
+    Eigen::VectorXd mu_grad = Eigen::VectorXd::Zero(dimension());
+    Eigen::VectorXd omega_grad = Eigen::VectorXd::Zero(dimension());
+    parallel_monte_carlo_grad(*this, model, n_monte_carlo_grad, rng, logger, function,
+        [&](const Eigen::VectorXd& grad, const Eigen::VectorXd& eta) {
+          mu_grad += grad;
+          omega_grad.array() += grad.array().cwiseProduct(eta.array());
+        });
+    mu_grad /= static_cast<double>(n_monte_carlo_grad);
+    omega_grad /= static_cast<double>(n_monte_carlo_grad);
+
+    // Scale by exp(omega) and add the gradient of the entropy
+    omega_grad.array() = omega_grad.array().cwiseProduct(omega().array().exp());
+    omega_grad.array() += 1.0;
+
+    elbo_grad.set_mu(mu_grad);
+    elbo_grad.set_omega(omega_grad);
+  }
+};
+
+/**
+ * Full-rank Gaussian family whose ELBO gradient evaluates its Monte Carlo
+ * draws in parallel (see parallel_monte_carlo_grad). All other operations
+ * are those of stan::variational::normal_fullrank.
+ */
+class parallel_normal_fullrank : public stan::variational::normal_fullrank {
+public:
+  using stan::variational::normal_fullrank::normal_fullrank;
+
+  // Results of the base class arithmetic convert back to this family
+  parallel_normal_fullrank(const stan::variational::normal_fullrank& q)  // NOLINT
+    : stan::variational::normal_fullrank(q) {}
+
+  template <class Model, class BaseRNG>
+  void calc_grad(parallel_normal_fullrank& elbo_grad, Model& model,
+                 Eigen::VectorXd& cont_params, int n_monte_carlo_grad,
+                 BaseRNG& rng, stan::callbacks::logger& logger) const {
+    static const char* function = "stan3::parallel_normal_fullrank::calc_grad";
+    stan::math::check_size_match(function, "Dimension of elbo_grad", elbo_grad.dimension(),
+                                 "Dimension of variational q", dimension());
+    stan::math::check_size_match(function, "Dimension of variational q", dimension(),
+                                 "Dimension of variables in model", cont_params.size());
+
+    const int dim = dimension();
+    Eigen::VectorXd mu_grad = Eigen::VectorXd::Zero(dim);
+    Eigen::MatrixXd L_grad = Eigen::MatrixXd::Zero(dim, dim);
+    parallel_monte_carlo_grad(*this, model, n_monte_carlo_grad, rng, logger, function,
+        [&](const Eigen::VectorXd& grad, const Eigen::VectorXd& eta) {
+          mu_grad += grad;
+          for (int i = 0; i < dim; ++i) {
+            for (int j = 0; j <= i; ++j) {
+              L_grad(i, j) += grad(i) * eta(j);
+            }
+          }
+        });
+    mu_grad /= static_cast<double>(n_monte_carlo_grad);
+    L_grad /= static_cast<double>(n_monte_carlo_grad);
+
+    // Add the gradient of the entropy
+    L_grad.diagonal().array() += L_chol().diagonal().array().inverse();
+
+    elbo_grad.set_mu(mu_grad);
+    elbo_grad.set_L_chol(L_grad);
+  }
+};
+
+/* Run ADVI with variational family Q, writing the mean of the
+ * approximation and then the approximate draws
+ *
+ * @param args ADVI arguments
+ * @param model Stan model
+ * @param init Initial values; missing parameters are drawn at random
+ * @param logger Logger for messages
+ * @param parameter_writer Writer for the mean and the draws
+ * @return Return code of the ADVI run
+ */
+template <class Q, class Model>
+int run_advi_family(const advi_args& args, Model& model,
+                    const stan::io::var_context& init,
+                    stan::callbacks::logger& logger,
+                    stan::callbacks::writer& parameter_writer) {
+  auto rng = stan::services::util::create_rng(args.base.model.random_seed, 1);
+  stan::callbacks::writer init_writer;
+  stan::callbacks::writer diagnostic_writer;
+
+  std::vector<double> cont_vector = stan::services::util::initialize(
+      model, init, rng, args.base.init.init_radius, true, logger, init_writer);
+
+  std::vector<std::string> names{"lp__", "log_p__", "log_g__"};
+  model.constrained_param_names(names, true, true);
+  parameter_writer(names);
+
+  Eigen::VectorXd cont_params
+      = Eigen::Map<Eigen::VectorXd>(cont_vector.data(), cont_vector.size());
+  stan::variational::advi<Model, Q, decltype(rng)> advi(
+      model, cont_params, rng, args.grad_samples, args.elbo_samples, args.eval_elbo,
+      args.output_draws);
+  return advi.run(args.eta, args.adapt_engaged, args.adapt_iterations, args.tol_rel_obj,
+                  args.num_iterations, logger, parameter_writer, diagnostic_writer);
+}
+
+/* Function to run the ADVI algorithm
+ *
+ * The Monte Carlo ELBO gradient evaluates its --grad-samples draws on up
+ * to --num-threads threads when the model is compiled with STAN_THREADS.
+ * Writes the mean of the approximation followed by the approximate draws
+ * to <model>_<timestamp>_advi.csv.
+ *
+ * @param args ADVI arguments
+ * @param model Stan model
+ * @return 0 on success, 1 on error
+ */
+template <class Model>
+int run_advi(const advi_args& args, Model& model) {
+  try {
+    stan::callbacks::stream_logger logger(std::cout, std::cout, std::cout,
+                                         std::cerr, std::cerr);
+
+    std::shared_ptr<const stan::io::var_context> init;
+    try {
+      init = read_json_data(get_init_file_for_chain(args.base.init, 0));
+    } catch (const std::exception& e) {
+      throw std::invalid_argument("Error reading initial parameter values file: "
+                                  + std::string(e.what()));
+    }
+
+    ensure_output_directory(args.base.output_dir);
+    std::string output_file = create_file_path(
+        args.base.output_dir, model.model_name() + "_" + generate_timestamp() + "_advi.csv");
+    auto writer = create_writer_impl<csv_writer>(output_file, "#");
+
+    if (args.base.num_threads > 1 && !threading_enabled()) {
+      logger.warn("A parallel ELBO gradient requires a model compiled with "
+                  "STAN_THREADS; evaluating gradient draws sequentially.");
+    }
+    unsigned int num_threads = threading_enabled() ? args.base.num_threads : 1;
+    tbb::task_arena arena(static_cast<int>(
+        std::max<size_t>(1, std::min<size_t>(num_threads, args.grad_samples))));
+
+    int return_code = 0;
+    arena.execute([&] {
+      if (args.algorithm == variational_t::FULLRANK) {
+        return_code = run_advi_family<parallel_normal_fullrank>(args, model, *init,
+                                                                logger, *writer);
+      } else {
+        return_code = run_advi_family<parallel_normal_meanfield>(args, model, *init,
+                                                                 logger, *writer);
+      }
+    });
+    if (return_code != 0) {
+      std::cerr << "Error: ADVI failed with return code " << return_code << std::endl;
+      return 1;
+    }
+
+    std::cout << "ADVI completed successfully!" << std::endl;
+    std::cout << "  Output: " << output_file << std::endl;
+    return 0;
+
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+}
+
+}  // namespace stan3
+
+#endif  // STAN3_RUN_ADVI_HPP
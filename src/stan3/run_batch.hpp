@@ -0,0 +1,195 @@
+#ifndef STAN3_RUN_BATCH_HPP
+#define STAN3_RUN_BATCH_HPP
+
+#include <stan3/arguments.hpp>
+#include <stan3/load_model.hpp>
+#include <stan3/output_writers.hpp>
+#include <stan3/parallel_chains.hpp>
+#include <stan3/run_hmc_nuts.hpp>
+
+#include <stan/model/model_base.hpp>
+
+#include <tbb/global_control.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan3 {
+
+/* One job of a batch: the hmc arguments of a manifest line */
+struct batch_job {
+  size_t line = 0;
+  hmc_nuts_args args;
+};
+
+/* Read the jobs of a batch manifest
+ *
+ * Each non-blank line not starting with '#' holds the options of one job,
+ * as given to the hmc subcommand, e.g. "--data fit1.json --seed 7
+ * --chains 2"; double quotes group words containing spaces. A job without
+ * --output-dir writes to the directory job_<n> of the batch output
+ * directory, n being its 1-based position in the manifest. The chains of
+ * a job run as tasks of the batch's thread pool, so the job's
+ * --num-threads is replaced by its number of chains, at most the batch's
+ * --num-threads.
+ *
+ * @param args Batch arguments
+ * @return Jobs in manifest order
+ * @throws std::invalid_argument naming the line of the first invalid job,
+ *   or if the manifest cannot be read or holds no jobs
+ */
+inline std::vector<batch_job> read_batch_manifest(const batch_args& args) {
+  std::ifstream manifest(args.manifest_file);
+  if (!manifest) {
+    throw std::invalid_argument("Cannot open batch manifest: " + args.manifest_file);
+  }
+  std::vector<batch_job> jobs;
+  std::string line;
+  for (size_t line_number = 1; std::getline(manifest, line); ++line_number) {
+    std::istringstream words(line);
+    std::vector<std::string> tokens{"stan3"};
+    for (std::string token; words >> std::quoted(token);) {
+      tokens.push_back(token);
+    }
+    if (tokens.size() == 1 || tokens[1][0] == '#') {
+      continue;
+    }
+    std::vector<char*> argv;
+    for (auto& token : tokens) {
+      argv.push_back(token.data());
+    }
+
+    batch_job job;
+    job.line = line_number;
+    std::string error_msg;
+    std::string where = args.manifest_file + ":" + std::to_string(line_number);
+    if (!parse_hmc_args(static_cast<int>(argv.size()), argv.data(), job.args, error_msg)) {
+      if (error_msg.rfind("Error: ", 0) == 0) {
+        error_msg.erase(0, 7);
+      }
+      throw std::invalid_argument("Invalid job at " + where + ": " + error_msg);
+    }
+    // Chains adapting together each block a thread, which the jobs
+    // sharing the pool cannot guarantee
+    if (job.args.cross_chain_warmup) {
+      throw std::invalid_argument("Invalid job at " + where
+                                  + ": --cross-chain-warmup is not supported in a batch");
+    }
+    // Each job would pin its chains to the same first cores, leaving the
+    // others idle, while the pool already spreads jobs across all of them
+    if (job.args.affinity) {
+      throw std::invalid_argument("Invalid job at " + where
+                                  + ": --affinity is not supported in a batch");
+    }
+    if (job.args.base.output_dir.empty()) {
+      job.args.base.output_dir = create_file_path(
+        args.output_dir, "job_" + std::to_string(jobs.size() + 1));
+    }
+    // A job never needs more threads than its chains can use at once
+    size_t job_threads = job.args.threads_per_chain == 0
+      ? args.num_threads : job.args.base.num_chains * job.args.threads_per_chain;
+    job.args.base.num_threads = static_cast<unsigned int>(
+      std::min<size_t>(job_threads, args.num_threads));
+    jobs.push_back(std::move(job));
+  }
+  if (jobs.empty()) {
+    throw std::invalid_argument("Batch manifest holds no jobs: " + args.manifest_file);
+  }
+  return jobs;
+}
+
+/* Run run_job(i) for every job index i on one work-stealing thread pool
+ * of at most num_threads threads.
+ *
+ * Jobs are tasks of the pool's arena. Each job runs in a
+ * shared_pool_scope, so the parallel chains of a job are nested tasks of
+ * the same arena rather than of an arena of the job's own: a thread that
+ * finishes a chain or a job takes over pending work of any other job,
+ * and the pool stays busy whatever the number of chains per job. A
+ * chain's --threads-per-chain workers still get an arena of their own.
+ * A failing job does not stop the others.
+ *
+ * @param num_jobs Number of jobs
+ * @param num_threads Maximum number of threads of all jobs together
+ * @param run_job Callable taking the 0-based job index
+ * @return One exception_ptr per job, null for jobs that succeeded
+ */
+template <typename F>
+std::vector<std::exception_ptr> run_batch_jobs(size_t num_jobs, unsigned int num_threads,
+                                               F&& run_job) {
+  tbb::global_control limit(tbb::global_control::max_allowed_parallelism,
+                            std::max(1u, num_threads));
+  return run_chains_parallel(num_jobs, num_threads, [&](size_t i) {
+    shared_pool_scope scope;
+    run_job(i);
+  });
+}
+
+/* Run the HMC-NUTS jobs of a batch manifest
+ *
+ * Every job loads its data into a model instance of its own and runs its
+ * chains like the hmc subcommand, writing to its own output directory.
+ * Without STAN_THREADS, jobs and chains run one at a time.
+ *
+ * @param args Batch arguments
+ * @return 0 if every job succeeded, 1 otherwise
+ */
+inline int run_batch(const batch_args& args) {
+  batch_args batch = args;
+  if (batch.num_threads > 1 && !threading_enabled()) {
+    std::cerr << "Warning: Parallel jobs require a model compiled with STAN_THREADS; "
+              << "running jobs sequentially." << std::endl;
+    batch.num_threads = 1;
+  }
+  std::vector<batch_job> jobs;
+  try {
+    jobs = read_batch_manifest(batch);
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+  std::cout << "Running " << jobs.size() << " jobs on up to " << batch.num_threads
+            << " threads" << std::endl;
+
+  auto errors = run_batch_jobs(jobs.size(), batch.num_threads, [&](size_t i) {
+    const hmc_nuts_args& job_args = jobs[i].args;
+    std::filesystem::create_directories(job_args.base.output_dir);
+    std::unique_ptr<stan::model::model_base> model(&load_model(job_args.base.model));
+    if (run_hmc(job_args, *model) != 0) {
+      throw std::runtime_error("sampling failed");
+    }
+  });
+
+  size_t num_failed = 0;
+  for (size_t i = 0; i < errors.size(); ++i) {
+    if (!errors[i]) {
+      continue;
+    }
+    ++num_failed;
+    std::cerr << "Job " << (i + 1) << " (line " << jobs[i].line << ") failed: ";
+    try {
+      std::rethrow_exception(errors[i]);
+    } catch (const std::exception& e) {
+      std::cerr << e.what() << std::endl;
+    } catch (...) {
+      std::cerr << "unknown error" << std::endl;
+    }
+  }
+  std::cout << (jobs.size() - num_failed) << " of " << jobs.size()
+            << " jobs completed successfully." << std::endl;
+  return num_failed == 0 ? 0 : 1;
+}
+
+}  // namespace stan3
+
+#endif  // STAN3_RUN_BATCH_HPP
@@ -0,0 +1,187 @@
+#ifndef STAN3_RUN_GQ_HPP
+#define STAN3_RUN_GQ_HPP
+
+#include <stan3/arguments.hpp>
+#include <stan3/draws_reader.hpp>
+#include <stan3/output_format_type.hpp>
+#include <stan3/output_writers.hpp>
+#include <stan3/parallel_chains.hpp>
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/model/model_base.hpp>
+#include <stan/services/util/create_rng.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan3 {
+
+/* Evaluate the generated quantities of a model for every draw of a
+ * fitted draws file
+ *
+ * Draws are read in chunks of args.chunk_size; the draws of a chunk are
+ * evaluated concurrently on up to --num-threads threads (STAN_THREADS
+ * builds) and then written in draw order, so memory use is bounded by
+ * the chunk size rather than the number of draws. Draw n (0-indexed)
+ * uses the random stream create_rng(seed, n + 1), which makes the output
+ * independent of the number of threads. A draw whose evaluation fails is
+ * written as NaN and reported through the logger.
+ *
+ * @param args Generated quantities arguments
+ * @param model Stan model the draws were fitted with
+ * @param reader Reader for the fitted draws
+ * @param writer Writer for the generated quantities, one row per draw
+ * @param logger Logger for print statements and failed draws
+ * @return Number of draws evaluated
+ * @throws std::invalid_argument if the model has no generated quantities
+ *   or a parameter is missing from the draws
+ */
+template <class Model>
+size_t generate_quantities(const gq_args& args, const Model& model,
+                           draws_reader& reader, stan::callbacks::writer& writer,
+                           stan::callbacks::logger& logger) {
+  std::vector<std::string> param_names;
+  std::vector<std::string> all_names;
+  model.constrained_param_names(param_names, false, false);
+  model.constrained_param_names(all_names, false, true);
+  const size_t num_params = param_names.size();
+  std::vector<std::string> gq_names(all_names.begin() + num_params, all_names.end());
+  if (gq_names.empty()) {
+    throw std::invalid_argument("Model " + model.model_name()
+                                + " has no generated quantities");
+  }
+
+  std::map<std::string, size_t> columns;
+  for (size_t j = 0; j < reader.column_names().size(); ++j) {
+    columns[reader.column_names()[j]] = j;
+  }
+  std::vector<size_t> param_columns;
+  param_columns.reserve(num_params);
+  for (const auto& name : param_names) {
+    auto it = columns.find(name);
+    if (it == columns.end()) {
+      throw std::invalid_argument("Fitted draws have no column " + name);
+    }
+    param_columns.push_back(it->second);
+  }
+
+  if (args.base.num_threads > 1 && !threading_enabled()) {
+    logger.warn("Parallel generated quantities require a model compiled with "
+                "STAN_THREADS; evaluating draws sequentially.");
+  }
+  unsigned int num_threads = threading_enabled() ? args.base.num_threads : 1;
+  const size_t chunk_size = std::max<size_t>(1, args.chunk_size);
+  tbb::task_arena arena(static_cast<int>(
+      std::max<size_t>(1, std::min<size_t>(num_threads, chunk_size))));
+
+  const size_t num_gqs = gq_names.size();
+  std::vector<std::vector<double>> draws(chunk_size);
+  std::vector<std::vector<double>> values(chunk_size, std::vector<double>(num_gqs));
+  std::vector<std::string> messages(chunk_size);
+
+  writer(gq_names);
+  size_t first = 0;
+  while (true) {
+    size_t n = 0;
+    while (n < chunk_size && reader.next(draws[n])) {
+      ++n;
+    }
+    if (n == 0) {
+      break;
+    }
+
+    arena.execute([&] {
+      tbb::parallel_for(tbb::blocked_range<size_t>(0, n), [&](const tbb::blocked_range<size_t>& r) {
+        Eigen::VectorXd constrained(num_params);
+        Eigen::VectorXd unconstrained;
+        Eigen::VectorXd vars;
+        for (size_t k = r.begin(); k != r.end(); ++k) {
+          std::stringstream msg;
+          try {
+            for (size_t j = 0; j < num_params; ++j) {
+              constrained(j) = draws[k][param_columns[j]];
+            }
+            model.unconstrain_array(constrained, unconstrained, &msg);
+            auto rng = stan::services::util::create_rng(args.base.model.random_seed,
+                                                        first + k + 1);
+            model.write_array(rng, unconstrained, vars, false, true, &msg);
+            std::copy(vars.data() + vars.size() - num_gqs, vars.data() + vars.size(),
+                      values[k].begin());
+          } catch (const std::exception& e) {
+            std::fill(values[k].begin(), values[k].end(),
+                      std::numeric_limits<double>::quiet_NaN());
+            msg << e.what();
+          }
+          messages[k] = msg.str();
+        }
+      });
+    });
+
+    for (size_t k = 0; k < n; ++k) {
+      if (!messages[k].empty()) {
+        logger.info("Draw " + std::to_string(first + k + 1) + ": " + messages[k]);
+      }
+      writer(values[k]);
+    }
+    first += n;
+  }
+  return first;
+}
+
+/* Function to run standalone generated quantities
+ *
+ * Writes the generated quantities of every fitted draw, in draw order, to
+ * <model>_<timestamp>_gq.csv (or .bin with --output-format binary).
+ *
+ * @param args Generated quantities arguments
+ * @param model Stan model
+ * @return 0 on success, 1 on error
+ */
+template <class Model>
+int run_gq(const gq_args& args, const Model& model) {
+  try {
+    stan::callbacks::stream_logger logger(std::cout, std::cout, std::cout,
+                                         std::cerr, std::cerr);
+
+    auto reader = open_draws_reader(args.fitted_params_file);
+    ensure_output_directory(args.base.output_dir);
+    bool binary = args.output_format == output_format_t::BINARY;
+    std::string output_file = create_file_path(
+        args.base.output_dir, model.model_name() + "_" + generate_timestamp()
+                              + "_gq" + (binary ? ".bin" : ".csv"));
+    std::unique_ptr<stan::callbacks::writer> writer;
+    if (binary) {
+      writer = create_writer_impl<binary_writer>(output_file, "");
+    } else {
+      writer = create_writer_impl<fast_csv_writer>(output_file, "#");
+    }
+
+    size_t num_draws = generate_quantities(args, model, *reader, *writer, logger);
+    writer.reset();
+
+    std::cout << "Generated quantities completed for " << num_draws << " draws" << std::endl;
+    std::cout << "  Output: " << output_file << std::endl;
+    return 0;
+
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+}
+
+}  // namespace stan3
+
+#endif  // STAN3_RUN_GQ_HPP
@@ -8,6 +8,7 @@
 #include <stan3/run_samplers.hpp>
 #include <stan3/metric_type.hpp>
 #include <stan3/read_json_data.hpp>
+#include <stan3/run_pathfinder.hpp>
 
 #include <stan/callbacks/interrupt.hpp>
 #include <stan/callbacks/writer.hpp>
@@ -28,67 +29,130 @@ using rng_t = boost::random::mixmax;
 
 namespace stan3 {
 
-/* Function to run HMC algorithm */
+/* Initial values and inverse metrics of the chains of a run */
+struct hmc_contexts {
+  std::vector<std::shared_ptr<const stan::io::var_context>> inits;
+  std::vector<std::shared_ptr<const stan::io::var_context>> metrics;
+};
+
+/* Read the initial values and inverse metric of every chain, running
+ * Pathfinder first for --pathfinder-init. Metrics are only read for
+ * models with parameters.
+ * 
+ * @param args HMC-NUTS arguments
+ * @param model Stan model
+ * @param interrupt Interrupt callback for Pathfinder
+ * @param logger Logger for messages
+ * @return One initial value and one metric context per chain
+ * @throws std::invalid_argument if an init or metric file cannot be read
+ * @throws std::runtime_error if Pathfinder fails
+ */
+template <class Model>
+hmc_contexts load_hmc_contexts(const hmc_nuts_args& args, Model& model,
+                               stan::callbacks::interrupt& interrupt,
+                               stan::callbacks::logger& logger) {
+  std::stringstream err_msg;
+  std::vector<std::string> uparam_names;
+  model.unconstrained_param_names(uparam_names, false, false);
+
+  hmc_contexts contexts;
+  pathfinder_warm_start warm_start;
+  if (args.pathfinder_init && !uparam_names.empty()) {
+    try {
+      std::string draws_file = create_file_path(
+          args.base.output_dir,
+          model.model_name() + "_" + generate_timestamp() + "_pathfinder.csv");
+      run_pathfinder_paths(pathfinder_args_for_hmc(args), model, draws_file,
+                           interrupt, logger);
+      warm_start = read_pathfinder_warm_start(model, draws_file, args.base.num_chains);
+    } catch (const std::exception &e) {
+      err_msg << "Error running Pathfinder for initialization: " << e.what() << std::endl;
+      throw std::runtime_error(err_msg.str());
+    }
+    contexts.inits = warm_start.inits;
+  } else {
+    contexts.inits.reserve(args.base.num_chains);
+    for (size_t i = 0; i < args.base.num_chains; ++i) {
+      std::string init_file = get_init_file_for_chain(args.base.init, i);
+      try {
+        auto init_context = stan3::read_json_data(init_file);
+        contexts.inits.push_back(init_context);
+      } catch (const std::exception &e) {
+        err_msg << "Error reading initial parameter values file for chain " 
+                << (i + 1) << ": " << e.what() << std::endl;
+        throw std::invalid_argument(err_msg.str());
+      }
+    }
+  }
+  if (uparam_names.empty()) {
+    return contexts;
+  }
+
+  // A Pathfinder metric only applies to the diagonal metric and does
+  // not override metric files given explicitly
+  if (warm_start.inv_metric && args.metric_type == metric_t::DIAG_E
+      && args.metric_files.empty()) {
+    contexts.metrics.assign(args.base.num_chains, warm_start.inv_metric);
+  } else {
+    contexts.metrics.reserve(args.base.num_chains);
+    stan3::json_records metric_records;
+    for (size_t i = 0; i < args.base.num_chains; ++i) {
+      std::string metric_file = get_metric_file_for_chain(args, i);
+      try {
+        // Chains given the same file share its read-only records, which
+        // for a dense metric hold N^2 values
+        if (i == 0 || metric_file != get_metric_file_for_chain(args, i - 1)) {
+          metric_records = stan3::read_json_records(metric_file);
+        }
+        // An array, as written with --single-file, holds one record per chain
+        size_t record = metric_records.per_chain ? i : 0;
+        if (record >= metric_records.records.size() || !metric_records.records[record]) {
+          throw std::runtime_error("The file holds no record for this chain");
+        }
+        contexts.metrics.push_back(metric_records.records[record]);
+      } catch (const std::exception &e) {
+        err_msg << "Error reading precomputed inverse metric file for chain " 
+                << (i + 1) << ": " << e.what() << std::endl;
+        throw std::invalid_argument(err_msg.str());
+      }
+    }
+  }
+  return contexts;
+}
+
+/* Run the HMC algorithm, sending each chain's output to the given writers
+ * 
+ * @param args HMC-NUTS arguments
+ * @param model Stan model
+ * @param writers Output writers, one set per chain
+ * @return 0 on success, 1 on error
+ */
 template <bool Jacobian = true, class Model>
-int run_hmc(const hmc_nuts_args& args, Model& model) {
+int run_hmc(const hmc_nuts_args& args, Model& model,
+            const std::vector<hmc_nuts_writers>& writers) {
   std::stringstream err_msg;
   try {
+    validate_output_variables(args, model);
     stan::callbacks::interrupt interrupt;
     stan::callbacks::stream_logger logger(std::cout, std::cout, std::cout,
                                          std::cerr, std::cerr);
-    std::string model_name = model.model_name();
 
-    // Configure outputs
-    std::vector<hmc_nuts_writers> writers;
-    if (args.base.num_chains == 1) {
-      auto timestamp = generate_timestamp();
-      writers.push_back(create_hmc_nuts_single_chain_writers(
-        args, model_name, timestamp, 1));
-    } else {
-      writers = create_hmc_nuts_multi_chain_writers(args, model_name);
-    }
-
-    std::vector<std::string> uparam_names;
-    model.unconstrained_param_names(uparam_names, false, false);
+    // assemble initial param values, initial inverse metric
+    hmc_contexts contexts = load_hmc_contexts(args, model, interrupt, logger);
 
-    if (uparam_names.empty()) {
-      // Handle fixed parameter models
+    if (contexts.metrics.empty()) {
+      // Models without parameters only draw generated quantities
       logger.info("Model has no parameters. Running fixed parameter sampler.");
-      
-      // TODO: Implement fixed parameter sampling if needed
-      // For now, just return success
-      std::cout << "Fixed parameter model detected - no sampling required." << std::endl;
-      return 0;
-    } else {
-      // assemble initial param values, initial inverse metric
-      std::vector<std::shared_ptr<const stan::io::var_context>> init_contexts;
-      init_contexts.reserve(args.base.num_chains);
-      for (size_t i = 0; i < args.base.num_chains; ++i) {
-        std::string init_file = get_init_file_for_chain(args.base.init, i);
-        try {
-          auto init_context = stan3::read_json_data(init_file);
-          init_contexts.push_back(init_context);
-        } catch (const std::exception &e) {
-          err_msg << "Error reading initial parameter values file for chain " 
-                  << (i + 1) << ": " << e.what() << std::endl;
-          throw std::invalid_argument(err_msg.str());
-        }
-      }
-      std::vector<std::shared_ptr<const stan::io::var_context>> metric_contexts;
-      metric_contexts.reserve(args.base.num_chains);
-      for (size_t i = 0; i < args.base.num_chains; ++i) {
-        std::string metric_file = get_metric_file_for_chain(args, i);
-        try {
-          auto metric_context = stan3::read_json_data(metric_file);
-          metric_contexts.push_back(metric_context);
-        } catch (const std::exception &e) {
-          err_msg << "Error reading precomputed inverse metric file for chain " 
-                  << (i + 1) << ": " << e.what() << std::endl;
-          throw std::invalid_argument(err_msg.str());
-        }
+      try {
+        run_fixed_param_samplers(model, args, contexts.inits, writers,
+                                 interrupt, logger);
+      } catch (const std::exception& e) {
+        err_msg << "Error running samplers: " << e.what() << std::endl;
+        throw std::runtime_error(err_msg.str());
       }
+    } else {
       try {
-        run_samplers(model, args, init_contexts, metric_contexts, 
+        run_samplers(model, args, contexts.inits, contexts.metrics,
                     writers, interrupt, logger);
       } catch (const std::exception& e) {
         err_msg << "Error running samplers: " << e.what() << std::endl;
@@ -97,7 +161,6 @@ int run_hmc(const hmc_nuts_args& args, Model& model) {
     }
 
     std::cout << "Sampling completed successfully!" << std::endl;
-    std::cout << "  Output dir: " << args.base.output_dir << std::endl;
     return 0;
 
   } catch (const std::exception& e) {
@@ -106,5 +169,32 @@ int run_hmc(const hmc_nuts_args& args, Model& model) {
   }
 }
 
+/* Function to run HMC algorithm */
+template <bool Jacobian = true, class Model>
+int run_hmc(const hmc_nuts_args& args, Model& model) {
+  std::vector<hmc_nuts_writers> writers;
+  try {
+    // Configure outputs, once the selected variables are known to exist
+    validate_output_variables(args, model);
+    std::string model_name = model.model_name();
+    if (args.base.num_chains == 1) {
+      auto timestamp = generate_timestamp();
+      writers.push_back(create_hmc_nuts_single_chain_writers(
+        args, model_name, timestamp, 1));
+    } else {
+      writers = create_hmc_nuts_multi_chain_writers(args, model_name);
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+
+  int result = run_hmc<Jacobian>(args, model, writers);
+  if (result == 0) {
+    std::cout << "  Output dir: " << args.base.output_dir << std::endl;
+  }
+  return result;
+}
+
 }  // namespace stan3
 #endif  // STAN3_RUN_HMC_HPP
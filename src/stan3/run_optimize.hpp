@@ -0,0 +1,281 @@
+#ifndef STAN3_RUN_OPTIMIZE_HPP
+#define STAN3_RUN_OPTIMIZE_HPP
+
+#include <stan3/arguments.hpp>
+#include <stan3/optimizer_type.hpp>
+#include <stan3/output_writers.hpp>
+#include <stan3/parallel_chains.hpp>
+#include <stan3/read_json_data.hpp>
+
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/io/var_context.hpp>
+#include <stan/services/error_codes.hpp>
+#include <stan/services/optimize/bfgs.hpp>
+#include <stan/services/optimize/lbfgs.hpp>
+#include <stan/services/optimize/newton.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace stan3 {
+
+/* Outcome of one optimization: the return code of the Stan service and
+ * the last iterate, lp__ followed by the constrained values, which is
+ * empty if the run failed before writing any values */
+struct optimize_result {
+  int return_code = stan::services::error_codes::SOFTWARE;
+  std::vector<double> values;
+};
+
+/**
+ * Writer that keeps the last row of values it receives, the optimum,
+ * and forwards everything to an optional writer for the iterates.
+ */
+class optimum_writer : public stan::callbacks::writer {
+public:
+  /**
+   * @param iterations Writer for all iterates, or null to keep only the optimum
+   */
+  explicit optimum_writer(stan::callbacks::writer* iterations = nullptr)
+    : iterations_(iterations) {}
+
+  void operator()(const std::vector<std::string>& names) override {
+    if (iterations_) {
+      (*iterations_)(names);
+    }
+  }
+
+  void operator()(const std::vector<double>& values) override {
+    last_ = values;
+    if (iterations_) {
+      (*iterations_)(values);
+    }
+  }
+
+  void operator()() override {
+    if (iterations_) {
+      (*iterations_)();
+    }
+  }
+
+  void operator()(const std::string& message) override {
+    if (iterations_) {
+      (*iterations_)(message);
+    }
+  }
+
+  const std::vector<double>& optimum() const { return last_; }
+
+private:
+  stan::callbacks::writer* iterations_;
+  std::vector<double> last_;
+};
+
+/* Column names of the optimization results: run__ (1-indexed),
+ * return_code__, lp__ and the constrained parameter, transformed
+ * parameter and generated quantity values */
+template <class Model>
+std::vector<std::string> optimize_result_names(const Model& model) {
+  std::vector<std::string> names{"run__", "return_code__", "lp__"};
+  model.constrained_param_names(names, true, true);
+  return names;
+}
+
+/* Row of the optimization results for one run, padded with NaN when the
+ * run did not produce values */
+inline std::vector<double> optimize_result_row(size_t run_idx,
+                                               const optimize_result& result,
+                                               size_t num_cols) {
+  std::vector<double> row(num_cols, std::numeric_limits<double>::quiet_NaN());
+  row[0] = static_cast<double>(run_idx + 1);
+  row[1] = static_cast<double>(result.return_code);
+  for (size_t j = 0; j < result.values.size() && j + 2 < num_cols; ++j) {
+    row[j + 2] = result.values[j];
+  }
+  return row;
+}
+
+/* Run the selected optimization algorithm once
+ *
+ * @param args Optimization arguments
+ * @param model Stan model
+ * @param init Initial values; missing parameters are drawn at random
+ * @param chain Run identifier (1-indexed), which selects the random stream
+ * @param interrupt Interrupt callback
+ * @param logger Logger for messages
+ * @param init_writer Writer for the initial values
+ * @param parameter_writer Writer for the iterates or the optimum
+ * @return Return code of the Stan service
+ */
+template <bool Jacobian, class Model>
+int run_optimizer(const optimize_args& args, Model& model,
+                  const stan::io::var_context& init, unsigned int chain,
+                  stan::callbacks::interrupt& interrupt,
+                  stan::callbacks::logger& logger,
+                  stan::callbacks::writer& init_writer,
+                  stan::callbacks::writer& parameter_writer) {
+  switch (args.algorithm) {
+    case optimizer_t::NEWTON:
+      return stan::services::optimize::newton<Model, Jacobian>(
+          model, init, args.base.model.random_seed, chain, args.base.init.init_radius,
+          args.num_iterations, args.save_iterations, interrupt, logger,
+          init_writer, parameter_writer);
+    case optimizer_t::BFGS:
+      return stan::services::optimize::bfgs<Model, Jacobian>(
+          model, init, args.base.model.random_seed, chain, args.base.init.init_radius,
+          args.init_alpha, args.tol_obj, args.tol_rel_obj, args.tol_grad,
+          args.tol_rel_grad, args.tol_param, args.num_iterations,
+          args.save_iterations, args.refresh, interrupt, logger, init_writer,
+          parameter_writer);
+    case optimizer_t::LBFGS:
+    default:
+      return stan::services::optimize::lbfgs<Model, Jacobian>(
+          model, init, args.base.model.random_seed, chain, args.base.init.init_radius,
+          args.history_size, args.init_alpha, args.tol_obj, args.tol_rel_obj,
+          args.tol_grad, args.tol_rel_grad, args.tol_param, args.num_iterations,
+          args.save_iterations, args.refresh, interrupt, logger, init_writer,
+          parameter_writer);
+  }
+}
+
+/* Run args.num_runs independent optimizations of one model
+ *
+ * Run i starts from the i-th --inits file (or the only one) and draws any
+ * missing values with the random stream of chain i + 1, so runs are
+ * reproducible for a given seed. Runs execute concurrently on up to
+ * --num-threads threads when the model is compiled with STAN_THREADS. A
+ * failing run is reported and recorded in its result; it does not stop
+ * the others.
+ *
+ * @param args Optimization arguments
+ * @param model Stan model, shared read-only by all runs
+ * @param timestamp Timestamp for the files of saved iterates
+ * @param interrupt Interrupt callback
+ * @param logger Logger for messages
+ * @return One result per run, in run order
+ * @throws std::invalid_argument if an init file cannot be read
+ */
+template <class Model>
+std::vector<optimize_result> run_optimizations(const optimize_args& args, Model& model,
+                                               const std::string& timestamp,
+                                               stan::callbacks::interrupt& interrupt,
+                                               stan::callbacks::logger& logger) {
+  const size_t num_runs = args.num_runs;
+  // A single init file is read once and shared by all runs
+  const size_t num_init_files = std::max<size_t>(1, args.base.init.init_files.size());
+  std::vector<std::shared_ptr<const stan::io::var_context>> init_contexts;
+  init_contexts.reserve(num_init_files);
+  for (size_t i = 0; i < num_init_files; ++i) {
+    std::string init_file = get_init_file_for_chain(args.base.init, i);
+    try {
+      init_contexts.push_back(read_json_data(init_file));
+    } catch (const std::exception& e) {
+      throw std::invalid_argument("Error reading initial parameter values file for run "
+                                  + std::to_string(i + 1) + ": " + e.what());
+    }
+  }
+
+  if (args.base.num_threads > 1 && num_runs > 1 && !threading_enabled()) {
+    logger.warn("Parallel optimizations require a model compiled with "
+                "STAN_THREADS; running optimizations sequentially.");
+  }
+  unsigned int num_threads = threading_enabled() ? args.base.num_threads : 1;
+  shared_interrupt run_interrupt(interrupt);
+
+  std::vector<optimize_result> results(num_runs);
+  auto errors = run_chains_parallel(num_runs, num_threads, [&](size_t i) {
+    std::unique_ptr<csv_writer> iterations;
+    if (args.save_iterations) {
+      iterations = create_writer<csv_writer>(args.base.output_dir, model.model_name(),
+                                             timestamp, i + 1, "optimize_iterations",
+                                             ".csv", "#");
+    }
+    stan::callbacks::writer init_writer;
+    optimum_writer parameter_writer(iterations.get());
+    const auto& init = *init_contexts[num_init_files == 1 ? 0 : i];
+    results[i].return_code = args.jacobian
+        ? run_optimizer<true>(args, model, init, i + 1, run_interrupt, logger,
+                              init_writer, parameter_writer)
+        : run_optimizer<false>(args, model, init, i + 1, run_interrupt, logger,
+                               init_writer, parameter_writer);
+    results[i].values = parameter_writer.optimum();
+  });
+
+  for (size_t i = 0; i < num_runs; ++i) {
+    if (!errors[i]) {
+      continue;
+    }
+    try {
+      std::rethrow_exception(errors[i]);
+    } catch (const std::exception& e) {
+      logger.error("Optimization " + std::to_string(i + 1) + " failed: " + e.what());
+    } catch (...) {
+      logger.error("Optimization " + std::to_string(i + 1) + " failed");
+    }
+    results[i].return_code = stan::services::error_codes::SOFTWARE;
+  }
+  return results;
+}
+
+/* Function to run the optimization algorithm
+ *
+ * Writes one row per run (see optimize_result_names) to
+ * <model>_<timestamp>_optimize.csv and, with --save-iterations, the
+ * iterates of each run to its own file.
+ *
+ * @param args Optimization arguments
+ * @param model Stan model
+ * @return 0 if at least one run succeeded, 1 otherwise
+ */
+template <class Model>
+int run_optimize(const optimize_args& args, Model& model) {
+  try {
+    stan::callbacks::interrupt interrupt;
+    stan::callbacks::stream_logger logger(std::cout, std::cout, std::cout,
+                                         std::cerr, std::cerr);
+
+    ensure_output_directory(args.base.output_dir);
+    std::string model_name = model.model_name();
+    std::string timestamp = generate_timestamp();
+    std::string results_file = create_file_path(
+        args.base.output_dir, model_name + "_" + timestamp + "_optimize.csv");
+    auto writer = create_writer_impl<csv_writer>(results_file, "#");
+
+    auto results = run_optimizations(args, model, timestamp, interrupt, logger);
+
+    auto names = optimize_result_names(model);
+    (*writer)(names);
+    size_t num_succeeded = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+      (*writer)(optimize_result_row(i, results[i], names.size()));
+      if (results[i].return_code == stan::services::error_codes::OK) {
+        ++num_succeeded;
+      }
+    }
+
+    if (num_succeeded == 0) {
+      std::cerr << "Error: all " << results.size() << " optimizations failed" << std::endl;
+      return 1;
+    }
+    std::cout << "Optimization completed: " << num_succeeded << " of "
+              << results.size() << " runs succeeded" << std::endl;
+    std::cout << "  Results: " << results_file << std::endl;
+    return 0;
+
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+}
+
+}  // namespace stan3
+
+#endif  // STAN3_RUN_OPTIMIZE_HPP
@@ -0,0 +1,251 @@
+#ifndef STAN3_RUN_PATHFINDER_HPP
+#define STAN3_RUN_PATHFINDER_HPP
+
+#include <stan3/arguments.hpp>
+#include <stan3/draws_reader.hpp>
+#include <stan3/output_writers.hpp>
+#include <stan3/parallel_chains.hpp>
+#include <stan3/read_json_data.hpp>
+#include <stan3/write_json_data.hpp>
+
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/callbacks/structured_writer.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/io/array_var_context.hpp>
+#include <stan/io/var_context.hpp>
+#include <stan/model/model_base.hpp>
+#include <stan/services/pathfinder/multi.hpp>
+
+#include <tbb/task_arena.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan3 {
+
+/* Initial values and diagonal inverse metric derived from Pathfinder draws */
+struct pathfinder_warm_start {
+  std::vector<std::shared_ptr<const stan::io::var_context>> inits;
+  std::shared_ptr<const stan::io::var_context> inv_metric;
+};
+
+/* Pathfinder arguments for warm-starting an HMC run: one path per chain,
+ * with the chains' seed, initial values and threads */
+inline pathfinder_args pathfinder_args_for_hmc(const hmc_nuts_args& args) {
+  pathfinder_args pathfinder;
+  pathfinder.base = args.base;
+  pathfinder.num_paths = static_cast<int>(args.base.num_chains);
+  pathfinder.refresh = args.refresh;
+  return pathfinder;
+}
+
+/* Run multi-path Pathfinder and write its draws to a CSV file
+ *
+ * Paths run concurrently on up to --num-threads threads when the model is
+ * compiled with STAN_THREADS.
+ *
+ * @param args Pathfinder arguments
+ * @param model Stan model
+ * @param draws_file Path of the CSV file for the draws
+ * @param interrupt Interrupt callback
+ * @param logger Logger for messages
+ * @throws std::invalid_argument if an init file cannot be read
+ * @throws std::runtime_error if Pathfinder fails
+ */
+template <class Model>
+void run_pathfinder_paths(const pathfinder_args& args, Model& model,
+                          const std::string& draws_file,
+                          stan::callbacks::interrupt& interrupt,
+                          stan::callbacks::logger& logger) {
+  const size_t num_paths = args.num_paths;
+  std::vector<std::shared_ptr<const stan::io::var_context>> init_contexts;
+  init_contexts.reserve(num_paths);
+  for (size_t i = 0; i < num_paths; ++i) {
+    std::string init_file = get_init_file_for_chain(args.base.init, i);
+    try {
+      init_contexts.push_back(read_json_data(init_file));
+    } catch (const std::exception& e) {
+      throw std::invalid_argument("Error reading initial parameter values file for path "
+                                  + std::to_string(i + 1) + ": " + e.what());
+    }
+  }
+
+  auto parameter_writer = create_writer_impl<csv_writer>(draws_file, "#");
+  stan::callbacks::structured_writer diagnostic_writer;
+  std::vector<stan::callbacks::writer> init_writers(num_paths);
+  std::vector<stan::callbacks::writer> single_path_parameter_writers(num_paths);
+  std::vector<stan::callbacks::structured_writer> single_path_diagnostic_writers(num_paths);
+
+  if (args.base.num_threads > 1 && !threading_enabled()) {
+    logger.warn("Parallel paths require a model compiled with "
+                "STAN_THREADS; running paths sequentially.");
+  }
+  unsigned int num_threads = threading_enabled() ? args.base.num_threads : 1;
+  tbb::task_arena arena(static_cast<int>(
+      std::max<size_t>(1, std::min<size_t>(num_threads, num_paths))));
+
+  int return_code = 0;
+  arena.execute([&] {
+    return_code = stan::services::pathfinder::pathfinder_lbfgs_multi(
+        model, init_contexts, args.base.model.random_seed, 1,
+        args.base.init.init_radius, args.history_size, args.init_alpha,
+        args.tol_obj, args.tol_rel_obj, args.tol_grad, args.tol_rel_grad,
+        args.tol_param, args.num_iterations, args.num_elbo_draws,
+        args.num_draws, args.num_multi_draws, args.num_paths, false,
+        args.refresh, interrupt, logger, init_writers,
+        single_path_parameter_writers, single_path_diagnostic_writers,
+        *parameter_writer, diagnostic_writer, args.calculate_lp,
+        args.psis_resample);
+  });
+  if (return_code != 0) {
+    throw std::runtime_error("Pathfinder failed with return code "
+                             + std::to_string(return_code));
+  }
+}
+
+/* Read initial values for num_chains chains, taken from evenly spaced
+ * draws, and a diagonal inverse metric, the variance of the draws on the
+ * unconstrained scale, from a Pathfinder draws file
+ *
+ * @param model Stan model that produced the draws
+ * @param draws_file Pathfinder CSV draws file
+ * @param num_chains Number of initial values to return
+ * @return Initial values and inverse metric as var_contexts
+ * @throws std::runtime_error if the file is missing draws or parameters
+ */
+template <class Model>
+pathfinder_warm_start read_pathfinder_warm_start(const Model& model,
+                                                 const std::string& draws_file,
+                                                 size_t num_chains) {
+  std::vector<std::string> param_names;
+  std::vector<std::vector<size_t>> param_dims;
+  std::vector<std::string> flat_names;
+  model.get_param_names(param_names, false, false);
+  model.get_dims(param_dims, false, false);
+  model.constrained_param_names(flat_names, false, false);
+
+  csv_draws_reader reader(draws_file);
+  std::map<std::string, size_t> columns;
+  for (size_t j = 0; j < reader.column_names().size(); ++j) {
+    columns[reader.column_names()[j]] = j;
+  }
+  std::vector<size_t> param_columns;
+  for (const auto& name : flat_names) {
+    auto it = columns.find(name);
+    if (it == columns.end()) {
+      throw std::runtime_error("Draws file " + draws_file + " has no column " + name);
+    }
+    param_columns.push_back(it->second);
+  }
+
+  std::vector<std::vector<double>> params;
+  std::vector<double> draw;
+  while (reader.next(draw)) {
+    std::vector<double> values(param_columns.size());
+    for (size_t j = 0; j < param_columns.size(); ++j) {
+      values[j] = draw[param_columns[j]];
+    }
+    params.push_back(std::move(values));
+  }
+  if (params.empty()) {
+    throw std::runtime_error("Draws file " + draws_file + " has no draws");
+  }
+
+  auto to_context = [&](const std::vector<double>& values) {
+    return std::make_shared<stan::io::array_var_context>(param_names, values, param_dims);
+  };
+
+  pathfinder_warm_start warm_start;
+  for (size_t i = 0; i < num_chains; ++i) {
+    warm_start.inits.push_back(to_context(params[(i * params.size()) / num_chains]));
+  }
+
+  // Running mean and variance on the unconstrained scale (Welford)
+  const size_t num_unconstrained = model.num_params_r();
+  Eigen::VectorXd mean = Eigen::VectorXd::Zero(num_unconstrained);
+  Eigen::VectorXd m2 = Eigen::VectorXd::Zero(num_unconstrained);
+  Eigen::VectorXd unconstrained(num_unconstrained);
+  std::stringstream msg;
+  for (size_t n = 0; n < params.size(); ++n) {
+    model.transform_inits(*to_context(params[n]), unconstrained, &msg);
+    Eigen::VectorXd delta = unconstrained - mean;
+    mean += delta / static_cast<double>(n + 1);
+    m2 += delta.cwiseProduct(unconstrained - mean);
+  }
+  std::vector<double> inv_metric(num_unconstrained, 1.0);
+  if (params.size() > 1) {
+    for (size_t k = 0; k < num_unconstrained; ++k) {
+      double var = m2(k) / static_cast<double>(params.size() - 1);
+      if (std::isfinite(var) && var > 0) {
+        inv_metric[k] = var;
+      }
+    }
+  }
+  warm_start.inv_metric = std::make_shared<stan::io::array_var_context>(
+      std::vector<std::string>{"inv_metric"}, inv_metric,
+      std::vector<std::vector<size_t>>{{num_unconstrained}});
+  return warm_start;
+}
+
+/* Function to run the Pathfinder algorithm
+ *
+ * Writes the draws to <model>_<timestamp>_pathfinder.csv, one initial
+ * values file per path and a diagonal inverse metric file, which can be
+ * passed to hmc as --inits and --metric.
+ *
+ * @param args Pathfinder arguments
+ * @param model Stan model
+ * @return 0 on success, 1 on error
+ */
+template <class Model>
+int run_pathfinder(const pathfinder_args& args, Model& model) {
+  try {
+    stan::callbacks::interrupt interrupt;
+    stan::callbacks::stream_logger logger(std::cout, std::cout, std::cout,
+                                         std::cerr, std::cerr);
+
+    ensure_output_directory(args.base.output_dir);
+    std::string model_name = model.model_name();
+    std::string timestamp = generate_timestamp();
+    std::string draws_file = create_file_path(
+        args.base.output_dir, model_name + "_" + timestamp + "_pathfinder.csv");
+
+    run_pathfinder_paths(args, model, draws_file, interrupt, logger);
+
+    auto warm_start = read_pathfinder_warm_start(model, draws_file, args.num_paths);
+    std::string init_files;
+    for (size_t i = 0; i < warm_start.inits.size(); ++i) {
+      std::string init_file = create_file_path(
+          args.base.output_dir,
+          generate_filename(model_name, timestamp, i + 1, "pathfinder_init", ".json"));
+      write_json_data(*warm_start.inits[i], init_file);
+      init_files += " " + init_file;
+    }
+    std::string metric_file = create_file_path(
+        args.base.output_dir, model_name + "_" + timestamp + "_pathfinder_metric.json");
+    write_json_data(*warm_start.inv_metric, metric_file);
+
+    std::cout << "Pathfinder completed successfully!" << std::endl;
+    std::cout << "  Draws: " << draws_file << std::endl;
+    std::cout << "  Warm start for hmc: --inits" << init_files
+              << " --metric " << metric_file << std::endl;
+    return 0;
+
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+}
+
+}  // namespace stan3
+
+#endif  // STAN3_RUN_PATHFINDER_HPP
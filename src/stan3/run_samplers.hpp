@@ -2,10 +2,15 @@
 #define STAN3_RUN_SAMPLERS_HPP
 
 #include <stan3/arguments.hpp>
+#include <stan3/chain_affinity.hpp>
+#include <stan3/chain_profile.hpp>
 #include <stan3/hmc_output_writers.hpp>
 #include <stan3/load_samplers.hpp>
 #include <stan3/metric_type.hpp>
+#include <stan3/online_summary.hpp>
+#include <stan3/parallel_chains.hpp>
 
+#include <stan/callbacks/interrupt.hpp>
 #include <stan/callbacks/logger.hpp>
 #include <stan/callbacks/stream_logger.hpp>
 #include <stan/callbacks/writer.hpp>
@@ -15,43 +20,102 @@
 #include <stan/mcmc/hmc/nuts/adapt_dense_e_nuts.hpp>
 #include <stan/mcmc/hmc/nuts/adapt_unit_e_nuts.hpp>
 #include <stan/model/model_base.hpp>
+#include <stan/services/error_codes.hpp>
+#include <stan/services/sample/fixed_param.hpp>
 #include <stan/services/util/create_rng.hpp>
 #include <stan/services/util/initialize.hpp>
 #include <stan/services/util/inv_metric.hpp>
 #include <stan/services/util/run_adaptive_sampler.hpp>
+#include <stan/services/util/run_sampler.hpp>
 
+#include <chrono>
+#include <exception>
+#include <iostream>
 #include <memory>
 #include <stdexcept>
+#include <string>
 #include <variant>
 #include <vector>
 
 namespace stan3 {
 
+/* Runs the chains of a sampler configuration; the sampling draws of
+ * each chain are added to the online summary, if one is given.
+ * 
+ * With --target-ess or --target-rhat the summary is checked while the
+ * chains sample, and all chains stop through the shared interrupt once
+ * the targets are met; chains stopped this way have completed. The
+ * targets need all chains to run at the same time, as chains that run
+ * later would otherwise stop after a fraction of the draws of the first;
+ * when they do not, the targets are ignored with a warning.
+ * 
+ * Each chain's last draw is stored back into the configuration's
+ * init_params. A resumed run starts every chain from there and draws
+ * args.num_samples more samples with the sampler's current step size and
+ * metric, without warmup or adaptation. So does a --warm-start run with
+ * --warmup 0, from the chains' initial values.
+ *
+ * With --memory-lean the initial values are instead handed to the chain
+ * and released once it has run, and the last draw is not stored, so the
+ * run cannot be resumed; sampling sessions turn the flag off. */
 template <typename Model>
 class sampler_runner {
 public:
   sampler_runner(Model& model, const hmc_nuts_args& args,
                  const std::vector<hmc_nuts_writers>& writers,
                  stan::callbacks::interrupt& interrupt,
-                 stan::callbacks::logger& logger)
+                 stan::callbacks::logger& logger,
+                 online_summary* summary = nullptr,
+                 bool resume = false)
     : model_(model), args_(args), writers_(writers), 
-      interrupt_(interrupt), logger_(logger) {}
+      interrupt_(interrupt), logger_(logger), summary_(summary),
+      resume_(resume), chain_interrupt_(interrupt),
+      placement_(args.base.num_chains, args.base.num_threads, args.threads_per_chain,
+                 args.affinity) {
+    if (summary_ && (args_.target_ess > 0 || args_.target_rhat > 0)
+        && !placement_.runs_all_at_once(args_.base.num_chains)) {
+      logger_.warn("--target-ess and --target-rhat need all chains to run at "
+                   "the same time; ignoring them and drawing all samples.");
+    } else if (summary_ && (args_.target_ess > 0 || args_.target_rhat > 0)) {
+      monitor_ = std::make_unique<convergence_monitor>(
+        *summary_, args_.target_ess, args_.target_rhat,
+        [this] { chain_interrupt_.request_stop(); });
+    }
+  }
+
+  /* True if the chains stopped because the convergence targets were met */
+  bool converged() const { return monitor_ && monitor_->converged(); }
 
   template <typename ConfigType>
   void operator()(ConfigType& config) {
+    if (args_.threads_per_chain != 1 && !threading_enabled()) {
+      logger_.warn("Threads per chain require a model compiled with "
+                   "STAN_THREADS; evaluating each chain on one thread.");
+    }
     if (args_.base.num_chains == 1) {
-      run_single_chain(config, 0);
+      run_single_chain(config, 0, monitor_ ? chain_interrupt_ : interrupt_);
+    } else if (placement_.threads().parallel_chains > 1) {
+      run_multiple_chains_parallel(config);
     } else {
+      if (args_.base.num_threads > 1 && !threading_enabled()) {
+        logger_.warn("Parallel chains require a model compiled with "
+                     "STAN_THREADS; running chains sequentially.");
+      }
       run_multiple_chains_sequential(config);
     }
   }
 
 private:
   template <typename ConfigType>
-  void run_single_chain(ConfigType& config, size_t chain_idx) {
+  void run_single_chain(ConfigType& config, size_t chain_idx,
+                        stan::callbacks::interrupt& interrupt) {
     auto& sampler = config.samplers[chain_idx];
-    auto& init_params = config.init_params[chain_idx];
     auto& rng = config.rngs[chain_idx];
+    std::vector<double> lean_init_params;
+    if (args_.memory_lean) {
+      lean_init_params.swap(config.init_params[chain_idx]);
+    }
+    auto& init_params = args_.memory_lean ? lean_init_params : config.init_params[chain_idx];
     
     // Get writers - handle nullable cases
     stan::callbacks::writer dummy_writer;
@@ -65,11 +129,56 @@ private:
       writers_[chain_idx].metric_writer ? 
       writers_[chain_idx].metric_writer.get() : &dummy_structured_writer;
     
-    stan::services::util::run_adaptive_sampler(
-      sampler, model_, init_params, args_.num_warmup, args_.num_samples,
-      args_.thin, args_.refresh, args_.save_warmup, rng, interrupt_, logger_,
-      *writers_[chain_idx].sample_writer, *diagnostic_writer, *metric_writer, 
-      chain_idx + 1, args_.base.num_chains);
+    stan::callbacks::writer* sample_writer = writers_[chain_idx].sample_writer.get();
+
+    // Time spent in the draws writers is only measured for a profile
+    chain_profile& profile = sampler.profile();
+    std::unique_ptr<timed_writer> timed_sample_writer;
+    std::unique_ptr<timed_writer> timed_diagnostic_writer;
+    if (!args_.profile_file.empty()) {
+      timed_sample_writer = std::make_unique<timed_writer>(*sample_writer, profile.writer_seconds);
+      timed_diagnostic_writer = std::make_unique<timed_writer>(*diagnostic_writer,
+                                                               profile.writer_seconds);
+      sample_writer = timed_sample_writer.get();
+      diagnostic_writer = timed_diagnostic_writer.get();
+    }
+    std::unique_ptr<summary_writer> summarized_sample_writer;
+    if (summary_) {
+      summarized_sample_writer = std::make_unique<summary_writer>(
+        *sample_writer, *summary_, chain_idx,
+        args_.save_warmup ? num_saved_iterations(args_.num_warmup, args_.thin) : 0,
+        monitor_.get());
+      sample_writer = summarized_sample_writer.get();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    try {
+      // The chain's gradient evaluations get its share of the threads
+      // and, with --affinity, its cores
+      placement_.run(chain_idx, [&] {
+        if (resume_ || (args_.warm_start && args_.num_warmup == 0)) {
+          stan::services::util::run_sampler(
+            sampler, model_, init_params, 0, args_.num_samples, args_.thin,
+            args_.refresh, false, rng, interrupt, logger_, *sample_writer,
+            *diagnostic_writer, chain_idx + 1, args_.base.num_chains);
+        } else {
+          stan::services::util::run_adaptive_sampler(
+            sampler, model_, init_params, args_.num_warmup, args_.num_samples,
+            args_.thin, args_.refresh, args_.save_warmup, rng, interrupt, logger_,
+            *sample_writer, *diagnostic_writer, *metric_writer, 
+            chain_idx + 1, args_.base.num_chains);
+        }
+      });
+    } catch (const chain_interrupted&) {
+      if (!converged()) {
+        throw;
+      }
+    }
+    if (!args_.memory_lean) {
+      const Eigen::VectorXd& last_draw = sampler.z().q;
+      init_params.assign(last_draw.data(), last_draw.data() + last_draw.size());
+    }
+    profile.total_seconds += seconds_since(start);
   }
   
   template <typename ConfigType>
@@ -79,7 +188,7 @@ private:
       std::cout << "Starting chain " << (i + 1) << " of " << args_.base.num_chains << std::endl;
       
       try {
-        run_single_chain(config, i);
+        run_single_chain(config, i, monitor_ ? chain_interrupt_ : interrupt_);
         std::cout << "Completed chain " << (i + 1) << std::endl;
       } catch (const std::exception& e) {
         std::cerr << "Chain " << (i + 1) << " failed: " << e.what() << std::endl;
@@ -89,14 +198,92 @@ private:
     std::cout << "All " << args_.base.num_chains << " chains completed successfully." << std::endl;
   }
 
+  template <typename ConfigType>
+  void run_multiple_chains_parallel(ConfigType& config) {
+    // Each chain owns its sampler, RNG and writers; only the model and
+    // the interrupt are shared. A failing chain stops the others.
+    shared_interrupt& interrupt = chain_interrupt_;
+    const thread_allocation& threads = placement_.threads();
+    std::cout << "Running " << args_.base.num_chains << " chains, up to "
+              << threads.parallel_chains << " at a time with "
+              << threads.threads_per_chain << " threads each"
+              << (placement_.pinned() ? " on pinned cores" : "") << std::endl;
+
+    auto errors = placement_.run_chains(
+      args_.base.num_chains, [&](size_t i) {
+        try {
+          run_single_chain(config, i, interrupt);
+        } catch (...) {
+          interrupt.request_stop();
+          config.samplers[i].cancel_cross_chain_warmup();
+          throw;
+        }
+      });
+
+    rethrow_first_chain_error(errors);
+    std::cout << "All " << args_.base.num_chains << " chains completed successfully." << std::endl;
+  }
+
   Model& model_;
   const hmc_nuts_args& args_;
   const std::vector<hmc_nuts_writers>& writers_;
   stan::callbacks::interrupt& interrupt_;
   stan::callbacks::logger& logger_;
+  online_summary* summary_;
+  bool resume_;
+  shared_interrupt chain_interrupt_;
+  chain_placement placement_;
+  std::unique_ptr<convergence_monitor> monitor_;
 };
 
-/* Convenience function to create and run samplers */
+/* Per-chain profiles of the samplers in a configuration */
+template <typename ConfigType>
+std::vector<chain_profile> collect_profiles(const ConfigType& config) {
+  std::vector<chain_profile> profiles;
+  profiles.reserve(config.samplers.size());
+  for (const auto& sampler : config.samplers) {
+    profiles.push_back(sampler.profile());
+  }
+  return profiles;
+}
+
+/* Write the per-chain profiles of a run to args.profile_file
+ * 
+ * @param args HMC-NUTS arguments naming the profile file
+ * @param model_name Name of the Stan model
+ * @param profiles Profiles, one per chain
+ * @throws std::runtime_error if the file cannot be opened
+ */
+inline void write_profile_file(const hmc_nuts_args& args, const std::string& model_name,
+                               const std::vector<chain_profile>& profiles) {
+  auto writer = create_writer_impl<json_writer>(args.profile_file, "");
+  write_profiles(*writer, model_name, profiles);
+}
+
+/* Write the online summary of a run to args.summary_file
+ * 
+ * @param args HMC-NUTS arguments naming the summary file
+ * @param model_name Name of the Stan model
+ * @param summary Summary of the sampling draws of all chains
+ * @throws std::runtime_error if the file cannot be opened
+ */
+inline void write_summary_file(const hmc_nuts_args& args, const std::string& model_name,
+                               const online_summary& summary) {
+  auto writer = create_writer_impl<json_writer>(args.summary_file, "");
+  summary.write(*writer, model_name);
+}
+
+/* Online summary for the sampling draws of a run, or null if neither a
+ * summary file nor a convergence target is requested */
+inline std::unique_ptr<online_summary> create_online_summary(const hmc_nuts_args& args) {
+  if (args.summary_file.empty() && args.target_ess <= 0 && args.target_rhat <= 0) {
+    return nullptr;
+  }
+  return std::make_unique<online_summary>(args.base.num_chains);
+}
+
+/* Convenience function to create and run samplers; the profile and
+ * summary files, if requested, are written once all chains have finished */
   // Create init writers from the writers struct
   // Create samplers
   // Run samplers using visitor pattern
@@ -118,8 +305,93 @@ void run_samplers(Model& model,
   }
   auto sampler_configs = create_samplers(model, args, init_contexts, 
                                        metric_contexts, logger, init_writers);
-  sampler_runner runner(model, args, writers, interrupt, logger);
+  auto summary = create_online_summary(args);
+  sampler_runner runner(model, args, writers, interrupt, logger, summary.get());
   std::visit(runner, sampler_configs);
+  if (runner.converged()) {
+    logger.info("Convergence targets met after " + std::to_string(summary->num_draws())
+                + " sampling draws; chains stopped early.");
+  }
+  if (!args.profile_file.empty()) {
+    write_profile_file(args, model.model_name(),
+                       std::visit([](const auto& config) { return collect_profiles(config); },
+                                  sampler_configs));
+  }
+  if (!args.summary_file.empty()) {
+    write_summary_file(args, model.model_name(), *summary);
+  }
+}
+
+/* Run the fixed_param sampler for a model without parameters
+ * 
+ * Each chain writes args.num_samples draws (thinned by args.thin) of the
+ * generated quantities; there is no warmup. Chain i uses the random stream
+ * create_rng(seed, i + 1), so the draws do not depend on the number of
+ * threads. Chains run concurrently on up to --num-threads threads when
+ * the model is compiled with STAN_THREADS; a failing chain stops the
+ * others. The summary file, if requested, summarizes the draws of all
+ * chains.
+ * 
+ * @param model Stan model, shared read-only by all chains
+ * @param args HMC-NUTS arguments
+ * @param init_contexts Initialization contexts, one per chain
+ * @param writers Output writers, one set per chain
+ * @param interrupt Interrupt callback
+ * @param logger Logger for messages
+ * @throws std::runtime_error if a chain fails
+ */
+template <typename Model>
+void run_fixed_param_samplers(Model& model,
+                              const hmc_nuts_args& args,
+                              const std::vector<std::shared_ptr<const stan::io::var_context>>& init_contexts,
+                              const std::vector<hmc_nuts_writers>& writers,
+                              stan::callbacks::interrupt& interrupt,
+                              stan::callbacks::logger& logger) {
+  const size_t num_chains = args.base.num_chains;
+  if (num_chains > 1 && args.base.num_threads > 1 && !threading_enabled()) {
+    logger.warn("Parallel chains require a model compiled with "
+                "STAN_THREADS; running chains sequentially.");
+  }
+  unsigned int num_threads = threading_enabled() ? args.base.num_threads : 1;
+  shared_interrupt chain_interrupt(interrupt);
+  // Convergence targets do not apply: fixed_param draws are independent
+  std::unique_ptr<online_summary> summary;
+  if (!args.summary_file.empty()) {
+    summary = create_online_summary(args);
+  }
+
+  auto errors = run_chains_parallel(num_chains, num_threads, [&](size_t i) {
+    stan::callbacks::writer dummy_writer;
+    stan::callbacks::writer* init_writer =
+      writers[i].start_params_writer ? writers[i].start_params_writer.get() : &dummy_writer;
+    stan::callbacks::writer* diagnostic_writer =
+      writers[i].diagnostics_writer ? writers[i].diagnostics_writer.get() : &dummy_writer;
+    stan::callbacks::writer* sample_writer = writers[i].sample_writer.get();
+    std::unique_ptr<summary_writer> summarized_sample_writer;
+    if (summary) {
+      summarized_sample_writer = std::make_unique<summary_writer>(*sample_writer,
+                                                                  *summary, i);
+      sample_writer = summarized_sample_writer.get();
+    }
+    try {
+      int return_code = stan::services::sample::fixed_param(
+        model, *init_contexts[i], args.base.model.random_seed, i + 1,
+        args.base.init.init_radius, args.num_samples, args.thin, args.refresh,
+        chain_interrupt, logger, *init_writer, *sample_writer, *diagnostic_writer);
+      if (return_code != stan::services::error_codes::OK) {
+        throw std::runtime_error("fixed_param sampler returned error code "
+                                 + std::to_string(return_code));
+      }
+    } catch (...) {
+      chain_interrupt.request_stop();
+      throw;
+    }
+  });
+
+  rethrow_first_chain_error(errors);
+  if (!args.summary_file.empty()) {
+    write_summary_file(args, model.model_name(), *summary);
+  }
 }
 
 }  // namespace stan3
@@ -0,0 +1,158 @@
+#ifndef STAN3_SAMPLING_SESSION_HPP
+#define STAN3_SAMPLING_SESSION_HPP
+
+#include <stan3/arguments.hpp>
+#include <stan3/hmc_output_writers.hpp>
+#include <stan3/load_samplers.hpp>
+#include <stan3/memory_writer.hpp>
+#include <stan3/run_hmc_nuts.hpp>
+#include <stan3/run_samplers.hpp>
+
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/writer.hpp>
+
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace stan3 {
+
+/**
+ * Sampling run that can be extended with more draws.
+ *
+ * start() warms up and draws --samples draws per chain, like a run of the
+ * hmc subcommand with in-memory draws. The samplers, with their adapted
+ * step sizes and metrics, the RNGs and each chain's last draw are kept,
+ * so every extend() continues the chains where they stopped, drawing more
+ * samples without another warmup. Each call returns the draws of that
+ * call only. As the last draws are needed, --memory-lean is ignored.
+ * The online summary and profile of a run, --target-ess, --target-rhat,
+ * --summary-output and --profile-output, are not supported.
+ *
+ * The model must outlive the session. Calls must not overlap.
+ *
+ * @tparam Model Stan model type
+ */
+template <typename Model>
+class sampling_session {
+public:
+  /* @param model Stan model with parameters
+   * @param args HMC-NUTS arguments of the run
+   * @throws std::invalid_argument if the model has no parameters or the
+   *   arguments use an option sessions do not support
+   */
+  sampling_session(Model& model, const hmc_nuts_args& args)
+    : model_(model), args_(session_args(args)) {
+    std::vector<std::string> uparam_names;
+    model_.unconstrained_param_names(uparam_names, false, false);
+    if (uparam_names.empty()) {
+      throw std::invalid_argument("A sampling session needs a model with parameters");
+    }
+  }
+
+  /* Create the samplers, warm up and draw args.num_samples draws per chain
+   *
+   * @param interrupt Interrupt callback
+   * @param logger Logger for messages
+   * @return Draws of all chains, including warmup with --save-warmup
+   * @throws std::logic_error if the session has already started
+   * @throws std::exception if the samplers cannot be created or a chain fails
+   */
+  std::shared_ptr<draws_buffer> start(stan::callbacks::interrupt& interrupt,
+                                      stan::callbacks::logger& logger) {
+    if (samplers_) {
+      throw std::logic_error("The sampling session has already started");
+    }
+    validate_output_variables(args_, model_);
+    hmc_contexts contexts = load_hmc_contexts(args_, model_, interrupt, logger);
+    auto buffer = std::make_shared<draws_buffer>(args_.base.num_chains,
+                                                 num_saved_draws(args_));
+    auto writers = create_hmc_nuts_memory_writers(args_, model_.model_name(), buffer);
+    std::vector<stan::callbacks::writer*> init_writers;
+    for (auto& chain_writers : writers) {
+      init_writers.push_back(chain_writers.start_params_writer.get());
+    }
+    auto samplers = create_samplers(model_, args_, contexts.inits, contexts.metrics,
+                                    logger, init_writers);
+    sampler_runner<Model> runner(model_, args_, writers, interrupt, logger);
+    std::visit(runner, samplers);
+    // Moving the configuration keeps the samplers and the RNGs they refer
+    // to in place
+    samplers_.emplace(std::move(samplers));
+    return buffer;
+  }
+
+  /* Draw more samples, continuing every chain from its last draw with the
+   * adapted step size and metric
+   *
+   * @param num_samples Number of iterations per chain, thinned by --thin
+   * @param interrupt Interrupt callback
+   * @param logger Logger for messages
+   * @return Draws of all chains from this call
+   * @throws std::logic_error if the session has not started
+   * @throws std::exception if a chain fails
+   */
+  std::shared_ptr<draws_buffer> extend(int num_samples,
+                                       stan::callbacks::interrupt& interrupt,
+                                       stan::callbacks::logger& logger) {
+    if (!samplers_) {
+      throw std::logic_error("The sampling session has not started");
+    }
+    // Warmup, adaptation and the per-run output files belong to start()
+    hmc_nuts_args args = args_;
+    args.num_warmup = 0;
+    args.num_samples = num_samples;
+    args.save_warmup = false;
+    args.save_start_params = false;
+    args.save_metric = false;
+    args.save_diagnostics = false;
+    auto buffer = std::make_shared<draws_buffer>(args.base.num_chains,
+                                                 num_saved_draws(args));
+    auto writers = create_hmc_nuts_memory_writers(args, model_.model_name(), buffer);
+    sampler_runner<Model> runner(model_, args, writers, interrupt, logger, nullptr, true);
+    std::visit(runner, *samplers_);
+    return buffer;
+  }
+
+  /* Whether start() has completed successfully */
+  bool started() const { return samplers_.has_value(); }
+
+private:
+  static hmc_nuts_args session_args(hmc_nuts_args args) {
+    std::vector<std::string> unsupported;
+    if (args.target_ess > 0) {
+      unsupported.push_back("--target-ess");
+    }
+    if (args.target_rhat > 0) {
+      unsupported.push_back("--target-rhat");
+    }
+    if (!args.summary_file.empty()) {
+      unsupported.push_back("--summary-output");
+    }
+    if (!args.profile_file.empty()) {
+      unsupported.push_back("--profile-output");
+    }
+    if (!unsupported.empty()) {
+      std::string msg = "Not supported in a sampling session:";
+      for (size_t i = 0; i < unsupported.size(); ++i) {
+        msg += (i == 0 ? " " : ", ") + unsupported[i];
+      }
+      throw std::invalid_argument(msg);
+    }
+    args.memory_lean = false;
+    return args;
+  }
+
+  Model& model_;
+  const hmc_nuts_args args_;
+  std::optional<sampler_variant<Model>> samplers_;
+};
+
+}  // namespace stan3
+
+#endif  // STAN3_SAMPLING_SESSION_HPP
@@ -0,0 +1,176 @@
+#ifndef STAN3_SHARED_DENSE_METRIC_HPP
+#define STAN3_SHARED_DENSE_METRIC_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/structured_writer.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/mcmc/base_adapter.hpp>
+#include <stan/mcmc/hmc/hamiltonians/base_hamiltonian.hpp>
+#include <stan/mcmc/hmc/hamiltonians/ps_point.hpp>
+#include <stan/mcmc/hmc/integrators/expl_leapfrog.hpp>
+#include <stan/mcmc/hmc/nuts/base_nuts.hpp>
+#include <stan/mcmc/sample.hpp>
+#include <stan/mcmc/stepsize_adapter.hpp>
+
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/variate_generator.hpp>
+
+#include <Eigen/Dense>
+
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace stan3 {
+
+/**
+ * Dense inverse metric shared read-only by the chains of a run, with
+ * the upper Cholesky factor U (inv_metric = U' U) that draws momenta.
+ *
+ * The factor is computed once here rather than at every transition.
+ */
+struct dense_inv_metric {
+  Eigen::MatrixXd inv_metric;
+  Eigen::MatrixXd upper_factor;
+
+  /* @throws std::domain_error if inv_metric is not positive definite */
+  explicit dense_inv_metric(const Eigen::MatrixXd& inv)
+    : inv_metric(inv) {
+    Eigen::LLT<Eigen::MatrixXd> llt(inv_metric);
+    if (llt.info() != Eigen::Success) {
+      throw std::domain_error("The inverse metric is not positive definite");
+    }
+    upper_factor = llt.matrixU();
+  }
+
+  /* Heap bytes of the metric and its factor */
+  size_t bytes() const {
+    return sizeof(double) * (inv_metric.size() + upper_factor.size());
+  }
+};
+
+/**
+ * Phase space point whose dense inverse metric is shared with other
+ * chains' points instead of owned, like stan::mcmc::dense_e_point
+ * otherwise. A point must be given a metric before the sampler is used.
+ */
+class shared_dense_e_point : public stan::mcmc::ps_point {
+public:
+  explicit shared_dense_e_point(int n) : stan::mcmc::ps_point(n) {}
+
+  /* Use a metric of this point's own */
+  void set_metric(const Eigen::MatrixXd& inv_e_metric) {
+    metric_ = std::make_shared<const dense_inv_metric>(inv_e_metric);
+  }
+
+  /* Use a metric shared with other points */
+  void share_metric(std::shared_ptr<const dense_inv_metric> metric) {
+    metric_ = std::move(metric);
+  }
+
+  const dense_inv_metric& metric() const { return *metric_; }
+
+  inline void write_metric(stan::callbacks::writer& writer) {
+    const Eigen::MatrixXd& inv_e_metric = metric_->inv_metric;
+    writer("Elements of inverse mass matrix:");
+    for (int i = 0; i < inv_e_metric.rows(); ++i) {
+      std::stringstream inv_e_metric_ss;
+      inv_e_metric_ss << inv_e_metric(i, 0);
+      for (int j = 1; j < inv_e_metric.cols(); ++j) {
+        inv_e_metric_ss << ", " << inv_e_metric(i, j);
+      }
+      writer(inv_e_metric_ss.str());
+    }
+  }
+
+  inline void write_metric(stan::callbacks::structured_writer& writer) {
+    writer.write("metric_type", "dense_e");
+    writer.write("inv_metric", metric_->inv_metric);
+  }
+
+private:
+  std::shared_ptr<const dense_inv_metric> metric_;
+};
+
+/* Euclidean metric of a shared_dense_e_point, as stan::mcmc::dense_e_metric */
+template <class Model, class BaseRNG>
+class shared_dense_e_metric
+  : public stan::mcmc::base_hamiltonian<Model, shared_dense_e_point, BaseRNG> {
+public:
+  explicit shared_dense_e_metric(const Model& model)
+    : stan::mcmc::base_hamiltonian<Model, shared_dense_e_point, BaseRNG>(model) {}
+
+  double T(shared_dense_e_point& z) {
+    return 0.5 * z.p.transpose() * z.metric().inv_metric * z.p;
+  }
+
+  double tau(shared_dense_e_point& z) { return T(z); }
+
+  double phi(shared_dense_e_point& z) { return this->V(z); }
+
+  double dG_dt(shared_dense_e_point& z, stan::callbacks::logger& logger) {
+    return 2 * T(z) - z.q.dot(z.g);
+  }
+
+  Eigen::VectorXd dtau_dq(shared_dense_e_point& z, stan::callbacks::logger& logger) {
+    return Eigen::VectorXd::Zero(this->model_.num_params_r());
+  }
+
+  Eigen::VectorXd dtau_dp(shared_dense_e_point& z) {
+    return z.metric().inv_metric * z.p;
+  }
+
+  Eigen::VectorXd dphi_dq(shared_dense_e_point& z, stan::callbacks::logger& logger) {
+    return z.g;
+  }
+
+  void sample_p(shared_dense_e_point& z, BaseRNG& rng) {
+    boost::variate_generator<BaseRNG&, boost::normal_distribution<>> rand_dense_gaus(
+      rng, boost::normal_distribution<>());
+    Eigen::VectorXd u(z.p.size());
+    for (Eigen::Index i = 0; i < u.size(); ++i) {
+      u(i) = rand_dense_gaus();
+    }
+    z.p = z.metric().upper_factor.triangularView<Eigen::Upper>().solve(u);
+  }
+};
+
+/**
+ * NUTS with a dense metric shared by all chains, adapting only the step
+ * size, as stan::mcmc::adapt_unit_e_nuts does for the unit metric.
+ *
+ * Without a covariance estimator and an inverse metric per chain, each
+ * chain holds O(N) instead of O(N^2) doubles. For runs whose metric is
+ * given and not adapted.
+ */
+template <class Model, class BaseRNG>
+class adapt_shared_dense_e_nuts
+  : public stan::mcmc::base_nuts<Model, shared_dense_e_metric, stan::mcmc::expl_leapfrog,
+                                 BaseRNG>,
+    public stan::mcmc::stepsize_adapter {
+public:
+  adapt_shared_dense_e_nuts(const Model& model, BaseRNG& rng)
+    : stan::mcmc::base_nuts<Model, shared_dense_e_metric, stan::mcmc::expl_leapfrog,
+                            BaseRNG>(model, rng) {}
+
+  stan::mcmc::sample transition(stan::mcmc::sample& init_sample,
+                                stan::callbacks::logger& logger) {
+    stan::mcmc::sample s
+      = stan::mcmc::base_nuts<Model, shared_dense_e_metric, stan::mcmc::expl_leapfrog,
+                              BaseRNG>::transition(init_sample, logger);
+    if (this->adapt_flag_) {
+      this->stepsize_adaptation_.learn_stepsize(this->nom_epsilon_, s.accept_stat());
+    }
+    return s;
+  }
+
+  void disengage_adaptation() {
+    stan::mcmc::base_adapter::disengage_adaptation();
+    this->stepsize_adaptation_.complete_adaptation(this->nom_epsilon_);
+  }
+};
+
+}  // namespace stan3
+
+#endif  // STAN3_SHARED_DENSE_METRIC_HPP
@@ -0,0 +1,322 @@
+#ifndef STAN3_SHARED_OUTPUT_HPP
+#define STAN3_SHARED_OUTPUT_HPP
+
+#include <stan/callbacks/json_writer.hpp>
+#include <stan/callbacks/writer.hpp>
+
+#include <tbb/concurrent_queue.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace stan3 {
+
+/**
+ * Draws file written by all chains of a run.
+ *
+ * Chains hand chunks of rows, the header and comments to a bounded
+ * concurrent queue; a single I/O thread takes them off in order and
+ * forwards them to the wrapped writer. Only the first header reaches the
+ * file, as every chain of a run writes the same one. The queue holds at
+ * most capacity chunks; chains block while it is full.
+ *
+ * An exception thrown by the wrapped writer stops further output and is
+ * rethrown to every chain on its next submit().
+ */
+class shared_draws_file {
+public:
+  /* Unit of work for the I/O thread; values holds whole rows of
+   * num_cols values each */
+  struct chunk {
+    enum class kind { NAMES, ROWS, BLANK, MESSAGE, STOP };
+    kind type = kind::ROWS;
+    size_t num_cols = 0;
+    std::vector<double> values;
+    std::vector<std::string> names;
+    std::string message;
+  };
+
+  /**
+   * @param writer Writer of the file
+   * @param capacity Maximum number of queued chunks
+   */
+  explicit shared_draws_file(std::unique_ptr<stan::callbacks::writer>&& writer,
+                             size_t capacity = 256)
+    : writer_(std::move(writer)) {
+    if (!writer_) {
+      throw std::invalid_argument("shared_draws_file: wrapped writer is null");
+    }
+    queue_.set_capacity(static_cast<std::ptrdiff_t>(capacity == 0 ? 1 : capacity));
+    thread_ = std::thread([this] { run(); });
+  }
+
+  shared_draws_file(const shared_draws_file&) = delete;
+  shared_draws_file& operator=(const shared_draws_file&) = delete;
+
+  /* Write the queued chunks, then stop the I/O thread */
+  ~shared_draws_file() {
+    chunk stop;
+    stop.type = chunk::kind::STOP;
+    queue_.push(std::move(stop));
+    thread_.join();
+    if (failed_.load(std::memory_order_acquire)) {
+      try {
+        std::rethrow_exception(error_);
+      } catch (const std::exception& e) {
+        std::cerr << "Error writing output: " << e.what() << std::endl;
+      } catch (...) {
+        std::cerr << "Error writing output" << std::endl;
+      }
+    }
+  }
+
+  /* Queue a chunk, waiting while the queue is full
+   *
+   * @throws the wrapped writer's exception if it has failed
+   */
+  void submit(chunk&& c) {
+    if (failed_.load(std::memory_order_acquire)) {
+      std::rethrow_exception(error_);
+    }
+    queue_.push(std::move(c));
+  }
+
+private:
+  void run() {
+    std::vector<double> row;
+    bool header_written = false;
+    while (true) {
+      chunk c;
+      queue_.pop(c);
+      if (c.type == chunk::kind::STOP) {
+        return;
+      }
+      // After a failure the queue is still drained so that no chain
+      // blocks on a full queue
+      if (failed_.load(std::memory_order_relaxed)) {
+        continue;
+      }
+      try {
+        switch (c.type) {
+          case chunk::kind::NAMES:
+            if (!header_written) {
+              (*writer_)(c.names);
+              header_written = true;
+            }
+            break;
+          case chunk::kind::ROWS:
+            row.resize(c.num_cols);
+            for (size_t offset = 0; offset + c.num_cols <= c.values.size();
+                 offset += c.num_cols) {
+              std::copy(c.values.begin() + offset, c.values.begin() + offset + c.num_cols,
+                        row.begin());
+              (*writer_)(row);
+            }
+            break;
+          case chunk::kind::BLANK:
+            (*writer_)();
+            break;
+          case chunk::kind::MESSAGE:
+            (*writer_)(c.message);
+            break;
+          case chunk::kind::STOP:
+            break;
+        }
+      } catch (...) {
+        error_ = std::current_exception();
+        failed_.store(true, std::memory_order_release);
+      }
+    }
+  }
+
+  std::unique_ptr<stan::callbacks::writer> writer_;
+  tbb::concurrent_bounded_queue<chunk> queue_;
+  std::thread thread_;
+  std::exception_ptr error_;
+  std::atomic<bool> failed_{false};
+};
+
+/**
+ * Writer of one chain into a shared draws file.
+ *
+ * Each row gets a leading chain__ column holding the chain id. Rows are
+ * collected into chunks of chunk_rows rows before they are queued, so
+ * chains rarely touch the shared queue; the header and comments first
+ * queue the rows collected so far, keeping the chain's output in order.
+ * Comments are prefixed with the chain id.
+ *
+ * Calls must come from a single thread, as with every per-chain writer.
+ */
+class shared_chain_writer : public stan::callbacks::writer {
+public:
+  /**
+   * @param file Shared file, kept open while the chain's writer exists
+   * @param chain_id Chain id written to the chain__ column (1-based)
+   * @param chunk_rows Number of rows per queued chunk
+   */
+  shared_chain_writer(std::shared_ptr<shared_draws_file> file, unsigned int chain_id,
+                      size_t chunk_rows = 64)
+    : file_(std::move(file)), chain_id_(chain_id),
+      chunk_rows_(chunk_rows == 0 ? 1 : chunk_rows) {
+    if (!file_) {
+      throw std::invalid_argument("shared_chain_writer: shared file is null");
+    }
+  }
+
+  ~shared_chain_writer() override {
+    try {
+      submit_rows();
+    } catch (...) {
+      // Reported by the shared file
+    }
+  }
+
+  void operator()(const std::vector<std::string>& names) override {
+    submit_rows();
+    shared_draws_file::chunk c;
+    c.type = shared_draws_file::chunk::kind::NAMES;
+    c.names.reserve(names.size() + 1);
+    c.names.push_back("chain__");
+    c.names.insert(c.names.end(), names.begin(), names.end());
+    file_->submit(std::move(c));
+  }
+
+  void operator()(const std::vector<double>& state) override {
+    if (state.empty()) {
+      return;
+    }
+    if (num_rows_ > 0 && state.size() + 1 != rows_.num_cols) {
+      submit_rows();
+    }
+    if (num_rows_ == 0) {
+      rows_.num_cols = state.size() + 1;
+      rows_.values.reserve(chunk_rows_ * rows_.num_cols);
+    }
+    rows_.values.push_back(chain_id_);
+    rows_.values.insert(rows_.values.end(), state.begin(), state.end());
+    if (++num_rows_ == chunk_rows_) {
+      submit_rows();
+    }
+  }
+
+  void operator()() override {
+    submit_rows();
+    shared_draws_file::chunk c;
+    c.type = shared_draws_file::chunk::kind::BLANK;
+    file_->submit(std::move(c));
+  }
+
+  void operator()(const std::string& message) override {
+    submit_rows();
+    shared_draws_file::chunk c;
+    c.type = shared_draws_file::chunk::kind::MESSAGE;
+    c.message = "chain " + std::to_string(chain_id_) + ": " + message;
+    file_->submit(std::move(c));
+  }
+
+private:
+  void submit_rows() {
+    if (num_rows_ == 0) {
+      return;
+    }
+    shared_draws_file::chunk c = std::move(rows_);
+    rows_ = shared_draws_file::chunk();
+    num_rows_ = 0;
+    file_->submit(std::move(c));
+  }
+
+  std::shared_ptr<shared_draws_file> file_;
+  unsigned int chain_id_;
+  size_t chunk_rows_;
+  shared_draws_file::chunk rows_;
+  size_t num_rows_ = 0;
+};
+
+/**
+ * JSON file holding one record per chain, as an array in chain order.
+ *
+ * Each chain writes its record to a shared_json_writer; when that writer
+ * is destroyed, the record is handed over. The file is written once the
+ * writers of all chains are gone; chains that wrote nothing get null.
+ */
+class shared_json_file {
+public:
+  /**
+   * @param filepath Path of the file
+   * @param num_chains Number of chains
+   * @throws std::runtime_error if the file cannot be opened
+   */
+  shared_json_file(const std::string& filepath, size_t num_chains)
+    : output_(filepath), records_(num_chains) {
+    if (!output_.is_open()) {
+      throw std::runtime_error("Cannot open output file: " + filepath);
+    }
+  }
+
+  shared_json_file(const shared_json_file&) = delete;
+  shared_json_file& operator=(const shared_json_file&) = delete;
+
+  ~shared_json_file() {
+    output_ << "[\n";
+    for (size_t i = 0; i < records_.size(); ++i) {
+      output_ << (records_[i].empty() ? "null" : records_[i])
+              << (i + 1 < records_.size() ? ",\n" : "\n");
+    }
+    output_ << "]\n";
+  }
+
+  /* Hand over the record of a chain (0-based index) */
+  void set_record(size_t chain_idx, std::string record) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    records_.at(chain_idx) = std::move(record);
+  }
+
+private:
+  std::ofstream output_;
+  std::mutex mutex_;
+  std::vector<std::string> records_;
+};
+
+/* Deleter of a chain's record stream that hands the record to the
+ * shared JSON file */
+struct submit_json_record {
+  std::shared_ptr<shared_json_file> file;
+  size_t chain_idx = 0;
+
+  void operator()(std::stringstream* record) const {
+    std::unique_ptr<std::stringstream> owned(record);
+    if (file) {
+      file->set_record(chain_idx, record->str());
+    }
+  }
+};
+
+using shared_json_writer = stan::callbacks::json_writer<std::stringstream, submit_json_record>;
+
+/* Writer of one chain's record of a shared JSON file
+ *
+ * @param file Shared file
+ * @param chain_idx Chain index (0-based)
+ * @return JSON writer whose record reaches the file when it is destroyed
+ */
+inline std::unique_ptr<shared_json_writer> create_shared_json_writer(
+    const std::shared_ptr<shared_json_file>& file, size_t chain_idx) {
+  return std::make_unique<shared_json_writer>(
+    std::unique_ptr<std::stringstream, submit_json_record>(
+      new std::stringstream, submit_json_record{file, chain_idx}));
+}
+
+}  // namespace stan3
+
+#endif  // STAN3_SHARED_OUTPUT_HPP
@@ -4,8 +4,13 @@
 
 #include <stan3/arguments.hpp>
 #include <stan3/load_model.hpp>
+#include <stan3/log_density.hpp>
 #include <stan3/run_hmc_nuts.hpp>
+#include <stan3/run_optimize.hpp>
+#include <stan3/sampling_session.hpp>
 
+#include <algorithm>
+#include <mutex>
 #include <stdexcept>
 #include <iostream>
 
@@ -15,8 +20,12 @@ namespace c_api {
 /* Static storage for the loaded model and error messages */
 std::unique_ptr<stan::model::model_base> g_model = nullptr;
 std::string g_last_error;
+std::shared_ptr<draws_buffer> g_draws = nullptr;
+data_cache g_data_cache;
 
-bool load_model_impl(int argc, char** argv, std::string& error_msg) {
+bool create_model_impl(int argc, char** argv,
+                       std::unique_ptr<stan::model::model_base>& model,
+                       std::string& error_msg) {
   try {
     stan3::model_args args;
     
@@ -24,8 +33,15 @@ bool load_model_impl(int argc, char** argv, std::string& error_msg) {
       return false;
     }
     
-    auto& model = stan3::load_model(args);
-    g_model = std::unique_ptr<stan::model::model_base>(&model);
+    // Repeat loads of an unchanged data file reuse the parsed context
+    std::shared_ptr<const stan::io::var_context> data_context;
+    try {
+      data_context = g_data_cache.get(args.data_file);
+    } catch (const std::exception& e) {
+      throw std::invalid_argument("Error reading input data, " + std::string(e.what()));
+    }
+    model = std::unique_ptr<stan::model::model_base>(
+        &stan3::load_model(args, *data_context));
     
     return true;
     
@@ -44,25 +60,37 @@ bool load_model_impl(int argc, char** argv, std::string& error_msg) {
   }
 }
 
-bool run_samplers_impl(int argc, char** argv, std::string& error_msg) {
+bool load_model_impl(int argc, char** argv, std::string& error_msg) {
+  return create_model_impl(argc, argv, g_model, error_msg);
+}
+
+bool sample_impl(stan::model::model_base& model, int argc, char** argv,
+                 std::shared_ptr<draws_buffer>* draws, std::string& error_msg) {
   try {
-    if (!g_model) {
-      error_msg = "No model loaded. Call stan3_load_model() first.";
-      return false;
-    }
-    
     stan3::hmc_nuts_args args;
     
     if (!stan3::parse_hmc_args(argc, argv, args, error_msg)) {
       return false;
     }
     
-    int result = stan3::run_hmc(args, *g_model);
+    int result;
+    std::shared_ptr<draws_buffer> buffer;
+    if (draws) {
+      buffer = std::make_shared<draws_buffer>(args.base.num_chains,
+                                              num_saved_draws(args));
+      auto writers = create_hmc_nuts_memory_writers(args, model.model_name(), buffer);
+      result = stan3::run_hmc(args, model, writers);
+    } else {
+      result = stan3::run_hmc(args, model);
+    }
     if (result != 0) {
       error_msg = "Sampling failed with exit code: " + std::to_string(result);
       return false;
     }
     
+    if (draws) {
+      *draws = buffer;
+    }
     return true;
     
   } catch (const std::invalid_argument& e) {
@@ -80,6 +108,276 @@ bool run_samplers_impl(int argc, char** argv, std::string& error_msg) {
   }
 }
 
+bool optimize_impl(stan::model::model_base& model, int argc, char** argv,
+                   std::shared_ptr<draws_buffer>* results, std::string& error_msg) {
+  try {
+    stan3::optimize_args args;
+    
+    if (!stan3::parse_optimize_args(argc, argv, args, error_msg)) {
+      return false;
+    }
+    
+    if (!results) {
+      int result = stan3::run_optimize(args, model);
+      if (result != 0) {
+        error_msg = "Optimization failed with exit code: " + std::to_string(result);
+        return false;
+      }
+      return true;
+    }
+    
+    stan::callbacks::interrupt interrupt;
+    stan::callbacks::stream_logger logger(std::cout, std::cout, std::cout,
+                                         std::cerr, std::cerr);
+    ensure_output_directory(args.base.output_dir);
+    auto run_results = stan3::run_optimizations(args, model, generate_timestamp(),
+                                                interrupt, logger);
+    auto names = stan3::optimize_result_names(model);
+    auto buffer = std::make_shared<draws_buffer>(run_results.size(), 1);
+    buffer->set_column_names(names);
+    size_t num_succeeded = 0;
+    for (size_t i = 0; i < run_results.size(); ++i) {
+      auto row = stan3::optimize_result_row(i, run_results[i], names.size());
+      std::copy(row.begin(), row.end(), buffer->row(i, 0));
+      buffer->set_draws_written(i, 1);
+      if (run_results[i].return_code == stan::services::error_codes::OK) {
+        ++num_succeeded;
+      }
+    }
+    if (num_succeeded == 0) {
+      error_msg = "Optimization failed: all " + std::to_string(run_results.size())
+                  + " runs failed";
+      return false;
+    }
+    
+    *results = buffer;
+    return true;
+    
+  } catch (const std::invalid_argument& e) {
+    error_msg = "Invalid argument: " + std::string(e.what());
+    return false;
+  } catch (const std::runtime_error& e) {
+    error_msg = "Runtime error: " + std::string(e.what());
+    return false;
+  } catch (const std::exception& e) {
+    error_msg = "Error running optimization: " + std::string(e.what());
+    return false;
+  } catch (...) {
+    error_msg = "Unknown error occurred while running optimization";
+    return false;
+  }
+}
+
+bool run_samplers_impl(int argc, char** argv, std::string& error_msg) {
+  if (!g_model) {
+    error_msg = "No model loaded. Call stan3_load_model() first.";
+    return false;
+  }
+  return sample_impl(*g_model, argc, argv, nullptr, error_msg);
+}
+
+bool run_samplers_to_buffer_impl(int argc, char** argv, std::string& error_msg) {
+  if (!g_model) {
+    error_msg = "No model loaded. Call stan3_load_model() first.";
+    return false;
+  }
+  g_draws.reset();
+  return sample_impl(*g_model, argc, argv, &g_draws, error_msg);
+}
+
+bool run_optimize_impl(int argc, char** argv, bool to_buffer, std::string& error_msg) {
+  if (!g_model) {
+    error_msg = "No model loaded. Call stan3_load_model() first.";
+    return false;
+  }
+  if (!to_buffer) {
+    return optimize_impl(*g_model, argc, argv, nullptr, error_msg);
+  }
+  g_draws.reset();
+  return optimize_impl(*g_model, argc, argv, &g_draws, error_msg);
+}
+
+/* Map a model loading error message to an error code */
+static int load_error_code(const std::string& error_msg) {
+  if (error_msg.find("parsing failed") != std::string::npos) {
+    return STAN3_ERROR_PARSING;
+  } else if (error_msg.find("Invalid argument") != std::string::npos) {
+    return STAN3_ERROR_INVALID_ARGS;
+  } else {
+    return STAN3_ERROR_MODEL_LOAD;
+  }
+}
+
+/* Map a sampling or optimization error message to an error code, with
+ * failure_code for failures of the algorithm itself */
+static int run_error_code(const std::string& error_msg, int failure_code) {
+  if (error_msg.find("No model loaded") != std::string::npos) {
+    return STAN3_ERROR_MODEL_LOAD;
+  } else if (error_msg.find("parsing failed") != std::string::npos) {
+    return STAN3_ERROR_PARSING;
+  } else if (error_msg.find("Invalid argument") != std::string::npos) {
+    return STAN3_ERROR_INVALID_ARGS;
+  } else {
+    return failure_code;
+  }
+}
+
+/* Store an error message on a handle and in the caller's buffer */
+static void set_handle_error(stan3_model_handle* handle, const std::string& error_msg,
+                             char* error_message, size_t error_message_size) {
+  {
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    handle->last_error = error_msg;
+  }
+  copy_error_message(error_msg, error_message, error_message_size);
+}
+
+/* Clear the error message of a handle and the caller's buffer */
+static void clear_handle_error(stan3_model_handle* handle,
+                               char* error_message, size_t error_message_size) {
+  {
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    handle->last_error.clear();
+  }
+  if (error_message && error_message_size > 0) {
+    error_message[0] = '\0';
+  }
+}
+
+/* Admits the calls that use a handle's model for autodiff. Without
+ * STAN_THREADS the autodiff stack is global to the process, so a call
+ * made while another one holds the guard is refused rather than left to
+ * corrupt the stack; with STAN_THREADS every thread has its own stack
+ * and all calls are admitted. */
+class autodiff_guard {
+public:
+  autodiff_guard()
+#ifndef STAN_THREADS
+    : lock_(global_mutex(), std::try_to_lock)
+#endif
+  {}
+
+  bool admitted() const {
+#ifdef STAN_THREADS
+    return true;
+#else
+    return lock_.owns_lock();
+#endif
+  }
+
+  static constexpr const char* refused_message
+    = "Another call is in progress; concurrent calls require a library built "
+      "with STAN_THREADS";
+
+private:
+#ifndef STAN_THREADS
+  static std::mutex& global_mutex() {
+    static std::mutex mutex;
+    return mutex;
+  }
+
+  std::unique_lock<std::mutex> lock_;
+#endif
+};
+
+/* Run samplers or optimizations on a handle's model, optionally keeping
+ * the draws or results */
+static int run_on_handle(stan3_model_handle* handle, int argc, char** argv,
+                         bool optimize, bool to_buffer,
+                         char* error_message, size_t error_message_size) {
+  if (!handle) {
+    copy_error_message("Invalid arguments: handle is NULL",
+                       error_message, error_message_size);
+    return STAN3_ERROR_INVALID_ARGS;
+  }
+  if (argc < 0 || !argv) {
+    set_handle_error(handle, "Invalid arguments: argc < 0 or argv is NULL",
+                     error_message, error_message_size);
+    return STAN3_ERROR_INVALID_ARGS;
+  }
+  
+  autodiff_guard guard;
+  if (!guard.admitted()) {
+    set_handle_error(handle, autodiff_guard::refused_message,
+                     error_message, error_message_size);
+    return STAN3_ERROR_RUNTIME;
+  }
+
+  std::string error_msg;
+  std::shared_ptr<draws_buffer> draws;
+  bool success = optimize
+    ? optimize_impl(*handle->model, argc, argv, to_buffer ? &draws : nullptr, error_msg)
+    : sample_impl(*handle->model, argc, argv, to_buffer ? &draws : nullptr, error_msg);
+  if (!success) {
+    set_handle_error(handle, error_msg, error_message, error_message_size);
+    return run_error_code(error_msg, optimize ? STAN3_ERROR_OPTIMIZE : STAN3_ERROR_SAMPLING);
+  }
+  
+  if (to_buffer) {
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    handle->draws = draws;
+  }
+  clear_handle_error(handle, error_message, error_message_size);
+  return STAN3_SUCCESS;
+}
+
+/* Run a log density API call on a handle's model, mapping exceptions to
+ * STAN3_ERROR_RUNTIME and the handle's last error */
+template <typename F>
+static int evaluate_on_handle(stan3_model_handle* handle, F&& evaluate) {
+  autodiff_guard guard;
+  if (!guard.admitted()) {
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    handle->last_error = autodiff_guard::refused_message;
+    return STAN3_ERROR_RUNTIME;
+  }
+  try {
+    evaluate(*handle->model);
+    return STAN3_SUCCESS;
+  } catch (const std::exception& e) {
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    handle->last_error = e.what();
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    handle->last_error = "Unknown error occurred while evaluating the model";
+  }
+  return STAN3_ERROR_RUNTIME;
+}
+
+/* Record the outcome of a sampling or optimization call and map it to an
+ * error code */
+static int run_result(bool success, const std::string& error_msg, int failure_code,
+                      char* error_message, size_t error_message_size) {
+  if (!success) {
+    g_last_error = error_msg;
+    copy_error_message(error_msg, error_message, error_message_size);
+    return run_error_code(error_msg, failure_code);
+  }
+  
+  g_last_error.clear();
+  if (error_message && error_message_size > 0) {
+    error_message[0] = '\0';
+  }
+  
+  return STAN3_SUCCESS;
+}
+
+/* Run a sampling or optimization call on the global model under the
+ * autodiff guard and record its outcome */
+template <typename F>
+static int run_global(F&& run, int failure_code,
+                      char* error_message, size_t error_message_size) {
+  autodiff_guard guard;
+  if (!guard.admitted()) {
+    g_last_error = autodiff_guard::refused_message;
+    copy_error_message(g_last_error, error_message, error_message_size);
+    return STAN3_ERROR_RUNTIME;
+  }
+  std::string error_msg;
+  bool success = run(error_msg);
+  return run_result(success, error_msg, failure_code, error_message, error_message_size);
+}
+
 }  // namespace c_api
 }  // namespace stan3
 
@@ -101,14 +399,7 @@ STAN3_API int stan3_load_model(int argc, char** argv,
   if (!success) {
     stan3::c_api::g_last_error = error_msg;
     stan3::c_api::copy_error_message(error_msg, error_message, error_message_size);
-    
-    if (error_msg.find("parsing failed") != std::string::npos) {
-      return STAN3_ERROR_PARSING;
-    } else if (error_msg.find("Invalid argument") != std::string::npos) {
-      return STAN3_ERROR_INVALID_ARGS;
-    } else {
-      return STAN3_ERROR_MODEL_LOAD;
-    }
+    return stan3::c_api::load_error_code(error_msg);
   }
   
   stan3::c_api::g_last_error.clear();
@@ -128,32 +419,113 @@ STAN3_API int stan3_run_samplers(int argc, char** argv,
     return STAN3_ERROR_INVALID_ARGS;
   }
   
-  std::string error_msg;
-  bool success = stan3::c_api::run_samplers_impl(argc, argv, error_msg);
+  return stan3::c_api::run_global(
+    [&](std::string& error_msg) {
+      return stan3::c_api::run_samplers_impl(argc, argv, error_msg);
+    },
+    STAN3_ERROR_SAMPLING, error_message, error_message_size);
+}
+
+STAN3_API int stan3_run_samplers_to_buffer(int argc, char** argv,
+                                           char* error_message,
+                                           size_t error_message_size) {
+  if (argc < 0 || !argv) {
+    stan3::c_api::g_last_error = "Invalid arguments: argc < 0 or argv is NULL";
+    stan3::c_api::copy_error_message(stan3::c_api::g_last_error, 
+                                    error_message, error_message_size);
+    return STAN3_ERROR_INVALID_ARGS;
+  }
   
-  if (!success) {
-    stan3::c_api::g_last_error = error_msg;
-    stan3::c_api::copy_error_message(error_msg, error_message, error_message_size);
-    
-    if (error_msg.find("No model loaded") != std::string::npos) {
-      return STAN3_ERROR_MODEL_LOAD;
-    } else if (error_msg.find("parsing failed") != std::string::npos) {
-      return STAN3_ERROR_PARSING;
-    } else if (error_msg.find("Invalid argument") != std::string::npos) {
-      return STAN3_ERROR_INVALID_ARGS;
-    } else {
-      return STAN3_ERROR_SAMPLING;
-    }
+  return stan3::c_api::run_global(
+    [&](std::string& error_msg) {
+      return stan3::c_api::run_samplers_to_buffer_impl(argc, argv, error_msg);
+    },
+    STAN3_ERROR_SAMPLING, error_message, error_message_size);
+}
+
+STAN3_API int stan3_run_optimize(int argc, char** argv,
+                                 char* error_message, size_t error_message_size) {
+  if (argc < 0 || !argv) {
+    stan3::c_api::g_last_error = "Invalid arguments: argc < 0 or argv is NULL";
+    stan3::c_api::copy_error_message(stan3::c_api::g_last_error, 
+                                    error_message, error_message_size);
+    return STAN3_ERROR_INVALID_ARGS;
   }
   
-  stan3::c_api::g_last_error.clear();
-  if (error_message && error_message_size > 0) {
-    error_message[0] = '\0';
+  return stan3::c_api::run_global(
+    [&](std::string& error_msg) {
+      return stan3::c_api::run_optimize_impl(argc, argv, false, error_msg);
+    },
+    STAN3_ERROR_OPTIMIZE, error_message, error_message_size);
+}
+
+STAN3_API int stan3_run_optimize_to_buffer(int argc, char** argv,
+                                           char* error_message,
+                                           size_t error_message_size) {
+  if (argc < 0 || !argv) {
+    stan3::c_api::g_last_error = "Invalid arguments: argc < 0 or argv is NULL";
+    stan3::c_api::copy_error_message(stan3::c_api::g_last_error, 
+                                    error_message, error_message_size);
+    return STAN3_ERROR_INVALID_ARGS;
   }
   
+  return stan3::c_api::run_global(
+    [&](std::string& error_msg) {
+      return stan3::c_api::run_optimize_impl(argc, argv, true, error_msg);
+    },
+    STAN3_ERROR_OPTIMIZE, error_message, error_message_size);
+}
+
+STAN3_API int stan3_get_draws(double** draws, size_t* rows, size_t* cols) {
+  if (!draws || !rows || !cols) {
+    stan3::c_api::g_last_error = "Invalid arguments: output pointer is NULL";
+    return STAN3_ERROR_INVALID_ARGS;
+  }
+  auto& buffer = stan3::c_api::g_draws;
+  if (!buffer || buffer->num_rows() == 0) {
+    *draws = NULL;
+    *rows = 0;
+    *cols = 0;
+    stan3::c_api::g_last_error = "No draws available. Call stan3_run_samplers_to_buffer() first.";
+    return STAN3_ERROR_NO_DRAWS;
+  }
+  *draws = buffer->data();
+  *rows = buffer->num_rows();
+  *cols = buffer->num_cols();
   return STAN3_SUCCESS;
 }
 
+STAN3_API size_t stan3_get_draws_num_chains(void) {
+  return stan3::c_api::g_draws ? stan3::c_api::g_draws->num_chains() : 0;
+}
+
+STAN3_API const char* stan3_get_draws_column_name(size_t col) {
+  auto& buffer = stan3::c_api::g_draws;
+  if (!buffer || col >= buffer->num_cols()) {
+    return NULL;
+  }
+  return buffer->column_names()[col].c_str();
+}
+
+STAN3_API void stan3_free_draws(void) {
+  stan3::c_api::g_draws.reset();
+}
+
+STAN3_API int stan3_evict_data(const char* data_file) {
+  if (!data_file) {
+    return 0;
+  }
+  return stan3::c_api::g_data_cache.evict(data_file) ? 1 : 0;
+}
+
+STAN3_API void stan3_clear_data_cache(void) {
+  stan3::c_api::g_data_cache.clear();
+}
+
+STAN3_API size_t stan3_data_cache_size(void) {
+  return stan3::c_api::g_data_cache.size();
+}
+
 STAN3_API const char* stan3_get_model_name(void) {
   if (!stan3::c_api::g_model) {
     return NULL;
@@ -182,4 +554,332 @@ STAN3_API void stan3_clear_error(void) {
   stan3::c_api::g_last_error.clear();
 }
 
+/* Handle-based API */
+
+STAN3_API stan3_model_handle* stan3_model_new(int argc, char** argv,
+                                              char* error_message,
+                                              size_t error_message_size) {
+  if (argc < 0 || !argv) {
+    stan3::c_api::copy_error_message("Invalid arguments: argc < 0 or argv is NULL",
+                                     error_message, error_message_size);
+    return NULL;
+  }
+  
+  try {
+    auto handle = std::make_unique<stan3_model_handle>();
+    std::string error_msg;
+    if (!stan3::c_api::create_model_impl(argc, argv, handle->model, error_msg)) {
+      stan3::c_api::copy_error_message(error_msg, error_message, error_message_size);
+      return NULL;
+    }
+    handle->model_name = handle->model->model_name();
+    handle->num_constrained_params = stan3::num_constrained_params(*handle->model);
+    if (error_message && error_message_size > 0) {
+      error_message[0] = '\0';
+    }
+    return handle.release();
+  } catch (const std::exception& e) {
+    stan3::c_api::copy_error_message("Error loading model: " + std::string(e.what()),
+                                     error_message, error_message_size);
+    return NULL;
+  }
+}
+
+STAN3_API void stan3_model_free(stan3_model_handle* handle) {
+  delete handle;
+}
+
+STAN3_API int stan3_run_samplers_h(stan3_model_handle* handle, int argc, char** argv,
+                                   char* error_message, size_t error_message_size) {
+  return stan3::c_api::run_on_handle(handle, argc, argv, false, false,
+                                     error_message, error_message_size);
+}
+
+STAN3_API int stan3_run_samplers_to_buffer_h(stan3_model_handle* handle,
+                                             int argc, char** argv,
+                                             char* error_message,
+                                             size_t error_message_size) {
+  return stan3::c_api::run_on_handle(handle, argc, argv, false, true,
+                                     error_message, error_message_size);
+}
+
+STAN3_API int stan3_run_optimize_h(stan3_model_handle* handle, int argc, char** argv,
+                                   char* error_message, size_t error_message_size) {
+  return stan3::c_api::run_on_handle(handle, argc, argv, true, false,
+                                     error_message, error_message_size);
+}
+
+STAN3_API int stan3_run_optimize_to_buffer_h(stan3_model_handle* handle,
+                                             int argc, char** argv,
+                                             char* error_message,
+                                             size_t error_message_size) {
+  return stan3::c_api::run_on_handle(handle, argc, argv, true, true,
+                                     error_message, error_message_size);
+}
+
+STAN3_API int stan3_get_draws_h(stan3_model_handle* handle, double** draws,
+                                size_t* rows, size_t* cols) {
+  if (!handle || !draws || !rows || !cols) {
+    return STAN3_ERROR_INVALID_ARGS;
+  }
+  std::lock_guard<std::mutex> lock(handle->mutex);
+  if (!handle->draws || handle->draws->num_rows() == 0) {
+    *draws = NULL;
+    *rows = 0;
+    *cols = 0;
+    handle->last_error = "No draws available. Call stan3_run_samplers_to_buffer_h() first.";
+    return STAN3_ERROR_NO_DRAWS;
+  }
+  *draws = handle->draws->data();
+  *rows = handle->draws->num_rows();
+  *cols = handle->draws->num_cols();
+  return STAN3_SUCCESS;
+}
+
+STAN3_API int stan3_copy_draws_h(stan3_model_handle* handle, double* draws,
+                                 size_t capacity, size_t* rows, size_t* cols) {
+  if (!handle || !rows || !cols) {
+    return STAN3_ERROR_INVALID_ARGS;
+  }
+  std::lock_guard<std::mutex> lock(handle->mutex);
+  if (!handle->draws || handle->draws->num_rows() == 0) {
+    *rows = 0;
+    *cols = 0;
+    handle->last_error = "No draws available. Call stan3_run_samplers_to_buffer_h() first.";
+    return STAN3_ERROR_NO_DRAWS;
+  }
+  *rows = handle->draws->num_rows();
+  *cols = handle->draws->num_cols();
+  size_t size = *rows * *cols;
+  if (!draws || capacity < size) {
+    handle->last_error = "Invalid arguments: the array holds fewer than rows * cols values";
+    return STAN3_ERROR_INVALID_ARGS;
+  }
+  std::copy(handle->draws->data(), handle->draws->data() + size, draws);
+  return STAN3_SUCCESS;
+}
+
+STAN3_API size_t stan3_get_draws_num_chains_h(stan3_model_handle* handle) {
+  if (!handle) {
+    return 0;
+  }
+  std::lock_guard<std::mutex> lock(handle->mutex);
+  return handle->draws ? handle->draws->num_chains() : 0;
+}
+
+STAN3_API const char* stan3_get_draws_column_name_h(stan3_model_handle* handle,
+                                                    size_t col) {
+  if (!handle) {
+    return NULL;
+  }
+  std::lock_guard<std::mutex> lock(handle->mutex);
+  if (!handle->draws || col >= handle->draws->num_cols()) {
+    return NULL;
+  }
+  return handle->draws->column_names()[col].c_str();
+}
+
+STAN3_API void stan3_free_draws_h(stan3_model_handle* handle) {
+  if (handle) {
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    handle->draws.reset();
+  }
+}
+
+STAN3_API const char* stan3_model_name_h(stan3_model_handle* handle) {
+  return handle ? handle->model_name.c_str() : NULL;
+}
+
+STAN3_API size_t stan3_param_unc_num_h(stan3_model_handle* handle) {
+  return handle ? handle->model->num_params_r() : 0;
+}
+
+STAN3_API size_t stan3_param_num_h(stan3_model_handle* handle, int include_tp,
+                                   int include_gq) {
+  if (!handle) {
+    return 0;
+  }
+  if (!include_tp && !include_gq) {
+    return handle->num_constrained_params;
+  }
+  std::vector<std::string> names;
+  handle->model->constrained_param_names(names, include_tp != 0, include_gq != 0);
+  return names.size();
+}
+
+STAN3_API int stan3_log_density_gradient_h(stan3_model_handle* handle,
+                                           const double* theta_unc,
+                                           double* lp, double* grad) {
+  if (!handle || !theta_unc || !lp || !grad) {
+    return STAN3_ERROR_INVALID_ARGS;
+  }
+  return stan3::c_api::evaluate_on_handle(handle, [&](const auto& model) {
+    *lp = stan3::log_density_gradient(model, theta_unc, grad);
+  });
+}
+
+STAN3_API int stan3_log_density_gradient_batch_h(stan3_model_handle* handle,
+                                                 size_t num_evals,
+                                                 const double* theta_unc,
+                                                 double* lp, double* grad,
+                                                 unsigned int num_threads) {
+  if (!handle || (num_evals > 0 && (!theta_unc || !lp || !grad))) {
+    return STAN3_ERROR_INVALID_ARGS;
+  }
+  return stan3::c_api::evaluate_on_handle(handle, [&](const auto& model) {
+    stan3::log_density_gradient_batch(model, num_evals, theta_unc, lp, grad, num_threads);
+  });
+}
+
+STAN3_API int stan3_param_unconstrain_h(stan3_model_handle* handle,
+                                        const double* theta, double* theta_unc) {
+  if (!handle || !theta || !theta_unc) {
+    return STAN3_ERROR_INVALID_ARGS;
+  }
+  return stan3::c_api::evaluate_on_handle(handle, [&](const auto& model) {
+    stan3::param_unconstrain(model, handle->num_constrained_params, theta, theta_unc);
+  });
+}
+
+STAN3_API int stan3_param_constrain_h(stan3_model_handle* handle,
+                                      const double* theta_unc, int include_tp,
+                                      int include_gq, unsigned int seed,
+                                      double* theta) {
+  if (!handle || !theta_unc || !theta) {
+    return STAN3_ERROR_INVALID_ARGS;
+  }
+  return stan3::c_api::evaluate_on_handle(handle, [&](const auto& model) {
+    stan3::param_constrain(model, theta_unc, include_tp != 0, include_gq != 0, seed, theta);
+  });
+}
+
+STAN3_API const char* stan3_get_last_error_h(stan3_model_handle* handle) {
+  if (!handle) {
+    return NULL;
+  }
+  // Copy per calling thread so the pointer stays valid while other
+  // threads update the handle's error
+  thread_local std::string last_error;
+  {
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    last_error = handle->last_error;
+  }
+  return last_error.empty() ? NULL : last_error.c_str();
+}
+
+STAN3_API void stan3_clear_error_h(stan3_model_handle* handle) {
+  if (handle) {
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    handle->last_error.clear();
+  }
+}
+
+/* Sampling sessions */
+
+STAN3_API stan3_session* stan3_session_new(stan3_model_handle* handle,
+                                           int argc, char** argv,
+                                           char* error_message,
+                                           size_t error_message_size) {
+  if (!handle) {
+    stan3::c_api::copy_error_message("Invalid arguments: handle is NULL",
+                                     error_message, error_message_size);
+    return NULL;
+  }
+  if (argc < 0 || !argv) {
+    stan3::c_api::copy_error_message("Invalid arguments: argc < 0 or argv is NULL",
+                                     error_message, error_message_size);
+    return NULL;
+  }
+  
+  stan3::c_api::autodiff_guard guard;
+  if (!guard.admitted()) {
+    stan3::c_api::copy_error_message(stan3::c_api::autodiff_guard::refused_message,
+                                     error_message, error_message_size);
+    return NULL;
+  }
+  
+  try {
+    stan3::hmc_nuts_args args;
+    std::string error_msg;
+    if (!stan3::parse_hmc_args(argc, argv, args, error_msg)) {
+      stan3::c_api::copy_error_message(error_msg, error_message, error_message_size);
+      return NULL;
+    }
+    auto session = std::make_unique<stan3_session>();
+    session->session = std::make_unique<stan3::sampling_session<stan::model::model_base>>(
+        *handle->model, args);
+    stan::callbacks::interrupt interrupt;
+    stan::callbacks::stream_logger logger(std::cout, std::cout, std::cout,
+                                          std::cerr, std::cerr);
+    session->draws = session->session->start(interrupt, logger);
+    if (error_message && error_message_size > 0) {
+      error_message[0] = '\0';
+    }
+    return session.release();
+  } catch (const std::exception& e) {
+    stan3::c_api::copy_error_message("Error running samplers: " + std::string(e.what()),
+                                     error_message, error_message_size);
+    return NULL;
+  }
+}
+
+STAN3_API int stan3_session_continue(stan3_session* session, int num_samples,
+                                     char* error_message, size_t error_message_size) {
+  if (!session || num_samples < 0) {
+    stan3::c_api::copy_error_message("Invalid arguments: session is NULL or num_samples < 0",
+                                     error_message, error_message_size);
+    return STAN3_ERROR_INVALID_ARGS;
+  }
+  stan3::c_api::autodiff_guard guard;
+  if (!guard.admitted()) {
+    stan3::c_api::copy_error_message(stan3::c_api::autodiff_guard::refused_message,
+                                     error_message, error_message_size);
+    return STAN3_ERROR_RUNTIME;
+  }
+  try {
+    stan::callbacks::interrupt interrupt;
+    stan::callbacks::stream_logger logger(std::cout, std::cout, std::cout,
+                                          std::cerr, std::cerr);
+    session->draws.reset();
+    session->draws = session->session->extend(num_samples, interrupt, logger);
+  } catch (const std::exception& e) {
+    stan3::c_api::copy_error_message("Error running samplers: " + std::string(e.what()),
+                                     error_message, error_message_size);
+    return STAN3_ERROR_SAMPLING;
+  }
+  if (error_message && error_message_size > 0) {
+    error_message[0] = '\0';
+  }
+  return STAN3_SUCCESS;
+}
+
+STAN3_API int stan3_session_get_draws(stan3_session* session, double** draws,
+                                      size_t* rows, size_t* cols) {
+  if (!session || !draws || !rows || !cols) {
+    return STAN3_ERROR_INVALID_ARGS;
+  }
+  if (!session->draws || session->draws->num_rows() == 0) {
+    *draws = NULL;
+    *rows = 0;
+    *cols = 0;
+    return STAN3_ERROR_NO_DRAWS;
+  }
+  *draws = session->draws->data();
+  *rows = session->draws->num_rows();
+  *cols = session->draws->num_cols();
+  return STAN3_SUCCESS;
+}
+
+STAN3_API const char* stan3_session_get_draws_column_name(stan3_session* session,
+                                                          size_t col) {
+  if (!session || !session->draws || col >= session->draws->num_cols()) {
+    return NULL;
+  }
+  return session->draws->column_names()[col].c_str();
+}
+
+STAN3_API void stan3_session_free(stan3_session* session) {
+  delete session;
+}
+
 }  /* extern "C" */
@@ -29,6 +29,8 @@ extern "C" {
 #define STAN3_ERROR_SAMPLING 3
 #define STAN3_ERROR_INVALID_ARGS 4
 #define STAN3_ERROR_RUNTIME 5
+#define STAN3_ERROR_NO_DRAWS 6
+#define STAN3_ERROR_OPTIMIZE 7
 
 /* Load a Stan model using the provided command-line arguments
  * 
@@ -52,6 +54,102 @@ STAN3_API int stan3_load_model(int argc, char** argv,
 STAN3_API int stan3_run_samplers(int argc, char** argv,
                                  char* error_message, size_t error_message_size);
 
+/* Run samplers on the loaded model, keeping the draws in memory instead
+ * of writing sample files. The draws replace those of any previous run
+ * and are read with stan3_get_draws(). Other outputs (--save-inits,
+ * --save-diagnostics, --save-metric) are still written to files.
+ * 
+ * @param argc Number of arguments
+ * @param argv Array of argument strings
+ * @param error_message Buffer to store error message on failure
+ * @param error_message_size Size of error message buffer
+ * @return STAN3_SUCCESS on success, error code on failure
+ */
+STAN3_API int stan3_run_samplers_to_buffer(int argc, char** argv,
+                                           char* error_message,
+                                           size_t error_message_size);
+
+/* Run optimizations on the loaded model using command-line arguments
+ * (as for the optimize subcommand, e.g. --algorithm, --runs, --inits)
+ * 
+ * @param argc Number of arguments
+ * @param argv Array of argument strings
+ * @param error_message Buffer to store error message on failure
+ * @param error_message_size Size of error message buffer
+ * @return STAN3_SUCCESS if at least one run succeeded, error code otherwise
+ */
+STAN3_API int stan3_run_optimize(int argc, char** argv,
+                                 char* error_message, size_t error_message_size);
+
+/* Run optimizations on the loaded model, keeping the results in memory
+ * instead of writing a results file. The results replace any held draws
+ * and are read with stan3_get_draws(): one row per run, with columns
+ * run__, return_code__, lp__ and the constrained values, and
+ * stan3_get_draws_num_chains() returning the number of runs.
+ * 
+ * @param argc Number of arguments
+ * @param argv Array of argument strings
+ * @param error_message Buffer to store error message on failure
+ * @param error_message_size Size of error message buffer
+ * @return STAN3_SUCCESS if at least one run succeeded, error code otherwise
+ */
+STAN3_API int stan3_run_optimize_to_buffer(int argc, char** argv,
+                                           char* error_message,
+                                           size_t error_message_size);
+
+/* Get the draws of the last stan3_run_samplers_to_buffer() call
+ * 
+ * The draws are a row-major rows x cols array. Rows are grouped by chain:
+ * with D = rows / stan3_get_draws_num_chains() draws per chain, draw d of
+ * chain c is row c * D + d. Rows of a chain that stopped early are NaN.
+ * The array is owned by the library and stays valid until the next
+ * stan3_run_samplers_to_buffer() or stan3_free_draws() call.
+ * 
+ * @param draws Output parameter for a pointer to the first value
+ * @param rows Output parameter for the number of rows
+ * @param cols Output parameter for the number of columns
+ * @return STAN3_SUCCESS, STAN3_ERROR_NO_DRAWS if no draws are held, or
+ *   STAN3_ERROR_INVALID_ARGS if an output parameter is NULL
+ */
+STAN3_API int stan3_get_draws(double** draws, size_t* rows, size_t* cols);
+
+/* Get the number of chains of the held draws
+ * 
+ * @return Number of chains, or 0 if no draws are held
+ */
+STAN3_API size_t stan3_get_draws_num_chains(void);
+
+/* Get the name of a column of the held draws
+ * 
+ * @param col Column index (0-indexed)
+ * @return Column name, or NULL if out of range or no draws are held
+ */
+STAN3_API const char* stan3_get_draws_column_name(size_t col);
+
+/* Release the held draws
+ */
+STAN3_API void stan3_free_draws(void);
+
+/* Remove a data file from the data cache
+ * 
+ * stan3_load_model() keeps the parsed contents of each --data file and
+ * reuses them while the file's modification time and size are unchanged.
+ * 
+ * @param data_file Path of the data file, as passed to --data
+ * @return 1 if an entry was removed, 0 otherwise
+ */
+STAN3_API int stan3_evict_data(const char* data_file);
+
+/* Remove all entries from the data cache
+ */
+STAN3_API void stan3_clear_data_cache(void);
+
+/* Get the number of data files held in the data cache
+ * 
+ * @return Number of cached data files
+ */
+STAN3_API size_t stan3_data_cache_size(void);
+
 /* Get the name of the currently loaded model
  * 
  * @return Model name string, or NULL if no model loaded
@@ -74,6 +172,333 @@ STAN3_API const char* stan3_get_last_error(void);
  */
 STAN3_API void stan3_clear_error(void);
 
+/* Handle-based API
+ * 
+ * Each handle owns one model together with its own error message and
+ * in-memory draws, so a process can hold any number of models. Parsed
+ * data files are shared through the data cache. The functions above
+ * operate on a separate global model.
+ * 
+ * With a library built with STAN_THREADS, calls on different handles may
+ * run concurrently, as may several runs on the same handle; the draws of
+ * a handle are those of its most recent completed in-memory run. Without
+ * STAN_THREADS the autodiff stack is shared by the whole process, so
+ * only one run or log density call may be in progress at a time, on any
+ * handle, session or the global model: a call made while another one
+ * runs fails with STAN3_ERROR_RUNTIME.
+ */
+typedef struct stan3_model_handle stan3_model_handle;
+
+/* Create a model from command-line arguments (--data, --seed)
+ * 
+ * @param argc Number of arguments
+ * @param argv Array of argument strings
+ * @param error_message Buffer to store error message on failure
+ * @param error_message_size Size of error message buffer
+ * @return New handle, or NULL on failure; release with stan3_model_free()
+ */
+STAN3_API stan3_model_handle* stan3_model_new(int argc, char** argv,
+                                              char* error_message,
+                                              size_t error_message_size);
+
+/* Release a handle, its model and its draws; NULL is ignored
+ * 
+ * @param handle Handle from stan3_model_new()
+ */
+STAN3_API void stan3_model_free(stan3_model_handle* handle);
+
+/* Run samplers on a handle's model, writing output files
+ * 
+ * @param handle Handle from stan3_model_new()
+ * @param argc Number of arguments
+ * @param argv Array of argument strings
+ * @param error_message Buffer to store error message on failure
+ * @param error_message_size Size of error message buffer
+ * @return STAN3_SUCCESS on success, error code on failure
+ */
+STAN3_API int stan3_run_samplers_h(stan3_model_handle* handle, int argc, char** argv,
+                                   char* error_message, size_t error_message_size);
+
+/* Run samplers on a handle's model, keeping the draws in the handle
+ * (see stan3_run_samplers_to_buffer())
+ * 
+ * @param handle Handle from stan3_model_new()
+ * @param argc Number of arguments
+ * @param argv Array of argument strings
+ * @param error_message Buffer to store error message on failure
+ * @param error_message_size Size of error message buffer
+ * @return STAN3_SUCCESS on success, error code on failure
+ */
+STAN3_API int stan3_run_samplers_to_buffer_h(stan3_model_handle* handle,
+                                             int argc, char** argv,
+                                             char* error_message,
+                                             size_t error_message_size);
+
+/* Run optimizations on a handle's model, writing a results file
+ * 
+ * @param handle Handle from stan3_model_new()
+ * @param argc Number of arguments
+ * @param argv Array of argument strings
+ * @param error_message Buffer to store error message on failure
+ * @param error_message_size Size of error message buffer
+ * @return STAN3_SUCCESS if at least one run succeeded, error code otherwise
+ */
+STAN3_API int stan3_run_optimize_h(stan3_model_handle* handle, int argc, char** argv,
+                                   char* error_message, size_t error_message_size);
+
+/* Run optimizations on a handle's model, keeping the results in the
+ * handle (see stan3_run_optimize_to_buffer())
+ * 
+ * @param handle Handle from stan3_model_new()
+ * @param argc Number of arguments
+ * @param argv Array of argument strings
+ * @param error_message Buffer to store error message on failure
+ * @param error_message_size Size of error message buffer
+ * @return STAN3_SUCCESS if at least one run succeeded, error code otherwise
+ */
+STAN3_API int stan3_run_optimize_to_buffer_h(stan3_model_handle* handle,
+                                             int argc, char** argv,
+                                             char* error_message,
+                                             size_t error_message_size);
+
+/* Get the draws held by a handle (layout as for stan3_get_draws())
+ * 
+ * The array is owned by the handle. It is released, and the pointer
+ * left dangling, when any of these complete on the same handle, from any
+ * thread: a successful stan3_run_samplers_to_buffer_h() or
+ * stan3_run_optimize_to_buffer_h(), stan3_free_draws_h(), or
+ * stan3_model_free(). The same holds for the names returned by
+ * stan3_get_draws_column_name_h(). Callers that may start such a call
+ * while reading the draws should use stan3_copy_draws_h() instead.
+ * 
+ * @param handle Handle from stan3_model_new()
+ * @param draws Output parameter for a pointer to the first value
+ * @param rows Output parameter for the number of rows
+ * @param cols Output parameter for the number of columns
+ * @return STAN3_SUCCESS, STAN3_ERROR_NO_DRAWS, or STAN3_ERROR_INVALID_ARGS
+ */
+STAN3_API int stan3_get_draws_h(stan3_model_handle* handle, double** draws,
+                                size_t* rows, size_t* cols);
+
+/* Copy the draws held by a handle into a caller-owned array
+ * 
+ * The copy is taken under the handle's lock, so it is safe while other
+ * threads run on the handle. With a NULL array, or one too small, only
+ * rows and cols are set, so a first call can size the array.
+ * 
+ * @param handle Handle from stan3_model_new()
+ * @param draws Array of at least rows * cols values, or NULL
+ * @param capacity Number of values the array holds
+ * @param rows Output parameter for the number of rows
+ * @param cols Output parameter for the number of columns
+ * @return STAN3_SUCCESS if the draws were copied, STAN3_ERROR_NO_DRAWS if
+ *   no draws are held, or STAN3_ERROR_INVALID_ARGS if the array is NULL or
+ *   too small, or another argument is NULL
+ */
+STAN3_API int stan3_copy_draws_h(stan3_model_handle* handle, double* draws,
+                                 size_t capacity, size_t* rows, size_t* cols);
+
+/* Get the number of chains of the draws held by a handle
+ * 
+ * @param handle Handle from stan3_model_new()
+ * @return Number of chains, or 0 if no draws are held
+ */
+STAN3_API size_t stan3_get_draws_num_chains_h(stan3_model_handle* handle);
+
+/* Get the name of a column of the draws held by a handle
+ * 
+ * @param handle Handle from stan3_model_new()
+ * @param col Column index (0-indexed)
+ * @return Column name, or NULL if out of range or no draws are held
+ */
+STAN3_API const char* stan3_get_draws_column_name_h(stan3_model_handle* handle,
+                                                    size_t col);
+
+/* Release the draws held by a handle
+ * 
+ * @param handle Handle from stan3_model_new()
+ */
+STAN3_API void stan3_free_draws_h(stan3_model_handle* handle);
+
+/* Get the name of a handle's model
+ * 
+ * @param handle Handle from stan3_model_new()
+ * @return Model name string, or NULL if handle is NULL
+ */
+STAN3_API const char* stan3_model_name_h(stan3_model_handle* handle);
+
+/* Log density API
+ * 
+ * Direct evaluation of a handle's model for external samplers. The
+ * functions work on caller-supplied arrays and reuse per-thread buffers,
+ * so repeated calls on a model do not allocate. With a model compiled
+ * with STAN_THREADS every thread differentiates on its own autodiff
+ * stack, so any number of threads may call them concurrently on the same
+ * handle. On failure they return STAN3_ERROR_RUNTIME and set the handle's
+ * last error; a NULL argument gives STAN3_ERROR_INVALID_ARGS.
+ */
+
+/* Get the number of unconstrained parameters of a handle's model
+ * 
+ * @param handle Handle from stan3_model_new()
+ * @return Number of unconstrained parameters, or 0 if handle is NULL
+ */
+STAN3_API size_t stan3_param_unc_num_h(stan3_model_handle* handle);
+
+/* Get the number of constrained values of a handle's model
+ * 
+ * @param handle Handle from stan3_model_new()
+ * @param include_tp Count transformed parameters? (0 or 1)
+ * @param include_gq Count generated quantities? (0 or 1)
+ * @return Number of values, or 0 if handle is NULL
+ */
+STAN3_API size_t stan3_param_num_h(stan3_model_handle* handle, int include_tp,
+                                   int include_gq);
+
+/* Evaluate the log density and its gradient at an unconstrained
+ * parameter vector. The density is the one the samplers target: up to a
+ * constant, including the Jacobian of the constraining transform.
+ * 
+ * @param handle Handle from stan3_model_new()
+ * @param theta_unc stan3_param_unc_num_h() unconstrained values
+ * @param lp Output for the log density
+ * @param grad Output for the stan3_param_unc_num_h() partial derivatives
+ * @return STAN3_SUCCESS, STAN3_ERROR_RUNTIME, or STAN3_ERROR_INVALID_ARGS
+ */
+STAN3_API int stan3_log_density_gradient_h(stan3_model_handle* handle,
+                                           const double* theta_unc,
+                                           double* lp, double* grad);
+
+/* Evaluate the log density and its gradient at many unconstrained
+ * parameter vectors, in parallel on up to num_threads threads (serially
+ * without STAN_THREADS). All vectors are evaluated; failed ones get a NaN
+ * log density and the last error names the first of them.
+ * 
+ * @param handle Handle from stan3_model_new()
+ * @param num_evals Number of parameter vectors
+ * @param theta_unc Row-major num_evals x stan3_param_unc_num_h() values
+ * @param lp Output for the num_evals log densities
+ * @param grad Output for the row-major num_evals x stan3_param_unc_num_h()
+ *   gradients
+ * @param num_threads Maximum number of threads
+ * @return STAN3_SUCCESS, STAN3_ERROR_RUNTIME if any evaluation failed, or
+ *   STAN3_ERROR_INVALID_ARGS
+ */
+STAN3_API int stan3_log_density_gradient_batch_h(stan3_model_handle* handle,
+                                                 size_t num_evals,
+                                                 const double* theta_unc,
+                                                 double* lp, double* grad,
+                                                 unsigned int num_threads);
+
+/* Transform constrained parameter values to unconstrained ones
+ * 
+ * @param handle Handle from stan3_model_new()
+ * @param theta stan3_param_num_h(handle, 0, 0) constrained values
+ * @param theta_unc Output for the stan3_param_unc_num_h() unconstrained values
+ * @return STAN3_SUCCESS, STAN3_ERROR_RUNTIME, or STAN3_ERROR_INVALID_ARGS
+ */
+STAN3_API int stan3_param_unconstrain_h(stan3_model_handle* handle,
+                                        const double* theta, double* theta_unc);
+
+/* Transform unconstrained parameter values to constrained ones,
+ * optionally with the transformed parameters and generated quantities
+ * 
+ * @param handle Handle from stan3_model_new()
+ * @param theta_unc stan3_param_unc_num_h() unconstrained values
+ * @param include_tp Include transformed parameters? (0 or 1)
+ * @param include_gq Include generated quantities? (0 or 1)
+ * @param seed Seed for the random numbers of generated quantities
+ * @param theta Output for the stan3_param_num_h(handle, include_tp,
+ *   include_gq) values
+ * @return STAN3_SUCCESS, STAN3_ERROR_RUNTIME, or STAN3_ERROR_INVALID_ARGS
+ */
+STAN3_API int stan3_param_constrain_h(stan3_model_handle* handle,
+                                      const double* theta_unc, int include_tp,
+                                      int include_gq, unsigned int seed,
+                                      double* theta);
+
+/* Get the last error message of a handle. The returned string belongs to
+ * the calling thread and stays valid until its next call of this function.
+ * 
+ * @param handle Handle from stan3_model_new()
+ * @return Error message string, or NULL if no error
+ */
+STAN3_API const char* stan3_get_last_error_h(stan3_model_handle* handle);
+
+/* Clear the last error message of a handle
+ * 
+ * @param handle Handle from stan3_model_new()
+ */
+STAN3_API void stan3_clear_error_h(stan3_model_handle* handle);
+
+/* Sampling sessions
+ * 
+ * A session samples a handle's model and keeps the samplers, their
+ * adapted step sizes and metrics, the RNGs and each chain's last draw, so
+ * the run can be extended with more draws without another warmup. The
+ * draws of a session are those of its most recent call. Calls on one
+ * session must not overlap; a session must be freed before its handle.
+ */
+typedef struct stan3_session stan3_session;
+
+/* Create a session and run its first sampling call: warmup and --samples
+ * draws per chain (arguments as for stan3_run_samplers_to_buffer_h(),
+ * except for --target-ess, --target-rhat, --summary-output and
+ * --profile-output, which sessions reject)
+ * 
+ * @param handle Handle from stan3_model_new(); its model needs parameters
+ * @param argc Number of arguments
+ * @param argv Array of argument strings
+ * @param error_message Buffer to store error message on failure
+ * @param error_message_size Size of error message buffer
+ * @return New session, or NULL on failure; release with stan3_session_free()
+ */
+STAN3_API stan3_session* stan3_session_new(stan3_model_handle* handle,
+                                           int argc, char** argv,
+                                           char* error_message,
+                                           size_t error_message_size);
+
+/* Draw more samples, continuing each chain from its last draw with the
+ * adapted step size and metric and without warmup. The new draws replace
+ * the session's draws.
+ * 
+ * @param session Session from stan3_session_new()
+ * @param num_samples Number of iterations per chain, thinned by --thin
+ * @param error_message Buffer to store error message on failure
+ * @param error_message_size Size of error message buffer
+ * @return STAN3_SUCCESS on success, error code on failure
+ */
+STAN3_API int stan3_session_continue(stan3_session* session, int num_samples,
+                                     char* error_message, size_t error_message_size);
+
+/* Get the draws of a session's most recent call (layout as for
+ * stan3_get_draws()); the array stays valid until the next
+ * stan3_session_continue() or stan3_session_free() call
+ * 
+ * @param session Session from stan3_session_new()
+ * @param draws Output parameter for a pointer to the first value
+ * @param rows Output parameter for the number of rows
+ * @param cols Output parameter for the number of columns
+ * @return STAN3_SUCCESS, STAN3_ERROR_NO_DRAWS, or STAN3_ERROR_INVALID_ARGS
+ */
+STAN3_API int stan3_session_get_draws(stan3_session* session, double** draws,
+                                      size_t* rows, size_t* cols);
+
+/* Get the name of a column of a session's draws
+ * 
+ * @param session Session from stan3_session_new()
+ * @param col Column index (0-indexed)
+ * @return Column name, or NULL if out of range or no draws are held
+ */
+STAN3_API const char* stan3_session_get_draws_column_name(stan3_session* session,
+                                                          size_t col);
+
+/* Release a session, its samplers and its draws; NULL is ignored
+ * 
+ * @param session Session from stan3_session_new()
+ */
+STAN3_API void stan3_session_free(stan3_session* session);
+
 #ifdef __cplusplus
 }
 #endif
@@ -2,11 +2,16 @@
 #define STAN3_C_API_HPP
 
 #include <stan3/arguments.hpp>
+#include <stan3/data_cache.hpp>
 #include <stan3/load_model.hpp>
+#include <stan3/memory_writer.hpp>
 #include <stan3/run_hmc_nuts.hpp>
+#include <stan3/run_optimize.hpp>
+#include <stan3/sampling_session.hpp>
 #include <stan/model/model_base.hpp>
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <cstring>
 
@@ -16,6 +21,8 @@ namespace c_api {
 /* Internal model storage */
 extern std::unique_ptr<stan::model::model_base> g_model;
 extern std::string g_last_error;
+extern std::shared_ptr<draws_buffer> g_draws;
+extern data_cache g_data_cache;
 
 /* Helper function to safely copy error message to C buffer
  * 
@@ -78,7 +85,19 @@ inline void free_argv(int argc, char** argv) {
   }
 }
 
-/* Internal implementation of model loading
+/* Internal implementation of model creation
+ * 
+ * @param argc Number of arguments
+ * @param argv Array of argument strings
+ * @param model Output parameter for the new model
+ * @param error_msg Output parameter for error message
+ * @return Success flag
+ */
+bool create_model_impl(int argc, char** argv,
+                       std::unique_ptr<stan::model::model_base>& model,
+                       std::string& error_msg);
+
+/* Internal implementation of model loading into the global model
  * 
  * @param argc Number of arguments
  * @param argv Array of argument strings
@@ -87,6 +106,32 @@ inline void free_argv(int argc, char** argv) {
  */
 bool load_model_impl(int argc, char** argv, std::string& error_msg);
 
+/* Internal implementation of sampling a given model
+ * 
+ * @param model Model to sample
+ * @param argc Number of arguments
+ * @param argv Array of argument strings
+ * @param draws If not null, draws are kept in memory and returned here
+ *   instead of being written to sample files
+ * @param error_msg Output parameter for error message
+ * @return Success flag
+ */
+bool sample_impl(stan::model::model_base& model, int argc, char** argv,
+                 std::shared_ptr<draws_buffer>* draws, std::string& error_msg);
+
+/* Internal implementation of optimizing a given model
+ * 
+ * @param model Model to optimize
+ * @param argc Number of arguments
+ * @param argv Array of argument strings
+ * @param results If not null, results are kept in memory, one row per
+ *   run, and returned here instead of being written to a results file
+ * @param error_msg Output parameter for error message
+ * @return Success flag
+ */
+bool optimize_impl(stan::model::model_base& model, int argc, char** argv,
+                   std::shared_ptr<draws_buffer>* results, std::string& error_msg);
+
 /* Internal implementation of sampler running
  * 
  * @param argc Number of arguments
@@ -96,7 +141,47 @@ bool load_model_impl(int argc, char** argv, std::string& error_msg);
  */
 bool run_samplers_impl(int argc, char** argv, std::string& error_msg);
 
+/* Internal implementation of sampler running with in-memory draws
+ * 
+ * @param argc Number of arguments
+ * @param argv Array of argument strings  
+ * @param error_msg Output parameter for error message
+ * @return Success flag
+ */
+bool run_samplers_to_buffer_impl(int argc, char** argv, std::string& error_msg);
+
+/* Internal implementation of optimizing the global model
+ * 
+ * @param argc Number of arguments
+ * @param argv Array of argument strings
+ * @param to_buffer Keep the results in memory instead of writing a file
+ * @param error_msg Output parameter for error message
+ * @return Success flag
+ */
+bool run_optimize_impl(int argc, char** argv, bool to_buffer, std::string& error_msg);
+
 }  // namespace c_api
 }  // namespace stan3
 
+/* State behind an opaque stan3_model_handle. The model is only read while
+ * sampling or optimizing, so runs on the same handle may proceed
+ * concurrently; the mutex guards the error message and the in-memory
+ * draws. */
+struct stan3_model_handle {
+  std::unique_ptr<stan::model::model_base> model;
+  std::string model_name;
+  // Constrained parameter values without transformed parameters and
+  // generated quantities, counted once for stan3_param_unconstrain_h()
+  size_t num_constrained_params = 0;
+  std::mutex mutex;
+  std::string last_error;
+  std::shared_ptr<stan3::draws_buffer> draws;
+};
+
+/* State behind an opaque stan3_session */
+struct stan3_session {
+  std::unique_ptr<stan3::sampling_session<stan::model::model_base>> session;
+  std::shared_ptr<stan3::draws_buffer> draws;
+};
+
 #endif  /* STAN3_C_API_HPP */
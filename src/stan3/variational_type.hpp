@@ -0,0 +1,12 @@
+#ifndef STAN3_VARIATIONAL_TYPE_HPP
+#define STAN3_VARIATIONAL_TYPE_HPP
+
+namespace stan3 {
+
+enum class variational_t {
+    MEANFIELD = 0,
+    FULLRANK = 1
+};
+
+}  // namespace stan3
+#endif
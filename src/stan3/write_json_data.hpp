@@ -0,0 +1,76 @@
+#ifndef STAN3_WRITE_JSON_DATA_HPP
+#define STAN3_WRITE_JSON_DATA_HPP
+
+#include <stan/io/var_context.hpp>
+
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan3 {
+
+/* Write the values of one variable as nested JSON arrays. Values are in
+ * var_context (column-major) order; the JSON nesting is row-major. */
+template <typename T>
+void write_json_array(std::ostream& out, const std::vector<T>& values,
+                      const std::vector<size_t>& dims, size_t dim,
+                      size_t offset, size_t stride) {
+  if (dim == dims.size()) {
+    out << values[offset];
+    return;
+  }
+  out << "[";
+  for (size_t i = 0; i < dims[dim]; ++i) {
+    out << (i ? ", " : "");
+    write_json_array(out, values, dims, dim + 1, offset + i * stride, stride * dims[dim]);
+  }
+  out << "]";
+}
+
+/* Write the contents of a var_context as a JSON data file that can be
+ * read back with read_json_data, e.g. as initial values or a metric
+ *
+ * @param context Data to write
+ * @param filename Path of the JSON file to create
+ * @throws std::runtime_error if the file cannot be written
+ */
+inline void write_json_data(const stan::io::var_context& context,
+                            const std::string& filename) {
+  std::ofstream out(filename);
+  if (!out) {
+    throw std::runtime_error("Cannot open output file: " + filename);
+  }
+  out << std::setprecision(std::numeric_limits<double>::max_digits10);
+  out << "{";
+  bool first = true;
+  auto write_name = [&](const std::string& name) {
+    out << (first ? "\n" : ",\n") << "  \"" << name << "\": ";
+    first = false;
+  };
+  std::vector<std::string> names;
+  context.names_i(names);
+  for (const auto& name : names) {
+    write_name(name);
+    write_json_array(out, context.vals_i(name), context.dims_i(name), 0, 0, 1);
+  }
+  context.names_r(names);
+  for (const auto& name : names) {
+    if (context.contains_i(name)) {
+      continue;
+    }
+    write_name(name);
+    write_json_array(out, context.vals_r(name), context.dims_r(name), 0, 0, 1);
+  }
+  out << "\n}\n";
+  if (!out) {
+    throw std::runtime_error("Error writing JSON data file: " + filename);
+  }
+}
+
+}  // namespace stan3
+
+#endif  // STAN3_WRITE_JSON_DATA_HPP
@@ -0,0 +1,222 @@
+#ifndef STAN3_ZSTD_STREAM_HPP
+#define STAN3_ZSTD_STREAM_HPP
+
+#include <fstream>
+#include <ios>
+#include <memory>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#ifdef STAN3_ZSTD
+#include <zstd.h>
+#endif
+
+namespace stan3 {
+
+/* Whether output files can be zstd-compressed.
+ *
+ * Compression needs libzstd, which is only linked when the program is
+ * built with STAN3_ZSTD.
+ */
+inline constexpr bool compression_enabled() {
+#ifdef STAN3_ZSTD
+  return true;
+#else
+  return false;
+#endif
+}
+
+/* Compression settings for draws files; a level of 0 writes them as is */
+struct output_compression {
+  int level = 0;
+  unsigned int threads = 1;
+
+  bool enabled() const { return level > 0; }
+};
+
+#ifdef STAN3_ZSTD
+
+/**
+ * Stream buffer that zstd-compresses everything written to it into
+ * another stream buffer, as a single frame.
+ *
+ * Writes go to a fixed input buffer that is handed to the compressor when
+ * full. With one or more worker threads, libzstd compresses in the
+ * background, so writing a draw costs little more than a copy. sync()
+ * hands over the buffered input and flushes what the compressor has
+ * already produced, but does not end a block, so flushing after every
+ * row does not hurt the compression ratio. The frame is finished by
+ * finish(), and at the latest by the destructor.
+ */
+class zstd_streambuf : public std::streambuf {
+public:
+  /* @param sink Stream buffer receiving the compressed bytes
+   * @param compression Compression level (1-22) and worker threads
+   * @throws std::runtime_error if the compressor cannot be created
+   */
+  zstd_streambuf(std::streambuf* sink, const output_compression& compression)
+    : sink_(sink), cctx_(ZSTD_createCCtx()),
+      in_(ZSTD_CStreamInSize()), out_(ZSTD_CStreamOutSize()) {
+    if (cctx_ == nullptr) {
+      throw std::runtime_error("Cannot create zstd compression context");
+    }
+    check(ZSTD_CCtx_setParameter(cctx_, ZSTD_c_compressionLevel, compression.level));
+    // Fails when libzstd is built without multithreading; compression
+    // then runs on the writing thread
+    ZSTD_CCtx_setParameter(cctx_, ZSTD_c_nbWorkers, static_cast<int>(compression.threads));
+    setp(in_.data(), in_.data() + in_.size());
+  }
+
+  zstd_streambuf(const zstd_streambuf&) = delete;
+  zstd_streambuf& operator=(const zstd_streambuf&) = delete;
+
+  ~zstd_streambuf() override {
+    try {
+      finish();
+    } catch (...) {
+    }
+    ZSTD_freeCCtx(cctx_);
+  }
+
+  /* Compress the remaining input and end the frame; later writes fail
+   *
+   * @throws std::runtime_error on a compression or write error
+   */
+  void finish() {
+    if (finished_) {
+      return;
+    }
+    finished_ = true;
+    compress(ZSTD_e_end);
+    setp(nullptr, nullptr);
+    sink_->pubsync();
+  }
+
+protected:
+  int_type overflow(int_type ch) override {
+    if (finished_) {
+      return traits_type::eof();
+    }
+    try {
+      compress(ZSTD_e_continue);
+    } catch (const std::runtime_error&) {
+      return traits_type::eof();
+    }
+    setp(in_.data(), in_.data() + in_.size());
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(ch);
+      pbump(1);
+    }
+    return traits_type::not_eof(ch);
+  }
+
+  int sync() override {
+    if (finished_) {
+      return 0;
+    }
+    try {
+      compress(ZSTD_e_continue);
+    } catch (const std::runtime_error&) {
+      return -1;
+    }
+    setp(in_.data(), in_.data() + in_.size());
+    return sink_->pubsync();
+  }
+
+private:
+  static size_t check(size_t code) {
+    if (ZSTD_isError(code)) {
+      throw std::runtime_error(std::string("zstd compression failed: ")
+                               + ZSTD_getErrorName(code));
+    }
+    return code;
+  }
+
+  /* Hand the buffered input to the compressor, writing whatever output it
+   * produces; with ZSTD_e_end, loop until the frame is complete */
+  void compress(ZSTD_EndDirective mode) {
+    ZSTD_inBuffer input{in_.data(), static_cast<size_t>(pptr() - pbase()), 0};
+    bool done = false;
+    while (!done) {
+      ZSTD_outBuffer output{out_.data(), out_.size(), 0};
+      size_t remaining = check(ZSTD_compressStream2(cctx_, &output, &input, mode));
+      std::streamsize written = static_cast<std::streamsize>(output.pos);
+      if (written > 0 && sink_->sputn(out_.data(), written) != written) {
+        throw std::runtime_error("Cannot write compressed output");
+      }
+      done = mode == ZSTD_e_end ? remaining == 0 : input.pos == input.size;
+    }
+  }
+
+  std::streambuf* sink_;
+  ZSTD_CCtx* cctx_;
+  std::vector<char> in_;
+  std::vector<char> out_;
+  bool finished_ = false;
+};
+
+/**
+ * Output file stream whose contents are zstd-compressed.
+ *
+ * It is a std::ofstream, so the existing writers that own a std::ofstream
+ * can own it too: everything written through the stream goes to the
+ * compressing buffer, which writes the compressed bytes to the file
+ * buffer of the ofstream.
+ */
+class zstd_ofstream : public std::ofstream {
+public:
+  zstd_ofstream(const std::string& filepath, const output_compression& compression)
+    : std::ofstream(filepath, std::ios::binary),
+      buffer_(std::ofstream::rdbuf(), compression) {
+    std::ios::rdbuf(&buffer_);
+  }
+
+  /* Finish the compressed frame before the file is closed */
+  ~zstd_ofstream() override {
+    try {
+      buffer_.finish();
+    } catch (...) {
+    }
+  }
+
+private:
+  zstd_streambuf buffer_;
+};
+
+#endif  // STAN3_ZSTD
+
+/* Open an output file stream, zstd-compressed when requested
+ *
+ * @param filepath Path of the file
+ * @param binary Open in binary mode?
+ * @param compression Compression settings
+ * @return Open stream
+ * @throws std::runtime_error if the file cannot be opened, or compression
+ *   is requested in a build without STAN3_ZSTD
+ */
+inline std::unique_ptr<std::ofstream> open_output_stream(
+    const std::string& filepath, bool binary,
+    const output_compression& compression = {}) {
+  std::unique_ptr<std::ofstream> stream;
+  if (compression.enabled()) {
+#ifdef STAN3_ZSTD
+    stream = std::make_unique<zstd_ofstream>(filepath, compression);
+#else
+    throw std::runtime_error("Compressed output requires building with STAN3_ZSTD=true");
+#endif
+  } else if (binary) {
+    stream = std::make_unique<std::ofstream>(filepath, std::ios::binary);
+  } else {
+    stream = std::make_unique<std::ofstream>(filepath);
+  }
+  if (!stream->is_open()) {
+    throw std::runtime_error("Cannot open output file: " + filepath);
+  }
+  return stream;
+}
+
+}  // namespace stan3
+
+#endif  // STAN3_ZSTD_STREAM_HPP
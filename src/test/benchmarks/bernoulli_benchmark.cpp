@@ -0,0 +1,33 @@
+#include <test/benchmarks/model_benchmarks.hpp>
+#include <test/test-models/bernoulli.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+/* Bernoulli data with n observations */
+std::string bernoulli_data(int n) {
+  std::mt19937 rng(n);
+  std::bernoulli_distribution draw(0.3);
+  std::vector<int> y(n);
+  for (auto& yi : y) {
+    yi = draw(rng);
+  }
+  return stan3::benchmarks::write_json_data(
+      "stan3_bernoulli_benchmark_" + std::to_string(n) + ".json", [&](std::ostream& out) {
+        out << "\"N\": " << n << ",\n\"y\": ";
+        stan3::benchmarks::write_json_array(out, y);
+      });
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  stan3::benchmarks::register_model_benchmarks("bernoulli", {
+      {"N10", "src/test/test-models/bernoulli.data.json"},
+      {"N100000", bernoulli_data(100000)}
+  }, 1000, 1000);
+  return stan3::benchmarks::run_benchmarks(argc, argv);
+}
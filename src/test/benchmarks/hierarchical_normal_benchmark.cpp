@@ -0,0 +1,40 @@
+#include <test/benchmarks/model_benchmarks.hpp>
+#include <test/test-models/hierarchical_normal.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+/* Hierarchical normal data with j groups; the model has j + 2 parameters
+ * and 2 * j + 2 output columns, so it also exercises wide draws */
+std::string hierarchical_normal_data(int j) {
+  std::mt19937 rng(j);
+  std::normal_distribution<double> normal(0.0, 1.0);
+  std::uniform_real_distribution<double> uniform(5.0, 15.0);
+  std::vector<double> y(j);
+  std::vector<double> sigma(j);
+  for (int i = 0; i < j; ++i) {
+    sigma[i] = uniform(rng);
+    y[i] = 8.0 + 6.0 * normal(rng) + sigma[i] * normal(rng);
+  }
+  return stan3::benchmarks::write_json_data(
+      "stan3_hierarchical_normal_benchmark_" + std::to_string(j) + ".json",
+      [&](std::ostream& out) {
+        out << "\"J\": " << j << ",\n\"y\": ";
+        stan3::benchmarks::write_json_array(out, y);
+        out << ",\n\"sigma\": ";
+        stan3::benchmarks::write_json_array(out, sigma);
+      });
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  stan3::benchmarks::register_model_benchmarks("hierarchical_normal", {
+      {"J8", hierarchical_normal_data(8)},
+      {"J500", hierarchical_normal_data(500)}
+  });
+  return stan3::benchmarks::run_benchmarks(argc, argv);
+}
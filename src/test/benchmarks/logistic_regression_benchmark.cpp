@@ -0,0 +1,51 @@
+#include <test/benchmarks/model_benchmarks.hpp>
+#include <test/test-models/logistic_regression.hpp>
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+/* Logistic regression data with an n x k design matrix */
+std::string logistic_regression_data(int n, int k) {
+  std::mt19937 rng(n + k);
+  std::normal_distribution<double> normal(0.0, 1.0);
+  std::vector<double> beta(k);
+  for (auto& b : beta) {
+    b = 0.5 * normal(rng);
+  }
+  std::vector<std::vector<double>> x(n, std::vector<double>(k));
+  std::vector<int> y(n);
+  for (int i = 0; i < n; ++i) {
+    double eta = 0.2;
+    for (int j = 0; j < k; ++j) {
+      x[i][j] = normal(rng);
+      eta += x[i][j] * beta[j];
+    }
+    y[i] = std::bernoulli_distribution(1.0 / (1.0 + std::exp(-eta)))(rng);
+  }
+  return stan3::benchmarks::write_json_data(
+      "stan3_logistic_regression_benchmark_" + std::to_string(n) + "x"
+          + std::to_string(k) + ".json",
+      [&](std::ostream& out) {
+        out << "\"N\": " << n << ",\n\"K\": " << k << ",\n\"x\": [";
+        for (int i = 0; i < n; ++i) {
+          out << (i ? ",\n" : "");
+          stan3::benchmarks::write_json_array(out, x[i]);
+        }
+        out << "],\n\"y\": ";
+        stan3::benchmarks::write_json_array(out, y);
+      });
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  stan3::benchmarks::register_model_benchmarks("logistic_regression", {
+      {"N1000_K10", logistic_regression_data(1000, 10)},
+      {"N10000_K50", logistic_regression_data(10000, 50)}
+  });
+  return stan3::benchmarks::run_benchmarks(argc, argv);
+}
@@ -0,0 +1,194 @@
+#ifndef STAN3_TEST_BENCHMARKS_MODEL_BENCHMARKS_HPP
+#define STAN3_TEST_BENCHMARKS_MODEL_BENCHMARKS_HPP
+
+#include <stan3/arguments.hpp>
+#include <stan3/hmc_output_writers.hpp>
+#include <stan3/load_model.hpp>
+#include <stan3/load_samplers.hpp>
+#include <stan3/memory_writer.hpp>
+#include <stan3/run_samplers.hpp>
+
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/logger.hpp>
+#include <stan/io/empty_var_context.hpp>
+#include <stan/model/model_base.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace stan3 {
+namespace benchmarks {
+
+/* A data set for a model benchmark: a label and a JSON data file */
+struct benchmark_data {
+  std::string label;
+  std::string data_file;
+};
+
+/* Write a JSON data file into the temporary directory
+ *
+ * @param filename File name within the temporary directory
+ * @param write_body Writes the members of the top-level JSON object
+ * @return Path of the written file
+ */
+inline std::string write_json_data(const std::string& filename,
+                                   const std::function<void(std::ostream&)>& write_body) {
+  auto path = std::filesystem::temp_directory_path() / filename;
+  std::ofstream out(path);
+  out.precision(17);
+  out << "{\n";
+  write_body(out);
+  out << "\n}\n";
+  return path.string();
+}
+
+/* Write a JSON array of values */
+template <typename T>
+void write_json_array(std::ostream& out, const std::vector<T>& values) {
+  out << "[";
+  for (size_t i = 0; i < values.size(); ++i) {
+    out << (i ? ", " : "") << values[i];
+  }
+  out << "]";
+}
+
+/* Sampler arguments for a benchmark run. Warmup draws are saved so that
+ * the leapfrog steps of every iteration can be counted from the output. */
+inline hmc_nuts_args benchmark_args(const std::string& data_file, size_t num_chains,
+                                    int num_warmup, int num_samples) {
+  hmc_nuts_args args;
+  args.base.model.data_file = data_file;
+  args.base.model.random_seed = 1234;
+  args.base.num_chains = num_chains;
+  args.base.num_threads = num_chains;
+  args.num_warmup = num_warmup;
+  args.num_samples = num_samples;
+  args.save_warmup = true;
+  args.refresh = 0;
+  return args;
+}
+
+/* Empty init and metric contexts, one per chain */
+inline std::vector<std::shared_ptr<const stan::io::var_context>>
+empty_contexts(size_t num_chains) {
+  return std::vector<std::shared_ptr<const stan::io::var_context>>(
+      num_chains, std::make_shared<stan::io::empty_var_context>());
+}
+
+/* Owns a model created by load_model */
+inline std::unique_ptr<stan::model::model_base> load_benchmark_model(const hmc_nuts_args& args) {
+  return std::unique_ptr<stan::model::model_base>(&load_model(args.base.model));
+}
+
+/* Model instantiation: reading the data and constructing the model */
+inline void BM_LoadModel(benchmark::State& state, const std::string& data_file) {
+  hmc_nuts_args args = benchmark_args(data_file, 1, 0, 0);
+  for (auto _ : state) {
+    auto model = load_benchmark_model(args);
+    benchmark::DoNotOptimize(model.get());
+  }
+  state.counters["loads_per_sec"] = benchmark::Counter(
+      static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+}
+
+/* Chain initialization: create_samplers for state.range(0) chains */
+inline void BM_InitializeChains(benchmark::State& state, const std::string& data_file) {
+  const size_t num_chains = state.range(0);
+  hmc_nuts_args args = benchmark_args(data_file, num_chains, 1000, 1000);
+  auto model = load_benchmark_model(args);
+  auto contexts = empty_contexts(num_chains);
+  std::vector<stan::callbacks::writer*> init_writers(num_chains, nullptr);
+  stan::callbacks::logger logger;
+
+  for (auto _ : state) {
+    auto configs = create_samplers(*model, args, contexts, contexts, logger, init_writers);
+    benchmark::DoNotOptimize(&configs);
+  }
+  state.counters["chains_per_sec"] = benchmark::Counter(
+      static_cast<double>(state.iterations() * num_chains), benchmark::Counter::kIsRate);
+}
+
+/* Sampling: warmup and sampling of state.range(0) chains into memory.
+ * Initialization is excluded from the timing. */
+inline void BM_Sample(benchmark::State& state, const std::string& data_file,
+                      int num_warmup, int num_samples) {
+  const size_t num_chains = state.range(0);
+  hmc_nuts_args args = benchmark_args(data_file, num_chains, num_warmup, num_samples);
+  auto model = load_benchmark_model(args);
+  auto contexts = empty_contexts(num_chains);
+  std::vector<stan::callbacks::writer*> init_writers(num_chains, nullptr);
+  stan::callbacks::interrupt interrupt;
+  stan::callbacks::logger logger;
+
+  double draws = 0;
+  double leapfrogs = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto buffer = std::make_shared<draws_buffer>(num_chains, num_saved_draws(args));
+    auto writers = create_hmc_nuts_memory_writers(args, model->model_name(), buffer);
+    auto configs = create_samplers(*model, args, contexts, contexts, logger, init_writers);
+    sampler_runner<stan::model::model_base> runner(*model, args, writers, interrupt, logger);
+    state.ResumeTiming();
+
+    std::visit(runner, configs);
+
+    state.PauseTiming();
+    const auto& names = buffer->column_names();
+    size_t col = std::find(names.begin(), names.end(), "n_leapfrog__") - names.begin();
+    for (size_t row = 0; row < buffer->num_rows() && col < names.size(); ++row) {
+      leapfrogs += buffer->values()[row * names.size() + col];
+    }
+    draws += buffer->num_rows();
+    state.ResumeTiming();
+  }
+  // Every leapfrog step evaluates the log density gradient once
+  state.counters["draws_per_sec"] = benchmark::Counter(draws, benchmark::Counter::kIsRate);
+  state.counters["grad_evals_per_sec"] = benchmark::Counter(leapfrogs, benchmark::Counter::kIsRate);
+}
+
+/* Register load, initialization and sampling benchmarks for each data set
+ *
+ * @param model_name Name used as the benchmark prefix
+ * @param data Data sets to benchmark
+ * @param num_warmup Warmup iterations per chain
+ * @param num_samples Sampling iterations per chain
+ */
+inline void register_model_benchmarks(const std::string& model_name,
+                                      const std::vector<benchmark_data>& data,
+                                      int num_warmup = 500, int num_samples = 500) {
+  for (const auto& d : data) {
+    std::string prefix = model_name + "/" + d.label + "/";
+    benchmark::RegisterBenchmark((prefix + "load_model").c_str(), BM_LoadModel, d.data_file)
+        ->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark((prefix + "initialize").c_str(), BM_InitializeChains,
+                                 d.data_file)
+        ->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark((prefix + "sample").c_str(), BM_Sample, d.data_file,
+                                 num_warmup, num_samples)
+        ->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime()->Iterations(3);
+  }
+}
+
+/* Entry point shared by the model benchmarks */
+inline int run_benchmarks(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
+
+}  // namespace benchmarks
+}  // namespace stan3
+
+#endif  // STAN3_TEST_BENCHMARKS_MODEL_BENCHMARKS_HPP
@@ -0,0 +1,85 @@
+#include <stan3/output_writers.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+/* Synthetic draws: state.range(0) rows of state.range(1) columns */
+struct synthetic_draws {
+  std::vector<std::string> names;
+  std::vector<std::vector<double>> rows;
+
+  synthetic_draws(size_t num_rows, size_t num_cols) : names(num_cols), rows(num_rows) {
+    std::mt19937 rng(num_cols);
+    std::normal_distribution<double> normal(0.0, 1.0);
+    for (size_t j = 0; j < num_cols; ++j) {
+      names[j] = "theta." + std::to_string(j + 1);
+    }
+    for (auto& row : rows) {
+      row.resize(num_cols);
+      for (auto& x : row) {
+        x = normal(rng);
+      }
+    }
+  }
+};
+
+/* Writing draws to a file, including opening and closing it. Background
+ * writers are timed until their destructor has drained the buffer. */
+template <typename WriterType>
+void BM_WriteDraws(benchmark::State& state, const std::string& extension) {
+  synthetic_draws draws(state.range(0), state.range(1));
+  std::string path = (std::filesystem::temp_directory_path()
+                      / ("stan3_output_writers_benchmark" + extension)).string();
+  int64_t bytes = 0;
+  for (auto _ : state) {
+    {
+      auto writer = stan3::create_writer_impl<WriterType>(path, "#");
+      (*writer)(draws.names);
+      for (const auto& row : draws.rows) {
+        (*writer)(row);
+      }
+    }
+    state.PauseTiming();
+    bytes += std::filesystem::file_size(path);
+    state.ResumeTiming();
+  }
+  std::filesystem::remove(path);
+  state.SetBytesProcessed(bytes);
+  state.counters["draws_per_sec"] = benchmark::Counter(
+      static_cast<double>(state.iterations() * draws.rows.size()), benchmark::Counter::kIsRate);
+}
+
+void draws_shapes(benchmark::internal::Benchmark* b) {
+  b->Args({4000, 10})->Args({4000, 1000})->Args({1000, 10000})
+   ->Unit(benchmark::kMillisecond)->UseRealTime();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  benchmark::RegisterBenchmark("csv_writer", BM_WriteDraws<stan3::csv_writer>, ".csv")
+      ->Apply(draws_shapes);
+  benchmark::RegisterBenchmark("fast_csv_writer", BM_WriteDraws<stan3::fast_csv_writer>, ".csv")
+      ->Apply(draws_shapes);
+  benchmark::RegisterBenchmark("binary_writer", BM_WriteDraws<stan3::binary_writer>, ".bin")
+      ->Apply(draws_shapes);
+  benchmark::RegisterBenchmark("async_csv_writer",
+                               BM_WriteDraws<stan3::async_writer<stan3::csv_writer>>, ".csv")
+      ->Apply(draws_shapes);
+  benchmark::RegisterBenchmark("async_binary_writer",
+                               BM_WriteDraws<stan3::async_writer<stan3::binary_writer>>, ".bin")
+      ->Apply(draws_shapes);
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
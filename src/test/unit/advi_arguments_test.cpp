@@ -0,0 +1,47 @@
+#include <stan3/arguments.hpp>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+TEST(AdviArgsTest, DefaultValues) {
+  stan3::advi_args args;
+  EXPECT_EQ(args.algorithm, stan3::variational_t::MEANFIELD);
+  EXPECT_EQ(args.num_iterations, 10000);
+  EXPECT_EQ(args.grad_samples, 1);
+  EXPECT_EQ(args.elbo_samples, 100);
+  EXPECT_EQ(args.eta, 1.0);
+  EXPECT_TRUE(args.adapt_engaged);
+  EXPECT_EQ(args.adapt_iterations, 50);
+  EXPECT_EQ(args.tol_rel_obj, 0.01);
+  EXPECT_EQ(args.eval_elbo, 100);
+  EXPECT_EQ(args.output_draws, 1000);
+}
+
+TEST(AdviArgsTest, ParseAdviArgs_ValidArgs) {
+  const char* argv[] = {"stan3", "--algorithm", "fullrank", "--grad-samples", "32",
+                        "--num-threads", "8", "--adapt-engaged", "false", "--eta", "0.5",
+                        "--draws", "200"};
+  int argc = 13;
+
+  stan3::advi_args args;
+  std::string error_msg;
+  ASSERT_TRUE(stan3::parse_advi_args(argc, const_cast<char**>(argv), args, error_msg))
+      << error_msg;
+  EXPECT_EQ(args.algorithm, stan3::variational_t::FULLRANK);
+  EXPECT_EQ(args.grad_samples, 32);
+  EXPECT_EQ(args.base.num_threads, 8);
+  EXPECT_FALSE(args.adapt_engaged);
+  EXPECT_EQ(args.eta, 0.5);
+  EXPECT_EQ(args.output_draws, 200);
+}
+
+TEST(AdviArgsTest, ParseAdviArgs_InvalidValues) {
+  const char* bad_family[] = {"stan3", "--algorithm", "lowrank"};
+  const char* bad_samples[] = {"stan3", "--grad-samples", "0"};
+
+  stan3::advi_args args;
+  std::string error_msg;
+  EXPECT_FALSE(stan3::parse_advi_args(3, const_cast<char**>(bad_family), args, error_msg));
+  EXPECT_FALSE(stan3::parse_advi_args(3, const_cast<char**>(bad_samples), args, error_msg));
+}
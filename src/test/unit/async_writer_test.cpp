@@ -0,0 +1,113 @@
+#include <stan3/async_writer.hpp>
+
+#include <stan/callbacks/writer.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+/* Records every call as a string; optionally slow or failing */
+struct recording_writer : public stan::callbacks::writer {
+  std::shared_ptr<std::vector<std::string>> log = std::make_shared<std::vector<std::string>>();
+  std::vector<std::string>& calls = *log;
+  std::thread::id thread;
+  std::chrono::milliseconds delay{0};
+  int fail_after = -1;
+
+  void record(const std::string& call) {
+    thread = std::this_thread::get_id();
+    if (delay.count() > 0) {
+      std::this_thread::sleep_for(delay);
+    }
+    if (fail_after >= 0 && static_cast<int>(calls.size()) >= fail_after) {
+      throw std::runtime_error("disk full");
+    }
+    calls.push_back(call);
+  }
+
+  void operator()(const std::vector<std::string>& names) override {
+    std::string call = "names";
+    for (const auto& name : names) {
+      call += " " + name;
+    }
+    record(call);
+  }
+
+  void operator()(const std::vector<double>& state) override {
+    std::string call = "values";
+    for (double x : state) {
+      call += " " + std::to_string(static_cast<int>(x));
+    }
+    record(call);
+  }
+
+  void operator()() override { record("blank"); }
+
+  void operator()(const std::string& message) override { record("message " + message); }
+};
+
+}  // namespace
+
+TEST(AsyncWriterTest, ForwardsCallsInOrder) {
+  auto inner = std::make_unique<recording_writer>();
+  recording_writer* recorder = inner.get();
+  {
+    stan3::async_writer<recording_writer> writer(std::move(inner), 4);
+    writer(std::vector<std::string>{"a", "b"});
+    writer(std::vector<double>{1, 2});
+    writer(std::string("Adaptation terminated"));
+    writer();
+    writer(std::vector<double>{3, 4});
+    writer.flush();
+
+    ASSERT_EQ(recorder->calls.size(), 5);
+    EXPECT_EQ(recorder->calls[0], "names a b");
+    EXPECT_EQ(recorder->calls[1], "values 1 2");
+    EXPECT_EQ(recorder->calls[2], "message Adaptation terminated");
+    EXPECT_EQ(recorder->calls[3], "blank");
+    EXPECT_EQ(recorder->calls[4], "values 3 4");
+    EXPECT_NE(recorder->thread, std::this_thread::get_id());
+  }
+}
+
+TEST(AsyncWriterTest, DestructorDrainsBuffer) {
+  auto inner = std::make_unique<recording_writer>();
+  inner->delay = std::chrono::milliseconds(1);
+  auto log = inner->log;
+  {
+    // More draws than slots: the producer blocks until the I/O thread catches up
+    stan3::async_writer<recording_writer> writer(std::move(inner), 2);
+    for (int i = 0; i < 20; ++i) {
+      writer(std::vector<double>{static_cast<double>(i)});
+    }
+  }
+
+  ASSERT_EQ(log->size(), 20);
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_EQ((*log)[i], "values " + std::to_string(i));
+  }
+}
+
+TEST(AsyncWriterTest, RethrowsWriterErrors) {
+  auto inner = std::make_unique<recording_writer>();
+  inner->fail_after = 1;
+  stan3::async_writer<recording_writer> writer(std::move(inner), 4);
+
+  writer(std::vector<double>{1});
+  writer(std::vector<double>{2});
+  EXPECT_THROW(writer.flush(), std::runtime_error);
+  EXPECT_THROW(writer(std::vector<double>{3}), std::runtime_error);
+  EXPECT_EQ(writer.get_writer().calls.size(), 1);
+}
+
+TEST(AsyncWriterTest, RejectsNullWriter) {
+  EXPECT_THROW(stan3::async_writer<recording_writer>(nullptr), std::invalid_argument);
+}
@@ -0,0 +1,127 @@
+#include <stan3/binary_var_context.hpp>
+#include <stan3/read_data.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+class BinaryVarContextTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    path = testing::TempDir() + "stan3_binary_var_context_test.bin";
+  }
+
+  void TearDown() override { std::remove(path.c_str()); }
+
+  std::string path;
+};
+
+TEST_F(BinaryVarContextTest, RoundTripsJsonData) {
+  auto json = stan3::read_json_data("src/test/unit/json/valid_data.json");
+  stan3::write_binary_data(*json, path);
+
+  stan3::binary_var_context context(path);
+  EXPECT_TRUE(context.contains_r("n"));
+  EXPECT_TRUE(context.contains_r("x"));
+  EXPECT_TRUE(context.contains_i("m"));
+  EXPECT_FALSE(context.contains_i("x"));
+  EXPECT_FALSE(context.contains_r("missing"));
+
+  EXPECT_EQ(context.vals_r("x"), json->vals_r("x"));
+  EXPECT_EQ(context.dims_r("x"), json->dims_r("x"));
+  EXPECT_EQ(context.vals_i("m"), json->vals_i("m"));
+  EXPECT_EQ(context.dims_i("m"), json->dims_i("m"));
+  EXPECT_EQ(context.vals_i("n"), json->vals_i("n"));
+  EXPECT_TRUE(context.dims_i("n").empty());
+
+  // Integers can be read as reals
+  std::vector<double> m_real = {1.0, 2.0, 3.0};
+  EXPECT_EQ(context.vals_r("m"), m_real);
+
+  std::vector<std::string> names;
+  context.names_i(names);
+  EXPECT_EQ(names, (std::vector<std::string>{"m", "n"}));
+  context.names_r(names);
+  EXPECT_EQ(names, std::vector<std::string>{"x"});
+}
+
+TEST_F(BinaryVarContextTest, ValidatesDims) {
+  auto json = stan3::read_json_data("src/test/unit/json/valid_data.json");
+  stan3::write_binary_data(*json, path);
+
+  stan3::binary_var_context context(path);
+  EXPECT_NO_THROW(context.validate_dims("data", "x", "vector", {5}));
+  EXPECT_THROW(context.validate_dims("data", "x", "vector", {4}), std::exception);
+}
+
+TEST_F(BinaryVarContextTest, ReadDataDispatchesOnExtension) {
+  auto json = stan3::read_json_data("src/test/unit/json/valid_data.json");
+  stan3::write_binary_data(*json, path);
+
+  auto binary = stan3::read_data(path);
+  EXPECT_NE(dynamic_cast<stan3::binary_var_context*>(binary.get()), nullptr);
+  EXPECT_EQ(binary->vals_r("x"), json->vals_r("x"));
+
+  auto text = stan3::read_data("src/test/unit/json/valid_data.json");
+  EXPECT_EQ(dynamic_cast<stan3::binary_var_context*>(text.get()), nullptr);
+  EXPECT_THROW(stan3::read_data("nonexistent.bin"), std::runtime_error);
+}
+
+TEST_F(BinaryVarContextTest, RejectsMalformedFiles) {
+  {
+    std::ofstream out(path, std::ios::binary);
+    out << "{\"n\": 5}";
+  }
+  EXPECT_THROW(stan3::binary_var_context context(path), std::runtime_error);
+
+  {
+    // Index entry whose values run past the end of the file
+    std::ofstream out(path, std::ios::binary);
+    out.write(stan3::data_format::magic, 8);
+    auto write_pod = [&](auto value) {
+      out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    write_pod(stan3::data_format::byte_order_mark);
+    write_pod(stan3::data_format::version);
+    write_pod(uint64_t{1});
+    write_pod(uint64_t{1});
+    out << "y";
+    write_pod(static_cast<uint32_t>(stan3::data_format::FLOAT64));
+    write_pod(uint32_t{1});
+    write_pod(uint64_t{1000});
+    write_pod(uint64_t{48});
+  }
+  EXPECT_THROW(stan3::binary_var_context context(path), std::runtime_error);
+}
+
+TEST_F(BinaryVarContextTest, RejectsOverflowingDims) {
+  {
+    // 2^32 x 2^32 values wrap around to a size of 0
+    std::ofstream out(path, std::ios::binary);
+    out.write(stan3::data_format::magic, 8);
+    auto write_pod = [&](auto value) {
+      out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    write_pod(stan3::data_format::byte_order_mark);
+    write_pod(stan3::data_format::version);
+    write_pod(uint64_t{1});
+    write_pod(uint64_t{1});
+    out << "y";
+    write_pod(static_cast<uint32_t>(stan3::data_format::FLOAT64));
+    write_pod(uint32_t{2});
+    write_pod(uint64_t{1} << 32);
+    write_pod(uint64_t{1} << 32);
+    write_pod(uint64_t{48});
+  }
+  try {
+    stan3::binary_var_context context(path);
+    FAIL() << "Expected std::runtime_error";
+  } catch (const std::runtime_error& e) {
+    EXPECT_NE(std::string(e.what()).find("overflow"), std::string::npos) << e.what();
+  }
+}
@@ -0,0 +1,135 @@
+#include <stan3/binary_writer.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+/* Leaves the stream with the test so it can be inspected after the writer is gone */
+struct keep_stream {
+  void operator()(std::stringstream*) const {}
+};
+
+using test_writer = stan3::binary_stream_writer<std::stringstream, keep_stream>;
+
+template <typename T>
+T read_pod(std::istream& in) {
+  T value;
+  in.read(reinterpret_cast<char*>(&value), sizeof(T));
+  return value;
+}
+
+std::vector<std::string> read_header(std::istream& in) {
+  char magic[8];
+  in.read(magic, 8);
+  EXPECT_EQ(std::memcmp(magic, stan3::binary_format::magic, 8), 0);
+  EXPECT_EQ(read_pod<uint32_t>(in), stan3::binary_format::byte_order_mark);
+  EXPECT_EQ(read_pod<uint32_t>(in), stan3::binary_format::version);
+  uint64_t num_cols = read_pod<uint64_t>(in);
+  std::vector<std::string> names;
+  size_t bytes = 24;
+  for (uint64_t i = 0; i < num_cols; ++i) {
+    uint64_t len = read_pod<uint64_t>(in);
+    std::string name(len, '\0');
+    in.read(&name[0], len);
+    names.push_back(name);
+    bytes += 8 + len;
+  }
+  in.ignore(stan3::binary_format::padding(bytes));
+  return names;
+}
+
+}  // namespace
+
+TEST(BinaryWriterTest, HeaderHoldsColumnNames) {
+  std::stringstream ss;
+  {
+    test_writer writer{std::unique_ptr<std::stringstream, keep_stream>(&ss)};
+    writer(std::vector<std::string>{"lp__", "theta", "long_column_name"});
+  }
+  auto names = read_header(ss);
+  ASSERT_EQ(names.size(), 3);
+  EXPECT_EQ(names[0], "lp__");
+  EXPECT_EQ(names[1], "theta");
+  EXPECT_EQ(names[2], "long_column_name");
+  EXPECT_EQ(ss.tellg() % 8, 0);
+  EXPECT_EQ(ss.peek(), std::char_traits<char>::eof());
+}
+
+TEST(BinaryWriterTest, DrawsAreColumnMajorRowGroups) {
+  std::stringstream ss;
+  {
+    // Two columns, 16 bytes per row: 32-byte blocks hold two rows
+    test_writer writer(std::unique_ptr<std::stringstream, keep_stream>(&ss), 32);
+    writer(std::vector<std::string>{"a", "b"});
+    writer(std::vector<double>{1.0, 10.0});
+    writer(std::vector<double>{2.0, 20.0});
+    writer(std::vector<double>{3.0, 30.0});
+  }
+  read_header(ss);
+
+  EXPECT_EQ(read_pod<uint32_t>(ss), stan3::binary_format::DRAWS);
+  EXPECT_EQ(read_pod<uint32_t>(ss), 0);
+  ASSERT_EQ(read_pod<uint64_t>(ss), 2);
+  EXPECT_EQ(read_pod<double>(ss), 1.0);
+  EXPECT_EQ(read_pod<double>(ss), 2.0);
+  EXPECT_EQ(read_pod<double>(ss), 10.0);
+  EXPECT_EQ(read_pod<double>(ss), 20.0);
+
+  // Remaining row is flushed when the writer is destroyed
+  EXPECT_EQ(read_pod<uint32_t>(ss), stan3::binary_format::DRAWS);
+  EXPECT_EQ(read_pod<uint32_t>(ss), 0);
+  ASSERT_EQ(read_pod<uint64_t>(ss), 1);
+  EXPECT_EQ(read_pod<double>(ss), 3.0);
+  EXPECT_EQ(read_pod<double>(ss), 30.0);
+  EXPECT_EQ(ss.peek(), std::char_traits<char>::eof());
+}
+
+TEST(BinaryWriterTest, CommentsFlushPendingDraws) {
+  std::stringstream ss;
+  {
+    test_writer writer{std::unique_ptr<std::stringstream, keep_stream>(&ss)};
+    writer(std::vector<std::string>{"x"});
+    writer(std::vector<double>{0.5});
+    writer(std::string("Adaptation terminated"));
+    writer(std::vector<double>{1.5});
+  }
+  read_header(ss);
+
+  EXPECT_EQ(read_pod<uint32_t>(ss), stan3::binary_format::DRAWS);
+  read_pod<uint32_t>(ss);
+  ASSERT_EQ(read_pod<uint64_t>(ss), 1);
+  EXPECT_EQ(read_pod<double>(ss), 0.5);
+
+  EXPECT_EQ(read_pod<uint32_t>(ss), stan3::binary_format::COMMENT);
+  read_pod<uint32_t>(ss);
+  uint64_t len = read_pod<uint64_t>(ss);
+  std::string message(len, '\0');
+  ss.read(&message[0], len);
+  EXPECT_EQ(message, "Adaptation terminated");
+  ss.ignore(stan3::binary_format::padding(len));
+
+  EXPECT_EQ(read_pod<uint32_t>(ss), stan3::binary_format::DRAWS);
+  read_pod<uint32_t>(ss);
+  ASSERT_EQ(read_pod<uint64_t>(ss), 1);
+  EXPECT_EQ(read_pod<double>(ss), 1.5);
+}
+
+TEST(BinaryWriterTest, RejectsMismatchedRowLength) {
+  std::stringstream ss;
+  test_writer writer{std::unique_ptr<std::stringstream, keep_stream>(&ss)};
+  writer(std::vector<std::string>{"a", "b"});
+  EXPECT_THROW(writer(std::vector<double>{1.0}), std::invalid_argument);
+}
+
+TEST(BinaryWriterTest, RejectsDrawsBeforeHeader) {
+  std::stringstream ss;
+  test_writer writer{std::unique_ptr<std::stringstream, keep_stream>(&ss)};
+  EXPECT_THROW(writer(std::vector<double>{1.0}), std::logic_error);
+}
@@ -0,0 +1,145 @@
+#include <stan3/chain_affinity.hpp>
+
+#include <tbb/parallel_for.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+TEST(ChainAffinityTest, ParseCpuList) {
+  EXPECT_EQ(stan3::parse_cpu_list("0-3,8,10-11"),
+            (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+  EXPECT_TRUE(stan3::parse_cpu_list("").empty());
+}
+
+TEST(ChainAffinityTest, CpuNumaNodes) {
+  auto dir = std::filesystem::temp_directory_path() / "stan3_chain_affinity_nodes";
+  std::filesystem::create_directories(dir / "node0");
+  std::filesystem::create_directories(dir / "node1");
+  std::filesystem::create_directories(dir / "power");
+  std::ofstream(dir / "node0" / "cpulist") << "0,2\n";
+  std::ofstream(dir / "node1" / "cpulist") << "1,3\n";
+
+  auto nodes = stan3::cpu_numa_nodes(dir);
+  std::filesystem::remove_all(dir);
+  ASSERT_EQ(nodes.size(), 4);
+  EXPECT_EQ(nodes[0], 0);
+  EXPECT_EQ(nodes[1], 1);
+  EXPECT_EQ(nodes[2], 0);
+  EXPECT_EQ(nodes[3], 1);
+  EXPECT_TRUE(stan3::cpu_numa_nodes(dir).empty());
+}
+
+TEST(ChainAffinityTest, ChainCoreSetsAreConsecutiveBlocks) {
+  // CPUs of two nodes with interleaved numbering, grouped by node
+  std::vector<int> cpus{0, 2, 4, 6, 1, 3, 5, 7};
+  auto core_sets = stan3::chain_core_sets(2, 4, cpus);
+  ASSERT_EQ(core_sets.size(), 2);
+  EXPECT_EQ(core_sets[0], (std::vector<int>{0, 2, 4, 6}));
+  EXPECT_EQ(core_sets[1], (std::vector<int>{1, 3, 5, 7}));
+
+  auto wrapped = stan3::chain_core_sets(3, 2, {0, 1, 2, 3});
+  EXPECT_EQ(wrapped[2], (std::vector<int>{0, 1}));
+  EXPECT_TRUE(stan3::chain_core_sets(2, 2, {})[1].empty());
+}
+
+TEST(ChainAffinityTest, PlacementWithoutAffinityIsNotPinned) {
+  stan3::chain_placement placement(4, 4, 1, false);
+  EXPECT_FALSE(placement.pinned());
+  EXPECT_TRUE(placement.cores(0).empty());
+  int runs = 0;
+  placement.run(2, [&] { ++runs; });
+  EXPECT_EQ(runs, 1);
+}
+
+TEST(ChainAffinityTest, ChainsRunAllAtOnceOnlyWithoutWaitingTurns) {
+  stan3::chain_placement placement(4, 4, 1, false);
+  EXPECT_TRUE(placement.runs_all_at_once(1));
+  // Two of four chains at a time take turns
+  EXPECT_FALSE(stan3::chain_placement(4, 2, 1, false).runs_all_at_once(4));
+  {
+    // A shared pool schedules the chains as it sees fit
+    stan3::shared_pool_scope scope;
+    EXPECT_FALSE(placement.runs_all_at_once(4));
+  }
+  bool enough_threads = stan3::threading_enabled()
+    && tbb::global_control::active_value(tbb::global_control::max_allowed_parallelism) >= 4;
+  EXPECT_EQ(placement.runs_all_at_once(4), enough_threads);
+}
+
+#ifdef __linux__
+TEST(ChainAffinityTest, PinnedChainRunsOnItsCoresAndRestoresAffinity) {
+  cpu_set_t before;
+  CPU_ZERO(&before);
+  ASSERT_EQ(sched_getaffinity(0, sizeof(before), &before), 0);
+
+  stan3::chain_placement placement(2, 2, 1, true);
+  ASSERT_TRUE(placement.pinned());
+  std::vector<int> cores = placement.cores(1);
+  ASSERT_FALSE(cores.empty());
+
+  std::atomic<bool> on_cores{true};
+  placement.run(1, [&] {
+    tbb::parallel_for(0, 16, [&](int) {
+      int cpu = sched_getcpu();
+      if (std::find(cores.begin(), cores.end(), cpu) == cores.end()) {
+        on_cores = false;
+      }
+    });
+  });
+  EXPECT_TRUE(on_cores.load());
+
+  cpu_set_t after;
+  CPU_ZERO(&after);
+  ASSERT_EQ(sched_getaffinity(0, sizeof(after), &after), 0);
+  EXPECT_TRUE(CPU_EQUAL(&before, &after));
+}
+
+TEST(ChainAffinityTest, PinnedChainsRunInWavesOfOneChainPerCoreSet) {
+  if (!stan3::threading_enabled()) {
+    GTEST_SKIP() << "Concurrent chains need STAN_THREADS";
+  }
+  stan3::chain_placement placement(7, 2, 1, true);
+  ASSERT_TRUE(placement.pinned());
+  ASSERT_EQ(placement.threads().parallel_chains, 2);
+
+  // Chains of one core set (same index modulo 2) never overlap, and a
+  // chain only starts once the previous wave has finished
+  std::atomic<int> running[2] = {0, 0};
+  std::atomic<int> finished{0};
+  std::atomic<bool> shared_cores{false};
+  std::atomic<bool> out_of_wave{false};
+  auto errors = placement.run_chains(7, [&](size_t i) {
+    if (finished.load() < static_cast<int>(i / 2) * 2) {
+      out_of_wave = true;
+    }
+    if (++running[i % 2] > 1) {
+      shared_cores = true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(i % 2 == 0 ? 1 : 5));
+    --running[i % 2];
+    ++finished;
+    if (i == 3) {
+      throw std::runtime_error("chain 4");
+    }
+  });
+  EXPECT_FALSE(shared_cores.load());
+  EXPECT_FALSE(out_of_wave.load());
+  EXPECT_EQ(finished.load(), 7);
+  ASSERT_EQ(errors.size(), 7);
+  for (size_t i = 0; i < errors.size(); ++i) {
+    EXPECT_EQ(static_cast<bool>(errors[i]), i == 3);
+  }
+}
+#endif
@@ -0,0 +1,104 @@
+#include <stan3/chain_profile.hpp>
+
+#include <stan/callbacks/json_writer.hpp>
+#include <stan/callbacks/writer.hpp>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+/* Counts calls; each call takes at least a millisecond */
+struct slow_writer : public stan::callbacks::writer {
+  int calls = 0;
+
+  void record() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    ++calls;
+  }
+
+  void operator()(const std::vector<std::string>&) override { record(); }
+  void operator()(const std::vector<double>&) override { record(); }
+  void operator()() override { record(); }
+  void operator()(const std::string&) override { record(); }
+};
+
+}  // namespace
+
+TEST(ChainProfileTest, RecordTransitionSplitsPhases) {
+  stan3::chain_profile profile;
+  profile.record_transition(true, 3, 7, false, 0.5);
+  profile.record_transition(true, 2, 3, true, 0.25);
+  profile.record_transition(false, 2, 3, false, 0.125);
+
+  EXPECT_EQ(profile.warmup_iterations, 2);
+  EXPECT_EQ(profile.sampling_iterations, 1);
+  EXPECT_EQ(profile.warmup_leapfrogs, 10);
+  EXPECT_EQ(profile.sampling_leapfrogs, 3);
+  EXPECT_EQ(profile.gradient_evaluations(), 13);
+  EXPECT_EQ(profile.divergences, 1);
+  EXPECT_DOUBLE_EQ(profile.warmup_seconds, 0.75);
+  EXPECT_DOUBLE_EQ(profile.sampling_seconds, 0.125);
+  EXPECT_EQ(profile.tree_depth_counts, (std::vector<size_t>{0, 0, 2, 1}));
+}
+
+TEST(ChainProfileTest, TimedWriterForwardsAndAccumulates) {
+  slow_writer inner;
+  double seconds = 0;
+  stan3::timed_writer writer(inner, seconds);
+
+  writer(std::vector<std::string>{"a"});
+  writer(std::vector<double>{1.0});
+  writer();
+  writer("message");
+
+  EXPECT_EQ(inner.calls, 4);
+  EXPECT_GE(seconds, 0.004);
+}
+
+TEST(ChainProfileTest, WriteProfilesIncludesChainsAndTotals) {
+  std::vector<stan3::chain_profile> profiles(2);
+  profiles[0].record_transition(false, 1, 1, false, 0.0);
+  profiles[1].record_transition(false, 2, 3, false, 0.0);
+
+  auto stream = std::make_unique<std::stringstream>();
+  std::stringstream* out = stream.get();
+  {
+    stan::callbacks::json_writer<std::stringstream> writer(std::move(stream));
+    stan3::write_profiles(writer, "test_model", profiles);
+    std::string json = out->str();
+    EXPECT_NE(json.find("test_model"), std::string::npos);
+    EXPECT_NE(json.find("\"chain_1\""), std::string::npos);
+    EXPECT_NE(json.find("\"chain_2\""), std::string::npos);
+    EXPECT_NE(json.find("\"all_chains\""), std::string::npos);
+    EXPECT_NE(json.find("\"tree_depth_counts\""), std::string::npos);
+    EXPECT_EQ(json.find("\"chain_3\""), std::string::npos);
+  }
+}
+
+TEST(ChainProfileTest, WriteProfilesIncludesMemory) {
+  std::vector<stan3::chain_profile> profiles(2);
+  profiles[0].memory_bytes = 24;
+  profiles[1].memory_bytes = 40;
+
+  auto stream = std::make_unique<std::stringstream>();
+  std::stringstream* out = stream.get();
+  stan::callbacks::json_writer<std::stringstream> writer(std::move(stream));
+  stan3::write_profiles(writer, "test_model", profiles);
+  std::string json = out->str();
+  size_t all_chains = json.find("\"all_chains\"");
+  ASSERT_NE(all_chains, std::string::npos);
+  size_t total = json.find("\"memory_bytes\"", all_chains);
+  ASSERT_NE(total, std::string::npos);
+  EXPECT_EQ(json.find("64", total), json.find_first_of("0123456789", total));
+  EXPECT_NE(json.find("\"peak_rss_bytes\""), std::string::npos);
+}
+
+TEST(ChainProfileTest, PeakRssIsReported) {
+  EXPECT_GT(stan3::peak_rss_bytes(), 0);
+}
@@ -0,0 +1,118 @@
+#include <stan3/cross_chain_warmup.hpp>
+#include <stan3/parallel_chains.hpp>
+
+#include <Eigen/Dense>
+
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+std::vector<Eigen::VectorXd> test_draws() {
+  std::vector<Eigen::VectorXd> draws;
+  for (int i = 0; i < 12; ++i) {
+    Eigen::VectorXd q(3);
+    q << std::sin(i), 0.5 * i, std::cos(3.0 * i);
+    draws.push_back(q);
+  }
+  return draws;
+}
+
+}  // namespace
+
+TEST(CrossChainWarmupTest, MomentsMatchTwoPass) {
+  auto draws = test_draws();
+  stan3::window_moments diag;
+  stan3::window_moments dense{true};
+  Eigen::VectorXd mean = Eigen::VectorXd::Zero(3);
+  for (const auto& q : draws) {
+    diag.add(q);
+    dense.add(q);
+    mean += q / draws.size();
+  }
+  Eigen::MatrixXd m2 = Eigen::MatrixXd::Zero(3, 3);
+  for (const auto& q : draws) {
+    m2 += (q - mean) * (q - mean).transpose();
+  }
+  EXPECT_EQ(diag.n, draws.size());
+  EXPECT_TRUE(diag.mean.isApprox(mean, 1e-12));
+  EXPECT_TRUE(dense.m2.isApprox(m2, 1e-12));
+  EXPECT_TRUE(diag.m2.col(0).isApprox(m2.diagonal(), 1e-12));
+}
+
+TEST(CrossChainWarmupTest, MergeEqualsSingleChain) {
+  auto draws = test_draws();
+  for (bool is_dense : {false, true}) {
+    stan3::window_moments all{is_dense};
+    stan3::window_moments first{is_dense};
+    stan3::window_moments second{is_dense};
+    for (size_t i = 0; i < draws.size(); ++i) {
+      all.add(draws[i]);
+      (i < 5 ? first : second).add(draws[i]);
+    }
+    first.merge(second);
+    first.merge(stan3::window_moments{is_dense});
+    EXPECT_EQ(first.n, all.n);
+    EXPECT_TRUE(first.mean.isApprox(all.mean, 1e-12));
+    EXPECT_TRUE(first.m2.isApprox(all.m2, 1e-12));
+  }
+}
+
+TEST(CrossChainWarmupTest, RegularizedVarianceShrinksLikeStan) {
+  stan3::window_moments moments;
+  for (const auto& q : test_draws()) {
+    moments.add(q);
+  }
+  double n = moments.n;
+  Eigen::VectorXd expected = (n / (n + 5.0)) * (moments.m2.col(0) / (n - 1)).array()
+                             + 1e-3 * (5.0 / (n + 5.0));
+  EXPECT_TRUE(moments.regularized_variance().col(0).isApprox(expected, 1e-12));
+}
+
+TEST(CrossChainWarmupTest, AdapterPoolsAcrossChains) {
+  const size_t num_chains = 3;
+  stan3::cross_chain_adapter adapter(num_chains);
+  std::vector<double> pooled_n(num_chains);
+  std::vector<double> pooled_stepsize(num_chains);
+  std::vector<std::thread> chains;
+  for (size_t c = 0; c < num_chains; ++c) {
+    chains.emplace_back([&, c] {
+      stan3::window_moments moments;
+      for (size_t k = 0; k <= c; ++k) {
+        moments.add(Eigen::VectorXd::Constant(2, static_cast<double>(k)));
+      }
+      // Two rounds, as at two window boundaries
+      for (int round = 0; round < 2; ++round) {
+        pooled_n[c] = adapter.pool_moments(c, moments).n;
+        pooled_stepsize[c] = adapter.pool_stepsize(c, std::pow(2.0, c));
+      }
+    });
+  }
+  for (auto& t : chains) {
+    t.join();
+  }
+  for (size_t c = 0; c < num_chains; ++c) {
+    EXPECT_EQ(pooled_n[c], 6);  // 1 + 2 + 3 draws
+    EXPECT_NEAR(pooled_stepsize[c], 2.0, 1e-12);  // geometric mean of 1, 2, 4
+  }
+}
+
+TEST(CrossChainWarmupTest, CancelReleasesWaitingChains) {
+  stan3::cross_chain_adapter adapter(2);
+  bool interrupted = false;
+  std::thread waiting([&] {
+    try {
+      adapter.pool_stepsize(0, 1.0);
+    } catch (const stan3::chain_interrupted&) {
+      interrupted = true;
+    }
+  });
+  adapter.cancel();
+  waiting.join();
+  EXPECT_TRUE(interrupted);
+  EXPECT_THROW(adapter.pool_stepsize(1, 1.0), stan3::chain_interrupted);
+}
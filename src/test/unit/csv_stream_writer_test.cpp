@@ -0,0 +1,87 @@
+#include <stan3/csv_stream_writer.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+/* Leaves the stream with the test so it can be inspected after the writer is gone */
+struct keep_stream {
+  void operator()(std::stringstream*) const {}
+};
+
+using test_writer = stan3::csv_stream_writer<std::stringstream, keep_stream>;
+
+}  // namespace
+
+TEST(CsvStreamWriterTest, WritesHeaderRowsAndComments) {
+  std::stringstream ss;
+  {
+    test_writer writer{std::unique_ptr<std::stringstream, keep_stream>(&ss), "# "};
+    writer(std::vector<std::string>{"lp__", "theta"});
+    writer(std::string("Adaptation terminated"));
+    writer(std::vector<double>{-7.25, 0.1});
+    writer(std::vector<double>{});
+    writer();
+  }
+  EXPECT_EQ(ss.str(), "lp__,theta\n# Adaptation terminated\n-7.25,0.1\n# \n");
+}
+
+TEST(CsvStreamWriterTest, ValuesRoundTrip) {
+  std::vector<double> values{1.0 / 3.0, -2.2250738585072014e-308, 1e300, 6.02214076e23,
+                             0.0, -0.0, 123456789.0};
+  std::stringstream ss;
+  {
+    test_writer writer{std::unique_ptr<std::stringstream, keep_stream>(&ss)};
+    writer(values);
+  }
+  std::string line = ss.str();
+  ASSERT_EQ(line.back(), '\n');
+  std::istringstream fields(line.substr(0, line.size() - 1));
+  std::string field;
+  for (double expected : values) {
+    ASSERT_TRUE(std::getline(fields, field, ','));
+    EXPECT_EQ(std::strtod(field.c_str(), nullptr), expected) << field;
+  }
+  EXPECT_FALSE(std::getline(fields, field, ','));
+}
+
+TEST(CsvStreamWriterTest, NonFiniteValues) {
+  std::stringstream ss;
+  {
+    test_writer writer{std::unique_ptr<std::stringstream, keep_stream>(&ss)};
+    writer(std::vector<double>{std::numeric_limits<double>::infinity(),
+                               -std::numeric_limits<double>::infinity(),
+                               std::numeric_limits<double>::quiet_NaN()});
+  }
+  EXPECT_EQ(ss.str(), "inf,-inf,nan\n");
+}
+
+TEST(CsvStreamWriterTest, BuffersUntilFullOrFlushed) {
+  std::stringstream ss;
+  test_writer writer{std::unique_ptr<std::stringstream, keep_stream>(&ss), "#", 64};
+  writer(std::vector<double>{1.5, 2.5});
+  EXPECT_TRUE(ss.str().empty());
+  // Rows larger than the buffer are written as they are formatted
+  std::vector<double> wide(100, 0.125);
+  writer(wide);
+  EXPECT_FALSE(ss.str().empty());
+  writer.flush();
+  std::string expected = "1.5,2.5\n";
+  for (size_t i = 0; i < wide.size(); ++i) {
+    expected += i + 1 < wide.size() ? "0.125," : "0.125\n";
+  }
+  EXPECT_EQ(ss.str(), expected);
+}
+
+TEST(CsvStreamWriterTest, NullStreamThrows) {
+  std::unique_ptr<std::stringstream, keep_stream> null_stream;
+  EXPECT_THROW(test_writer(std::move(null_stream)), std::invalid_argument);
+}
@@ -0,0 +1,73 @@
+#include <stan3/data_cache.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+class DataCacheTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    path = testing::TempDir() + "stan3_data_cache_test.json";
+    write_data("{\"N\": 3}");
+  }
+
+  void TearDown() override { std::remove(path.c_str()); }
+
+  void write_data(const std::string& text) {
+    std::ofstream out(path);
+    out << text;
+  }
+
+  std::string path;
+  stan3::data_cache cache;
+};
+
+TEST_F(DataCacheTest, RepeatLoadsShareContext) {
+  auto first = cache.get(path);
+  auto second = cache.get(path);
+  EXPECT_EQ(first.get(), second.get());
+  EXPECT_EQ(cache.size(), 1);
+  EXPECT_EQ(first->vals_i("N"), std::vector<int>{3});
+}
+
+TEST_F(DataCacheTest, ReloadsChangedFile) {
+  auto first = cache.get(path);
+  write_data("{\"N\": 12345}");
+  auto second = cache.get(path);
+  EXPECT_NE(first.get(), second.get());
+  EXPECT_EQ(second->vals_i("N"), std::vector<int>{12345});
+  EXPECT_EQ(cache.size(), 1);
+}
+
+TEST_F(DataCacheTest, EvictAndClear) {
+  auto first = cache.get(path);
+  EXPECT_TRUE(cache.evict(path));
+  EXPECT_FALSE(cache.evict(path));
+  EXPECT_EQ(cache.size(), 0);
+
+  // Evicted contexts stay valid for their holders
+  EXPECT_EQ(first->vals_i("N"), std::vector<int>{3});
+  EXPECT_NE(cache.get(path).get(), first.get());
+
+  cache.get("src/test/unit/json/valid_data.json");
+  EXPECT_EQ(cache.size(), 2);
+  cache.clear();
+  EXPECT_EQ(cache.size(), 0);
+}
+
+TEST_F(DataCacheTest, EmptyFilenameIsNotCached) {
+  auto context = cache.get("");
+  std::vector<std::string> names;
+  context->names_r(names);
+  EXPECT_TRUE(names.empty());
+  EXPECT_EQ(cache.size(), 0);
+}
+
+TEST_F(DataCacheTest, MissingFileThrows) {
+  EXPECT_THROW(cache.get("nonexistent_data.json"), std::runtime_error);
+  EXPECT_EQ(cache.size(), 0);
+}
@@ -0,0 +1,121 @@
+#include <stan3/draws_reader.hpp>
+#include <stan3/binary_writer.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+class CsvDrawsReaderTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    path_ = (std::filesystem::temp_directory_path() / "csv_draws_reader_test.csv").string();
+  }
+
+  void TearDown() override {
+    std::filesystem::remove(path_);
+  }
+
+  void write_file(const std::string& contents) {
+    std::ofstream out(path_);
+    out << contents;
+  }
+
+  std::string path_;
+};
+
+TEST_F(CsvDrawsReaderTest, ReadsHeaderAndDraws) {
+  write_file("# model = bernoulli\n"
+             "lp__,accept_stat__,theta\n"
+             "# Adaptation terminated\n"
+             "-7.5,0.9,0.25\n"
+             "\n"
+             "-6.75,1,1e-3\r\n");
+  stan3::csv_draws_reader reader(path_);
+  EXPECT_EQ(reader.column_names(),
+            (std::vector<std::string>{"lp__", "accept_stat__", "theta"}));
+
+  std::vector<double> draw;
+  ASSERT_TRUE(reader.next(draw));
+  EXPECT_EQ(draw, (std::vector<double>{-7.5, 0.9, 0.25}));
+  ASSERT_TRUE(reader.next(draw));
+  EXPECT_EQ(draw, (std::vector<double>{-6.75, 1, 1e-3}));
+  EXPECT_FALSE(reader.next(draw));
+  EXPECT_EQ(reader.num_draws(), 2);
+}
+
+TEST_F(CsvDrawsReaderTest, ThrowsOnMalformedDraw) {
+  write_file("a,b\n1,2\n1\n1,2,3\n");
+  stan3::csv_draws_reader reader(path_);
+  std::vector<double> draw;
+  EXPECT_TRUE(reader.next(draw));
+  EXPECT_THROW(reader.next(draw), std::runtime_error);
+  EXPECT_THROW(reader.next(draw), std::runtime_error);
+}
+
+TEST_F(CsvDrawsReaderTest, ThrowsOnMissingFileOrHeader) {
+  EXPECT_THROW(stan3::csv_draws_reader("nonexistent_draws.csv"), std::runtime_error);
+  write_file("# only comments\n");
+  EXPECT_THROW(stan3::csv_draws_reader reader(path_), std::runtime_error);
+}
+
+class BinaryDrawsReaderTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    path_ = (std::filesystem::temp_directory_path() / "binary_draws_reader_test.bin").string();
+  }
+
+  void TearDown() override {
+    std::filesystem::remove(path_);
+  }
+
+  /* Write draws with a row group of two draws, so they span several blocks */
+  void write_draws(const std::vector<std::vector<double>>& draws) {
+    stan3::binary_stream_writer<std::ofstream> writer(
+        std::make_unique<std::ofstream>(path_, std::ios::binary), 2 * 2 * sizeof(double));
+    writer(std::vector<std::string>{"lp__", "theta"});
+    writer("Adaptation terminated");
+    for (const auto& draw : draws) {
+      writer(draw);
+    }
+  }
+
+  std::string path_;
+};
+
+TEST_F(BinaryDrawsReaderTest, ReadsDrawsAcrossBlocks) {
+  std::vector<std::vector<double>> draws{{-7.5, 0.25}, {-7.0, 0.5}, {-6.5, 0.75}};
+  write_draws(draws);
+
+  stan3::binary_draws_reader reader(path_);
+  EXPECT_EQ(reader.column_names(), (std::vector<std::string>{"lp__", "theta"}));
+  std::vector<double> draw;
+  for (const auto& expected : draws) {
+    ASSERT_TRUE(reader.next(draw));
+    EXPECT_EQ(draw, expected);
+  }
+  EXPECT_FALSE(reader.next(draw));
+  EXPECT_EQ(reader.num_draws(), 3);
+}
+
+TEST_F(BinaryDrawsReaderTest, ThrowsOnCsvFile) {
+  std::ofstream(path_) << "lp__,theta\n-7.5,0.25\n";
+  EXPECT_THROW(stan3::binary_draws_reader reader(path_), std::runtime_error);
+}
+
+TEST_F(BinaryDrawsReaderTest, OpenDrawsReaderDetectsFormat) {
+  write_draws({{-7.5, 0.25}});
+  auto binary = stan3::open_draws_reader(path_);
+  EXPECT_NE(dynamic_cast<stan3::binary_draws_reader*>(binary.get()), nullptr);
+
+  std::ofstream(path_) << "lp__,theta\n-7.5,0.25\n";
+  auto csv = stan3::open_draws_reader(path_);
+  EXPECT_NE(dynamic_cast<stan3::csv_draws_reader*>(csv.get()), nullptr);
+  std::vector<double> draw;
+  ASSERT_TRUE(csv->next(draw));
+  EXPECT_EQ(draw, (std::vector<double>{-7.5, 0.25}));
+}
@@ -0,0 +1,100 @@
+#include <stan3/filtered_writer.hpp>
+
+#include <stan/callbacks/writer.hpp>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+/* Keeps the header and rows it receives */
+struct recording_writer : public stan::callbacks::writer {
+  std::shared_ptr<std::vector<std::string>> names = std::make_shared<std::vector<std::string>>();
+  std::shared_ptr<std::vector<std::vector<double>>> rows
+    = std::make_shared<std::vector<std::vector<double>>>();
+  std::shared_ptr<std::vector<std::string>> messages = std::make_shared<std::vector<std::string>>();
+
+  void operator()(const std::vector<std::string>& header) override { *names = header; }
+
+  void operator()(const std::vector<double>& state) override { rows->push_back(state); }
+
+  void operator()(const std::string& message) override { messages->push_back(message); }
+};
+
+std::vector<std::string> sample_names() {
+  return {"lp__", "accept_stat__", "mu", "theta.1", "theta.2", "tau", "y_rep.1", "y_rep.2"};
+}
+
+}  // namespace
+
+TEST(FilteredWriterTest, ColumnVariable) {
+  EXPECT_EQ(stan3::column_variable("mu"), "mu");
+  EXPECT_EQ(stan3::column_variable("theta.1.2"), "theta");
+  EXPECT_EQ(stan3::column_variable("pair:1"), "pair");
+  EXPECT_TRUE(stan3::is_sampler_column("lp__"));
+  EXPECT_FALSE(stan3::is_sampler_column("mu"));
+}
+
+TEST(FilteredWriterTest, IncludeKeepsVariablesAndSamplerColumns) {
+  auto columns = stan3::select_columns(sample_names(), {{"theta", "tau"}, {}}, false);
+  EXPECT_EQ(columns, (std::vector<size_t>{0, 1, 3, 4, 5}));
+}
+
+TEST(FilteredWriterTest, ExcludeMatchesVariablesOrColumns) {
+  auto columns = stan3::select_columns(sample_names(), {{}, {"y_rep", "theta.2"}}, false);
+  EXPECT_EQ(columns, (std::vector<size_t>{0, 1, 2, 3, 5}));
+}
+
+TEST(FilteredWriterTest, DiagnosticColumnsFollowTheirParameter) {
+  std::vector<std::string> names{"lp__", "stepsize__", "mu", "theta.1", "theta.2",
+                                 "p_mu", "p_theta.1", "p_theta.2",
+                                 "g_mu", "g_theta.1", "g_theta.2"};
+  auto columns = stan3::select_columns(names, {{"mu"}, {}}, true);
+  EXPECT_EQ(columns, (std::vector<size_t>{0, 1, 2, 5, 8}));
+}
+
+TEST(FilteredWriterTest, WritesOnlySelectedColumns) {
+  recording_writer recorder;
+  stan3::filtered_writer writer(std::make_unique<recording_writer>(recorder),
+                                {{"mu", "y_rep"}, {"y_rep.1"}});
+  writer(sample_names());
+  writer(std::vector<double>{-1, 0.9, 2, 3, 4, 5, 6, 7});
+  writer(std::vector<double>{1.5});
+  writer(std::string("Elapsed"));
+
+  EXPECT_EQ(*recorder.names,
+            (std::vector<std::string>{"lp__", "accept_stat__", "mu", "y_rep.2"}));
+  ASSERT_EQ(recorder.rows->size(), 2);
+  EXPECT_EQ((*recorder.rows)[0], (std::vector<double>{-1, 0.9, 2, 7}));
+  // Rows that do not match the header are forwarded unchanged
+  EXPECT_EQ((*recorder.rows)[1], (std::vector<double>{1.5}));
+  EXPECT_EQ(*recorder.messages, (std::vector<std::string>{"Elapsed"}));
+}
+
+TEST(FilteredWriterTest, NullWriterThrows) {
+  EXPECT_THROW(stan3::filtered_writer(nullptr, {}), std::invalid_argument);
+}
+
+TEST(FilteredWriterTest, ValidateAcceptsVariablesColumnsAndSamplerColumns) {
+  EXPECT_NO_THROW(stan3::validate_variable_filter({{"theta", "theta.1", "lp__"}, {"y_rep.2"}},
+                                                  sample_names()));
+}
+
+TEST(FilteredWriterTest, ValidateListsUnknownNames) {
+  try {
+    stan3::validate_variable_filter({{"theta", "thetaa", "sigma"}, {}}, sample_names());
+    FAIL() << "Expected std::invalid_argument";
+  } catch (const std::invalid_argument& e) {
+    EXPECT_STREQ(e.what(), "Unknown variables in --output-vars: thetaa, sigma");
+  }
+  try {
+    stan3::validate_variable_filter({{}, {"yrep"}}, sample_names());
+    FAIL() << "Expected std::invalid_argument";
+  } catch (const std::invalid_argument& e) {
+    EXPECT_STREQ(e.what(), "Unknown variables in --exclude-vars: yrep");
+  }
+}
@@ -123,6 +123,7 @@ TEST(HmcNutsArgsTest, HmcDefaultValues) {
   
   // Test inference_args defaults
   EXPECT_EQ(args.base.num_chains, 1);
+  EXPECT_EQ(args.base.num_threads, 1);
   
   // Test HMC-specific defaults
   EXPECT_EQ(args.num_warmup, 1000);
@@ -135,10 +136,13 @@ TEST(HmcNutsArgsTest, HmcDefaultValues) {
   EXPECT_EQ(args.max_depth, 10);
   
   // Test output defaults
+  EXPECT_EQ(args.output_format, stan3::output_format_t::CSV);
+  EXPECT_FALSE(args.async_output);
   EXPECT_FALSE(args.save_start_params);
   EXPECT_FALSE(args.save_warmup);
   EXPECT_FALSE(args.save_diagnostics);
   EXPECT_FALSE(args.save_metric);
+  EXPECT_TRUE(args.profile_file.empty());
   
   // Test NUTS adaptation defaults
   EXPECT_EQ(args.delta, 0.8);
@@ -247,6 +251,155 @@ TEST(HmcNutsArgsTest, ParseHmcArgs_ValidArgs) {
   }
 }
 
+TEST(HmcNutsArgsTest, ParseHmcArgs_NumThreads) {
+  const char* argv[] = {"stan3", "--chains", "4", "--num-threads", "4"};
+  int argc = 5;
+
+  stan3::hmc_nuts_args args;
+  std::string error_msg;
+  EXPECT_TRUE(stan3::parse_hmc_args(argc, const_cast<char**>(argv), args, error_msg));
+  EXPECT_EQ(args.base.num_chains, 4);
+  EXPECT_EQ(args.base.num_threads, 4);
+}
+
+TEST(HmcNutsArgsTest, ParseHmcArgs_NumThreadsMustBePositive) {
+  const char* argv[] = {"stan3", "--num-threads", "0"};
+  int argc = 3;
+
+  stan3::hmc_nuts_args args;
+  std::string error_msg;
+  EXPECT_FALSE(stan3::parse_hmc_args(argc, const_cast<char**>(argv), args, error_msg));
+}
+
+TEST(HmcNutsArgsTest, ParseHmcArgs_OutputFormat) {
+  const char* argv[] = {"stan3", "--output-format", "binary"};
+  int argc = 3;
+
+  stan3::hmc_nuts_args args;
+  std::string error_msg;
+  EXPECT_TRUE(stan3::parse_hmc_args(argc, const_cast<char**>(argv), args, error_msg));
+  EXPECT_EQ(args.output_format, stan3::output_format_t::BINARY);
+
+  const char* bad_argv[] = {"stan3", "--output-format", "parquet"};
+  stan3::hmc_nuts_args bad_args;
+  EXPECT_FALSE(stan3::parse_hmc_args(argc, const_cast<char**>(bad_argv), bad_args, error_msg));
+}
+
+TEST(HmcNutsArgsTest, ParseHmcArgs_AsyncOutput) {
+  const char* argv[] = {"stan3", "--async-output"};
+  int argc = 2;
+
+  stan3::hmc_nuts_args args;
+  std::string error_msg;
+  EXPECT_TRUE(stan3::parse_hmc_args(argc, const_cast<char**>(argv), args, error_msg));
+  EXPECT_TRUE(args.async_output);
+}
+
+TEST(HmcNutsArgsTest, ParseHmcArgs_ProfileOutput) {
+  const char* argv[] = {"stan3", "--profile-output", "profile.json"};
+  int argc = 3;
+
+  stan3::hmc_nuts_args args;
+  std::string error_msg;
+  EXPECT_TRUE(stan3::parse_hmc_args(argc, const_cast<char**>(argv), args, error_msg));
+  EXPECT_EQ(args.profile_file, "profile.json");
+}
+
+TEST(HmcNutsArgsTest, ParseHmcArgs_ConvergenceTargets) {
+  const char* argv[] = {"stan3", "--target-ess", "400", "--target-rhat", "1.01",
+                        "--summary-output", "summary.json"};
+  int argc = 7;
+
+  stan3::hmc_nuts_args args;
+  std::string error_msg;
+  EXPECT_EQ(args.target_ess, 0);
+  EXPECT_EQ(args.target_rhat, 0);
+  ASSERT_TRUE(stan3::parse_hmc_args(argc, const_cast<char**>(argv), args, error_msg))
+      << error_msg;
+  EXPECT_EQ(args.target_ess, 400);
+  EXPECT_EQ(args.target_rhat, 1.01);
+  EXPECT_EQ(args.summary_file, "summary.json");
+}
+
+TEST(HmcNutsArgsTest, ParseHmcArgs_TargetRhatMustExceedOne) {
+  const char* argv[] = {"stan3", "--target-rhat", "0.9"};
+  int argc = 3;
+
+  stan3::hmc_nuts_args args;
+  std::string error_msg;
+  EXPECT_FALSE(stan3::parse_hmc_args(argc, const_cast<char**>(argv), args, error_msg));
+  EXPECT_NE(error_msg.find("--target-rhat"), std::string::npos);
+}
+
+TEST(HmcNutsArgsTest, ParseHmcArgs_WarmStartRequiresMetric) {
+  const char* argv[] = {"stan3", "--warm-start"};
+  int argc = 2;
+
+  stan3::hmc_nuts_args args;
+  std::string error_msg;
+  EXPECT_FALSE(stan3::parse_hmc_args(argc, const_cast<char**>(argv), args, error_msg));
+  EXPECT_NE(error_msg.find("--warm-start"), std::string::npos);
+}
+
+TEST(HmcNutsArgsTest, ParseHmcArgs_ThreadsPerChain) {
+  const char* argv[] = {"stan3", "--num-threads", "8", "--threads-per-chain", "4"};
+  int argc = 5;
+
+  stan3::hmc_nuts_args args;
+  std::string error_msg;
+  ASSERT_TRUE(stan3::parse_hmc_args(argc, const_cast<char**>(argv), args, error_msg));
+  EXPECT_EQ(args.threads_per_chain, 4);
+
+  const char* too_many[] = {"stan3", "--num-threads", "2", "--threads-per-chain", "4"};
+  stan3::hmc_nuts_args invalid_args;
+  EXPECT_FALSE(stan3::parse_hmc_args(argc, const_cast<char**>(too_many), invalid_args, error_msg));
+  EXPECT_NE(error_msg.find("--threads-per-chain"), std::string::npos);
+}
+
+TEST(HmcNutsArgsTest, ParseHmcArgs_Affinity) {
+  const char* argv[] = {"stan3", "--affinity"};
+  int argc = 2;
+
+  stan3::hmc_nuts_args args;
+  std::string error_msg;
+  EXPECT_FALSE(args.affinity);
+  ASSERT_TRUE(stan3::parse_hmc_args(argc, const_cast<char**>(argv), args, error_msg));
+  EXPECT_TRUE(args.affinity);
+}
+
+TEST(HmcNutsArgsTest, ParseHmcArgs_MemoryLean) {
+  const char* argv[] = {"stan3", "--memory-lean"};
+  int argc = 2;
+
+  stan3::hmc_nuts_args args;
+  std::string error_msg;
+  EXPECT_FALSE(args.memory_lean);
+  ASSERT_TRUE(stan3::parse_hmc_args(argc, const_cast<char**>(argv), args, error_msg));
+  EXPECT_TRUE(args.memory_lean);
+}
+
+TEST(HmcNutsArgsTest, ParseHmcArgs_OutputVars) {
+  const char* argv[] = {"stan3", "--output-vars", "mu,tau", "--exclude-vars", "y_rep"};
+  int argc = 5;
+
+  stan3::hmc_nuts_args args;
+  std::string error_msg;
+  ASSERT_TRUE(stan3::parse_hmc_args(argc, const_cast<char**>(argv), args, error_msg))
+      << error_msg;
+  EXPECT_EQ(args.output_vars, (std::vector<std::string>{"mu", "tau"}));
+  EXPECT_EQ(args.exclude_vars, (std::vector<std::string>{"y_rep"}));
+}
+
+TEST(HmcNutsArgsTest, ParseHmcArgs_OutputVarsMustNotBeExcluded) {
+  const char* argv[] = {"stan3", "--output-vars", "mu", "--exclude-vars", "mu"};
+  int argc = 5;
+
+  stan3::hmc_nuts_args args;
+  std::string error_msg;
+  EXPECT_FALSE(stan3::parse_hmc_args(argc, const_cast<char**>(argv), args, error_msg));
+  EXPECT_NE(error_msg.find("--exclude-vars"), std::string::npos);
+}
+
 /* Test finalize function */
 TEST(HmcNutsArgsTest, FinalizeHmcArguments) {
   stan3::hmc_nuts_args args;
@@ -1,6 +1,7 @@
 #include <stan3/hmc_output_writers.hpp>
 #include <stan3/arguments.hpp>
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <string>
@@ -263,6 +264,44 @@ TEST_F(HMCOutputWritersTest, CreateMultiChainWritersFilesCreated) {
   EXPECT_TRUE(found_chain2);
 }
 
+TEST_F(HMCOutputWritersTest, CreateMultiChainWritersSingleFile) {
+  args.base.num_chains = 2;
+  args.single_file = true;
+  args.save_metric = true;
+
+  auto multi_writers = stan3::create_hmc_nuts_multi_chain_writers(
+    args, "shared_test");
+  ASSERT_EQ(multi_writers.size(), 2);
+  for (size_t i = 0; i < multi_writers.size(); ++i) {
+    multi_writers[i].sample_writer->operator()(std::vector<std::string>{"lp__", "theta"});
+    multi_writers[i].sample_writer->operator()(std::vector<double>{-1, 0.5 * (i + 1)});
+    multi_writers[i].metric_writer->begin_record();
+    multi_writers[i].metric_writer->write("stepsize", 0.5 * (i + 1));
+    multi_writers[i].metric_writer->end_record();
+  }
+  multi_writers.clear();
+
+  std::vector<std::filesystem::path> files;
+  for (const auto& entry : std::filesystem::directory_iterator(test_dir)) {
+    files.push_back(entry.path());
+  }
+  // One sample file and one metric file for both chains
+  ASSERT_EQ(files.size(), 2);
+  std::filesystem::path sample_file = files[0].extension() == ".csv" ? files[0] : files[1];
+  EXPECT_EQ(sample_file.filename().string().find("chain"), std::string::npos);
+
+  std::ifstream file(sample_file);
+  std::string header;
+  std::vector<std::string> rows(2);
+  std::getline(file, header);
+  std::getline(file, rows[0]);
+  std::getline(file, rows[1]);
+  std::sort(rows.begin(), rows.end());
+  EXPECT_EQ(header, "chain__,lp__,theta");
+  EXPECT_EQ(rows[0], "1,-1,0.5");
+  EXPECT_EQ(rows[1], "2,-1,1");
+}
+
 TEST_F(HMCOutputWritersTest, CreateWritersCustomCommentPrefix) {
   std::string model_name = "comment_test";
   std::string timestamp = "20250522_143000";
@@ -293,6 +332,42 @@ TEST_F(HMCOutputWritersTest, CreateWritersCustomCommentPrefix) {
   EXPECT_EQ(line, "## comment");
 }
 
+TEST_F(HMCOutputWritersTest, CreateSingleChainWritersBinaryFormat) {
+  args.output_format = stan3::output_format_t::BINARY;
+  args.save_diagnostics = true;
+  
+  std::string model_name = "binary_test";
+  std::string timestamp = "20250522_143000";
+  
+  auto writers = stan3::create_hmc_nuts_single_chain_writers(
+    args, model_name, timestamp, 1);
+  
+  ASSERT_TRUE(writers.sample_writer != nullptr);
+  ASSERT_TRUE(writers.diagnostics_writer != nullptr);
+  
+  std::vector<std::string> headers = {"lp__", "theta"};
+  std::vector<double> values = {-7.3, 0.25};
+  writers.sample_writer->operator()(headers);
+  writers.sample_writer->operator()(values);
+  writers.sample_writer.reset();
+  writers.diagnostics_writer.reset();
+  
+  for (const auto& data_type : {"sample", "param_grads"}) {
+    std::string path = stan3::create_file_path(
+      test_dir.string(),
+      stan3::generate_filename(model_name, timestamp, 1, data_type, ".bin"));
+    EXPECT_TRUE(std::filesystem::exists(path));
+  }
+  
+  std::ifstream file(stan3::create_file_path(
+    test_dir.string(),
+    stan3::generate_filename(model_name, timestamp, 1, "sample", ".bin")),
+    std::ios::binary);
+  char magic[8];
+  file.read(magic, 8);
+  EXPECT_EQ(std::string(magic, 8), "STAN3DRW");
+}
+
 TEST_F(HMCOutputWritersTest, CreateWritersInvalidOutputDir) {
   args.base.output_dir = "/root/invalid_directory_that_should_not_exist";
   
@@ -304,3 +379,98 @@ TEST_F(HMCOutputWritersTest, CreateWritersInvalidOutputDir) {
     std::runtime_error
   );
 }
+
+TEST_F(HMCOutputWritersTest, CreateSingleChainWritersAsyncOutput) {
+  args.async_output = true;
+  
+  std::string model_name = "async_test";
+  std::string timestamp = "20250522_143000";
+  
+  auto writers = stan3::create_hmc_nuts_single_chain_writers(
+    args, model_name, timestamp, 1);
+  ASSERT_TRUE(writers.sample_writer != nullptr);
+  
+  writers.sample_writer->operator()(std::vector<std::string>{"lp__", "theta"});
+  for (int i = 0; i < 500; ++i) {
+    writers.sample_writer->operator()(std::vector<double>{-7.3, 0.25});
+  }
+  writers.sample_writer.reset();
+  
+  std::ifstream file(stan3::create_file_path(
+    test_dir.string(),
+    stan3::generate_filename(model_name, timestamp, 1, "sample", ".csv")));
+  std::string line;
+  int lines = 0;
+  while (std::getline(file, line)) {
+    ++lines;
+  }
+  EXPECT_EQ(lines, 501);
+}
+
+TEST_F(HMCOutputWritersTest, CreateSingleChainWritersOutputVars) {
+  args.output_vars = {"theta"};
+
+  std::string model_name = "filter_test";
+  std::string timestamp = "20250522_143000";
+
+  auto writers = stan3::create_hmc_nuts_single_chain_writers(
+    args, model_name, timestamp, 1);
+  writers.sample_writer->operator()(std::vector<std::string>{"lp__", "theta", "z.1", "z.2"});
+  writers.sample_writer->operator()(std::vector<double>{-7.5, 0.25, 1, 2});
+  writers.sample_writer.reset();
+
+  std::ifstream file(stan3::create_file_path(
+    test_dir.string(),
+    stan3::generate_filename(model_name, timestamp, 1, "sample", ".csv")));
+  std::string header, row;
+  std::getline(file, header);
+  std::getline(file, row);
+  EXPECT_EQ(header, "lp__,theta");
+  EXPECT_EQ(row, "-7.5,0.25");
+}
+
+TEST_F(HMCOutputWritersTest, NumSavedDraws) {
+  args.num_warmup = 100;
+  args.num_samples = 1000;
+  args.thin = 3;
+  args.save_warmup = false;
+  EXPECT_EQ(stan3::num_saved_draws(args), 334);
+  
+  args.save_warmup = true;
+  EXPECT_EQ(stan3::num_saved_draws(args), 334 + 34);
+  
+  args.num_warmup = 0;
+  EXPECT_EQ(stan3::num_saved_draws(args), 334);
+}
+
+TEST_F(HMCOutputWritersTest, CreateMemoryWriters) {
+  args.base.num_chains = 2;
+  args.num_warmup = 10;
+  args.num_samples = 5;
+  args.save_metric = true;
+  
+  auto buffer = std::make_shared<stan3::draws_buffer>(
+    args.base.num_chains, stan3::num_saved_draws(args));
+  auto writers = stan3::create_hmc_nuts_memory_writers(args, "memory_test", buffer);
+  
+  ASSERT_EQ(writers.size(), 2);
+  for (auto& writer : writers) {
+    ASSERT_TRUE(writer.sample_writer != nullptr);
+    EXPECT_TRUE(writer.start_params_writer == nullptr);
+    EXPECT_TRUE(writer.diagnostics_writer == nullptr);
+    EXPECT_TRUE(writer.metric_writer != nullptr);
+    writer.sample_writer->operator()(std::vector<std::string>{"lp__"});
+  }
+  writers[1].sample_writer->operator()(std::vector<double>{-3.5});
+  
+  EXPECT_EQ(buffer->num_rows(), 10);
+  EXPECT_EQ(buffer->values()[5], -3.5);
+  
+  // Only the metric files reach the output directory
+  size_t num_files = 0;
+  for (const auto& entry : std::filesystem::directory_iterator(test_dir)) {
+    EXPECT_NE(entry.path().string().find("_metric.json"), std::string::npos);
+    ++num_files;
+  }
+  EXPECT_EQ(num_files, 2);
+}
@@ -0,0 +1,94 @@
+#include <stan3/log_density.hpp>
+#include <stan3/read_json_data.hpp>
+
+#include <test/test-models/bernoulli.hpp>
+
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+class LogDensityTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    auto data_context = stan3::read_json_data("src/test/test-models/bernoulli.data.json");
+    model_ = std::make_unique<bernoulli_model_namespace::bernoulli_model>(*data_context, 12345);
+  }
+
+  /* Log density of the bernoulli model (2 successes in 10 trials,
+   * uniform prior) at u = logit(theta), with the Jacobian */
+  static double bernoulli_lp(double u) {
+    double theta = 1.0 / (1.0 + std::exp(-u));
+    return 3.0 * std::log(theta) + 9.0 * std::log(1.0 - theta);
+  }
+
+  static double bernoulli_grad(double u) {
+    return 3.0 - 12.0 / (1.0 + std::exp(-u));
+  }
+
+  std::unique_ptr<bernoulli_model_namespace::bernoulli_model> model_;
+};
+
+TEST_F(LogDensityTest, GradientMatchesAnalytic) {
+  for (double u : {-2.0, 0.0, 0.7}) {
+    double grad = 0;
+    double lp = stan3::log_density_gradient(*model_, &u, &grad);
+    EXPECT_NEAR(lp, bernoulli_lp(u), 1e-8);
+    EXPECT_NEAR(grad, bernoulli_grad(u), 1e-4);
+  }
+}
+
+TEST_F(LogDensityTest, BatchMatchesSingleEvaluations) {
+  const size_t num_evals = 200;
+  std::vector<double> theta_unc(num_evals);
+  for (size_t i = 0; i < num_evals; ++i) {
+    theta_unc[i] = -3.0 + 6.0 * i / num_evals;
+  }
+  std::vector<double> lp(num_evals);
+  std::vector<double> grad(num_evals);
+  stan3::log_density_gradient_batch(*model_, num_evals, theta_unc.data(), lp.data(),
+                                    grad.data(), 4);
+  for (size_t i = 0; i < num_evals; ++i) {
+    double expected_grad = 0;
+    double expected_lp = stan3::log_density_gradient(*model_, &theta_unc[i], &expected_grad);
+    EXPECT_EQ(lp[i], expected_lp);
+    EXPECT_EQ(grad[i], expected_grad);
+  }
+}
+
+TEST_F(LogDensityTest, ConcurrentCallersDoNotInterfere) {
+  if (!stan3::threading_enabled()) {
+    GTEST_SKIP() << "Concurrent evaluation needs STAN_THREADS";
+  }
+  std::vector<std::thread> callers;
+  std::vector<int> mismatches(4, 0);
+  for (int t = 0; t < 4; ++t) {
+    callers.emplace_back([&, t] {
+      for (int k = 0; k < 500; ++k) {
+        double u = 0.01 * (k + 1000 * t);
+        double grad = 0;
+        double lp = stan3::log_density_gradient(*model_, &u, &grad);
+        if (std::abs(lp - bernoulli_lp(u)) > 1e-8) {
+          ++mismatches[t];
+        }
+      }
+    });
+  }
+  for (auto& caller : callers) {
+    caller.join();
+  }
+  EXPECT_EQ(mismatches, std::vector<int>(4, 0));
+}
+
+TEST_F(LogDensityTest, ConstrainInvertsUnconstrain) {
+  double theta = 0.25;
+  double u = 0;
+  ASSERT_EQ(stan3::num_constrained_params(*model_), 1);
+  stan3::param_unconstrain(*model_, 1, &theta, &u);
+  EXPECT_NEAR(u, std::log(0.25 / 0.75), 1e-12);
+  double constrained = 0;
+  stan3::param_constrain(*model_, &u, true, true, 1234, &constrained);
+  EXPECT_NEAR(constrained, theta, 1e-12);
+}
@@ -0,0 +1,71 @@
+#include <stan3/memory_writer.hpp>
+
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+TEST(MemoryWriterTest, ChainsWriteTheirOwnRows) {
+  auto buffer = std::make_shared<stan3::draws_buffer>(2, 3);
+  stan3::memory_writer chain1(buffer, 0);
+  stan3::memory_writer chain2(buffer, 1);
+  EXPECT_EQ(buffer->num_rows(), 0);
+
+  chain1(std::vector<std::string>{"lp__", "theta"});
+  chain2(std::vector<std::string>{"lp__", "theta"});
+  ASSERT_EQ(buffer->num_rows(), 6);
+  ASSERT_EQ(buffer->num_cols(), 2);
+
+  for (int i = 0; i < 3; ++i) {
+    chain2(std::vector<double>{-10.0 - i, 0.5});
+    chain1(std::vector<double>{-1.0 - i, 0.25});
+  }
+  chain1(std::string("Adaptation terminated"));
+  chain1();
+
+  const auto& values = buffer->values();
+  ASSERT_EQ(values.size(), 12);
+  // Row-major, rows grouped by chain
+  EXPECT_EQ(values[0], -1.0);
+  EXPECT_EQ(values[1], 0.25);
+  EXPECT_EQ(values[4], -3.0);
+  EXPECT_EQ(values[6], -10.0);
+  EXPECT_EQ(values[7], 0.5);
+  EXPECT_EQ(values[10], -12.0);
+  EXPECT_EQ(buffer->draws_written(0), 3);
+  EXPECT_EQ(buffer->draws_written(1), 3);
+}
+
+TEST(MemoryWriterTest, UnwrittenRowsAreNaN) {
+  auto buffer = std::make_shared<stan3::draws_buffer>(1, 2);
+  stan3::memory_writer writer(buffer, 0);
+  writer(std::vector<std::string>{"x"});
+  writer(std::vector<double>{1.0});
+
+  EXPECT_EQ(buffer->draws_written(0), 1);
+  EXPECT_EQ(buffer->values()[0], 1.0);
+  EXPECT_TRUE(std::isnan(buffer->values()[1]));
+}
+
+TEST(MemoryWriterTest, RejectsInvalidDraws) {
+  auto buffer = std::make_shared<stan3::draws_buffer>(1, 1);
+  stan3::memory_writer writer(buffer, 0);
+  EXPECT_THROW(writer(std::vector<double>{1.0}), std::logic_error);
+
+  writer(std::vector<std::string>{"a", "b"});
+  EXPECT_THROW(writer(std::vector<double>{1.0}), std::invalid_argument);
+  writer(std::vector<double>{1.0, 2.0});
+  EXPECT_THROW(writer(std::vector<double>{3.0, 4.0}), std::out_of_range);
+}
+
+TEST(MemoryWriterTest, RejectsMismatchedColumnNames) {
+  auto buffer = std::make_shared<stan3::draws_buffer>(2, 1);
+  stan3::memory_writer chain1(buffer, 0);
+  stan3::memory_writer chain2(buffer, 1);
+  chain1(std::vector<std::string>{"a"});
+  EXPECT_THROW(chain2(std::vector<std::string>{"b"}), std::invalid_argument);
+  EXPECT_THROW(stan3::memory_writer(buffer, 2), std::out_of_range);
+}
@@ -0,0 +1,249 @@
+#include <stan3/online_summary.hpp>
+
+#include <stan/callbacks/json_writer.hpp>
+#include <stan/callbacks/writer.hpp>
+
+#include <boost/random/mixmax.hpp>
+#include <boost/random/normal_distribution.hpp>
+
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+/* Writer that records every row */
+struct recording_writer : public stan::callbacks::writer {
+  void operator()(const std::vector<std::string>& n) override { names = n; }
+  void operator()(const std::vector<double>& row) override { rows.push_back(row); }
+  std::vector<std::string> names;
+  std::vector<std::vector<double>> rows;
+};
+
+/* Fill a summary with AR(1) chains x_t = phi * x_{t-1} + e_t, with
+ * e_t ~ normal(0, 1) and chain c shifted by c * offset */
+stan3::online_summary ar1_summary(size_t num_chains, size_t num_draws, double phi,
+                                  double offset = 0.0) {
+  stan3::online_summary summary(num_chains);
+  boost::random::mixmax rng(1234);
+  boost::random::normal_distribution<double> normal;
+  for (size_t c = 0; c < num_chains; ++c) {
+    summary.set_names(c, {"x"});
+    double x = normal(rng) / std::sqrt(1 - phi * phi);
+    for (size_t t = 0; t < num_draws; ++t) {
+      x = phi * x + normal(rng);
+      summary.add(c, {x + c * offset});
+    }
+  }
+  return summary;
+}
+
+}  // namespace
+
+TEST(OnlineSummaryTest, WelfordMatchesTwoPass) {
+  std::vector<double> xs{1.5, -2.0, 3.25, 0.0, 7.0};
+  stan3::welford_accumulator acc;
+  double sum = 0;
+  for (double x : xs) {
+    acc.add(x);
+    sum += x;
+  }
+  double mean = sum / xs.size();
+  double ss = 0;
+  for (double x : xs) {
+    ss += (x - mean) * (x - mean);
+  }
+  EXPECT_EQ(acc.n, xs.size());
+  EXPECT_NEAR(acc.mean, mean, 1e-12);
+  EXPECT_NEAR(acc.variance(), ss / (xs.size() - 1), 1e-12);
+  EXPECT_TRUE(std::isnan(stan3::welford_accumulator().variance()));
+}
+
+TEST(OnlineSummaryTest, BatchMeansBoundsBatches) {
+  stan3::batch_means batches;
+  for (int i = 0; i < 10000; ++i) {
+    batches.add(i % 2);
+  }
+  // 10000 values in 32 to 64 batches
+  EXPECT_GE(batches.batch_size(), 10000 / (2 * stan3::batch_means::min_batches));
+  EXPECT_LE(batches.batch_size(), 10000 / stan3::batch_means::min_batches);
+  // Alternating values average out within every (even) batch
+  EXPECT_NEAR(batches.asymptotic_variance(), 0.0, 1e-12);
+}
+
+TEST(OnlineSummaryTest, BatchMeansSplitsAtCurrentLength) {
+  stan3::batch_means batches;
+  for (int i = 0; i < 40; ++i) {
+    batches.add(i < 20 ? 1.0 : 3.0);
+  }
+  // Before the batch size doubles, the halves are exact
+  EXPECT_EQ(batches.half(0).n, 20);
+  EXPECT_EQ(batches.half(1).n, 20);
+  EXPECT_DOUBLE_EQ(batches.half(0).mean, 1.0);
+  EXPECT_DOUBLE_EQ(batches.half(1).mean, 3.0);
+
+  for (int i = 40; i < 1001; ++i) {
+    batches.add(i);
+  }
+  {
+    stan3::welford_accumulator first = batches.half(0);
+    stan3::welford_accumulator second = batches.half(1);
+    EXPECT_EQ(first.n + second.n, 1001);
+    EXPECT_LE(first.n > 500 ? first.n - 500 : 500 - first.n, batches.batch_size() / 2);
+  }
+}
+
+TEST(OnlineSummaryTest, IndependentDrawsConverge) {
+  auto summary = ar1_summary(4, 2000, 0.0);
+  stan3::column_summary s = summary.summarize(0);
+  EXPECT_EQ(summary.num_draws(), 8000);
+  EXPECT_NEAR(s.mean, 0.0, 0.1);
+  EXPECT_NEAR(s.sd, 1.0, 0.05);
+  EXPECT_NEAR(s.rhat, 1.0, 0.01);
+  EXPECT_GT(s.ess, 5000);
+  EXPECT_NEAR(s.mcse_mean, s.sd / std::sqrt(s.ess), 1e-12);
+}
+
+TEST(OnlineSummaryTest, AutocorrelationReducesEss) {
+  // ESS of an AR(1) chain is N (1 - phi) / (1 + phi)
+  double phi = 0.9;
+  auto summary = ar1_summary(4, 5000, phi);
+  stan3::column_summary s = summary.summarize(0);
+  double expected = 20000 * (1 - phi) / (1 + phi);
+  EXPECT_GT(s.ess, 0.6 * expected);
+  EXPECT_LT(s.ess, 1.4 * expected);
+}
+
+TEST(OnlineSummaryTest, DisagreeingChainsHaveLargeRhat) {
+  auto summary = ar1_summary(4, 1000, 0.0, 2.0);
+  EXPECT_GT(summary.summarize(0).rhat, 1.5);
+}
+
+TEST(OnlineSummaryTest, ConstantColumnHasNoRhat) {
+  stan3::online_summary summary(2);
+  for (size_t c = 0; c < 2; ++c) {
+    summary.set_names(c, {"k"});
+    for (int t = 0; t < 10; ++t) {
+      summary.add(c, {3.0});
+    }
+  }
+  stan3::column_summary s = summary.summarize(0);
+  EXPECT_EQ(s.mean, 3.0);
+  EXPECT_EQ(s.sd, 0.0);
+  EXPECT_TRUE(std::isnan(s.rhat));
+  EXPECT_TRUE(std::isnan(s.ess));
+}
+
+TEST(OnlineSummaryTest, SummaryWriterSkipsWarmupAndForwards) {
+  stan3::online_summary summary(1);
+  recording_writer out;
+  stan3::summary_writer writer(out, summary, 0, 2);
+  writer(std::vector<std::string>{"lp__", "theta"});
+  writer(std::string("Adaptation terminated"));
+  for (double v : {100.0, 100.0, 1.0, 2.0, 3.0}) {
+    writer(std::vector<double>{-v, v});
+  }
+  EXPECT_EQ(out.names.size(), 2);
+  EXPECT_EQ(out.rows.size(), 5);
+  EXPECT_EQ(summary.chain(0).num_draws(), 3);
+  EXPECT_NEAR(summary.summarize(1).mean, 2.0, 1e-12);
+}
+
+TEST(OnlineSummaryTest, WriteIncludesEveryColumn) {
+  auto summary = ar1_summary(2, 100, 0.5);
+  auto stream = std::make_unique<std::stringstream>();
+  std::stringstream* out = stream.get();
+  {
+    stan::callbacks::json_writer<std::stringstream> writer(std::move(stream));
+    summary.write(writer, "test_model");
+    std::string json = out->str();
+    EXPECT_NE(json.find("test_model"), std::string::npos);
+    EXPECT_NE(json.find("\"variables\""), std::string::npos);
+    EXPECT_NE(json.find("\"x\""), std::string::npos);
+    EXPECT_NE(json.find("\"rhat\""), std::string::npos);
+    EXPECT_NE(json.find("\"ess\""), std::string::npos);
+  }
+}
+
+TEST(OnlineSummaryTest, ConvergenceMonitorChecksTargets) {
+  auto summary = ar1_summary(4, 1000, 0.0);
+  auto never = [] {};
+  EXPECT_TRUE(stan3::convergence_monitor(summary, 400, 1.05, never).targets_met());
+  EXPECT_TRUE(stan3::convergence_monitor(summary, 0, 1.05, never).targets_met());
+  EXPECT_FALSE(stan3::convergence_monitor(summary, 1e6, 0, never).targets_met());
+  // Every chain needs check_interval draws before the first check
+  EXPECT_FALSE(stan3::convergence_monitor(summary, 400, 0, never, 2000).targets_met());
+
+  auto disagreeing = ar1_summary(4, 1000, 0.0, 2.0);
+  EXPECT_FALSE(stan3::convergence_monitor(disagreeing, 0, 1.05, never).targets_met());
+}
+
+TEST(OnlineSummaryTest, ConvergenceMonitorIgnoresSamplerColumns) {
+  stan3::online_summary summary(2);
+  boost::random::mixmax rng(99);
+  boost::random::normal_distribution<double> normal;
+  for (size_t c = 0; c < 2; ++c) {
+    summary.set_names(c, {"lp__", "accept_stat__", "x"});
+    for (int t = 0; t < 200; ++t) {
+      // accept_stat__ differs between chains, which alone would fail R-hat
+      summary.add(c, {normal(rng), c + 0.01 * normal(rng), normal(rng)});
+    }
+  }
+  EXPECT_TRUE(stan3::convergence_monitor(summary, 0, 1.1, [] {}).targets_met());
+}
+
+TEST(OnlineSummaryTest, SummaryWriterStopsOnceConverged) {
+  const size_t num_chains = 2;
+  stan3::online_summary summary(num_chains);
+  int stops = 0;
+  stan3::convergence_monitor monitor(summary, 200, 1.1, [&] { ++stops; }, 50);
+  recording_writer out;
+  std::vector<std::unique_ptr<stan3::summary_writer>> writers;
+  for (size_t c = 0; c < num_chains; ++c) {
+    writers.push_back(std::make_unique<stan3::summary_writer>(out, summary, c, 0, &monitor));
+    (*writers[c])(std::vector<std::string>{"x"});
+  }
+  boost::random::mixmax rng(5);
+  boost::random::normal_distribution<double> normal;
+  size_t t = 0;
+  for (; t < 10000 && !monitor.converged(); ++t) {
+    for (size_t c = 0; c < num_chains; ++c) {
+      (*writers[c])(std::vector<double>{normal(rng)});
+    }
+  }
+  EXPECT_TRUE(monitor.converged());
+  EXPECT_EQ(stops, 1);
+  EXPECT_EQ(t % 50, 0);
+  EXPECT_LT(t, 1000);
+}
+
+TEST(OnlineSummaryTest, EarlyChecksUseSplitRhat) {
+  // Both chains drift the same way, which only split R-hat detects
+  const size_t num_chains = 2;
+  const size_t num_draws = 400;
+  stan3::online_summary summary(num_chains);
+  boost::random::mixmax rng(11);
+  boost::random::normal_distribution<double> normal;
+  for (size_t c = 0; c < num_chains; ++c) {
+    summary.set_names(c, {"x"});
+    for (size_t t = 0; t < num_draws; ++t) {
+      summary.add(c, {normal(rng) + 0.02 * t});
+    }
+  }
+  // The halves split each chain at its current draws, however many
+  // draws the run had planned
+  EXPECT_EQ(summary.chain(0).half(0, 0).n, num_draws / 2);
+  EXPECT_EQ(summary.chain(0).half(1, 0).n, num_draws / 2);
+  EXPECT_GT(summary.summarize(0).rhat, 1.5);
+  EXPECT_FALSE(stan3::convergence_monitor(summary, 0, 1.05, [] {}).targets_met());
+}
+
+TEST(OnlineSummaryTest, SingleChainHasSplitRhat) {
+  auto summary = ar1_summary(1, 300, 0.0);
+  EXPECT_NEAR(summary.summarize(0).rhat, 1.0, 0.05);
+  EXPECT_TRUE(stan3::convergence_monitor(summary, 0, 1.05, [] {}).targets_met());
+}
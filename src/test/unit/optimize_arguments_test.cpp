@@ -0,0 +1,68 @@
+#include <stan3/arguments.hpp>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+TEST(OptimizeArgsTest, DefaultValues) {
+  stan3::optimize_args args;
+  EXPECT_EQ(args.algorithm, stan3::optimizer_t::LBFGS);
+  EXPECT_FALSE(args.jacobian);
+  EXPECT_EQ(args.num_iterations, 2000);
+  EXPECT_FALSE(args.save_iterations);
+  EXPECT_EQ(args.num_runs, 1);
+  EXPECT_EQ(args.history_size, 5);
+  EXPECT_EQ(args.init_alpha, 0.001);
+  EXPECT_EQ(args.base.num_threads, 1);
+}
+
+TEST(OptimizeArgsTest, ParseOptimizeArgs_ValidArgs) {
+  const char* argv[] = {"stan3", "--algorithm", "bfgs", "--jacobian", "--runs", "100",
+                        "--num-threads", "8", "--iterations", "500", "--tol-grad", "1e-6"};
+  int argc = 12;
+
+  stan3::optimize_args args;
+  std::string error_msg;
+  ASSERT_TRUE(stan3::parse_optimize_args(argc, const_cast<char**>(argv), args, error_msg))
+      << error_msg;
+  EXPECT_EQ(args.algorithm, stan3::optimizer_t::BFGS);
+  EXPECT_TRUE(args.jacobian);
+  EXPECT_EQ(args.num_runs, 100);
+  EXPECT_EQ(args.base.num_threads, 8);
+  EXPECT_EQ(args.num_iterations, 500);
+  EXPECT_EQ(args.tol_grad, 1e-6);
+}
+
+TEST(OptimizeArgsTest, ParseOptimizeArgs_AlgorithmIgnoresCase) {
+  const char* argv[] = {"stan3", "--algorithm", "Newton"};
+  int argc = 3;
+
+  stan3::optimize_args args;
+  std::string error_msg;
+  ASSERT_TRUE(stan3::parse_optimize_args(argc, const_cast<char**>(argv), args, error_msg))
+      << error_msg;
+  EXPECT_EQ(args.algorithm, stan3::optimizer_t::NEWTON);
+}
+
+TEST(OptimizeArgsTest, ParseOptimizeArgs_InvalidAlgorithm) {
+  const char* argv[] = {"stan3", "--algorithm", "sgd"};
+  int argc = 3;
+
+  stan3::optimize_args args;
+  std::string error_msg;
+  EXPECT_FALSE(stan3::parse_optimize_args(argc, const_cast<char**>(argv), args, error_msg));
+}
+
+TEST(OptimizeArgsTest, ValidateOptimizeArguments_InitFiles) {
+  stan3::optimize_args args;
+  std::string error_msg;
+  args.num_runs = 2;
+  args.base.init.init_files = {"a.json", "b.json", "c.json"};
+  EXPECT_FALSE(stan3::validate_optimize_arguments(args, error_msg));
+  EXPECT_NE(error_msg.find("--inits"), std::string::npos);
+
+  args.base.init.init_files = {"a.json"};
+  EXPECT_TRUE(stan3::validate_optimize_arguments(args, error_msg));
+  args.base.init.init_files = {"a.json", "b.json"};
+  EXPECT_TRUE(stan3::validate_optimize_arguments(args, error_msg));
+}
@@ -195,6 +195,7 @@ TEST_F(OutputWritersTest, TraitsDetection) {
   // Test type traits for writer detection
   EXPECT_TRUE(stan3::traits::is_stream_writer<stan3::csv_writer>::value);
   EXPECT_FALSE(stan3::traits::is_json_writer<stan3::csv_writer>::value);
+  EXPECT_TRUE(stan3::traits::is_stream_writer<stan3::fast_csv_writer>::value);
   
   EXPECT_FALSE(stan3::traits::is_stream_writer<stan3::json_writer>::value);
   EXPECT_TRUE(stan3::traits::is_json_writer<stan3::json_writer>::value);
@@ -203,3 +204,45 @@ TEST_F(OutputWritersTest, TraitsDetection) {
   EXPECT_FALSE(stan3::traits::is_stream_writer<int>::value);
   EXPECT_FALSE(stan3::traits::is_json_writer<std::string>::value);
 }
+
+#ifdef STAN3_ZSTD
+TEST_F(OutputWritersTest, CreateCompressedCSVWriter) {
+  for (unsigned int threads : {0u, 2u}) {
+    auto writer = stan3::create_writer<stan3::csv_writer>(
+      test_dir.string(), "test_model", "20250522_143000", 1,
+      "sample", ".csv", "# ", stan3::output_compression{3, threads});
+    std::stringstream expected;
+    writer->operator()(std::vector<std::string>{"param1", "param2"});
+    expected << "param1,param2\n";
+    for (int i = 0; i < 20000; ++i) {
+      writer->operator()(std::vector<double>{1.5, static_cast<double>(i)});
+      expected << "1.5," << i << "\n";
+    }
+    writer.reset();
+
+    std::string filepath = stan3::create_file_path(
+      test_dir.string(),
+      stan3::generate_filename("test_model", "20250522_143000", 1, "sample", ".csv.zst"));
+    std::ifstream file(filepath, std::ios::binary);
+    std::string compressed((std::istreambuf_iterator<char>(file)),
+                           std::istreambuf_iterator<char>());
+    EXPECT_LT(compressed.size(), expected.str().size() / 4);
+
+    std::string decompressed(expected.str().size(), '\0');
+    size_t size = ZSTD_decompress(decompressed.data(), decompressed.size(),
+                                  compressed.data(), compressed.size());
+    ASSERT_FALSE(ZSTD_isError(size));
+    decompressed.resize(size);
+    EXPECT_EQ(decompressed, expected.str());
+  }
+}
+#else
+TEST_F(OutputWritersTest, CompressionNeedsZstdBuild) {
+  EXPECT_FALSE(stan3::compression_enabled());
+  EXPECT_THROW(
+    stan3::create_writer<stan3::csv_writer>(
+      test_dir.string(), "test_model", "20250522_143000", 1,
+      "sample", ".csv", "# ", stan3::output_compression{3, 1}),
+    std::runtime_error);
+}
+#endif
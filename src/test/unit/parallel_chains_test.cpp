@@ -0,0 +1,148 @@
+#include <stan3/parallel_chains.hpp>
+
+#include <stan/callbacks/interrupt.hpp>
+
+#include <tbb/task_arena.h>
+
+#include <atomic>
+#include <exception>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+TEST(ParallelChainsTest, RunsEveryChainOnce) {
+  std::vector<std::atomic<int>> visits(8);
+  auto errors = stan3::run_chains_parallel(8, 4, [&](size_t i) {
+    visits[i]++;
+  });
+
+  ASSERT_EQ(errors.size(), 8);
+  for (size_t i = 0; i < 8; ++i) {
+    EXPECT_EQ(visits[i].load(), 1);
+    EXPECT_FALSE(errors[i]);
+  }
+}
+
+TEST(ParallelChainsTest, CapturesExceptionsPerChain) {
+  auto errors = stan3::run_chains_parallel(4, 2, [](size_t i) {
+    if (i == 2) {
+      throw std::domain_error("chain 3 failed");
+    }
+  });
+
+  ASSERT_EQ(errors.size(), 4);
+  EXPECT_FALSE(errors[0]);
+  EXPECT_FALSE(errors[1]);
+  EXPECT_FALSE(errors[3]);
+  ASSERT_TRUE(errors[2]);
+  EXPECT_THROW(std::rethrow_exception(errors[2]), std::domain_error);
+}
+
+TEST(ParallelChainsTest, RethrowsTheFirstFailedChainsError) {
+  std::vector<std::exception_ptr> errors(4);
+  EXPECT_NO_THROW(stan3::rethrow_first_chain_error(errors));
+
+  // Chains stopped through the shared interrupt are not failures
+  errors[0] = std::make_exception_ptr(stan3::chain_interrupted());
+  EXPECT_NO_THROW(stan3::rethrow_first_chain_error(errors));
+
+  errors[1] = std::make_exception_ptr(std::domain_error("chain 2 failed"));
+  errors[3] = std::make_exception_ptr(std::invalid_argument("chain 4 failed"));
+  try {
+    stan3::rethrow_first_chain_error(errors);
+    FAIL() << "Expected std::domain_error";
+  } catch (const std::domain_error& e) {
+    EXPECT_STREQ(e.what(), "chain 2 failed");
+  }
+}
+
+TEST(ParallelChainsTest, MoreThreadsThanChains) {
+  std::atomic<int> count{0};
+  auto errors = stan3::run_chains_parallel(2, 16, [&](size_t) { count++; });
+  EXPECT_EQ(count.load(), 2);
+  EXPECT_EQ(errors.size(), 2);
+}
+
+TEST(ParallelChainsTest, NoChains) {
+  auto errors = stan3::run_chains_parallel(0, 4, [](size_t) {});
+  EXPECT_TRUE(errors.empty());
+}
+
+TEST(ParallelChainsTest, SharedInterruptStops) {
+  stan::callbacks::interrupt base;
+  stan3::shared_interrupt interrupt(base);
+
+  EXPECT_FALSE(interrupt.stop_requested());
+  EXPECT_NO_THROW(interrupt());
+
+  interrupt.request_stop();
+  EXPECT_TRUE(interrupt.stop_requested());
+  EXPECT_THROW(interrupt(), stan3::chain_interrupted);
+}
+
+TEST(ParallelChainsTest, SharedInterruptForwardsToBase) {
+  struct counting_interrupt : public stan::callbacks::interrupt {
+    std::atomic<int> calls{0};
+    void operator()() override { calls++; }
+  };
+  counting_interrupt base;
+  stan3::shared_interrupt interrupt(base);
+
+  stan3::run_chains_parallel(4, 4, [&](size_t) {
+    for (int n = 0; n < 100; ++n) {
+      interrupt();
+    }
+  });
+  EXPECT_EQ(base.calls.load(), 400);
+}
+
+TEST(ParallelChainsTest, AllocateThreads) {
+  auto fixed = stan3::allocate_threads(4, 16, 4);
+  auto even = stan3::allocate_threads(2, 16, 0);
+  auto capped = stan3::allocate_threads(8, 6, 4);
+  if (!stan3::threading_enabled()) {
+    EXPECT_EQ(fixed.parallel_chains, 1);
+    EXPECT_EQ(fixed.threads_per_chain, 1);
+    return;
+  }
+  EXPECT_EQ(fixed.parallel_chains, 4);
+  EXPECT_EQ(fixed.threads_per_chain, 4);
+  EXPECT_EQ(even.parallel_chains, 2);
+  EXPECT_EQ(even.threads_per_chain, 8);
+  EXPECT_EQ(capped.parallel_chains, 1);
+  EXPECT_EQ(capped.threads_per_chain, 4);
+  // One thread per chain keeps --num-threads concurrent chains
+  auto chains = stan3::allocate_threads(4, 3, 1);
+  EXPECT_EQ(chains.parallel_chains, 3);
+  EXPECT_EQ(chains.threads_per_chain, 1);
+}
+
+TEST(ParallelChainsTest, ChainArenaLimitsConcurrency) {
+  int concurrency = 0;
+  stan3::run_in_chain_arena(3, [&] {
+    concurrency = tbb::this_task_arena::max_concurrency();
+  });
+  EXPECT_EQ(concurrency, 3);
+  EXPECT_THROW(stan3::run_in_chain_arena(2, [] { throw std::domain_error("failed"); }),
+               std::domain_error);
+}
+
+TEST(ParallelChainsTest, SharedPoolScopeRunsChainsInTheCallingArena) {
+  tbb::task_arena outer(3);
+  int own_arena = 0;
+  int shared_arena = 0;
+  outer.execute([&] {
+    stan3::run_chains_parallel(1, 1, [&](size_t) {
+      own_arena = tbb::this_task_arena::max_concurrency();
+    });
+    stan3::shared_pool_scope scope;
+    EXPECT_TRUE(stan3::shared_pool_scope::active());
+    stan3::run_chains_parallel(1, 1, [&](size_t) {
+      shared_arena = tbb::this_task_arena::max_concurrency();
+    });
+  });
+  EXPECT_EQ(own_arena, 1);
+  EXPECT_EQ(shared_arena, 3);
+  EXPECT_FALSE(stan3::shared_pool_scope::active());
+}
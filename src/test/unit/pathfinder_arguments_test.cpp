@@ -0,0 +1,67 @@
+#include <stan3/arguments.hpp>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+TEST(PathfinderArgsTest, DefaultValues) {
+  stan3::pathfinder_args args;
+  EXPECT_EQ(args.num_paths, 4);
+  EXPECT_EQ(args.num_draws, 1000);
+  EXPECT_EQ(args.num_multi_draws, 1000);
+  EXPECT_EQ(args.num_elbo_draws, 25);
+  EXPECT_TRUE(args.psis_resample);
+  EXPECT_TRUE(args.calculate_lp);
+  EXPECT_EQ(args.history_size, 5);
+  EXPECT_EQ(args.init_alpha, 0.001);
+  EXPECT_EQ(args.num_iterations, 1000);
+  EXPECT_EQ(args.base.num_threads, 1);
+}
+
+TEST(PathfinderArgsTest, ParsePathfinderArgs_ValidArgs) {
+  const char* argv[] = {"stan3", "--paths", "8", "--draws", "200", "--num-threads", "4",
+                        "--psis-resample", "false", "--history-size", "10"};
+  int argc = 11;
+
+  stan3::pathfinder_args args;
+  std::string error_msg;
+  ASSERT_TRUE(stan3::parse_pathfinder_args(argc, const_cast<char**>(argv), args, error_msg))
+      << error_msg;
+  EXPECT_EQ(args.num_paths, 8);
+  EXPECT_EQ(args.num_draws, 200);
+  EXPECT_EQ(args.base.num_threads, 4);
+  EXPECT_FALSE(args.psis_resample);
+  EXPECT_EQ(args.history_size, 10);
+}
+
+TEST(PathfinderArgsTest, ParsePathfinderArgs_PathsMustBePositive) {
+  const char* argv[] = {"stan3", "--paths", "0"};
+  int argc = 3;
+
+  stan3::pathfinder_args args;
+  std::string error_msg;
+  EXPECT_FALSE(stan3::parse_pathfinder_args(argc, const_cast<char**>(argv), args, error_msg));
+}
+
+TEST(PathfinderArgsTest, ValidatePathfinderArguments_InitFiles) {
+  stan3::pathfinder_args args;
+  std::string error_msg;
+  args.num_paths = 2;
+  args.base.init.init_files = {"a.json", "b.json", "c.json"};
+  EXPECT_FALSE(stan3::validate_pathfinder_arguments(args, error_msg));
+  EXPECT_NE(error_msg.find("--inits"), std::string::npos);
+
+  args.base.init.init_files = {"a.json", "b.json"};
+  EXPECT_TRUE(stan3::validate_pathfinder_arguments(args, error_msg));
+}
+
+TEST(PathfinderArgsTest, HmcPathfinderInitFlag) {
+  const char* argv[] = {"stan3", "--pathfinder-init"};
+  int argc = 2;
+
+  stan3::hmc_nuts_args args;
+  std::string error_msg;
+  EXPECT_FALSE(args.pathfinder_init);
+  EXPECT_TRUE(stan3::parse_hmc_args(argc, const_cast<char**>(argv), args, error_msg));
+  EXPECT_TRUE(args.pathfinder_init);
+}
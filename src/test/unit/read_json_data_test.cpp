@@ -1,4 +1,8 @@
 #include <stan3/read_json_data.hpp>
+#include <stan3/shared_output.hpp>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
 #include <string>
 #include <vector>
 #include <gtest/gtest.h>
@@ -56,13 +60,81 @@ TEST(ReadJsonDataTest, HandlesEmptyFile) {
     EXPECT_THROW(stan3::read_json_data("src/test/unit/json/empty_data.json"), stan::json::json_error);
 }
 
+TEST(ReadJsonDataTest, MappedFileReadsWholeFile) {
+    stan3::mapped_file mapping("src/test/unit/json/valid_data.json");
+    ASSERT_TRUE(mapping.is_open());
 
+    std::ifstream in("src/test/unit/json/valid_data.json", std::ios::binary);
+    std::string expected((std::istreambuf_iterator<char>(in)),
+                         std::istreambuf_iterator<char>());
+    EXPECT_EQ(std::string(mapping.data(), mapping.size()), expected);
+}
 
+TEST(ReadJsonDataTest, MappedFileHandlesEmptyAndMissingFiles) {
+    std::string empty_file = testing::TempDir() + "stan3_empty_mapped_file.json";
+    std::ofstream(empty_file).close();
+    stan3::mapped_file empty(empty_file);
+    EXPECT_TRUE(empty.is_open());
+    EXPECT_EQ(empty.size(), 0);
+    std::remove(empty_file.c_str());
 
+    stan3::mapped_file missing("json/nonexistent_file.json");
+    EXPECT_FALSE(missing.is_open());
+}
 
+TEST(ReadJsonDataTest, MemoryStreambufSupportsSeeking) {
+    const std::string text = "{\"a\": 1}";
+    stan3::memory_streambuf buf(text.data(), text.size());
+    std::istream in(&buf);
+
+    EXPECT_EQ(in.get(), '{');
+    EXPECT_EQ(in.tellg(), 1);
+    in.seekg(0, std::ios::end);
+    EXPECT_EQ(in.tellg(), static_cast<std::streamoff>(text.size()));
+    in.seekg(2);
+    EXPECT_EQ(in.peek(), 'a');
+}
 
+TEST(ReadJsonDataTest, SplitJsonArrayKeepsNestedValuesAndStrings) {
+    auto elements = stan3::split_json_array(
+        " [ {\"a\": [1, 2], \"s\": \"x,]\\\"}\"},\n null , [3] ]\n");
+    ASSERT_EQ(elements.size(), 3);
+    EXPECT_EQ(elements[0], "{\"a\": [1, 2], \"s\": \"x,]\\\"}\"}");
+    EXPECT_EQ(elements[1], "null");
+    EXPECT_EQ(elements[2], "[3]");
+    EXPECT_TRUE(stan3::split_json_array("[]").empty());
+    EXPECT_THROW(stan3::split_json_array("{}"), std::runtime_error);
+    EXPECT_THROW(stan3::split_json_array("[{}, "), std::runtime_error);
+    EXPECT_THROW(stan3::split_json_array("[{}, ]"), std::runtime_error);
+}
 
+TEST(ReadJsonDataTest, ObjectFileIsOneRecordForEveryChain) {
+    auto records = stan3::read_json_records("src/test/unit/json/valid_data.json");
+    EXPECT_FALSE(records.per_chain);
+    ASSERT_EQ(records.records.size(), 1);
+    EXPECT_TRUE(records.records[0]->contains_r("x"));
+}
 
-
-
-
+TEST(ReadJsonDataTest, ReadsSingleFileMetricArrayPerChain) {
+    std::string path = testing::TempDir() + "read_json_data_test_metric.json";
+    {
+        auto file = std::make_shared<stan3::shared_json_file>(path, 3);
+        for (size_t chain : {0, 1}) {
+            auto writer = stan3::create_shared_json_writer(file, chain);
+            writer->begin_record();
+            writer->write("stepsize", chain == 0 ? 0.5 : 0.25);
+            writer->write("inv_metric", std::vector<double>{chain + 1.0});
+            writer->end_record();
+        }
+    }
+    auto records = stan3::read_json_records(path);
+    std::remove(path.c_str());
+
+    EXPECT_TRUE(records.per_chain);
+    ASSERT_EQ(records.records.size(), 3);
+    EXPECT_EQ(records.records[0]->vals_r("stepsize")[0], 0.5);
+    EXPECT_EQ(records.records[1]->vals_r("stepsize")[0], 0.25);
+    EXPECT_EQ(records.records[1]->vals_r("inv_metric")[0], 2.0);
+    // The third chain wrote no record
+    EXPECT_EQ(records.records[2], nullptr);
+}
@@ -0,0 +1,171 @@
+#include <stan3/run_advi.hpp>
+#include <stan3/arguments.hpp>
+#include <stan3/draws_reader.hpp>
+#include <stan3/read_json_data.hpp>
+
+#include <test/test-models/bernoulli.hpp>
+
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/services/util/create_rng.hpp>
+
+#include <tbb/task_arena.h>
+
+#include <cmath>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+/* Standard normal log density that is NaN for positive x, so that its
+ * gradient cannot be evaluated there */
+struct failing_model {
+  template <bool propto, bool jacobian, typename T>
+  T log_prob(Eigen::Matrix<T, Eigen::Dynamic, 1>& x, std::ostream*) const {
+    if (x(0) > 0) {
+      return T(std::numeric_limits<double>::quiet_NaN());
+    }
+    return -0.5 * x(0) * x(0);
+  }
+
+  double log_prob_propto_jacobian(Eigen::VectorXd& x, std::ostream* msgs) const {
+    return log_prob<true, true, double>(x, msgs);
+  }
+};
+
+}  // namespace
+
+class RunAdviTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    temp_dir_ = std::filesystem::temp_directory_path() / "run_advi_test";
+    std::filesystem::create_directories(temp_dir_);
+
+    auto data_context = stan3::read_json_data("src/test/test-models/bernoulli.data.json");
+    model_ = std::make_unique<bernoulli_model_namespace::bernoulli_model>(*data_context, 12345);
+
+    args_.base.model.random_seed = 12345;
+    args_.base.output_dir = temp_dir_.string();
+    args_.output_draws = 100;
+
+    logger_ = std::make_unique<stan::callbacks::stream_logger>(
+      log_stream_, log_stream_, log_stream_, log_stream_, log_stream_);
+  }
+
+  void TearDown() override {
+    std::filesystem::remove_all(temp_dir_);
+  }
+
+  /* Gradient of the bernoulli log density (2 successes in 10 trials,
+   * uniform prior) with respect to logit(theta) */
+  static double bernoulli_grad(double u) {
+    return 3.0 - 12.0 / (1.0 + std::exp(-u));
+  }
+
+  std::filesystem::path temp_dir_;
+  std::unique_ptr<bernoulli_model_namespace::bernoulli_model> model_;
+  stan3::advi_args args_;
+  std::unique_ptr<stan::callbacks::stream_logger> logger_;
+  std::stringstream log_stream_;
+};
+
+TEST_F(RunAdviTest, ParallelMeanfieldGrad_MatchesMonteCarloEstimate) {
+  const int n = 64;
+  Eigen::VectorXd cont_params = Eigen::VectorXd::Zero(1);
+  stan3::parallel_normal_meanfield q(cont_params);
+  stan3::parallel_normal_meanfield elbo_grad(1);
+
+  auto rng = stan::services::util::create_rng(12345, 1);
+  auto expected_rng = rng;
+  tbb::task_arena arena(4);
+  arena.execute([&] {
+    q.calc_grad(elbo_grad, *model_, cont_params, n, rng, *logger_);
+  });
+
+  double mu_grad = 0;
+  double omega_grad = 0;
+  for (int i = 0; i < n; ++i) {
+    double eta = stan::math::normal_rng(0, 1, expected_rng);
+    mu_grad += bernoulli_grad(eta);
+    omega_grad += bernoulli_grad(eta) * eta;
+  }
+  EXPECT_NEAR(elbo_grad.mu()(0), mu_grad / n, 1e-8);
+  EXPECT_NEAR(elbo_grad.omega()(0), omega_grad / n + 1.0, 1e-8);
+}
+
+TEST_F(RunAdviTest, ParallelGrad_FailsAtTheFirstFailedDraw) {
+  const int n = 64;
+  stan3::parallel_normal_meanfield q(Eigen::VectorXd::Zero(1));
+  failing_model model;
+  auto rng = stan::services::util::create_rng(12345, 1);
+  auto expected_rng = rng;
+
+  // q is the standard normal, so zeta = eta and draws with a positive
+  // eta fail
+  int first_failure = 0;
+  while (stan::math::normal_rng(0, 1, expected_rng) <= 0) {
+    ++first_failure;
+  }
+  ASSERT_LT(first_failure, n);
+
+  int num_accumulated = 0;
+  EXPECT_THROW(stan3::parallel_monte_carlo_grad(
+                 q, model, n, rng, *logger_, "test",
+                 [&](const Eigen::VectorXd&, const Eigen::VectorXd& eta) {
+                   EXPECT_LE(eta(0), 0);
+                   ++num_accumulated;
+                 }),
+               std::domain_error);
+  // As in Stan's estimator, the failed draw is not replaced
+  EXPECT_EQ(num_accumulated, first_failure);
+}
+
+TEST_F(RunAdviTest, ParallelFullrankGrad_IndependentOfThreads) {
+  Eigen::VectorXd cont_params = Eigen::VectorXd::Zero(1);
+  stan3::parallel_normal_fullrank q(cont_params);
+  stan3::parallel_normal_fullrank serial_grad(1);
+  stan3::parallel_normal_fullrank parallel_grad(1);
+
+  auto serial_rng = stan::services::util::create_rng(12345, 1);
+  auto parallel_rng = serial_rng;
+  tbb::task_arena serial(1);
+  tbb::task_arena parallel(4);
+  serial.execute([&] {
+    q.calc_grad(serial_grad, *model_, cont_params, 32, serial_rng, *logger_);
+  });
+  parallel.execute([&] {
+    q.calc_grad(parallel_grad, *model_, cont_params, 32, parallel_rng, *logger_);
+  });
+  EXPECT_EQ(serial_grad.mu(), parallel_grad.mu());
+  EXPECT_EQ(serial_grad.L_chol(), parallel_grad.L_chol());
+}
+
+TEST_F(RunAdviTest, RunAdvi_WritesMeanAndDraws) {
+  for (auto algorithm : {stan3::variational_t::MEANFIELD, stan3::variational_t::FULLRANK}) {
+    std::filesystem::remove_all(temp_dir_);
+    args_.algorithm = algorithm;
+    args_.grad_samples = 8;
+    args_.base.num_threads = 4;
+    ASSERT_EQ(stan3::run_advi(args_, *model_), 0);
+
+    size_t num_files = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(temp_dir_)) {
+      ++num_files;
+      stan3::csv_draws_reader reader(entry.path().string());
+      EXPECT_EQ(reader.column_names(),
+                (std::vector<std::string>{"lp__", "log_p__", "log_g__", "theta"}));
+      std::vector<double> draw;
+      ASSERT_TRUE(reader.next(draw));
+      EXPECT_NEAR(draw[3], 0.25, 0.1);  // mean of the approximation
+      while (reader.next(draw)) {
+      }
+      EXPECT_EQ(reader.num_draws(), 101);
+    }
+    EXPECT_EQ(num_files, 1);
+  }
+}
@@ -0,0 +1,138 @@
+#include <stan3/run_batch.hpp>
+#include <stan3/arguments.hpp>
+
+#include <test/test-models/bernoulli.hpp>
+
+#include <tbb/task_arena.h>
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+class RunBatchTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    temp_dir_ = std::filesystem::temp_directory_path() / "run_batch_test";
+    std::filesystem::create_directories(temp_dir_);
+    args_.manifest_file = (temp_dir_ / "manifest.txt").string();
+    args_.output_dir = temp_dir_.string();
+    args_.num_threads = 4;
+  }
+
+  void TearDown() override {
+    std::filesystem::remove_all(temp_dir_);
+  }
+
+  void write_manifest(const std::string& contents) {
+    std::ofstream out(args_.manifest_file);
+    out << contents;
+  }
+
+  std::filesystem::path temp_dir_;
+  stan3::batch_args args_;
+};
+
+TEST_F(RunBatchTest, ReadManifest_SkipsBlankAndCommentLines) {
+  std::string data = "src/test/test-models/bernoulli.data.json";
+  write_manifest("# fits of the bernoulli model\n"
+                 "--data " + data + " --seed 7 --chains 2\n"
+                 "\n"
+                 "   \n"
+                 "--data \"" + data + "\" --seed 8 --chains 8 -o "
+                 + (temp_dir_ / "custom").string() + "\n");
+
+  auto jobs = stan3::read_batch_manifest(args_);
+  ASSERT_EQ(jobs.size(), 2);
+  EXPECT_EQ(jobs[0].line, 2);
+  EXPECT_EQ(jobs[0].args.base.model.data_file, data);
+  EXPECT_EQ(jobs[0].args.base.model.random_seed, 7);
+  EXPECT_EQ(jobs[0].args.base.output_dir, (temp_dir_ / "job_1").string());
+  EXPECT_EQ(jobs[0].args.base.num_threads, 2);
+
+  EXPECT_EQ(jobs[1].line, 5);
+  EXPECT_EQ(jobs[1].args.base.model.data_file, data);
+  EXPECT_EQ(jobs[1].args.base.output_dir, (temp_dir_ / "custom").string());
+  // At most the threads of the batch
+  EXPECT_EQ(jobs[1].args.base.num_threads, 4);
+}
+
+TEST_F(RunBatchTest, ReadManifest_NamesLineOfInvalidJob) {
+  write_manifest("--seed 1\n--chains 0\n");
+  try {
+    stan3::read_batch_manifest(args_);
+    FAIL() << "Expected std::invalid_argument";
+  } catch (const std::invalid_argument& e) {
+    EXPECT_NE(std::string(e.what()).find("manifest.txt:2"), std::string::npos) << e.what();
+  }
+}
+
+TEST_F(RunBatchTest, ReadManifest_RejectsCrossChainWarmup) {
+  write_manifest("--chains 4 --num-threads 4 --cross-chain-warmup\n");
+  EXPECT_THROW(stan3::read_batch_manifest(args_), std::invalid_argument);
+}
+
+TEST_F(RunBatchTest, ReadManifest_RejectsAffinity) {
+  write_manifest("--chains 2 --seed 1\n--chains 2 --affinity\n");
+  try {
+    stan3::read_batch_manifest(args_);
+    FAIL() << "Expected std::invalid_argument";
+  } catch (const std::invalid_argument& e) {
+    std::string message = e.what();
+    EXPECT_NE(message.find(":2:"), std::string::npos) << message;
+    EXPECT_NE(message.find("--affinity"), std::string::npos) << message;
+  }
+}
+
+TEST_F(RunBatchTest, ReadManifest_RejectsEmptyManifest) {
+  write_manifest("# no jobs\n\n");
+  EXPECT_THROW(stan3::read_batch_manifest(args_), std::invalid_argument);
+}
+
+TEST_F(RunBatchTest, RunJobs_FailingJobDoesNotStopOthers) {
+  const size_t num_jobs = 20;
+  std::vector<std::atomic<int>> runs(num_jobs);
+  auto errors = stan3::run_batch_jobs(num_jobs, 4, [&](size_t i) {
+    ++runs[i];
+    if (i == 3) {
+      throw std::runtime_error("job 3 failed");
+    }
+  });
+  ASSERT_EQ(errors.size(), num_jobs);
+  for (size_t i = 0; i < num_jobs; ++i) {
+    EXPECT_EQ(runs[i], 1);
+    EXPECT_EQ(static_cast<bool>(errors[i]), i == 3);
+  }
+}
+
+TEST_F(RunBatchTest, RunJobs_ChainsRunInTheBatchArena) {
+  std::atomic<int> shared{0};
+  auto errors = stan3::run_batch_jobs(3, 4, [&](size_t) {
+    stan3::run_chains_parallel(2, 2, [&](size_t) {
+      if (tbb::this_task_arena::max_concurrency() == 3) {
+        ++shared;
+      }
+    });
+  });
+  for (const auto& error : errors) {
+    EXPECT_FALSE(error);
+  }
+  // Each job's chains are tasks of the batch's arena of min(4, 3) threads
+  EXPECT_EQ(shared.load(), 6);
+}
+
+TEST_F(RunBatchTest, RunBatch_WritesEachJobToItsOwnDirectory) {
+  std::string job = "--data src/test/test-models/bernoulli.data.json --warmup 20 "
+                    "--samples 20 --refresh 0 --metric-type unit_e --chains 2";
+  write_manifest(job + " --seed 1\n" + job + " --seed 2\n");
+
+  EXPECT_EQ(stan3::run_batch(args_), 0);
+  for (const char* dir : {"job_1", "job_2"}) {
+    ASSERT_TRUE(std::filesystem::is_directory(temp_dir_ / dir));
+    EXPECT_FALSE(std::filesystem::is_empty(temp_dir_ / dir));
+  }
+}
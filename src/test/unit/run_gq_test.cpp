@@ -0,0 +1,207 @@
+#include <stan3/run_gq.hpp>
+#include <stan3/arguments.hpp>
+#include <stan3/binary_writer.hpp>
+#include <stan3/draws_reader.hpp>
+
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/callbacks/writer.hpp>
+
+#include <boost/random/uniform_01.hpp>
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+/* Model with parameters mu and sigma > 0 and generated quantities
+ * total = mu + sigma and u ~ uniform(0, 1); evaluation fails for mu > 100 */
+struct gq_test_model {
+  std::string model_name() const { return "gq_test_model"; }
+
+  void constrained_param_names(std::vector<std::string>& names, bool,
+                               bool include_gqs) const {
+    names.push_back("mu");
+    names.push_back("sigma");
+    if (include_gqs) {
+      names.push_back("total");
+      names.push_back("u");
+    }
+  }
+
+  void unconstrain_array(const Eigen::VectorXd& constrained, Eigen::VectorXd& unconstrained,
+                         std::ostream*) const {
+    unconstrained.resize(2);
+    unconstrained(0) = constrained(0);
+    unconstrained(1) = std::log(constrained(1));
+  }
+
+  template <typename RNG>
+  void write_array(RNG& rng, Eigen::VectorXd& unconstrained, Eigen::VectorXd& vars,
+                   bool, bool, std::ostream* msgs) const {
+    double mu = unconstrained(0);
+    double sigma = std::exp(unconstrained(1));
+    if (mu > 100) {
+      throw std::domain_error("mu is too large");
+    }
+    if (mu < 0 && msgs) {
+      *msgs << "negative mu";
+    }
+    vars.resize(4);
+    vars << mu, sigma, mu + sigma, boost::uniform_01<double>()(rng);
+  }
+};
+
+/* Writer that records every row */
+struct recording_writer : public stan::callbacks::writer {
+  void operator()(const std::vector<std::string>& n) override { names = n; }
+  void operator()(const std::vector<double>& row) override { rows.push_back(row); }
+  std::vector<std::string> names;
+  std::vector<std::vector<double>> rows;
+};
+
+}  // namespace
+
+class RunGqTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    temp_dir_ = std::filesystem::temp_directory_path() / "run_gq_test";
+    std::filesystem::create_directories(temp_dir_);
+    draws_file_ = (temp_dir_ / "fit.csv").string();
+    args_.base.output_dir = temp_dir_.string();
+    args_.chunk_size = 3;
+    logger_ = std::make_unique<stan::callbacks::stream_logger>(
+      log_stream_, log_stream_, log_stream_, log_stream_, log_stream_);
+  }
+
+  void TearDown() override {
+    std::filesystem::remove_all(temp_dir_);
+  }
+
+  /* Fitted draws with mu = 1, ..., num_draws and sigma = 0.5 */
+  void write_fit(size_t num_draws) {
+    std::ofstream out(draws_file_);
+    out << "# fitted draws\nlp__,sigma,mu\n";
+    for (size_t n = 1; n <= num_draws; ++n) {
+      out << "-1," << 0.5 << "," << n << "\n";
+    }
+  }
+
+  recording_writer generate() {
+    recording_writer writer;
+    stan3::csv_draws_reader reader(draws_file_);
+    stan3::generate_quantities(args_, model_, reader, writer, *logger_);
+    return writer;
+  }
+
+  std::filesystem::path temp_dir_;
+  std::string draws_file_;
+  gq_test_model model_;
+  stan3::gq_args args_;
+  std::unique_ptr<stan::callbacks::stream_logger> logger_;
+  std::stringstream log_stream_;
+};
+
+TEST_F(RunGqTest, GenerateQuantities_InDrawOrder) {
+  write_fit(10);
+  auto writer = generate();
+  EXPECT_EQ(writer.names, (std::vector<std::string>{"total", "u"}));
+  ASSERT_EQ(writer.rows.size(), 10);
+  for (size_t n = 0; n < 10; ++n) {
+    EXPECT_DOUBLE_EQ(writer.rows[n][0], n + 1.5);
+    EXPECT_GE(writer.rows[n][1], 0.0);
+    EXPECT_LE(writer.rows[n][1], 1.0);
+  }
+}
+
+TEST_F(RunGqTest, GenerateQuantities_IndependentOfChunkSize) {
+  write_fit(10);
+  auto chunked = generate();
+  args_.chunk_size = 1024;
+  args_.base.num_threads = 4;
+  auto whole = generate();
+  EXPECT_EQ(chunked.rows, whole.rows);
+}
+
+TEST_F(RunGqTest, GenerateQuantities_FailedDrawIsNaN) {
+  {
+    std::ofstream out(draws_file_);
+    out << "mu,sigma\n1,1\n200,1\n-1,1\n";
+  }
+  auto writer = generate();
+  ASSERT_EQ(writer.rows.size(), 3);
+  EXPECT_DOUBLE_EQ(writer.rows[0][0], 2.0);
+  EXPECT_TRUE(std::isnan(writer.rows[1][0]));
+  EXPECT_TRUE(std::isnan(writer.rows[1][1]));
+  EXPECT_DOUBLE_EQ(writer.rows[2][0], 0.0);
+  EXPECT_NE(log_stream_.str().find("Draw 2: mu is too large"), std::string::npos);
+  EXPECT_NE(log_stream_.str().find("Draw 3: negative mu"), std::string::npos);
+}
+
+TEST_F(RunGqTest, GenerateQuantities_MissingParameter) {
+  {
+    std::ofstream out(draws_file_);
+    out << "lp__,mu\n-1,1\n";
+  }
+  EXPECT_THROW(generate(), std::invalid_argument);
+}
+
+TEST_F(RunGqTest, RunGq_ReadsBinaryWritesBinary) {
+  std::string binary_fit = (temp_dir_ / "fit.bin").string();
+  {
+    stan3::binary_writer writer(std::make_unique<std::ofstream>(binary_fit, std::ios::binary));
+    writer(std::vector<std::string>{"mu", "sigma"});
+    writer(std::vector<double>{1.0, 2.0});
+    writer(std::vector<double>{3.0, 4.0});
+  }
+  args_.fitted_params_file = binary_fit;
+  args_.output_format = stan3::output_format_t::BINARY;
+  ASSERT_EQ(stan3::run_gq(args_, model_), 0);
+
+  size_t num_files = 0;
+  for (const auto& entry : std::filesystem::directory_iterator(temp_dir_)) {
+    if (entry.path().filename().string().find("_gq.bin") == std::string::npos) {
+      continue;
+    }
+    ++num_files;
+    stan3::binary_draws_reader reader(entry.path().string());
+    EXPECT_EQ(reader.column_names(), (std::vector<std::string>{"total", "u"}));
+    std::vector<double> draw;
+    ASSERT_TRUE(reader.next(draw));
+    EXPECT_DOUBLE_EQ(draw[0], 3.0);
+    ASSERT_TRUE(reader.next(draw));
+    EXPECT_DOUBLE_EQ(draw[0], 7.0);
+    EXPECT_FALSE(reader.next(draw));
+  }
+  EXPECT_EQ(num_files, 1);
+}
+
+TEST(GqArgsTest, ParseGqArgs) {
+  std::string fit = (std::filesystem::temp_directory_path() / "gq_args_fit.csv").string();
+  std::ofstream(fit) << "mu\n1\n";
+  std::string fit_arg = fit;
+  const char* argv[] = {"stan3", "--fitted-params", fit_arg.c_str(), "--chunk-size", "64",
+                        "--num-threads", "8", "--output-format", "binary"};
+  int argc = 9;
+
+  stan3::gq_args args;
+  std::string error_msg;
+  ASSERT_TRUE(stan3::parse_gq_args(argc, const_cast<char**>(argv), args, error_msg))
+      << error_msg;
+  EXPECT_EQ(args.fitted_params_file, fit);
+  EXPECT_EQ(args.chunk_size, 64);
+  EXPECT_EQ(args.base.num_threads, 8);
+  EXPECT_EQ(args.output_format, stan3::output_format_t::BINARY);
+  std::filesystem::remove(fit);
+
+  const char* missing[] = {"stan3", "--chunk-size", "64"};
+  stan3::gq_args missing_args;
+  EXPECT_FALSE(stan3::parse_gq_args(3, const_cast<char**>(missing), missing_args, error_msg));
+}
@@ -0,0 +1,148 @@
+#include <stan3/run_optimize.hpp>
+#include <stan3/arguments.hpp>
+#include <stan3/draws_reader.hpp>
+#include <stan3/read_json_data.hpp>
+
+#include <test/test-models/bernoulli.hpp>
+
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/callbacks/stream_writer.hpp>
+
+#include <cmath>
+#include <filesystem>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+class RunOptimizeTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    temp_dir_ = std::filesystem::temp_directory_path() / "run_optimize_test";
+    std::filesystem::create_directories(temp_dir_);
+
+    auto data_context = stan3::read_json_data("src/test/test-models/bernoulli.data.json");
+    model_ = std::make_unique<bernoulli_model_namespace::bernoulli_model>(*data_context, 12345);
+
+    args_.base.model.random_seed = 12345;
+    args_.base.output_dir = temp_dir_.string();
+    args_.refresh = 0;
+
+    logger_ = std::make_unique<stan::callbacks::stream_logger>(
+      log_stream_, log_stream_, log_stream_, log_stream_, log_stream_);
+  }
+
+  void TearDown() override {
+    std::filesystem::remove_all(temp_dir_);
+  }
+
+  std::vector<stan3::optimize_result> run() {
+    return stan3::run_optimizations(args_, *model_, "test", interrupt_, *logger_);
+  }
+
+  std::filesystem::path temp_dir_;
+  std::unique_ptr<bernoulli_model_namespace::bernoulli_model> model_;
+  stan3::optimize_args args_;
+  stan::callbacks::interrupt interrupt_;
+  std::unique_ptr<stan::callbacks::stream_logger> logger_;
+  std::stringstream log_stream_;
+};
+
+TEST_F(RunOptimizeTest, Algorithms_FindMle) {
+  for (auto algorithm : {stan3::optimizer_t::LBFGS, stan3::optimizer_t::BFGS,
+                         stan3::optimizer_t::NEWTON}) {
+    args_.algorithm = algorithm;
+    auto results = run();
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results[0].return_code, 0);
+    ASSERT_EQ(results[0].values.size(), 2);  // lp__, theta
+    EXPECT_NEAR(results[0].values[1], 0.2, 1e-3);
+  }
+}
+
+TEST_F(RunOptimizeTest, Jacobian_FindsMap) {
+  args_.jacobian = true;
+  auto results = run();
+  ASSERT_EQ(results.size(), 1);
+  EXPECT_NEAR(results[0].values[1], 0.25, 1e-3);
+}
+
+TEST_F(RunOptimizeTest, BatchedRuns_ResultsInRunOrder) {
+  args_.num_runs = 16;
+  args_.base.num_threads = 4;
+  auto results = run();
+  ASSERT_EQ(results.size(), 16);
+  for (const auto& result : results) {
+    EXPECT_EQ(result.return_code, 0);
+    EXPECT_NEAR(result.values[1], 0.2, 1e-3);
+  }
+
+  auto names = stan3::optimize_result_names(*model_);
+  ASSERT_EQ(names.size(), 4);
+  EXPECT_EQ(names[2], "lp__");
+  auto row = stan3::optimize_result_row(7, results[7], names.size());
+  EXPECT_EQ(row[0], 8);
+  EXPECT_EQ(row[1], 0);
+  EXPECT_EQ(row[3], results[7].values[1]);
+}
+
+TEST_F(RunOptimizeTest, SaveIterations_WritesFilePerRun) {
+  args_.num_runs = 2;
+  args_.save_iterations = true;
+  run();
+  for (unsigned int run_id = 1; run_id <= 2; ++run_id) {
+    auto file = temp_dir_ / stan3::generate_filename(model_->model_name(), "test", run_id,
+                                                     "optimize_iterations", ".csv");
+    stan3::csv_draws_reader reader(file.string());
+    std::vector<double> draw;
+    while (reader.next(draw)) {
+    }
+    EXPECT_GT(reader.num_draws(), 1);
+  }
+}
+
+TEST_F(RunOptimizeTest, RunOptimize_WritesResults) {
+  args_.num_runs = 3;
+  EXPECT_EQ(stan3::run_optimize(args_, *model_), 0);
+
+  size_t num_files = 0;
+  for (const auto& entry : std::filesystem::directory_iterator(temp_dir_)) {
+    if (entry.path().filename().string().find("_optimize.csv") == std::string::npos) {
+      continue;
+    }
+    ++num_files;
+    stan3::csv_draws_reader reader(entry.path().string());
+    EXPECT_EQ(reader.column_names(),
+              (std::vector<std::string>{"run__", "return_code__", "lp__", "theta"}));
+    std::vector<double> draw;
+    while (reader.next(draw)) {
+      EXPECT_EQ(draw[0], reader.num_draws());
+      EXPECT_NEAR(draw[3], 0.2, 1e-3);
+    }
+    EXPECT_EQ(reader.num_draws(), 3);
+  }
+  EXPECT_EQ(num_files, 1);
+}
+
+TEST(OptimumWriterTest, KeepsLastValuesAndForwards) {
+  std::stringstream out;
+  stan::callbacks::stream_writer iterations(out);
+  stan3::optimum_writer writer(&iterations);
+  writer(std::vector<std::string>{"lp__", "theta"});
+  writer(std::vector<double>{-7.0, 0.5});
+  writer(std::vector<double>{-5.0, 0.2});
+  EXPECT_EQ(writer.optimum(), (std::vector<double>{-5.0, 0.2}));
+  EXPECT_NE(out.str().find("theta"), std::string::npos);
+}
+
+TEST(OptimizeResultRowTest, FailedRunIsNaN) {
+  stan3::optimize_result result;
+  auto row = stan3::optimize_result_row(0, result, 4);
+  EXPECT_EQ(row[0], 1);
+  EXPECT_EQ(row[1], result.return_code);
+  EXPECT_TRUE(std::isnan(row[2]));
+  EXPECT_TRUE(std::isnan(row[3]));
+}
@@ -0,0 +1,110 @@
+#include <stan3/run_pathfinder.hpp>
+#include <stan3/arguments.hpp>
+#include <stan3/draws_reader.hpp>
+#include <stan3/read_json_data.hpp>
+
+#include <test/test-models/bernoulli.hpp>
+
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+class RunPathfinderTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    temp_dir_ = std::filesystem::temp_directory_path() / "run_pathfinder_test";
+    std::filesystem::create_directories(temp_dir_);
+
+    auto data_context = stan3::read_json_data("src/test/test-models/bernoulli.data.json");
+    model_ = std::make_unique<bernoulli_model_namespace::bernoulli_model>(*data_context, 12345);
+
+    args_.base.model.random_seed = 12345;
+    args_.base.output_dir = temp_dir_.string();
+    args_.num_paths = 2;
+    args_.num_draws = 100;
+    args_.num_multi_draws = 100;
+    args_.refresh = 0;
+
+    logger_ = std::make_unique<stan::callbacks::stream_logger>(
+      log_stream_, log_stream_, log_stream_, log_stream_, log_stream_);
+  }
+
+  void TearDown() override {
+    std::filesystem::remove_all(temp_dir_);
+  }
+
+  std::filesystem::path temp_dir_;
+  std::unique_ptr<bernoulli_model_namespace::bernoulli_model> model_;
+  stan3::pathfinder_args args_;
+  stan::callbacks::interrupt interrupt_;
+  std::unique_ptr<stan::callbacks::stream_logger> logger_;
+  std::stringstream log_stream_;
+};
+
+TEST_F(RunPathfinderTest, RunPathfinderPaths_WritesDraws) {
+  std::string draws_file = (temp_dir_ / "pathfinder.csv").string();
+  stan3::run_pathfinder_paths(args_, *model_, draws_file, interrupt_, *logger_);
+
+  stan3::csv_draws_reader reader(draws_file);
+  const auto& names = reader.column_names();
+  EXPECT_NE(std::find(names.begin(), names.end(), "theta"), names.end());
+  std::vector<double> draw;
+  while (reader.next(draw)) {
+  }
+  EXPECT_EQ(reader.num_draws(), 100);
+}
+
+TEST_F(RunPathfinderTest, ReadPathfinderWarmStart_InitsAndMetric) {
+  std::string draws_file = (temp_dir_ / "draws.csv").string();
+  {
+    std::ofstream out(draws_file);
+    out << "lp_approx__,lp__,theta\n";
+    out << "-1,-7,0.2\n-1,-7,0.3\n-1,-7,0.4\n-1,-7,0.1\n";
+  }
+  auto warm_start = stan3::read_pathfinder_warm_start(*model_, draws_file, 2);
+
+  ASSERT_EQ(warm_start.inits.size(), 2);
+  EXPECT_DOUBLE_EQ(warm_start.inits[0]->vals_r("theta")[0], 0.2);
+  EXPECT_DOUBLE_EQ(warm_start.inits[1]->vals_r("theta")[0], 0.4);
+
+  auto inv_metric = warm_start.inv_metric->vals_r("inv_metric");
+  ASSERT_EQ(inv_metric.size(), 1);
+  EXPECT_GT(inv_metric[0], 0);
+}
+
+TEST_F(RunPathfinderTest, ReadPathfinderWarmStart_MissingColumn) {
+  std::string draws_file = (temp_dir_ / "draws.csv").string();
+  {
+    std::ofstream out(draws_file);
+    out << "lp_approx__,lp__\n-1,-7\n";
+  }
+  EXPECT_THROW(stan3::read_pathfinder_warm_start(*model_, draws_file, 1), std::runtime_error);
+}
+
+TEST_F(RunPathfinderTest, RunPathfinder_WritesWarmStartFiles) {
+  EXPECT_EQ(stan3::run_pathfinder(args_, *model_), 0);
+
+  size_t init_files = 0;
+  size_t metric_files = 0;
+  for (const auto& entry : std::filesystem::directory_iterator(temp_dir_)) {
+    std::string name = entry.path().filename().string();
+    if (name.find("_pathfinder_init.json") != std::string::npos) {
+      ++init_files;
+      EXPECT_TRUE(stan3::read_json_data(entry.path().string())->contains_r("theta"));
+    } else if (name.find("_pathfinder_metric.json") != std::string::npos) {
+      ++metric_files;
+      EXPECT_TRUE(stan3::read_json_data(entry.path().string())->contains_r("inv_metric"));
+    }
+  }
+  EXPECT_EQ(init_files, 2);
+  EXPECT_EQ(metric_files, 1);
+}
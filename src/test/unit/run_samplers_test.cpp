@@ -9,6 +9,7 @@
 #include <stan/callbacks/interrupt.hpp>
 
 #include <filesystem>
+#include <fstream>
 #include <memory>
 #include <vector>
 #include <sstream>
@@ -123,6 +124,26 @@ TEST_F(RunSamplersTest, RunSamplers_MultipleChains) {
   });
 }
 
+TEST_F(RunSamplersTest, RunSamplers_MultipleChainsParallel) {
+  args_.base.num_chains = 4;
+  args_.base.num_threads = 4;
+  args_.metric_type = stan3::metric_t::DIAG_E;
+
+  init_contexts_.clear();
+  metric_contexts_.clear();
+  for (size_t i = 0; i < args_.base.num_chains; ++i) {
+    init_contexts_.push_back(stan3::read_json_data(""));
+    metric_contexts_.push_back(stan3::read_json_data(""));
+  }
+  writers_ = stan3::create_hmc_nuts_multi_chain_writers(args_, "test_model");
+
+  EXPECT_NO_THROW({
+    stan3::run_samplers(*model_, args_, init_contexts_, metric_contexts_,
+                       writers_, *interrupt_, *logger_);
+  });
+  EXPECT_EQ(writers_.size(), 4);
+}
+
 TEST_F(RunSamplersTest, SamplerRunner_Construction) {
   stan3::sampler_runner runner(*model_, args_, writers_, *interrupt_, *logger_);
   
@@ -170,3 +191,219 @@ TEST_F(RunSamplersTest, RunSamplers_WithNullableWriters) {
   EXPECT_EQ(writers_[0].metric_writer, nullptr);
   EXPECT_NE(writers_[0].sample_writer, nullptr);  // Sample writer should never be null
 }
+
+TEST_F(RunSamplersTest, RunSamplers_WritesProfile) {
+  args_.base.num_chains = 2;
+  args_.metric_type = stan3::metric_t::DIAG_E;
+  args_.profile_file = (temp_dir_ / "profile.json").string();
+
+  init_contexts_.clear();
+  metric_contexts_.clear();
+  for (size_t i = 0; i < args_.base.num_chains; ++i) {
+    init_contexts_.push_back(stan3::read_json_data(""));
+    metric_contexts_.push_back(stan3::read_json_data(""));
+  }
+  writers_ = stan3::create_hmc_nuts_multi_chain_writers(args_, "test_model");
+
+  stan3::run_samplers(*model_, args_, init_contexts_, metric_contexts_,
+                     writers_, *interrupt_, *logger_);
+
+  ASSERT_TRUE(std::filesystem::exists(args_.profile_file));
+  std::ifstream in(args_.profile_file);
+  std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  EXPECT_NE(contents.find("\"chain_1\""), std::string::npos);
+  EXPECT_NE(contents.find("\"chain_2\""), std::string::npos);
+  EXPECT_NE(contents.find("\"all_chains\""), std::string::npos);
+  EXPECT_NE(contents.find("\"gradient_evaluations\""), std::string::npos);
+  EXPECT_NE(contents.find("\"tree_depth_counts\""), std::string::npos);
+}
+
+TEST_F(RunSamplersTest, RunFixedParamSamplers_MultipleChainsParallel) {
+  args_.base.num_chains = 3;
+  args_.base.num_threads = 2;
+  args_.num_samples = 25;
+
+  init_contexts_.clear();
+  for (size_t i = 0; i < args_.base.num_chains; ++i) {
+    init_contexts_.push_back(stan3::read_json_data(""));
+  }
+  writers_ = stan3::create_hmc_nuts_multi_chain_writers(args_, "fixed_param_model");
+
+  stan3::run_fixed_param_samplers(*model_, args_, init_contexts_, writers_,
+                                  *interrupt_, *logger_);
+  writers_.clear();  // flush and close the sample files
+
+  size_t num_files = 0;
+  for (const auto& entry : std::filesystem::directory_iterator(temp_dir_)) {
+    std::string name = entry.path().filename().string();
+    if (name.find("fixed_param_model") == std::string::npos
+        || name.find("_sample.csv") == std::string::npos) {
+      continue;
+    }
+    ++num_files;
+    std::ifstream in(entry.path());
+    std::string line;
+    size_t num_rows = 0;
+    while (std::getline(in, line)) {
+      if (!line.empty() && line[0] != '#') {
+        ++num_rows;
+      }
+    }
+    EXPECT_EQ(num_rows, args_.num_samples + 1) << name;  // header and draws
+  }
+  EXPECT_EQ(num_files, args_.base.num_chains);
+}
+
+TEST_F(RunSamplersTest, RunSamplers_WritesSummary) {
+  args_.base.num_chains = 2;
+  args_.save_warmup = true;
+  args_.summary_file = (temp_dir_ / "summary.json").string();
+
+  init_contexts_.clear();
+  metric_contexts_.clear();
+  for (size_t i = 0; i < args_.base.num_chains; ++i) {
+    init_contexts_.push_back(stan3::read_json_data(""));
+    metric_contexts_.push_back(stan3::read_json_data(""));
+  }
+  writers_ = stan3::create_hmc_nuts_multi_chain_writers(args_, "test_model");
+
+  stan3::run_samplers(*model_, args_, init_contexts_, metric_contexts_,
+                     writers_, *interrupt_, *logger_);
+
+  ASSERT_TRUE(std::filesystem::exists(args_.summary_file));
+  std::ifstream in(args_.summary_file);
+  std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  // Saved warmup draws are not summarized: 2 chains of 10 sampling draws
+  size_t pos = contents.find("\"num_draws\"");
+  ASSERT_NE(pos, std::string::npos);
+  EXPECT_EQ(contents.find_first_of("0123456789", pos), contents.find("20", pos));
+  EXPECT_NE(contents.find("\"theta\""), std::string::npos);
+  EXPECT_NE(contents.find("\"rhat\""), std::string::npos);
+}
+
+TEST_F(RunSamplersTest, RunSamplers_StopsAtConvergenceTargets) {
+  args_.base.num_chains = 2;
+  args_.base.num_threads = 2;
+  args_.num_warmup = 100;
+  args_.num_samples = 20000;
+  args_.target_ess = 200;
+  args_.target_rhat = 1.05;
+
+  init_contexts_.clear();
+  metric_contexts_.clear();
+  for (size_t i = 0; i < args_.base.num_chains; ++i) {
+    init_contexts_.push_back(stan3::read_json_data(""));
+    metric_contexts_.push_back(stan3::read_json_data(""));
+  }
+  writers_ = stan3::create_hmc_nuts_multi_chain_writers(args_, "converging_model");
+  bool all_at_once = stan3::chain_placement(args_.base.num_chains, args_.base.num_threads,
+                                            args_.threads_per_chain, false)
+                       .runs_all_at_once(args_.base.num_chains);
+
+  EXPECT_NO_THROW({
+    stan3::run_samplers(*model_, args_, init_contexts_, metric_contexts_,
+                       writers_, *interrupt_, *logger_);
+  });
+  writers_.clear();  // flush and close the sample files
+
+  for (const auto& entry : std::filesystem::directory_iterator(temp_dir_)) {
+    std::string name = entry.path().filename().string();
+    if (name.find("converging_model") == std::string::npos
+        || name.find("_sample.csv") == std::string::npos) {
+      continue;
+    }
+    std::ifstream in(entry.path());
+    std::string line;
+    size_t num_rows = 0;
+    while (std::getline(in, line)) {
+      if (!line.empty() && line[0] != '#') {
+        ++num_rows;
+      }
+    }
+    if (all_at_once) {
+      EXPECT_LT(num_rows, static_cast<size_t>(args_.num_samples)) << name;
+    } else {
+      // Chains running in turns cannot stop together: the targets are
+      // ignored, as without STAN_THREADS or with too few CPUs
+      EXPECT_EQ(num_rows, static_cast<size_t>(args_.num_samples) + 1) << name;
+    }
+  }
+}
+
+TEST_F(RunSamplersTest, RunSamplers_IgnoresTargetsForChainsRunningInTurns) {
+  // Three chains on two threads do not all run at once
+  args_.base.num_chains = 3;
+  args_.base.num_threads = 2;
+  args_.num_warmup = 100;
+  args_.num_samples = 2000;
+  args_.target_ess = 200;
+  args_.target_rhat = 1.05;
+
+  init_contexts_.clear();
+  metric_contexts_.clear();
+  for (size_t i = 0; i < args_.base.num_chains; ++i) {
+    init_contexts_.push_back(stan3::read_json_data(""));
+    metric_contexts_.push_back(stan3::read_json_data(""));
+  }
+  writers_ = stan3::create_hmc_nuts_multi_chain_writers(args_, "turns_model");
+
+  EXPECT_NO_THROW({
+    stan3::run_samplers(*model_, args_, init_contexts_, metric_contexts_,
+                       writers_, *interrupt_, *logger_);
+  });
+  writers_.clear();  // flush and close the sample files
+
+  size_t num_files = 0;
+  for (const auto& entry : std::filesystem::directory_iterator(temp_dir_)) {
+    std::string name = entry.path().filename().string();
+    if (name.find("turns_model") == std::string::npos
+        || name.find("_sample.csv") == std::string::npos) {
+      continue;
+    }
+    ++num_files;
+    std::ifstream in(entry.path());
+    std::string line;
+    size_t num_rows = 0;
+    while (std::getline(in, line)) {
+      if (!line.empty() && line[0] != '#') {
+        ++num_rows;
+      }
+    }
+    EXPECT_EQ(num_rows, static_cast<size_t>(args_.num_samples) + 1) << name;
+  }
+  EXPECT_EQ(num_files, args_.base.num_chains);
+}
+
+TEST_F(RunSamplersTest, SamplerRunner_CrossChainWarmupSharesStepsize) {
+  args_.base.num_chains = 3;
+  args_.base.num_threads = 3;
+  args_.metric_type = stan3::metric_t::DIAG_E;
+  args_.num_warmup = 150;
+  args_.cross_chain_warmup = true;
+
+  init_contexts_.clear();
+  metric_contexts_.clear();
+  for (size_t i = 0; i < args_.base.num_chains; ++i) {
+    init_contexts_.push_back(stan3::read_json_data(""));
+    metric_contexts_.push_back(stan3::read_json_data(""));
+  }
+  writers_ = stan3::create_hmc_nuts_multi_chain_writers(args_, "test_model");
+  std::vector<stan::callbacks::writer*> init_writers(args_.base.num_chains, nullptr);
+
+  auto sampler_configs = stan3::create_samplers(*model_, args_, init_contexts_,
+                                                metric_contexts_, *logger_, init_writers);
+  stan3::sampler_runner runner(*model_, args_, writers_, *interrupt_, *logger_);
+  EXPECT_NO_THROW(std::visit(runner, sampler_configs));
+
+  // Without a thread per chain the chains adapt separately
+  bool shared = stan3::threading_enabled()
+                && tbb::this_task_arena::max_concurrency() >= 3;
+  if (shared) {
+    std::visit([](auto& config) {
+      for (auto& sampler : config.samplers) {
+        EXPECT_EQ(sampler.get_nominal_stepsize(),
+                  config.samplers[0].get_nominal_stepsize());
+      }
+    }, sampler_configs);
+  }
+}
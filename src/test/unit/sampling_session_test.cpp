@@ -0,0 +1,101 @@
+#include <stan3/sampling_session.hpp>
+#include <stan3/arguments.hpp>
+#include <stan3/read_json_data.hpp>
+
+#include <test/test-models/bernoulli.hpp>
+
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+class SamplingSessionTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    auto data_context = stan3::read_json_data("src/test/test-models/bernoulli.data.json");
+    model_ = std::make_unique<bernoulli_model_namespace::bernoulli_model>(*data_context, 12345);
+
+    args_.base.num_chains = 2;
+    args_.base.model.random_seed = 12345;
+    args_.metric_type = stan3::metric_t::DIAG_E;
+    args_.num_warmup = 100;
+    args_.num_samples = 50;
+    args_.refresh = 0;
+
+    logger_ = std::make_unique<stan::callbacks::stream_logger>(
+      log_stream_, log_stream_, log_stream_, log_stream_, log_stream_);
+  }
+
+  /* Column index of a draws buffer column */
+  static size_t column(const stan3::draws_buffer& draws, const std::string& name) {
+    const auto& names = draws.column_names();
+    return std::find(names.begin(), names.end(), name) - names.begin();
+  }
+
+  std::unique_ptr<bernoulli_model_namespace::bernoulli_model> model_;
+  stan3::hmc_nuts_args args_;
+  stan::callbacks::interrupt interrupt_;
+  std::unique_ptr<stan::callbacks::stream_logger> logger_;
+  std::stringstream log_stream_;
+};
+
+TEST_F(SamplingSessionTest, ExtendContinuesWithAdaptedStepsize) {
+  stan3::sampling_session<bernoulli_model_namespace::bernoulli_model> session(*model_, args_);
+  auto first = session.start(interrupt_, *logger_);
+  ASSERT_TRUE(session.started());
+  ASSERT_EQ(first->draws_per_chain(), 50);
+  ASSERT_GT(first->num_cols(), 0);
+
+  auto more = session.extend(30, interrupt_, *logger_);
+  ASSERT_EQ(more->num_chains(), 2);
+  ASSERT_EQ(more->draws_per_chain(), 30);
+  ASSERT_EQ(more->column_names(), first->column_names());
+
+  // Without adaptation every chain keeps the step size it ended warmup with
+  size_t stepsize = column(*more, "stepsize__");
+  ASSERT_LT(stepsize, more->num_cols());
+  for (size_t c = 0; c < 2; ++c) {
+    double adapted = first->row(c, 49)[stepsize];
+    for (size_t d = 0; d < 30; ++d) {
+      EXPECT_EQ(more->row(c, d)[stepsize], adapted);
+    }
+    EXPECT_EQ(more->draws_written(c), 30);
+  }
+}
+
+TEST_F(SamplingSessionTest, ExtendRequiresStart) {
+  stan3::sampling_session<bernoulli_model_namespace::bernoulli_model> session(*model_, args_);
+  EXPECT_FALSE(session.started());
+  EXPECT_THROW(session.extend(10, interrupt_, *logger_), std::logic_error);
+}
+
+TEST_F(SamplingSessionTest, RejectsSummaryAndProfileOptions) {
+  args_.target_ess = 400;
+  args_.profile_file = "profile.json";
+  try {
+    stan3::sampling_session<bernoulli_model_namespace::bernoulli_model> session(*model_, args_);
+    FAIL() << "Expected std::invalid_argument";
+  } catch (const std::invalid_argument& e) {
+    EXPECT_STREQ(e.what(), "Not supported in a sampling session: --target-ess, --profile-output");
+  }
+
+  args_.target_ess = 0;
+  args_.profile_file.clear();
+  args_.summary_file = "summary.json";
+  EXPECT_THROW((stan3::sampling_session<bernoulli_model_namespace::bernoulli_model>(*model_, args_)),
+               std::invalid_argument);
+}
+
+TEST_F(SamplingSessionTest, StartRejectsUnknownOutputVars) {
+  args_.output_vars = {"thetaa"};
+  stan3::sampling_session<bernoulli_model_namespace::bernoulli_model> session(*model_, args_);
+  EXPECT_THROW(session.start(interrupt_, *logger_), std::invalid_argument);
+  EXPECT_FALSE(session.started());
+}
@@ -0,0 +1,96 @@
+#include <stan3/shared_dense_metric.hpp>
+#include <stan3/read_json_data.hpp>
+
+#include <test/test-models/bernoulli.hpp>
+
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/mcmc/sample.hpp>
+#include <stan/services/util/create_rng.hpp>
+
+#include <boost/random/mixmax.hpp>
+
+#include <Eigen/Dense>
+
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+using model_t = bernoulli_model_namespace::bernoulli_model;
+using sampler_t = stan3::adapt_shared_dense_e_nuts<model_t, boost::random::mixmax>;
+
+}  // namespace
+
+TEST(SharedDenseMetricTest, UpperFactorReproducesTheMetric) {
+  Eigen::MatrixXd inv(3, 3);
+  inv << 4, 1, 0.5,
+         1, 3, 0.25,
+         0.5, 0.25, 2;
+  stan3::dense_inv_metric metric(inv);
+  EXPECT_TRUE(metric.inv_metric.isApprox(inv));
+  EXPECT_TRUE((metric.upper_factor.transpose() * metric.upper_factor).isApprox(inv));
+  EXPECT_TRUE(metric.upper_factor.isUpperTriangular());
+  EXPECT_EQ(metric.bytes(), 18 * sizeof(double));
+}
+
+TEST(SharedDenseMetricTest, NotPositiveDefiniteThrows) {
+  Eigen::MatrixXd inv(2, 2);
+  inv << 1, 2,
+         2, 1;
+  EXPECT_THROW(stan3::dense_inv_metric{inv}, std::domain_error);
+}
+
+TEST(SharedDenseMetricTest, PointsShareOneMetric) {
+  auto metric = std::make_shared<const stan3::dense_inv_metric>(
+    Eigen::MatrixXd::Identity(2, 2) * 2.0);
+  stan3::shared_dense_e_point first(2);
+  stan3::shared_dense_e_point second(2);
+  first.share_metric(metric);
+  second.share_metric(metric);
+  EXPECT_EQ(&first.metric(), &second.metric());
+  EXPECT_EQ(metric.use_count(), 3);
+
+  // A point's own metric leaves the shared one alone
+  second.set_metric(Eigen::MatrixXd::Identity(2, 2));
+  EXPECT_DOUBLE_EQ(second.metric().inv_metric(0, 0), 1.0);
+  EXPECT_DOUBLE_EQ(first.metric().inv_metric(0, 0), 2.0);
+  EXPECT_EQ(metric.use_count(), 2);
+}
+
+TEST(SharedDenseMetricTest, KineticEnergyUsesTheMetric) {
+  auto data_context = stan3::read_json_data("src/test/test-models/bernoulli.data.json");
+  model_t model(*data_context, 12345);
+  stan3::shared_dense_e_metric<model_t, boost::random::mixmax> hamiltonian(model);
+  stan3::shared_dense_e_point z(1);
+  z.share_metric(std::make_shared<const stan3::dense_inv_metric>(
+    Eigen::MatrixXd::Constant(1, 1, 4.0)));
+  z.p(0) = 0.5;
+  EXPECT_DOUBLE_EQ(hamiltonian.T(z), 0.5 * 0.5 * 4.0 * 0.5);
+  EXPECT_DOUBLE_EQ(hamiltonian.dtau_dp(z)(0), 2.0);
+}
+
+TEST(SharedDenseMetricTest, SamplerTransitionsWithASharedMetric) {
+  auto data_context = stan3::read_json_data("src/test/test-models/bernoulli.data.json");
+  model_t model(*data_context, 12345);
+  stan::callbacks::stream_logger logger(std::cout, std::cout, std::cout, std::cerr, std::cerr);
+  auto metric = std::make_shared<const stan3::dense_inv_metric>(
+    Eigen::MatrixXd::Identity(1, 1));
+
+  auto rng = stan::services::util::create_rng(12345, 1);
+  sampler_t sampler(model, rng);
+  sampler.z().share_metric(metric);
+  sampler.set_nominal_stepsize(0.5);
+  sampler.engage_adaptation();
+
+  Eigen::VectorXd q = Eigen::VectorXd::Zero(1);
+  stan::mcmc::sample s(q, 0, 0);
+  for (int n = 0; n < 10; ++n) {
+    s = sampler.transition(s, logger);
+  }
+  EXPECT_EQ(s.cont_params().size(), 1);
+  EXPECT_GT(sampler.get_nominal_stepsize(), 0);
+  EXPECT_EQ(&sampler.z().metric(), metric.get());
+}
@@ -0,0 +1,151 @@
+#include <stan3/shared_output.hpp>
+
+#include <stan/callbacks/writer.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+/* Keeps what it receives; the shared file's I/O thread is its only caller */
+struct recording_writer : public stan::callbacks::writer {
+  std::shared_ptr<std::vector<std::vector<std::string>>> headers
+    = std::make_shared<std::vector<std::vector<std::string>>>();
+  std::shared_ptr<std::vector<std::vector<double>>> rows
+    = std::make_shared<std::vector<std::vector<double>>>();
+  std::shared_ptr<std::vector<std::string>> messages = std::make_shared<std::vector<std::string>>();
+
+  void operator()(const std::vector<std::string>& names) override { headers->push_back(names); }
+
+  void operator()(const std::vector<double>& state) override { rows->push_back(state); }
+
+  void operator()(const std::string& message) override { messages->push_back(message); }
+};
+
+/* Fails on the first row */
+struct failing_writer : public stan::callbacks::writer {
+  void operator()(const std::vector<double>&) override {
+    throw std::runtime_error("disk full");
+  }
+};
+
+std::string read_file(const std::string& path) {
+  std::ifstream in(path);
+  std::stringstream ss;
+  ss << in.rdbuf();
+  return ss.str();
+}
+
+}  // namespace
+
+TEST(SharedOutputTest, ChainsShareOneHeaderAndTagTheirRows) {
+  recording_writer recorder;
+  const unsigned int num_chains = 4;
+  const int num_draws = 500;
+  {
+    auto file = std::make_shared<stan3::shared_draws_file>(
+        std::make_unique<recording_writer>(recorder), 8);
+    std::vector<std::thread> chains;
+    for (unsigned int id = 1; id <= num_chains; ++id) {
+      chains.emplace_back([file, id] {
+        stan3::shared_chain_writer writer(file, id, 16);
+        writer(std::vector<std::string>{"lp__", "theta"});
+        for (int n = 0; n < num_draws; ++n) {
+          writer(std::vector<double>{-1.0 * id, static_cast<double>(n)});
+        }
+        writer(std::string("Elapsed"));
+      });
+    }
+    for (auto& chain : chains) {
+      chain.join();
+    }
+  }
+
+  ASSERT_EQ(recorder.headers->size(), 1);
+  EXPECT_EQ(recorder.headers->front(), (std::vector<std::string>{"chain__", "lp__", "theta"}));
+  ASSERT_EQ(recorder.rows->size(), num_chains * num_draws);
+  // Each chain's draws arrive complete and in order
+  std::map<double, double> next_draw;
+  for (const auto& row : *recorder.rows) {
+    ASSERT_EQ(row.size(), 3);
+    EXPECT_EQ(row[1], -row[0]);
+    EXPECT_EQ(row[2], next_draw[row[0]]++);
+  }
+  EXPECT_EQ(next_draw.size(), num_chains);
+  EXPECT_EQ(recorder.messages->size(), num_chains);
+}
+
+TEST(SharedOutputTest, CommentsFollowTheChainsEarlierRows) {
+  recording_writer recorder;
+  {
+    auto file = std::make_shared<stan3::shared_draws_file>(
+        std::make_unique<recording_writer>(recorder));
+    stan3::shared_chain_writer writer(file, 2);
+    writer(std::vector<double>{0.5});
+    writer(std::string("Adaptation terminated"));
+    writer(std::vector<double>{1.5});
+  }
+  ASSERT_EQ(recorder.rows->size(), 2);
+  EXPECT_EQ((*recorder.rows)[0], (std::vector<double>{2, 0.5}));
+  EXPECT_EQ((*recorder.rows)[1], (std::vector<double>{2, 1.5}));
+  EXPECT_EQ(*recorder.messages, (std::vector<std::string>{"chain 2: Adaptation terminated"}));
+}
+
+TEST(SharedOutputTest, WriterErrorReachesTheChains) {
+  auto file = std::make_shared<stan3::shared_draws_file>(std::make_unique<failing_writer>());
+  stan3::shared_chain_writer writer(file, 1, 1);
+  writer(std::vector<double>{1.0});
+  // The I/O thread fails asynchronously; a later submit reports it
+  bool thrown = false;
+  for (int n = 0; n < 1000 && !thrown; ++n) {
+    try {
+      writer(std::vector<double>{1.0});
+    } catch (const std::runtime_error& e) {
+      EXPECT_STREQ(e.what(), "disk full");
+      thrown = true;
+    }
+    std::this_thread::yield();
+  }
+  EXPECT_TRUE(thrown);
+}
+
+TEST(SharedOutputTest, NullArgumentsThrow) {
+  std::unique_ptr<stan::callbacks::writer> null_writer;
+  EXPECT_THROW(stan3::shared_draws_file(std::move(null_writer)), std::invalid_argument);
+  EXPECT_THROW(stan3::shared_chain_writer(nullptr, 1), std::invalid_argument);
+}
+
+TEST(SharedOutputTest, JsonRecordsFormAnArrayInChainOrder) {
+  std::string path = testing::TempDir() + "shared_output_test_metric.json";
+  {
+    auto file = std::make_shared<stan3::shared_json_file>(path, 3);
+    auto second = stan3::create_shared_json_writer(file, 1);
+    auto first = stan3::create_shared_json_writer(file, 0);
+    second->begin_record();
+    second->write("stepsize", 0.25);
+    second->end_record();
+    first->begin_record();
+    first->write("stepsize", 0.5);
+    first->end_record();
+  }
+  std::string json = read_file(path);
+  std::remove(path.c_str());
+
+  ASSERT_EQ(json.rfind("[\n", 0), 0);
+  size_t first = json.find("0.5");
+  size_t second = json.find("0.25");
+  ASSERT_NE(first, std::string::npos);
+  ASSERT_NE(second, std::string::npos);
+  EXPECT_LT(first, second);
+  // The third chain wrote no record
+  EXPECT_NE(json.find("null\n]\n"), std::string::npos);
+}
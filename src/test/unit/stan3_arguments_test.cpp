@@ -1,5 +1,7 @@
 #include <stan3/arguments.hpp>
 
+#include <cstdio>
+#include <fstream>
 #include <string>
 #include <vector>
 
@@ -60,6 +62,32 @@ TEST(Stan3ArgsTest, JSONFileValidator_EmptyFile) {
   EXPECT_NE(result.find("JSON object"), std::string::npos);
 }
 
+TEST(Stan3ArgsTest, DataFileValidator_JSONFile) {
+  stan3::DataFileValidator validator;
+  EXPECT_EQ(validator(""), "");
+  EXPECT_EQ(validator("src/test/test-models/bernoulli.data.json"), "");
+  EXPECT_NE(validator("src/test/test-models/bernoulli.stan").find("JSON object"),
+            std::string::npos);
+}
+
+TEST(Stan3ArgsTest, DataFileValidator_BinaryFile) {
+  stan3::DataFileValidator validator;
+  EXPECT_NE(validator("nonexistent.bin").find("does not exist"), std::string::npos);
+
+  std::string path = testing::TempDir() + "stan3_validator_data.bin";
+  {
+    std::ofstream out(path, std::ios::binary);
+    out << "STAN3DAT";
+  }
+  EXPECT_EQ(validator(path), "");
+  {
+    std::ofstream out(path, std::ios::binary);
+    out << "{\"N\": 1}";
+  }
+  EXPECT_NE(validator(path).find("binary data format"), std::string::npos);
+  std::remove(path.c_str());
+}
+
 TEST(Stan3ArgsTest, JSONFileVectorValidator_EmptyString) {
   stan3::JSONFileVectorValidator validator;
   EXPECT_EQ(validator(""), "");
@@ -0,0 +1,190 @@
+#include <stan3/stan3_c_api.cpp>
+
+#include <test/test-models/bernoulli.hpp>
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+/* Mutable argv for the C API, with argv[0] the program name */
+class test_argv {
+public:
+  explicit test_argv(std::vector<std::string> args) : args_(std::move(args)) {
+    args_.insert(args_.begin(), "stan3");
+    for (auto& arg : args_) {
+      argv_.push_back(arg.data());
+    }
+  }
+
+  int argc() const { return static_cast<int>(argv_.size()); }
+  char** argv() { return argv_.data(); }
+
+private:
+  std::vector<std::string> args_;
+  std::vector<char*> argv_;
+};
+
+}  // namespace
+
+class StanCApiTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    first_ = new_handle();
+    second_ = new_handle();
+  }
+
+  void TearDown() override {
+    stan3_model_free(first_);
+    stan3_model_free(second_);
+  }
+
+  static stan3_model_handle* new_handle() {
+    test_argv args({"--data", "src/test/test-models/bernoulli.data.json"});
+    char error[256];
+    stan3_model_handle* handle = stan3_model_new(args.argc(), args.argv(), error, sizeof(error));
+    EXPECT_NE(handle, nullptr) << error;
+    return handle;
+  }
+
+  stan3_model_handle* first_ = nullptr;
+  stan3_model_handle* second_ = nullptr;
+};
+
+TEST_F(StanCApiTest, HandlesOwnTheirModels) {
+  ASSERT_NE(first_, nullptr);
+  ASSERT_NE(second_, nullptr);
+  EXPECT_STREQ(stan3_model_name_h(first_), "bernoulli_model");
+  EXPECT_STREQ(stan3_model_name_h(second_), "bernoulli_model");
+  EXPECT_EQ(stan3_param_unc_num_h(first_), 1);
+  EXPECT_EQ(stan3_param_num_h(second_, 0, 0), 1);
+
+  double u = 0.7;
+  double lp[2];
+  double grad[2];
+  ASSERT_EQ(stan3_log_density_gradient_h(first_, &u, &lp[0], &grad[0]), STAN3_SUCCESS);
+  ASSERT_EQ(stan3_log_density_gradient_h(second_, &u, &lp[1], &grad[1]), STAN3_SUCCESS);
+  EXPECT_EQ(lp[0], lp[1]);
+  EXPECT_EQ(grad[0], grad[1]);
+}
+
+TEST_F(StanCApiTest, ErrorsStayOnTheirHandle) {
+  ASSERT_NE(first_, nullptr);
+  ASSERT_NE(second_, nullptr);
+  test_argv args({"--not-an-option"});
+  char error[256];
+  EXPECT_NE(stan3_run_samplers_h(first_, args.argc(), args.argv(), error, sizeof(error)),
+            STAN3_SUCCESS);
+  ASSERT_NE(stan3_get_last_error_h(first_), nullptr);
+  EXPECT_STREQ(stan3_get_last_error_h(first_), error);
+  EXPECT_EQ(stan3_get_last_error_h(second_), nullptr);
+  EXPECT_EQ(stan3_get_last_error(), nullptr);
+
+  stan3_clear_error_h(first_);
+  EXPECT_EQ(stan3_get_last_error_h(first_), nullptr);
+}
+
+TEST_F(StanCApiTest, CopyDrawsChecksTheArraySize) {
+  ASSERT_NE(first_, nullptr);
+  size_t rows = 1;
+  size_t cols = 1;
+  double value = 0;
+  EXPECT_EQ(stan3_copy_draws_h(first_, &value, 1, &rows, &cols), STAN3_ERROR_NO_DRAWS);
+  EXPECT_EQ(rows, 0);
+  EXPECT_EQ(cols, 0);
+  EXPECT_NE(stan3_get_last_error_h(first_), nullptr);
+
+  // Two chains of three draws, as a completed in-memory run leaves them
+  auto buffer = std::make_shared<stan3::draws_buffer>(2, 3);
+  buffer->set_column_names({"lp__", "theta"});
+  for (size_t chain = 0; chain < 2; ++chain) {
+    for (size_t draw = 0; draw < 3; ++draw) {
+      buffer->row(chain, draw)[0] = -1.0 - draw;
+      buffer->row(chain, draw)[1] = chain + 0.1 * draw;
+    }
+    buffer->set_draws_written(chain, 3);
+  }
+  first_->draws = buffer;
+
+  std::vector<double> draws(5);
+  EXPECT_EQ(stan3_copy_draws_h(first_, draws.data(), draws.size(), &rows, &cols),
+            STAN3_ERROR_INVALID_ARGS);
+  EXPECT_EQ(rows, 6);
+  EXPECT_EQ(cols, 2);
+
+  draws.resize(rows * cols);
+  ASSERT_EQ(stan3_copy_draws_h(first_, draws.data(), draws.size(), &rows, &cols),
+            STAN3_SUCCESS);
+  // The copy outlives the handle's draws
+  stan3_free_draws_h(first_);
+  EXPECT_EQ(draws[0], -1.0);
+  EXPECT_EQ(draws[11], 1.2);
+  EXPECT_EQ(stan3_copy_draws_h(second_, draws.data(), draws.size(), &rows, &cols),
+            STAN3_ERROR_NO_DRAWS);
+}
+
+TEST_F(StanCApiTest, OverlappingCallsNeedStanThreads) {
+  ASSERT_NE(first_, nullptr);
+  double u = 0.7;
+  double lp = 0;
+  double grad = 0;
+  test_argv args({"--samples", "10"});
+  char error[256];
+  int log_density_code;
+  int global_code;
+  {
+    // A call in progress holds the guard
+    stan3::c_api::autodiff_guard in_progress;
+    ASSERT_TRUE(in_progress.admitted());
+    log_density_code = stan3_log_density_gradient_h(first_, &u, &lp, &grad);
+    global_code = stan3_run_samplers(args.argc(), args.argv(), error, sizeof(error));
+  }
+#ifdef STAN_THREADS
+  EXPECT_EQ(log_density_code, STAN3_SUCCESS);
+  // Admitted, but no global model is loaded
+  EXPECT_EQ(global_code, STAN3_ERROR_MODEL_LOAD);
+#else
+  EXPECT_EQ(log_density_code, STAN3_ERROR_RUNTIME);
+  EXPECT_STREQ(stan3_get_last_error_h(first_), stan3::c_api::autodiff_guard::refused_message);
+  EXPECT_EQ(global_code, STAN3_ERROR_RUNTIME);
+  EXPECT_STREQ(error, stan3::c_api::autodiff_guard::refused_message);
+  EXPECT_EQ(stan3_get_last_error_h(second_), nullptr);
+#endif
+  // Once the call has finished, the next one is admitted
+  EXPECT_EQ(stan3_log_density_gradient_h(first_, &u, &lp, &grad), STAN3_SUCCESS);
+}
+
+TEST_F(StanCApiTest, SessionCallsTakeTheGuard) {
+  ASSERT_NE(first_, nullptr);
+  test_argv args({"--chains", "1", "--warmup", "10", "--samples", "10", "--refresh", "0"});
+  char error[256];
+  stan3_session* session = stan3_session_new(first_, args.argc(), args.argv(),
+                                             error, sizeof(error));
+  ASSERT_NE(session, nullptr) << error;
+  {
+    stan3::c_api::autodiff_guard in_progress;
+#ifdef STAN_THREADS
+    EXPECT_EQ(stan3_session_continue(session, 10, error, sizeof(error)), STAN3_SUCCESS);
+#else
+    EXPECT_EQ(stan3_session_new(first_, args.argc(), args.argv(), error, sizeof(error)),
+              nullptr);
+    EXPECT_STREQ(error, stan3::c_api::autodiff_guard::refused_message);
+    EXPECT_EQ(stan3_session_continue(session, 10, error, sizeof(error)), STAN3_ERROR_RUNTIME);
+    EXPECT_STREQ(error, stan3::c_api::autodiff_guard::refused_message);
+#endif
+  }
+  EXPECT_EQ(stan3_session_continue(session, 10, error, sizeof(error)), STAN3_SUCCESS) << error;
+  stan3_session_free(session);
+}
+
+TEST_F(StanCApiTest, SessionRejectsSummaryOptions) {
+  ASSERT_NE(first_, nullptr);
+  test_argv args({"--samples", "10", "--target-rhat", "1.01"});
+  char error[256];
+  EXPECT_EQ(stan3_session_new(first_, args.argc(), args.argv(), error, sizeof(error)), nullptr);
+  EXPECT_NE(std::string(error).find("--target-rhat"), std::string::npos) << error;
+}
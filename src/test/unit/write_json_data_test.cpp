@@ -0,0 +1,41 @@
+#include <stan3/write_json_data.hpp>
+
+#include <stan/io/array_var_context.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+TEST(WriteJsonDataTest, NestsArraysInRowMajorOrder) {
+  std::ostringstream out;
+  // 2 x 3 matrix in column-major order
+  std::vector<double> values = {1, 4, 2, 5, 3, 6};
+  stan3::write_json_array(out, values, {2, 3}, 0, 0, 1);
+  EXPECT_EQ(out.str(), "[[1, 2, 3], [4, 5, 6]]");
+
+  std::ostringstream scalar;
+  stan3::write_json_array(scalar, std::vector<double>{2.5}, {}, 0, 0, 1);
+  EXPECT_EQ(scalar.str(), "2.5");
+}
+
+TEST(WriteJsonDataTest, WritesVarContext) {
+  stan::io::array_var_context context({"mu", "theta"}, std::vector<double>{0.5, 1, 2},
+                                      {{}, {2}});
+  std::string path = (std::filesystem::temp_directory_path() / "write_json_data_test.json").string();
+  stan3::write_json_data(context, path);
+
+  std::ifstream in(path);
+  std::stringstream contents;
+  contents << in.rdbuf();
+  EXPECT_EQ(contents.str(), "{\n  \"mu\": 0.5,\n  \"theta\": [1, 2]\n}\n");
+  std::filesystem::remove(path);
+}
+
+TEST(WriteJsonDataTest, ThrowsOnUnwritableFile) {
+  stan::io::array_var_context context({"mu"}, std::vector<double>{0.5}, {{}});
+  EXPECT_THROW(stan3::write_json_data(context, "/nonexistent_dir/data.json"), std::runtime_error);
+}